@@ -0,0 +1,67 @@
+#include "HIDJoystickReference.h"
+#include "HIDReportDescriptor.h"
+#include "HIDJoystick.h"
+#include "HostLogger.h"
+#include "MockUSBDevice.h"
+#include <cmath>
+#include <cstring>
+
+HIDJoystickReference::HIDJoystickReference(const uint8_t *descriptor, size_t size)
+    : BaseController(std::make_unique<MockUSBDevice>(0, 0), ControllerConfig(), std::make_unique<HostLogger>(HostLogger::LevelFromEnv(LogLevelWarning))),
+      m_joystick(std::make_shared<HIDJoystick>(std::make_shared<HIDReportDescriptor>(descriptor, size)))
+{
+}
+
+HIDJoystickReference::~HIDJoystickReference()
+{
+}
+
+ams::Result HIDJoystickReference::ReadInput(RawInputData *rawData, uint16_t *input_idx, uint32_t timeout_us)
+{
+    (void)rawData;
+    (void)input_idx;
+    (void)timeout_us;
+    R_RETURN(CONTROL_ERR_NOTHING_TODO);
+}
+
+uint16_t HIDJoystickReference::GetInputCount()
+{
+    return m_joystick->getCount();
+}
+
+// Same code as GenericHIDController::ReadInput without HIDReportLayout
+bool HIDJoystickReference::Decode(const uint8_t *report, size_t size, RawInputData *rawData, uint16_t *input_idx)
+{
+    HIDJoystickData joystick_data;
+
+    if (!m_joystick->parseData(report, size, &joystick_data))
+        return false;
+
+    *input_idx = joystick_data.index;
+
+    for (int i = 0; i < MAX_CONTROLLER_BUTTONS; i++)
+        rawData->buttons[i] = joystick_data.buttons[i];
+
+    rawData->Rx = Normalize(joystick_data.Rx, -32768, 32767);
+    rawData->Ry = Normalize(joystick_data.Ry, -32768, 32767);
+
+    rawData->X = Normalize(joystick_data.X, -32768, 32767);
+    rawData->Y = Normalize(joystick_data.Y, -32768, 32767);
+    rawData->Z = Normalize(joystick_data.Z, -32768, 32767);
+    rawData->Rz = Normalize(joystick_data.Rz, -32768, 32767);
+
+    rawData->dpad_up = joystick_data.hat_switch == HIDJoystickHatSwitch::UP || joystick_data.hat_switch == HIDJoystickHatSwitch::UP_RIGHT || joystick_data.hat_switch == HIDJoystickHatSwitch::UP_LEFT;
+    rawData->dpad_right = joystick_data.hat_switch == HIDJoystickHatSwitch::RIGHT || joystick_data.hat_switch == HIDJoystickHatSwitch::UP_RIGHT || joystick_data.hat_switch == HIDJoystickHatSwitch::DOWN_RIGHT;
+    rawData->dpad_down = joystick_data.hat_switch == HIDJoystickHatSwitch::DOWN || joystick_data.hat_switch == HIDJoystickHatSwitch::DOWN_RIGHT || joystick_data.hat_switch == HIDJoystickHatSwitch::DOWN_LEFT;
+    rawData->dpad_left = joystick_data.hat_switch == HIDJoystickHatSwitch::LEFT || joystick_data.hat_switch == HIDJoystickHatSwitch::UP_LEFT || joystick_data.hat_switch == HIDJoystickHatSwitch::DOWN_LEFT;
+
+    return true;
+}
+
+bool HIDJoystickReference::IsSameInput(const RawInputData &a, uint16_t a_idx, const RawInputData &b, uint16_t b_idx)
+{
+    return a_idx == b_idx && memcmp(a.buttons, b.buttons, sizeof(a.buttons)) == 0 &&
+           a.dpad_up == b.dpad_up && a.dpad_right == b.dpad_right && a.dpad_down == b.dpad_down && a.dpad_left == b.dpad_left &&
+           std::abs(a.X - b.X) <= 0.01f && std::abs(a.Y - b.Y) <= 0.01f && std::abs(a.Z - b.Z) <= 0.01f &&
+           std::abs(a.Rx - b.Rx) <= 0.01f && std::abs(a.Ry - b.Ry) <= 0.01f && std::abs(a.Rz - b.Rz) <= 0.01f;
+}
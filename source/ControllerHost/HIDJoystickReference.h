@@ -0,0 +1,25 @@
+#pragma once
+#include "Controllers/BaseController.h"
+#include <memory>
+
+class HIDJoystick;
+
+// Decoding of GenericHIDController before HIDReportLayout: HIDJoystick::parseData + hat switch comparisons + Normalize.
+// HIDReportLayout replaced it for every descriptor it compiles, it must give the same RawInputData (See IsSameInput).
+class HIDJoystickReference : public BaseController
+{
+private:
+    std::shared_ptr<HIDJoystick> m_joystick;
+
+public:
+    HIDJoystickReference(const uint8_t *descriptor, size_t size);
+    ~HIDJoystickReference();
+
+    ams::Result ReadInput(RawInputData *rawData, uint16_t *input_idx, uint32_t timeout_us) override;
+    uint16_t GetInputCount() override;
+
+    bool Decode(const uint8_t *report, size_t size, RawInputData *rawData, uint16_t *input_idx);
+
+    // Same buttons, dpad and input index, axes within 0.01
+    static bool IsSameInput(const RawInputData &a, uint16_t a_idx, const RawInputData &b, uint16_t b_idx);
+};
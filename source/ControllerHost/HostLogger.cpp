@@ -0,0 +1,50 @@
+#include "HostLogger.h"
+#include <cstdio>
+#include <cstdlib>
+
+static const char logLevelStr[] = {'T', 'D', 'I', 'W', 'E'};
+
+HostLogger::HostLogger(LogLevel level)
+    : m_level(level)
+{
+}
+
+void HostLogger::Print(LogLevel lvl, const char *format, ::std::va_list vl)
+{
+    if (lvl < m_level)
+        return;
+
+    fprintf(stderr, "|%c| ", logLevelStr[lvl]);
+    vfprintf(stderr, format, vl);
+    fputc('\n', stderr);
+}
+
+void HostLogger::PrintBuffer(LogLevel lvl, const uint8_t *buffer, size_t size)
+{
+    if (lvl < m_level)
+        return;
+
+    fprintf(stderr, "|%c| Buffer (%zu): ", logLevelStr[lvl], size);
+    for (size_t i = 0; i < size; i++)
+        fprintf(stderr, "%02X ", buffer[i]);
+    fputc('\n', stderr);
+}
+
+bool HostLogger::IsEnabled(LogLevel lvl) const
+{
+    return lvl >= m_level;
+}
+
+// SYSCON_LOG_LEVEL=0..4 (Trace..Error) allows to get the driver logs while running a benchmark or a tool
+LogLevel HostLogger::LevelFromEnv(LogLevel defaultLevel)
+{
+    const char *env = getenv("SYSCON_LOG_LEVEL");
+    if (env == NULL)
+        return defaultLevel;
+
+    int level = atoi(env);
+    if (level < LogLevelTrace || level > LogLevelError)
+        return defaultLevel;
+
+    return static_cast<LogLevel>(level);
+}
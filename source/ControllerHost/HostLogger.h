@@ -0,0 +1,20 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include "ILogger.h"
+
+// ILogger implementation for the host build, everything goes to stderr
+class HostLogger : public ILogger
+{
+private:
+    LogLevel m_level;
+
+public:
+    HostLogger(LogLevel level = LogLevelWarning);
+
+    void Print(LogLevel lvl, const char *format, ::std::va_list vl) override;
+    void PrintBuffer(LogLevel lvl, const uint8_t *buffer, size_t size) override;
+    bool IsEnabled(LogLevel lvl) const override;
+
+    static LogLevel LevelFromEnv(LogLevel defaultLevel);
+};
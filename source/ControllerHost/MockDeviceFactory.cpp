@@ -0,0 +1,299 @@
+#include "MockDeviceFactory.h"
+#include "Controllers.h"
+#include <cmath>
+
+namespace
+{
+    // Smooth stick motion + a button pattern changing every few frames
+    struct SyntheticFrame
+    {
+        int16_t lx, ly, rx, ry;
+        uint8_t lt, rt;
+        uint16_t buttons;
+        uint8_t hat;
+    };
+
+    SyntheticFrame MakeFrame(uint32_t frame)
+    {
+        SyntheticFrame f;
+        float angle = frame * 0.05f;
+        f.lx = (int16_t)(std::cos(angle) * 30000);
+        f.ly = (int16_t)(std::sin(angle) * 30000);
+        f.rx = (int16_t)(std::sin(angle * 0.5f) * 20000);
+        f.ry = (int16_t)(std::cos(angle * 0.5f) * 20000);
+        f.lt = (uint8_t)(frame * 3);
+        f.rt = (uint8_t)(255 - frame * 3);
+        f.buttons = (uint16_t)(1 << ((frame / 8) % 16));
+        f.hat = (frame / 16) % 9; // 8 = neutral
+        return f;
+    }
+
+    void PutLE16(uint8_t *p, uint16_t value)
+    {
+        p[0] = value & 0xFF;
+        p[1] = value >> 8;
+    }
+
+    MockUSBInterface *AddInterface(MockUSBDevice *device, uint8_t iclass, uint8_t isubclass, uint8_t iprotocol, uint8_t in_ep, uint16_t in_size, uint8_t in_interval, uint8_t out_ep, uint16_t out_size, uint8_t out_interval)
+    {
+        MockUSBInterface *interface = device->AddInterface(iclass, isubclass, iprotocol);
+        interface->AddEndpoint(in_ep, in_size, in_interval);
+        if (out_ep != 0)
+            interface->AddEndpoint(out_ep, out_size, out_interval);
+        return interface;
+    }
+
+    void BuildXbox360Report(const SyntheticFrame &f, uint8_t *report)
+    {
+        memset(report, 0, 20);
+        report[0] = 0x00;
+        report[1] = 0x14;
+        report[2] = (f.hat == 0 ? 0x01 : 0) | (f.hat == 4 ? 0x02 : 0) | (f.hat == 6 ? 0x04 : 0) | (f.hat == 2 ? 0x08 : 0) | ((f.buttons & 0x0F) << 4);
+        report[3] = (f.buttons >> 4) & 0xF7;
+        report[4] = f.lt;
+        report[5] = f.rt;
+        PutLE16(&report[6], f.lx);
+        PutLE16(&report[8], f.ly);
+        PutLE16(&report[10], f.rx);
+        PutLE16(&report[12], f.ry);
+    }
+
+    std::unique_ptr<MockUSBDevice> CreateXbox360(uint32_t frames)
+    {
+        auto device = std::make_unique<MockUSBDevice>(0x045e, 0x028e);
+        MockUSBEndpoint *in = AddInterface(device.get(), USB_CLASS_VENDOR_SPEC, 0x5D, 0x01, 0x81, 32, 4, 0x01, 32, 8)->GetMockEndpoint(IUSBEndpoint::USB_ENDPOINT_IN, 0);
+
+        for (uint32_t i = 0; i < frames; i++)
+        {
+            uint8_t report[20];
+            BuildXbox360Report(MakeFrame(i), report);
+            in->QueueReport(i * 4000, report, sizeof(report));
+        }
+        in->SetLoop(true, 4000);
+        return device;
+    }
+
+    std::unique_ptr<MockUSBDevice> CreateXbox360Wireless(uint32_t frames)
+    {
+        auto device = std::make_unique<MockUSBDevice>(0x045e, 0x0719);
+
+        // 4 slots, only the first one has a controller connected
+        for (uint8_t slot = 0; slot < 4; slot++)
+            AddInterface(device.get(), USB_CLASS_VENDOR_SPEC, 0x5D, 0x81, 0x81 + slot * 2, 32, 1, 0x01 + slot * 2, 32, 8);
+
+        MockUSBEndpoint *in = device->GetMockInterface(0)->GetMockEndpoint(IUSBEndpoint::USB_ENDPOINT_IN, 0);
+
+        const uint8_t connect[] = {0x08, 0x80};
+        in->QueueReport(0, connect, sizeof(connect));
+
+        for (uint32_t i = 0; i < frames; i++)
+        {
+            uint8_t report[29] = {0x00, 0x01, 0x00, 0xf0};
+            BuildXbox360Report(MakeFrame(i), &report[4]);
+            report[5] = 0x13;
+            in->QueueReport(1000 + i * 1000, report, sizeof(report));
+        }
+        in->SetLoop(false, 0);
+        return device;
+    }
+
+    std::unique_ptr<MockUSBDevice> CreateXboxOne(uint32_t frames)
+    {
+        auto device = std::make_unique<MockUSBDevice>(0x045e, 0x02ea);
+        MockUSBEndpoint *in = AddInterface(device.get(), USB_CLASS_VENDOR_SPEC, 0x47, 0xD0, 0x81, 64, 4, 0x01, 64, 4)->GetMockEndpoint(IUSBEndpoint::USB_ENDPOINT_IN, 0);
+
+        for (uint32_t i = 0; i < frames; i++)
+        {
+            SyntheticFrame f = MakeFrame(i);
+            uint8_t report[18] = {0x20, 0x00, (uint8_t)i, 0x0e};
+            report[4] = (f.buttons & 0x0F) << 4;
+            report[5] = (f.hat == 0 ? 0x01 : 0) | (f.hat == 4 ? 0x02 : 0) | (f.hat == 6 ? 0x04 : 0) | (f.hat == 2 ? 0x08 : 0) | (f.buttons & 0xF0);
+            PutLE16(&report[6], f.lt * 4);
+            PutLE16(&report[8], f.rt * 4);
+            PutLE16(&report[10], f.lx);
+            PutLE16(&report[12], f.ly);
+            PutLE16(&report[14], f.rx);
+            PutLE16(&report[16], f.ry);
+            in->QueueReport(i * 4000, report, sizeof(report));
+        }
+        in->SetLoop(true, 4000);
+        return device;
+    }
+
+    std::unique_ptr<MockUSBDevice> CreateXbox(uint32_t frames)
+    {
+        auto device = std::make_unique<MockUSBDevice>(0x045e, 0x0202);
+        MockUSBEndpoint *in = AddInterface(device.get(), 0x58, 0x42, 0x00, 0x81, 32, 4, 0x02, 32, 4)->GetMockEndpoint(IUSBEndpoint::USB_ENDPOINT_IN, 0);
+
+        for (uint32_t i = 0; i < frames; i++)
+        {
+            SyntheticFrame f = MakeFrame(i);
+            uint8_t report[20] = {0x00, 0x14};
+            report[2] = (f.buttons & 0x0F) << 4;
+            for (int b = 0; b < 6; b++)
+                report[4 + b] = (f.buttons & (0x10 << b)) ? 0xFF : 0x00;
+            report[10] = f.lt;
+            report[11] = f.rt;
+            PutLE16(&report[12], f.lx);
+            PutLE16(&report[14], f.ly);
+            PutLE16(&report[16], f.rx);
+            PutLE16(&report[18], f.ry);
+            in->QueueReport(i * 4000, report, sizeof(report));
+        }
+        in->SetLoop(true, 4000);
+        return device;
+    }
+
+    std::unique_ptr<MockUSBDevice> CreateDualshock3(uint32_t frames)
+    {
+        auto device = std::make_unique<MockUSBDevice>(0x054c, 0x0268);
+        MockUSBEndpoint *in = AddInterface(device.get(), USB_CLASS_HID, 0x00, 0x00, 0x81, 64, 1, 0x02, 64, 1)->GetMockEndpoint(IUSBEndpoint::USB_ENDPOINT_IN, 0);
+
+        for (uint32_t i = 0; i < frames; i++)
+        {
+            SyntheticFrame f = MakeFrame(i);
+            uint8_t report[49] = {0x01};
+            report[2] = (f.buttons & 0x0F) | (f.hat == 0 ? 0x10 : 0) | (f.hat == 2 ? 0x20 : 0) | (f.hat == 4 ? 0x40 : 0) | (f.hat == 6 ? 0x80 : 0);
+            report[3] = (f.buttons >> 4) & 0xFF;
+            report[6] = (uint8_t)((f.lx >> 8) + 128);
+            report[7] = (uint8_t)((f.ly >> 8) + 128);
+            report[8] = (uint8_t)((f.rx >> 8) + 128);
+            report[9] = (uint8_t)((f.ry >> 8) + 128);
+            report[18] = f.lt;
+            report[19] = f.rt;
+            in->QueueReport(i * 1000, report, sizeof(report));
+        }
+        in->SetLoop(true, 1000);
+        return device;
+    }
+
+    std::unique_ptr<MockUSBDevice> CreateGenericHID(uint32_t frames)
+    {
+        auto device = std::make_unique<MockUSBDevice>(0x0079, 0x0006);
+        MockUSBInterface *interface = AddInterface(device.get(), USB_CLASS_HID, 0x00, 0x00, 0x81, 8, 1, 0, 0, 0);
+        MockUSBEndpoint *in = interface->GetMockEndpoint(IUSBEndpoint::USB_ENDPOINT_IN, 0);
+
+        const std::vector<uint8_t> &descriptor = MockDeviceFactory::GenericHIDReportDescriptor();
+        interface->AddControlResponse((uint8_t)USB_ENDPOINT_IN | (uint8_t)USB_RECIPIENT_INTERFACE, USB_REQUEST_GET_DESCRIPTOR, (USB_DT_REPORT << 8) | interface->GetDescriptor()->bInterfaceNumber, 0, descriptor.data(), descriptor.size());
+
+        for (uint32_t i = 0; i < frames; i++)
+        {
+            SyntheticFrame f = MakeFrame(i);
+            uint8_t report[7];
+            report[0] = (uint8_t)((f.lx >> 8) + 128);
+            report[1] = (uint8_t)((f.ly >> 8) + 128);
+            report[2] = (uint8_t)((f.rx >> 8) + 128);
+            report[3] = (uint8_t)((f.ry >> 8) + 128);
+            report[4] = f.hat;
+            PutLE16(&report[5], f.buttons);
+            in->QueueReport(i * 1000, report, sizeof(report));
+        }
+        in->SetLoop(true, 1000);
+        return device;
+    }
+} // namespace
+
+const std::vector<std::string> &MockDeviceFactory::Drivers()
+{
+    static const std::vector<std::string> drivers = {"xbox360", "xbox360w", "xboxone", "xbox", "dualshock3", "generic"};
+    return drivers;
+}
+
+std::unique_ptr<MockUSBDevice> MockDeviceFactory::CreateDevice(const std::string &driver, uint32_t frames)
+{
+    if (driver == "xbox360")
+        return CreateXbox360(frames);
+    else if (driver == "xbox360w")
+        return CreateXbox360Wireless(frames);
+    else if (driver == "xboxone")
+        return CreateXboxOne(frames);
+    else if (driver == "xbox")
+        return CreateXbox(frames);
+    else if (driver == "dualshock3")
+        return CreateDualshock3(frames);
+
+    return CreateGenericHID(frames);
+}
+
+std::unique_ptr<IController> MockDeviceFactory::CreateController(const std::string &driver, std::unique_ptr<IUSBDevice> &&device, const ControllerConfig &config, std::unique_ptr<ILogger> &&logger)
+{
+    // Same dispatch as syscon::usb UsbEventThreadFunc
+    if (driver == "dualshock3")
+        return std::make_unique<Dualshock3Controller>(std::move(device), config, std::move(logger));
+    else if (driver == "xbox360w")
+        return std::make_unique<Xbox360WirelessController>(std::move(device), config, std::move(logger));
+    else if (driver == "xbox360")
+        return std::make_unique<Xbox360Controller>(std::move(device), config, std::move(logger));
+    else if (driver == "xboxone")
+        return std::make_unique<XboxOneController>(std::move(device), config, std::move(logger));
+    else if (driver == "xbox")
+        return std::make_unique<XboxController>(std::move(device), config, std::move(logger));
+
+    return std::make_unique<GenericHIDController>(std::move(device), config, std::move(logger));
+}
+
+ControllerConfig MockDeviceFactory::DefaultConfig()
+{
+    ControllerConfig config;
+
+    config.buttons_pin[ControllerButton::B] = 1;
+    config.buttons_pin[ControllerButton::A] = 2;
+    config.buttons_pin[ControllerButton::X] = 3;
+    config.buttons_pin[ControllerButton::Y] = 4;
+    config.buttons_pin[ControllerButton::L] = 5;
+    config.buttons_pin[ControllerButton::R] = 6;
+    config.buttons_pin[ControllerButton::ZL] = 7;
+    config.buttons_pin[ControllerButton::ZR] = 8;
+    config.buttons_pin[ControllerButton::MINUS] = 9;
+    config.buttons_pin[ControllerButton::PLUS] = 10;
+    config.buttons_pin[ControllerButton::CAPTURE] = 11;
+    config.buttons_pin[ControllerButton::HOME] = 12;
+    config.buttons_pin[ControllerButton::LSTICK_CLICK] = 13;
+    config.buttons_pin[ControllerButton::RSTICK_CLICK] = 14;
+
+    config.stickDeadzonePercent[0] = config.stickDeadzonePercent[1] = 20;
+    config.triggerDeadzonePercent[0] = config.triggerDeadzonePercent[1] = 5;
+
+    config.stickConfig[0].X.bind = ControllerAnalogBinding_X;
+    config.stickConfig[0].Y.bind = ControllerAnalogBinding_Y;
+    config.stickConfig[1].X.bind = ControllerAnalogBinding_Z;
+    config.stickConfig[1].Y.bind = ControllerAnalogBinding_RZ;
+    config.triggerConfig[0].bind = ControllerAnalogBinding_RX;
+    config.triggerConfig[1].bind = ControllerAnalogBinding_RY;
+
+    return config;
+}
+
+const std::vector<uint8_t> &MockDeviceFactory::GenericHIDReportDescriptor()
+{
+    static const std::vector<uint8_t> descriptor = {
+        0x05, 0x01,       // Usage Page (Generic Desktop)
+        0x09, 0x05,       // Usage (Game Pad)
+        0xA1, 0x01,       // Collection (Application)
+        0x15, 0x00,       //   Logical Minimum (0)
+        0x26, 0xFF, 0x00, //   Logical Maximum (255)
+        0x75, 0x08,       //   Report Size (8)
+        0x95, 0x04,       //   Report Count (4)
+        0x09, 0x30,       //   Usage (X)
+        0x09, 0x31,       //   Usage (Y)
+        0x09, 0x32,       //   Usage (Z)
+        0x09, 0x35,       //   Usage (Rz)
+        0x81, 0x02,       //   Input (Data,Var,Abs)
+        0x25, 0x07,       //   Logical Maximum (7)
+        0x75, 0x04,       //   Report Size (4)
+        0x95, 0x01,       //   Report Count (1)
+        0x09, 0x39,       //   Usage (Hat switch)
+        0x81, 0x42,       //   Input (Data,Var,Abs,Null State)
+        0x81, 0x01,       //   Input (Const) - 4 bits padding
+        0x05, 0x09,       //   Usage Page (Button)
+        0x19, 0x01,       //   Usage Minimum (1)
+        0x29, 0x10,       //   Usage Maximum (16)
+        0x15, 0x00,       //   Logical Minimum (0)
+        0x25, 0x01,       //   Logical Maximum (1)
+        0x75, 0x01,       //   Report Size (1)
+        0x95, 0x10,       //   Report Count (16)
+        0x81, 0x02,       //   Input (Data,Var,Abs)
+        0xC0,             // End Collection
+    };
+    return descriptor;
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include "IController.h"
+#include "MockUSBDevice.h"
+#include <string>
+#include <vector>
+
+// Build scripted devices which look like the real controllers handled by ControllerLib.
+// Every device loops over 'frames' synthetic input reports sent at the endpoint bInterval.
+class MockDeviceFactory
+{
+public:
+    // Driver names, same values as the "driver" key of config.ini ("generic" for GenericHIDController)
+    static const std::vector<std::string> &Drivers();
+
+    static std::unique_ptr<MockUSBDevice> CreateDevice(const std::string &driver, uint32_t frames = 256);
+
+    static std::unique_ptr<IController> CreateController(const std::string &driver, std::unique_ptr<IUSBDevice> &&device, const ControllerConfig &config, std::unique_ptr<ILogger> &&logger);
+
+    // Same mapping as the one automatically added to config.ini for an unknown controller
+    static ControllerConfig DefaultConfig();
+
+    // HID report descriptor of the "generic" device (4 axis, 1 hat switch, 16 buttons - 7 bytes report)
+    static const std::vector<uint8_t> &GenericHIDReportDescriptor();
+};
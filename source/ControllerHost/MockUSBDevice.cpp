@@ -0,0 +1,111 @@
+#include "MockUSBDevice.h"
+
+MockUSBDevice::MockUSBDevice(uint16_t vendor, uint16_t product)
+    : m_clock(std::make_shared<MockUSBClock>())
+{
+    m_vendorID = vendor;
+    m_productID = product;
+}
+
+MockUSBDevice::~MockUSBDevice()
+{
+}
+
+ams::Result MockUSBDevice::Open()
+{
+    if (m_interfaces.size() == 0)
+        R_RETURN(CONTROL_ERR_NO_INTERFACES);
+
+    m_isOpen = true;
+    R_SUCCEED();
+}
+
+void MockUSBDevice::Close()
+{
+    for (auto &&interface : m_interfaces)
+        interface->Close();
+
+    m_isOpen = false;
+}
+
+void MockUSBDevice::Reset()
+{
+    if (m_interfaces.size() != 0)
+        m_interfaces[0]->Reset();
+}
+
+ams::Result MockUSBDevice::WaitForInput(IUSBEndpoint *const *endpoints, size_t count, size_t firstIndex, size_t maxSize, size_t *readyIndex, u64 aTimeoutUs)
+{
+    uint64_t first_us = UINT64_MAX;
+
+    (void)maxSize;
+
+    // Same order as the console: the first endpoint from firstIndex with a report already arrived, otherwise the first report to arrive
+    for (size_t i = 0; i < count; i++)
+    {
+        size_t idx = (firstIndex + i) % count;
+        uint64_t arrival_us;
+
+        if (!static_cast<MockUSBEndpoint *>(endpoints[idx])->GetNextArrival(&arrival_us))
+            continue;
+
+        if (arrival_us <= m_clock->Now())
+        {
+            *readyIndex = idx;
+            R_SUCCEED();
+        }
+
+        if (arrival_us < first_us)
+        {
+            first_us = arrival_us;
+            *readyIndex = idx;
+        }
+    }
+
+    if (first_us == UINT64_MAX || (aTimeoutUs != UINT64_MAX && first_us > m_clock->Now() + aTimeoutUs))
+    {
+        if (aTimeoutUs != UINT64_MAX)
+            m_clock->Advance(aTimeoutUs);
+        R_RETURN(MOCKUSB_RESULT_TIMEOUT);
+    }
+
+    m_clock->AdvanceTo(first_us);
+    R_SUCCEED();
+}
+
+MockUSBInterface *MockUSBDevice::AddInterface(uint8_t bInterfaceClass, uint8_t bInterfaceSubClass, uint8_t bInterfaceProtocol)
+{
+    IUSBInterface::InterfaceDescriptor descriptor{9, USB_DT_INTERFACE, (uint8_t)m_interfaces.size(), 0, 0, bInterfaceClass, bInterfaceSubClass, bInterfaceProtocol, 0};
+
+    m_interfaces.push_back(std::make_unique<MockUSBInterface>(descriptor, m_clock));
+    return static_cast<MockUSBInterface *>(m_interfaces.back().get());
+}
+
+MockUSBInterface *MockUSBDevice::GetMockInterface(size_t index)
+{
+    if (index >= m_interfaces.size())
+        return NULL;
+
+    return static_cast<MockUSBInterface *>(m_interfaces[index].get());
+}
+
+MockUSBEndpoint *MockUSBDevice::FindMockEndpoint(uint8_t address)
+{
+    IUSBEndpoint::Direction direction = (address & USB_ENDPOINT_IN) ? IUSBEndpoint::USB_ENDPOINT_IN : IUSBEndpoint::USB_ENDPOINT_OUT;
+
+    for (auto &&interface : m_interfaces)
+    {
+        MockUSBInterface *mockInterface = static_cast<MockUSBInterface *>(interface.get());
+        for (uint8_t idx = 0; idx < MOCK_USB_MAX_ENDPOINTS; idx++)
+        {
+            MockUSBEndpoint *endpoint = mockInterface->GetMockEndpoint(direction, idx);
+            if (endpoint == NULL)
+                break;
+
+            if (endpoint->GetDescriptor()->bEndpointAddress == address)
+                return endpoint;
+        }
+    }
+
+    return NULL;
+}
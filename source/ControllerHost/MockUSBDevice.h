@@ -0,0 +1,34 @@
+#pragma once
+#include "IUSBDevice.h"
+#include "MockUSBInterface.h"
+
+// Scripted USB device for the host build
+// Build it with AddInterface/AddEndpoint, queue IN reports with their arrival timestamp,
+// then give it to any driver like a SwitchUSBDevice.
+class MockUSBDevice : public IUSBDevice
+{
+private:
+    std::shared_ptr<MockUSBClock> m_clock;
+    bool m_isOpen = false;
+
+public:
+    MockUSBDevice(uint16_t vendor, uint16_t product);
+    ~MockUSBDevice();
+
+    // Same behavior as SwitchUSBDevice, success if there are any interfaces
+    virtual ams::Result Open() override;
+    virtual void Close() override;
+    virtual void Reset() override;
+
+    // The endpoint whose next scripted transfer arrives first, moves the clock to its arrival
+    virtual ams::Result WaitForInput(IUSBEndpoint *const *endpoints, size_t count, size_t firstIndex, size_t maxSize, size_t *readyIndex, u64 aTimeoutUs) override;
+
+    // Scripting API
+    MockUSBInterface *AddInterface(uint8_t bInterfaceClass, uint8_t bInterfaceSubClass, uint8_t bInterfaceProtocol);
+    MockUSBInterface *GetMockInterface(size_t index);
+    // Find an endpoint on any interface by its address (bEndpointAddress)
+    MockUSBEndpoint *FindMockEndpoint(uint8_t address);
+
+    inline MockUSBClock &GetClock() { return *m_clock; }
+    inline bool IsOpen() const { return m_isOpen; }
+};
@@ -0,0 +1,285 @@
+#include "MockUSBEndpoint.h"
+#include "ControllerTypes.h"
+#include <cstring>
+
+MockUSBEndpoint::MockUSBEndpoint(const EndpointDescriptor &descriptor, std::shared_ptr<MockUSBClock> clock)
+    : m_descriptor(descriptor),
+      m_clock(clock)
+{
+}
+
+MockUSBEndpoint::~MockUSBEndpoint()
+{
+}
+
+ams::Result MockUSBEndpoint::Open(int maxPacketSize)
+{
+    (void)maxPacketSize;
+
+    R_TRY(m_openResult);
+
+    m_isOpen = true;
+    R_SUCCEED();
+}
+
+void MockUSBEndpoint::Close()
+{
+    // Like the console, what is still queued is sent before closing
+    SendQueuedWrites(UINT64_MAX);
+    m_isOpen = false;
+}
+
+ams::Result MockUSBEndpoint::Write(const uint8_t *inBuffer, size_t bufferSize)
+{
+    if (!m_isOpen || GetDirection() == USB_ENDPOINT_IN)
+        R_RETURN(CONTROL_ERR_INVALID_ENDPOINT);
+
+    R_TRY(m_writeResult);
+
+    // Same order and pacing as SwitchUSBEndpoint::Write
+    SendQueuedWrites(UINT64_MAX);
+    m_clock->AdvanceTo(m_outNextFree_us);
+
+    RecordWrite(m_clock->Now(), inBuffer, bufferSize);
+    m_outNextFree_us = m_clock->Now() + m_descriptor.bInterval * 1000;
+
+    R_SUCCEED();
+}
+
+ams::Result MockUSBEndpoint::QueueWrite(const uint8_t *inBuffer, size_t bufferSize, OutputKey key)
+{
+    if (!m_isOpen || GetDirection() == USB_ENDPOINT_IN)
+        R_RETURN(CONTROL_ERR_INVALID_ENDPOINT);
+
+    R_TRY(m_writeResult);
+
+    SendQueuedWrites(m_clock->Now());
+
+    QueuedWrite *entry = NULL;
+    for (size_t i = 0; key != OUTPUT_KEY_NONE && i < m_outQueue.size(); i++)
+    {
+        if (m_outQueue[i].key == key)
+        {
+            entry = &m_outQueue[i];
+            m_outputStats.coalesced++;
+            break;
+        }
+    }
+
+    if (entry == NULL)
+    {
+        if (m_outQueue.size() == MOCKUSB_OUTPUT_QUEUE_SIZE)
+        {
+            m_outputStats.dropped++;
+            R_RETURN(CONTROL_ERR_OUT_OF_MEMORY);
+        }
+
+        m_outQueue.push_back(QueuedWrite{0, key, {}});
+        entry = &m_outQueue.back();
+    }
+
+    entry->queued_us = m_clock->Now();
+    entry->data.assign(inBuffer, inBuffer + bufferSize);
+
+    m_outputStats.queued++;
+    m_outputStats.depth = m_outQueue.size();
+    m_outputStats.depthMax = std::max<uint32_t>(m_outputStats.depthMax, m_outQueue.size());
+
+    R_SUCCEED();
+}
+
+void MockUSBEndpoint::RecordWrite(uint64_t timestamp_us, const uint8_t *data, size_t size)
+{
+    m_writeCount++;
+    if (m_recordWrites)
+        m_writes.push_back(MockUSBTransfer{timestamp_us, 0, std::vector<uint8_t>(data, data + size)});
+}
+
+void MockUSBEndpoint::SendQueuedWrites(uint64_t until_us)
+{
+    while (!m_outQueue.empty())
+    {
+        QueuedWrite &entry = m_outQueue.front();
+        uint64_t send_us = std::max(entry.queued_us, m_outNextFree_us);
+        if (send_us > until_us)
+            break;
+
+        RecordWrite(send_us, entry.data.data(), entry.data.size());
+        m_outNextFree_us = send_us + m_descriptor.bInterval * 1000;
+
+        m_outputStats.sent++;
+        m_outputStats.latencyTotal_us += send_us - entry.queued_us;
+        m_outputStats.latencyMax_us = std::max(m_outputStats.latencyMax_us, send_us - entry.queued_us);
+
+        m_outQueue.erase(m_outQueue.begin());
+        m_outputStats.depth = m_outQueue.size();
+    }
+}
+
+ams::Result MockUSBEndpoint::NextTransfer(u64 aTimeoutUs, const ScriptedTransfer **outTransfer)
+{
+    if (!m_isOpen || GetDirection() == USB_ENDPOINT_OUT)
+        R_RETURN(CONTROL_ERR_INVALID_ENDPOINT);
+
+    if (m_cursor >= m_script.size())
+    {
+        if (!m_loop || m_script.empty())
+        {
+            if (aTimeoutUs != UINT64_MAX)
+                m_clock->Advance(aTimeoutUs);
+            R_RETURN(MOCKUSB_RESULT_TIMEOUT);
+        }
+
+        m_loopOffset_us += m_script.back().timestamp_us - m_script.front().timestamp_us + m_loopPeriod_us;
+        m_cursor = 0;
+    }
+
+    // Reports replaced by a newer one before this read (Within the current replay of the script)
+    while (m_latestOnly && m_cursor + 1 < m_script.size() && m_loopOffset_us + m_script[m_cursor + 1].timestamp_us <= m_clock->Now())
+    {
+        m_cursor++;
+        m_overwrittenCount++;
+    }
+
+    const ScriptedTransfer &transfer = m_script[m_cursor];
+    uint64_t arrival_us = m_loopOffset_us + transfer.timestamp_us;
+
+    if (aTimeoutUs != UINT64_MAX && arrival_us > m_clock->Now() + aTimeoutUs)
+    {
+        m_clock->Advance(aTimeoutUs);
+        R_RETURN(MOCKUSB_RESULT_TIMEOUT);
+    }
+
+    m_clock->AdvanceTo(arrival_us);
+    m_cursor++;
+    m_readCount++;
+    m_lastArrival_us = arrival_us;
+
+    *outTransfer = &transfer;
+    R_RETURN(transfer.result);
+}
+
+bool MockUSBEndpoint::GetNextArrival(uint64_t *arrival_us) const
+{
+    if (!m_isOpen || !(m_descriptor.bEndpointAddress & USB_ENDPOINT_IN) || m_script.empty())
+        return false;
+
+    if (m_cursor < m_script.size())
+    {
+        *arrival_us = m_loopOffset_us + m_script[m_cursor].timestamp_us;
+        return true;
+    }
+
+    if (!m_loop)
+        return false;
+
+    // First transfer of the next replay (See NextTransfer)
+    *arrival_us = m_loopOffset_us + m_script.back().timestamp_us + m_loopPeriod_us;
+    return true;
+}
+
+ams::Result MockUSBEndpoint::Read(uint8_t *outBuffer, size_t *bufferSizeInOut, u64 aTimeoutUs)
+{
+    const ScriptedTransfer *transfer = NULL;
+
+    ams::Result rc = NextTransfer(aTimeoutUs, &transfer);
+    if (R_FAILED(rc))
+    {
+        *bufferSizeInOut = 0;
+        R_RETURN(rc);
+    }
+
+    size_t size = std::min<size_t>(*bufferSizeInOut, transfer->length);
+    memcpy(outBuffer, m_scriptData->data() + transfer->offset, size);
+    *bufferSizeInOut = size;
+
+    m_readStats.reports++;
+    m_readStats.copies++;
+    m_readStats.copiedBytes += size;
+
+    if (size == 0)
+        R_RETURN(CONTROL_ERR_NO_DATA_AVAILABLE);
+
+    R_SUCCEED();
+}
+
+ams::Result MockUSBEndpoint::AcquireReadView(const uint8_t **outData, size_t *sizeInOut, u64 aTimeoutUs)
+{
+    const ScriptedTransfer *transfer = NULL;
+
+    *outData = NULL;
+
+    // Same contract as the console: the previous view must be released first
+    if (m_viewHeld)
+        R_RETURN(CONTROL_ERR_INVALID_ARGUMENT);
+
+    ams::Result rc = NextTransfer(aTimeoutUs, &transfer);
+    if (R_FAILED(rc))
+    {
+        *sizeInOut = 0;
+        R_RETURN(rc);
+    }
+
+    *sizeInOut = std::min<size_t>(*sizeInOut, transfer->length);
+    m_readStats.reports++;
+
+    if (*sizeInOut == 0)
+        R_RETURN(CONTROL_ERR_NO_DATA_AVAILABLE);
+
+    *outData = m_scriptData->data() + transfer->offset;
+    m_viewHeld = true;
+    R_SUCCEED();
+}
+
+void MockUSBEndpoint::ReleaseReadView()
+{
+    m_viewHeld = false;
+}
+
+IUSBEndpoint::Direction MockUSBEndpoint::GetDirection()
+{
+    return ((m_descriptor.bEndpointAddress & USB_ENDPOINT_IN) ? USB_ENDPOINT_IN : USB_ENDPOINT_OUT);
+}
+
+IUSBEndpoint::EndpointDescriptor *MockUSBEndpoint::GetDescriptor()
+{
+    return &m_descriptor;
+}
+
+void MockUSBEndpoint::QueueReport(uint64_t timestamp_us, const uint8_t *data, size_t size)
+{
+    if (m_scriptData == NULL)
+        m_scriptData = std::make_shared<MockUSBScriptData>(CONTROLLER_INPUT_BUFFER_SIZE, 0);
+
+    // Written over the trailing zeros, which are added again after the report
+    size_t offset = m_scriptData->size() - CONTROLLER_INPUT_BUFFER_SIZE;
+    m_scriptData->resize(offset + size + CONTROLLER_INPUT_BUFFER_SIZE, 0);
+    memcpy(m_scriptData->data() + offset, data, size);
+    memset(m_scriptData->data() + offset + size, 0, CONTROLLER_INPUT_BUFFER_SIZE);
+
+    m_script.push_back(ScriptedTransfer{timestamp_us, offset, 0, (uint32_t)size});
+}
+
+void MockUSBEndpoint::QueueReport(uint64_t timestamp_us, std::shared_ptr<MockUSBScriptData> data, size_t offset, size_t size)
+{
+    // A single data per endpoint: the report is copied if reports of another data were already queued
+    if (m_scriptData != NULL && m_scriptData != data)
+    {
+        QueueReport(timestamp_us, data->data() + offset, size);
+        return;
+    }
+
+    m_scriptData = std::move(data);
+    m_script.push_back(ScriptedTransfer{timestamp_us, offset, 0, (uint32_t)size});
+}
+
+void MockUSBEndpoint::QueueError(uint64_t timestamp_us, ams::Result rc)
+{
+    m_script.push_back(ScriptedTransfer{timestamp_us, 0, rc, 0});
+}
+
+void MockUSBEndpoint::SetLoop(bool loop, uint64_t period_us)
+{
+    m_loop = loop;
+    m_loopPeriod_us = period_us;
+}
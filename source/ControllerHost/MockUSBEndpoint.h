@@ -0,0 +1,147 @@
+#pragma once
+#include "IUSBEndpoint.h"
+#include <memory>
+#include <vector>
+
+// Result returned when nothing arrived before the timeout (Same value as KERNELRESULT(TimedOut) on the switch)
+#define MOCKUSB_RESULT_TIMEOUT 0xEA01
+// Result returned by a control transfer without scripted response (The device would STALL the request)
+#define MOCKUSB_RESULT_STALL 0xCC8C
+// Same output queue size as SWITCH_USB_OUTPUT_QUEUE_SIZE
+#define MOCKUSB_OUTPUT_QUEUE_SIZE 8
+
+// Virtual time shared by every endpoint of a mock device (in microseconds)
+// Reads never sleep, they move the clock forward, so a benchmark runs at full CPU speed
+// while connect time and report timings are still reported in device time.
+class MockUSBClock
+{
+private:
+    uint64_t m_now_us = 0;
+
+public:
+    inline uint64_t Now() const { return m_now_us; }
+    inline void Advance(uint64_t us) { m_now_us += us; }
+    inline void AdvanceTo(uint64_t us) { m_now_us = std::max(m_now_us, us); }
+};
+
+struct MockUSBTransfer
+{
+    uint64_t timestamp_us;
+    ams::Result result;
+    std::vector<uint8_t> data;
+};
+
+// Data of the scripted IN transfers, every report one after the other. Followed by CONTROLLER_INPUT_BUFFER_SIZE zeros:
+// a read view can always be read as a full transfer buffer, the bytes past a report are the ones of the next report
+// (Like a transfer buffer reused on the console). Can be shared by the endpoints of a device (See USBPcapImporter).
+typedef std::vector<uint8_t> MockUSBScriptData;
+
+class MockUSBEndpoint : public IUSBEndpoint
+{
+private:
+    EndpointDescriptor m_descriptor;
+    std::shared_ptr<MockUSBClock> m_clock;
+    bool m_isOpen = false;
+
+    // Scripted IN transfers, consumed in order
+    struct ScriptedTransfer
+    {
+        uint64_t timestamp_us;
+        size_t offset; // In m_scriptData
+        ams::Result result;
+        uint32_t length;
+    };
+    std::vector<ScriptedTransfer> m_script;
+    std::shared_ptr<MockUSBScriptData> m_scriptData;
+    size_t m_cursor = 0;
+    bool m_loop = false;
+    uint64_t m_loopOffset_us = 0;
+    uint64_t m_loopPeriod_us = 0;
+
+    // OUT transfers received from the driver
+    std::vector<MockUSBTransfer> m_writes;
+    bool m_recordWrites = true;
+
+    // Writes queued by QueueWrite, each one is sent at max(queue time, previous write + bInterval)
+    struct QueuedWrite
+    {
+        uint64_t queued_us;
+        OutputKey key;
+        std::vector<uint8_t> data;
+    };
+    std::vector<QueuedWrite> m_outQueue;
+    uint64_t m_outNextFree_us = 0;
+
+    ams::Result m_openResult = 0;
+    ams::Result m_writeResult = 0;
+
+    uint64_t m_readCount = 0;
+    uint64_t m_writeCount = 0;
+    uint64_t m_lastArrival_us = 0;
+    bool m_latestOnly = false;
+    uint64_t m_overwrittenCount = 0;
+    bool m_viewHeld = false;
+
+    ams::Result NextTransfer(u64 aTimeoutUs, const ScriptedTransfer **transfer);
+    void RecordWrite(uint64_t timestamp_us, const uint8_t *data, size_t size);
+    void SendQueuedWrites(uint64_t until_us);
+
+public:
+    MockUSBEndpoint(const EndpointDescriptor &descriptor, std::shared_ptr<MockUSBClock> clock);
+    ~MockUSBEndpoint();
+
+    virtual ams::Result Open(int maxPacketSize = 0) override;
+    virtual void Close() override;
+
+    // OUT transfers are recorded, a write waits for the queued ones and for bInterval ms after the previous one
+    virtual ams::Result Write(const uint8_t *inBuffer, size_t bufferSize) override;
+
+    // Doesn't take any device time, the write is recorded when the output thread of the console would have sent it
+    virtual ams::Result QueueWrite(const uint8_t *inBuffer, size_t bufferSize, OutputKey key = OUTPUT_KEY_NONE) override;
+
+    // Return the next scripted transfer if it arrives within aTimeoutUs, otherwise MOCKUSB_RESULT_TIMEOUT
+    virtual ams::Result Read(uint8_t *outBuffer, size_t *bufferSizeInOut, u64 aTimeoutUs) override;
+
+    // Same as Read, the view points to the scripted data
+    virtual ams::Result AcquireReadView(const uint8_t **outData, size_t *sizeInOut, u64 aTimeoutUs) override;
+    virtual void ReleaseReadView() override;
+
+    virtual IUSBEndpoint::Direction GetDirection() override;
+    virtual EndpointDescriptor *GetDescriptor() override;
+
+    // Scripting API
+    void QueueReport(uint64_t timestamp_us, const uint8_t *data, size_t size);
+    // Same without copy: the report is at offset in data, shared with its owner (See MockUSBScriptData)
+    void QueueReport(uint64_t timestamp_us, std::shared_ptr<MockUSBScriptData> data, size_t offset, size_t size);
+    void QueueError(uint64_t timestamp_us, ams::Result rc);
+    // Replay the script forever, each replay is shifted by the script duration + period_us
+    void SetLoop(bool loop, uint64_t period_us);
+    void InjectOpenError(ams::Result rc) { m_openResult = rc; }
+    void InjectWriteError(ams::Result rc) { m_writeResult = rc; }
+    // Like most HID devices, only keep the latest report while no transfer is posted: a read returns the newest report
+    // already arrived and the older ones are lost (Default: every report is kept and returned in order)
+    void SetLatestOnly(bool latestOnly) { m_latestOnly = latestOnly; }
+    // Disable the OUT history (i.e: for long benchmarks)
+    void SetRecordWrites(bool record) { m_recordWrites = record; }
+
+    inline bool IsOpen() const { return m_isOpen; }
+    // Record the queued writes sent by now (See QueueWrite), GetWrites and GetWriteCount call it
+    inline void UpdateOutput() { SendQueuedWrites(m_clock->Now()); }
+    inline const std::vector<MockUSBTransfer> &GetWrites()
+    {
+        UpdateOutput();
+        return m_writes;
+    }
+    inline uint64_t GetReadCount() const { return m_readCount; }
+    inline uint64_t GetWriteCount()
+    {
+        UpdateOutput();
+        return m_writeCount;
+    }
+    // Arrival time of the last transfer returned by Read (i.e: to measure how long a report waited)
+    inline uint64_t GetLastArrival() const { return m_lastArrival_us; }
+    inline uint64_t GetOverwrittenCount() const { return m_overwrittenCount; }
+    // Arrival time of the next scripted IN transfer, false if there is none (See MockUSBDevice::WaitForInput)
+    bool GetNextArrival(uint64_t *arrival_us) const;
+    inline size_t GetPendingCount() const { return m_loop ? SIZE_MAX : m_script.size() - m_cursor; }
+};
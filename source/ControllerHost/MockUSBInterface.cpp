@@ -0,0 +1,118 @@
+#include "MockUSBInterface.h"
+#include <cstring>
+
+MockUSBInterface::MockUSBInterface(const InterfaceDescriptor &descriptor, std::shared_ptr<MockUSBClock> clock)
+    : m_descriptor(descriptor),
+      m_clock(clock)
+{
+}
+
+MockUSBInterface::~MockUSBInterface()
+{
+}
+
+ams::Result MockUSBInterface::Open()
+{
+    R_TRY(m_openResult);
+
+    m_isOpen = true;
+    R_SUCCEED();
+}
+
+void MockUSBInterface::Close()
+{
+    for (auto &&endpoint : m_inEndpoints)
+        endpoint->Close();
+    for (auto &&endpoint : m_outEndpoints)
+        endpoint->Close();
+
+    m_isOpen = false;
+}
+
+const MockUSBControlTransfer *MockUSBInterface::FindControlResponse(uint8_t bmRequestType, uint8_t bmRequest, uint16_t wValue, uint16_t wIndex) const
+{
+    for (const MockUSBControlTransfer &response : m_controlResponses)
+    {
+        if (response.bmRequestType == bmRequestType && response.bmRequest == bmRequest && response.wValue == wValue && response.wIndex == wIndex)
+            return &response;
+    }
+
+    return NULL;
+}
+
+ams::Result MockUSBInterface::ControlTransferInput(uint8_t bmRequestType, uint8_t bmRequest, uint16_t wValue, uint16_t wIndex, void *buffer, uint16_t *wLength)
+{
+    if (!(bmRequestType & USB_ENDPOINT_IN))
+        R_RETURN(CONTROL_ERR_INVALID_ARGUMENT);
+
+    m_controlHistory.push_back(MockUSBControlTransfer{bmRequestType, bmRequest, wValue, wIndex, 0, {}});
+
+    const MockUSBControlTransfer *response = FindControlResponse(bmRequestType, bmRequest, wValue, wIndex);
+    if (response == NULL)
+        R_RETURN(MOCKUSB_RESULT_STALL);
+
+    R_TRY(response->result);
+
+    if (buffer == NULL || *wLength < response->data.size())
+        R_RETURN(CONTROL_ERR_INVALID_ARGUMENT);
+
+    memcpy(buffer, response->data.data(), response->data.size());
+    *wLength = response->data.size();
+
+    R_SUCCEED();
+}
+
+ams::Result MockUSBInterface::ControlTransferOutput(uint8_t bmRequestType, uint8_t bmRequest, uint16_t wValue, uint16_t wIndex, const void *buffer, uint16_t wLength)
+{
+    if (bmRequestType & USB_ENDPOINT_IN)
+        R_RETURN(CONTROL_ERR_INVALID_ARGUMENT);
+
+    const uint8_t *data = static_cast<const uint8_t *>(buffer);
+    m_controlHistory.push_back(MockUSBControlTransfer{bmRequestType, bmRequest, wValue, wIndex, 0, std::vector<uint8_t>(data, data + (buffer != NULL ? wLength : 0))});
+
+    const MockUSBControlTransfer *response = FindControlResponse(bmRequestType, bmRequest, wValue, wIndex);
+    if (response != NULL)
+        R_RETURN(response->result);
+
+    R_SUCCEED();
+}
+
+IUSBEndpoint *MockUSBInterface::GetEndpoint(IUSBEndpoint::Direction direction, uint8_t index)
+{
+    return GetMockEndpoint(direction, index);
+}
+
+MockUSBEndpoint *MockUSBInterface::GetMockEndpoint(IUSBEndpoint::Direction direction, uint8_t index)
+{
+    std::vector<std::unique_ptr<MockUSBEndpoint>> &endpoints = (direction == IUSBEndpoint::USB_ENDPOINT_IN) ? m_inEndpoints : m_outEndpoints;
+
+    if (index >= endpoints.size())
+        return NULL;
+
+    return endpoints[index].get();
+}
+
+ams::Result MockUSBInterface::Reset()
+{
+    m_resetCount++;
+    R_SUCCEED();
+}
+
+MockUSBEndpoint *MockUSBInterface::AddEndpoint(uint8_t bEndpointAddress, uint16_t wMaxPacketSize, uint8_t bInterval, uint8_t bmAttributes)
+{
+    IUSBEndpoint::EndpointDescriptor descriptor{7, USB_DT_ENDPOINT, bEndpointAddress, bmAttributes, wMaxPacketSize, bInterval};
+
+    std::vector<std::unique_ptr<MockUSBEndpoint>> &endpoints = (bEndpointAddress & USB_ENDPOINT_IN) ? m_inEndpoints : m_outEndpoints;
+    if (endpoints.size() >= MOCK_USB_MAX_ENDPOINTS)
+        return NULL;
+
+    endpoints.push_back(std::make_unique<MockUSBEndpoint>(descriptor, m_clock));
+    m_descriptor.bNumEndpoints++;
+
+    return endpoints.back().get();
+}
+
+void MockUSBInterface::AddControlResponse(uint8_t bmRequestType, uint8_t bmRequest, uint16_t wValue, uint16_t wIndex, const uint8_t *data, size_t size, ams::Result result)
+{
+    m_controlResponses.push_back(MockUSBControlTransfer{bmRequestType, bmRequest, wValue, wIndex, result, std::vector<uint8_t>(data, data + size)});
+}
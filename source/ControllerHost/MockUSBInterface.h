@@ -0,0 +1,63 @@
+#pragma once
+#include "IUSBInterface.h"
+#include "MockUSBEndpoint.h"
+#include <memory>
+#include <vector>
+
+#define MOCK_USB_MAX_ENDPOINTS 15
+
+struct MockUSBControlTransfer
+{
+    uint8_t bmRequestType;
+    uint8_t bmRequest;
+    uint16_t wValue;
+    uint16_t wIndex;
+    ams::Result result;
+    std::vector<uint8_t> data;
+};
+
+class MockUSBInterface : public IUSBInterface
+{
+private:
+    InterfaceDescriptor m_descriptor;
+    std::shared_ptr<MockUSBClock> m_clock;
+    std::vector<std::unique_ptr<MockUSBEndpoint>> m_inEndpoints;
+    std::vector<std::unique_ptr<MockUSBEndpoint>> m_outEndpoints;
+
+    // Scripted answers (Input) or injected results (Output), matched on the setup packet
+    std::vector<MockUSBControlTransfer> m_controlResponses;
+    // Control transfers sent by the driver
+    std::vector<MockUSBControlTransfer> m_controlHistory;
+
+    ams::Result m_openResult = 0;
+    bool m_isOpen = false;
+    uint32_t m_resetCount = 0;
+
+    const MockUSBControlTransfer *FindControlResponse(uint8_t bmRequestType, uint8_t bmRequest, uint16_t wValue, uint16_t wIndex) const;
+
+public:
+    MockUSBInterface(const InterfaceDescriptor &descriptor, std::shared_ptr<MockUSBClock> clock);
+    ~MockUSBInterface();
+
+    virtual ams::Result Open() override;
+    virtual void Close() override;
+
+    virtual ams::Result ControlTransferInput(uint8_t bmRequestType, uint8_t bmRequest, uint16_t wValue, uint16_t wIndex, void *buffer, uint16_t *wLength) override;
+    virtual ams::Result ControlTransferOutput(uint8_t bmRequestType, uint8_t bmRequest, uint16_t wValue, uint16_t wIndex, const void *buffer, uint16_t wLength) override;
+
+    // Endpoints are indexed per direction, in the order they have been added (Same as the switch descriptors arrays)
+    virtual IUSBEndpoint *GetEndpoint(IUSBEndpoint::Direction direction, uint8_t index) override;
+    virtual InterfaceDescriptor *GetDescriptor() override { return &m_descriptor; }
+
+    virtual ams::Result Reset() override;
+
+    // Scripting API
+    MockUSBEndpoint *AddEndpoint(uint8_t bEndpointAddress, uint16_t wMaxPacketSize, uint8_t bInterval, uint8_t bmAttributes = 0x03);
+    void AddControlResponse(uint8_t bmRequestType, uint8_t bmRequest, uint16_t wValue, uint16_t wIndex, const uint8_t *data, size_t size, ams::Result result = 0);
+    void InjectOpenError(ams::Result rc) { m_openResult = rc; }
+
+    MockUSBEndpoint *GetMockEndpoint(IUSBEndpoint::Direction direction, uint8_t index);
+    inline const std::vector<MockUSBControlTransfer> &GetControlHistory() const { return m_controlHistory; }
+    inline bool IsOpen() const { return m_isOpen; }
+    inline uint32_t GetResetCount() const { return m_resetCount; }
+};
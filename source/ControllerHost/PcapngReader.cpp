@@ -0,0 +1,177 @@
+#include "PcapngReader.h"
+#include <cstring>
+
+#define PCAPNG_BLOCK_SECTION_HEADER       0x0A0D0D0A
+#define PCAPNG_BLOCK_INTERFACE            0x00000001
+#define PCAPNG_BLOCK_ENHANCED_PACKET      0x00000006
+#define PCAPNG_BYTE_ORDER_MAGIC           0x1A2B3C4D
+#define PCAPNG_OPTION_END                 0
+#define PCAPNG_OPTION_IF_TSRESOL          9
+#define PCAPNG_MAX_BLOCK_SIZE             (16 * 1024 * 1024)
+
+namespace
+{
+    inline uint16_t ReadLE16(const uint8_t *p)
+    {
+        return p[0] | (p[1] << 8);
+    }
+
+    inline uint32_t ReadLE32(const uint8_t *p)
+    {
+        return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+    }
+} // namespace
+
+PcapngReader::PcapngReader()
+{
+}
+
+PcapngReader::~PcapngReader()
+{
+    Close();
+}
+
+bool PcapngReader::Open(const char *path)
+{
+    Close();
+
+    m_file = fopen(path, "rb");
+    if (m_file == NULL)
+    {
+        m_error = std::string("Unable to open ") + path;
+        return false;
+    }
+
+    m_interfaces.clear();
+    m_error.clear();
+    m_bytesRead = 0;
+    return true;
+}
+
+void PcapngReader::Close()
+{
+    if (m_file != NULL)
+        fclose(m_file);
+    m_file = NULL;
+}
+
+// Read a whole block, m_block contains the block body (without type, lengths)
+bool PcapngReader::ReadBlock(uint32_t *type)
+{
+    uint8_t header[8];
+
+    if (fread(header, sizeof(header), 1, m_file) != 1)
+        return false; // End of file
+
+    *type = ReadLE32(&header[0]);
+    uint32_t totalLength = ReadLE32(&header[4]);
+
+    if (totalLength < 12 || totalLength > PCAPNG_MAX_BLOCK_SIZE || (totalLength % 4) != 0)
+    {
+        m_error = "Invalid block length (corrupted or big endian capture)";
+        return false;
+    }
+
+    m_block.resize(totalLength - 8);
+    if (fread(m_block.data(), m_block.size(), 1, m_file) != 1)
+    {
+        m_error = "Truncated block at the end of the capture";
+        return false;
+    }
+
+    m_bytesRead += totalLength;
+
+    if (ReadLE32(&m_block[m_block.size() - 4]) != totalLength)
+    {
+        m_error = "Block length mismatch (corrupted capture)";
+        return false;
+    }
+
+    // Drop the trailing length
+    m_block.resize(m_block.size() - 4);
+    return true;
+}
+
+void PcapngReader::ParseInterfaceDescription()
+{
+    Interface interface{0, 1000000};
+
+    if (m_block.size() >= 8)
+    {
+        interface.linkType = ReadLE16(&m_block[0]);
+
+        size_t offset = 8;
+        while (offset + 4 <= m_block.size())
+        {
+            uint16_t code = ReadLE16(&m_block[offset]);
+            uint16_t length = ReadLE16(&m_block[offset + 2]);
+            offset += 4;
+
+            if (code == PCAPNG_OPTION_END || offset + length > m_block.size())
+                break;
+
+            if (code == PCAPNG_OPTION_IF_TSRESOL && length >= 1)
+            {
+                uint8_t resolution = m_block[offset];
+                uint64_t ticksPerSecond = 1;
+                for (int i = 0; i < (resolution & 0x7F) && ticksPerSecond < (UINT64_MAX / 10); i++)
+                    ticksPerSecond *= (resolution & 0x80) ? 2 : 10;
+                interface.ticksPerSecond = ticksPerSecond;
+            }
+
+            offset += (length + 3) & ~3;
+        }
+    }
+
+    m_interfaces.push_back(interface);
+}
+
+bool PcapngReader::Next(PcapngPacket *packet)
+{
+    uint32_t type;
+
+    if (m_file == NULL)
+        return false;
+
+    while (ReadBlock(&type))
+    {
+        if (type == PCAPNG_BLOCK_SECTION_HEADER)
+        {
+            if (m_block.size() < 4 || ReadLE32(&m_block[0]) != PCAPNG_BYTE_ORDER_MAGIC)
+            {
+                m_error = "Unsupported section (big endian capture)";
+                return false;
+            }
+
+            // Interface IDs are local to a section
+            m_interfaces.clear();
+        }
+        else if (type == PCAPNG_BLOCK_INTERFACE)
+        {
+            ParseInterfaceDescription();
+        }
+        else if (type == PCAPNG_BLOCK_ENHANCED_PACKET && m_block.size() >= 20)
+        {
+            packet->interfaceId = ReadLE32(&m_block[0]);
+            if (packet->interfaceId >= m_interfaces.size())
+                continue;
+
+            const Interface &interface = m_interfaces[packet->interfaceId];
+            uint64_t timestamp = ((uint64_t)ReadLE32(&m_block[4]) << 32) | ReadLE32(&m_block[8]);
+
+            packet->linkType = interface.linkType;
+            packet->timestamp_us = (interface.ticksPerSecond == 1000000) ? timestamp : (uint64_t)((double)timestamp * 1000000.0 / interface.ticksPerSecond);
+            packet->capturedLength = ReadLE32(&m_block[12]);
+            packet->originalLength = ReadLE32(&m_block[16]);
+            packet->data = &m_block[20];
+
+            if (20 + (size_t)packet->capturedLength > m_block.size())
+                packet->capturedLength = m_block.size() - 20;
+
+            return true;
+        }
+        // Any other block (Name resolution, statistics, simple packet ...) is ignored
+    }
+
+    return false;
+}
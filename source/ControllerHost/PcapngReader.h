@@ -0,0 +1,56 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Streaming reader for pcapng files (https://www.ietf.org/archive/id/draft-tuexen-opsawg-pcapng-05.html)
+// Only one block is kept in memory at a time, so captures of any size can be processed.
+// Only little endian sections are supported (Every capture made with Wireshark on a PC)
+
+#define PCAPNG_LINKTYPE_USB_LINUX         189
+#define PCAPNG_LINKTYPE_USB_LINUX_MMAPPED 220
+#define PCAPNG_LINKTYPE_USBPCAP           249
+
+struct PcapngPacket
+{
+    uint32_t interfaceId;
+    uint16_t linkType;
+    uint64_t timestamp_us;
+    const uint8_t *data; // Valid until the next call to PcapngReader::Next
+    uint32_t capturedLength;
+    uint32_t originalLength;
+};
+
+class PcapngReader
+{
+private:
+    struct Interface
+    {
+        uint16_t linkType;
+        // Timestamp resolution: ticks per second
+        uint64_t ticksPerSecond;
+    };
+
+    FILE *m_file = NULL;
+    std::vector<uint8_t> m_block;
+    std::vector<Interface> m_interfaces;
+    std::string m_error;
+    uint64_t m_bytesRead = 0;
+
+    bool ReadBlock(uint32_t *type);
+    void ParseInterfaceDescription();
+
+public:
+    PcapngReader();
+    ~PcapngReader();
+
+    bool Open(const char *path);
+    void Close();
+
+    // Return the next packet (Enhanced Packet Block), false at the end of the file or on error (See GetError)
+    bool Next(PcapngPacket *packet);
+
+    inline const std::string &GetError() const { return m_error; }
+    inline uint64_t GetBytesRead() const { return m_bytesRead; }
+};
@@ -0,0 +1,330 @@
+#include "USBPcapImporter.h"
+#include "ControllerTypes.h"
+#include <algorithm>
+#include <cstring>
+
+#define USBPCAP_HEADER_MIN_SIZE    27
+#define USBPCAP_INFO_PDO_TO_FDO    0x01
+#define USBPCAP_CONTROL_STAGE_SETUP 0
+
+#define USBMON_HEADER_SIZE         48
+#define USBMON_MMAPPED_HEADER_SIZE 64
+
+#define USB_TRANSFER_CONTROL 2
+
+namespace
+{
+    inline uint16_t ReadLE16(const uint8_t *p)
+    {
+        return p[0] | (p[1] << 8);
+    }
+
+    inline uint32_t ReadLE32(const uint8_t *p)
+    {
+        return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+    }
+
+    inline uint64_t ReadLE64(const uint8_t *p)
+    {
+        return ReadLE32(p) | ((uint64_t)ReadLE32(p + 4) << 32);
+    }
+} // namespace
+
+USBPcapImporter::USBPcapImporter(uint16_t vendor, uint16_t product)
+    : m_vendor(vendor),
+      m_product(product),
+      m_reportData(std::make_shared<MockUSBScriptData>())
+{
+}
+
+void USBPcapImporter::SetDeviceAddress(int bus, int device)
+{
+    m_bus = bus;
+    m_device = device;
+    m_deviceFound = true;
+}
+
+bool USBPcapImporter::DecodePacket(const PcapngPacket &packet, UsbPcapTransfer *transfer)
+{
+    const uint8_t *p = packet.data;
+    memset(transfer, 0, sizeof(UsbPcapTransfer));
+    transfer->timestamp_us = packet.timestamp_us;
+
+    if (packet.linkType == PCAPNG_LINKTYPE_USBPCAP)
+    {
+        if (packet.capturedLength < USBPCAP_HEADER_MIN_SIZE)
+            return false;
+
+        uint16_t headerLength = ReadLE16(&p[0]);
+        if (headerLength < USBPCAP_HEADER_MIN_SIZE || headerLength > packet.capturedLength)
+            return false;
+
+        transfer->id = ReadLE64(&p[2]);
+        transfer->status = ReadLE32(&p[10]);
+        transfer->completion = (p[16] & USBPCAP_INFO_PDO_TO_FDO) != 0;
+        transfer->bus = ReadLE16(&p[17]);
+        transfer->device = ReadLE16(&p[19]);
+        transfer->endpoint = p[21];
+        transfer->transferType = p[22];
+        transfer->data = &p[headerLength];
+        transfer->length = std::min(ReadLE32(&p[23]), packet.capturedLength - headerLength);
+
+        // The setup packet is sent as the data of the setup stage
+        if (transfer->transferType == USB_TRANSFER_CONTROL && headerLength > USBPCAP_HEADER_MIN_SIZE && p[27] == USBPCAP_CONTROL_STAGE_SETUP && !transfer->completion && transfer->length >= 8)
+        {
+            transfer->hasSetup = true;
+            memcpy(transfer->setup, transfer->data, 8);
+            transfer->data += 8;
+            transfer->length -= 8;
+        }
+        return true;
+    }
+    else if (packet.linkType == PCAPNG_LINKTYPE_USB_LINUX || packet.linkType == PCAPNG_LINKTYPE_USB_LINUX_MMAPPED)
+    {
+        uint32_t headerLength = packet.linkType == PCAPNG_LINKTYPE_USB_LINUX ? USBMON_HEADER_SIZE : USBMON_MMAPPED_HEADER_SIZE;
+        if (packet.capturedLength < headerLength)
+            return false;
+
+        transfer->id = ReadLE64(&p[0]);
+        transfer->completion = p[8] != 'S';
+        transfer->transferType = p[9];
+        transfer->endpoint = p[10];
+        transfer->device = p[11];
+        transfer->bus = ReadLE16(&p[12]);
+        transfer->hasSetup = p[14] == 0;
+        transfer->status = ReadLE32(&p[28]);
+        transfer->data = &p[headerLength];
+        transfer->length = std::min(ReadLE32(&p[36]), packet.capturedLength - headerLength);
+
+        if (transfer->hasSetup)
+            memcpy(transfer->setup, &p[40], 8);
+        return true;
+    }
+
+    return false;
+}
+
+bool USBPcapImporter::IsTargetDevice(const UsbPcapTransfer &transfer) const
+{
+    return m_deviceFound && transfer.device == m_device && (m_bus < 0 || transfer.bus == m_bus);
+}
+
+void USBPcapImporter::OnControlCompletion(const UsbPcapTransfer &setup, const UsbPcapTransfer &completion)
+{
+    uint8_t bmRequestType = setup.setup[0];
+    uint8_t bmRequest = setup.setup[1];
+    uint16_t wValue = ReadLE16(&setup.setup[2]);
+
+    if (completion.status != 0 || !(bmRequestType & USB_ENDPOINT_IN))
+        return;
+
+    // Device descriptor: this is how the device is found
+    if (bmRequest == USB_REQUEST_GET_DESCRIPTOR && (wValue >> 8) == USB_DT_DEVICE && completion.length >= 12)
+    {
+        if (ReadLE16(&completion.data[8]) == m_vendor && ReadLE16(&completion.data[10]) == m_product)
+        {
+            // Re-enumeration (or address assigned after the first descriptor request), forget the previous device
+            if (!m_deviceFound || m_device != completion.device || m_bus != completion.bus)
+            {
+                m_configDescriptor.clear();
+                m_controlResponses.clear();
+                m_reports.clear();
+                m_reportData->clear();
+                m_endpointsSeen.clear();
+            }
+
+            m_deviceFound = true;
+            m_bus = completion.bus;
+            m_device = completion.device;
+        }
+        return;
+    }
+
+    if (!IsTargetDevice(completion))
+        return;
+
+    if (bmRequest == USB_REQUEST_GET_DESCRIPTOR && (wValue >> 8) == USB_DT_CONFIG)
+    {
+        // The host usually reads the first 9 bytes then the full descriptor
+        if (completion.length > m_configDescriptor.size())
+            m_configDescriptor.assign(completion.data, completion.data + completion.length);
+        return;
+    }
+
+    // Any other control input (HID report descriptor, vendor requests ...), the first answer is kept
+    for (const ControlResponse &response : m_controlResponses)
+    {
+        if (memcmp(response.setup, setup.setup, 6) == 0)
+            return;
+    }
+
+    ControlResponse response;
+    memcpy(response.setup, setup.setup, sizeof(response.setup));
+    response.data.assign(completion.data, completion.data + completion.length);
+    m_controlResponses.push_back(std::move(response));
+}
+
+void USBPcapImporter::OnTransfer(const UsbPcapTransfer &transfer)
+{
+    if (transfer.transferType == USB_TRANSFER_CONTROL)
+    {
+        if (transfer.hasSetup && !transfer.completion)
+        {
+            m_pendingSetups[transfer.id] = transfer;
+            m_pendingSetups[transfer.id].data = NULL;
+            m_pendingSetups[transfer.id].length = 0;
+        }
+        else if (transfer.completion)
+        {
+            auto it = m_pendingSetups.find(transfer.id);
+            if (it == m_pendingSetups.end())
+                return;
+
+            UsbPcapTransfer setup = it->second;
+            m_pendingSetups.erase(it);
+            OnControlCompletion(setup, transfer);
+        }
+        return;
+    }
+
+    if (!IsTargetDevice(transfer))
+        return;
+
+    if (std::find(m_endpointsSeen.begin(), m_endpointsSeen.end(), transfer.endpoint) == m_endpointsSeen.end())
+        m_endpointsSeen.push_back(transfer.endpoint);
+
+    // Input reports sent by the device (A report is at most a transfer buffer, wMaxPacketSize of an interrupt endpoint)
+    if (transfer.completion && (transfer.endpoint & USB_ENDPOINT_IN) && transfer.status == 0 && transfer.length > 0)
+    {
+        uint16_t length = (uint16_t)std::min<uint32_t>(transfer.length, UINT16_MAX);
+        if (m_reportData->size() + length + CONTROLLER_INPUT_BUFFER_SIZE > UINT32_MAX)
+        {
+            m_error = "More than 4 GB of input reports";
+            return;
+        }
+
+        m_reports.push_back(InputReport{transfer.timestamp_us, (uint32_t)m_reportData->size(), length, transfer.endpoint});
+        m_reportData->insert(m_reportData->end(), transfer.data, transfer.data + length);
+    }
+}
+
+bool USBPcapImporter::Import(const char *path)
+{
+    PcapngReader reader;
+    PcapngPacket packet;
+    UsbPcapTransfer transfer;
+
+    if (!reader.Open(path))
+    {
+        m_error = reader.GetError();
+        return false;
+    }
+
+    while (reader.Next(&packet))
+    {
+        m_packetCount++;
+
+        if (!DecodePacket(packet, &transfer))
+            continue;
+
+        m_usbPacketCount++;
+        OnTransfer(transfer);
+    }
+
+    // Trailing zeros (See MockUSBScriptData), and no spare capacity left by the growth of the buffers
+    m_reportData->resize(m_reportData->size() + CONTROLLER_INPUT_BUFFER_SIZE, 0);
+    m_reportData->shrink_to_fit();
+    m_reports.shrink_to_fit();
+
+    if (m_error.empty())
+        m_error = reader.GetError();
+    return m_error.empty();
+}
+
+std::unique_ptr<MockUSBDevice> USBPcapImporter::CreateDevice(uint8_t defaultClass) const
+{
+    auto device = std::make_unique<MockUSBDevice>(m_vendor, m_product);
+    MockUSBInterface *interface = NULL;
+
+    // Interfaces and endpoints, alternate settings are ignored (Not supported by the drivers)
+    size_t offset = 0;
+    bool alternate = false;
+    while (offset + 2 <= m_configDescriptor.size())
+    {
+        const uint8_t *desc = &m_configDescriptor[offset];
+        uint8_t length = desc[0];
+        if (length < 2 || offset + length > m_configDescriptor.size())
+            break;
+
+        if (desc[1] == USB_DT_INTERFACE && length >= 9)
+        {
+            alternate = desc[3] != 0;
+            if (!alternate)
+                interface = device->AddInterface(desc[5], desc[6], desc[7]);
+        }
+        else if (desc[1] == USB_DT_ENDPOINT && length >= 7 && interface != NULL && !alternate)
+        {
+            interface->AddEndpoint(desc[2], ReadLE16(&desc[4]), desc[6], desc[3]);
+        }
+
+        offset += length;
+    }
+
+    if (interface == NULL)
+    {
+        interface = device->AddInterface(defaultClass, 0, 0);
+        for (uint8_t endpoint : m_endpointsSeen)
+            interface->AddEndpoint(endpoint, 64, 1);
+    }
+
+    for (const ControlResponse &response : m_controlResponses)
+    {
+        uint8_t bmRequestType = response.setup[0];
+        uint16_t wIndex = ReadLE16(&response.setup[4]);
+
+        // Requests to an interface go to this interface, everything else to the first one
+        MockUSBInterface *target = ((bmRequestType & 0x1F) == USB_RECIPIENT_INTERFACE) ? device->GetMockInterface(wIndex & 0xFF) : NULL;
+        if (target == NULL)
+            target = device->GetMockInterface(0);
+
+        target->AddControlResponse(bmRequestType, response.setup[1], ReadLE16(&response.setup[2]), wIndex, response.data.data(), response.data.size());
+    }
+
+    uint64_t firstTimestamp_us = m_reports.empty() ? 0 : m_reports.front().timestamp_us;
+    for (const InputReport &report : m_reports)
+    {
+        MockUSBEndpoint *endpoint = device->FindMockEndpoint(report.endpoint);
+        if (endpoint != NULL)
+            endpoint->QueueReport(report.timestamp_us - firstTimestamp_us, m_reportData, report.offset, report.length);
+    }
+
+    return device;
+}
+
+std::string USBPcapImporter::GetDefaultDriver() const
+{
+    std::unique_ptr<MockUSBDevice> device = CreateDevice();
+
+    for (size_t i = 0;; i++)
+    {
+        MockUSBInterface *interface = device->GetMockInterface(i);
+        if (interface == NULL)
+            break;
+
+        IUSBInterface::InterfaceDescriptor *desc = interface->GetDescriptor();
+        if (desc->bInterfaceClass == USB_CLASS_VENDOR_SPEC && desc->bInterfaceSubClass == 0x5D && desc->bInterfaceProtocol == 0x01)
+            return "xbox360";
+        else if (desc->bInterfaceClass == USB_CLASS_VENDOR_SPEC && desc->bInterfaceSubClass == 0x47 && desc->bInterfaceProtocol == 0xD0)
+            return "xboxone";
+        else if (desc->bInterfaceClass == USB_CLASS_VENDOR_SPEC && desc->bInterfaceSubClass == 0x5D && desc->bInterfaceProtocol == 0x81)
+            return "xbox360w";
+        else if (desc->bInterfaceClass == 0x58 && desc->bInterfaceSubClass == 0x42 && desc->bInterfaceProtocol == 0x00)
+            return "xbox";
+    }
+
+    // Same as the [054c-0268] section of the default config.ini
+    if (m_vendor == 0x054c && m_product == 0x0268)
+        return "dualshock3";
+
+    return "generic";
+}
@@ -0,0 +1,99 @@
+#pragma once
+#include "MockUSBDevice.h"
+#include "PcapngReader.h"
+#include <map>
+#include <string>
+#include <vector>
+
+// Extract the traffic of one USB device from a Wireshark capture (pcapng), and rebuild it as a scripted MockUSBDevice
+// Supported link types: USBPcap (Windows, see doc/WiresharkCapture.md) and usbmon (Linux)
+//
+// The device is identified by its device descriptor (VID/PID), so the capture must contain the enumeration
+// (Controller plugged after the capture started). Otherwise the device address can be given with SetDeviceAddress().
+// The capture is streamed, only the transfers of the selected device are kept in memory: the IN reports are stored one after
+// the other in a single buffer, shared without copy by the endpoints of the devices created (See MockUSBScriptData).
+
+struct UsbPcapTransfer
+{
+    uint64_t id; // IRP / URB id, same value for the submission and the completion
+    uint64_t timestamp_us;
+    uint16_t bus;
+    uint16_t device;
+    uint8_t endpoint;
+    uint8_t transferType; // 0: Isochronous, 1: Interrupt, 2: Control, 3: Bulk
+    bool completion;      // false: submitted by the host, true: completed by the device
+    bool hasSetup;
+    uint8_t setup[8];
+    uint32_t status;
+    const uint8_t *data;
+    uint32_t length;
+};
+
+class USBPcapImporter
+{
+private:
+    struct InputReport
+    {
+        uint64_t timestamp_us;
+        uint32_t offset; // In m_reportData
+        uint16_t length;
+        uint8_t endpoint;
+    };
+
+    struct ControlResponse
+    {
+        uint8_t setup[8];
+        std::vector<uint8_t> data;
+    };
+
+    uint16_t m_vendor;
+    uint16_t m_product;
+    int m_bus = -1;
+    int m_device = -1;
+    bool m_deviceFound = false;
+
+    // Control setups waiting for their completion, by transfer id
+    std::map<uint64_t, UsbPcapTransfer> m_pendingSetups;
+
+    std::vector<uint8_t> m_configDescriptor;
+    std::vector<ControlResponse> m_controlResponses;
+    std::vector<InputReport> m_reports;
+    std::shared_ptr<MockUSBScriptData> m_reportData;
+    std::vector<uint8_t> m_endpointsSeen;
+
+    uint64_t m_packetCount = 0;
+    uint64_t m_usbPacketCount = 0;
+    std::string m_error;
+
+    static bool DecodePacket(const PcapngPacket &packet, UsbPcapTransfer *transfer);
+
+    void OnTransfer(const UsbPcapTransfer &transfer);
+    void OnControlCompletion(const UsbPcapTransfer &setup, const UsbPcapTransfer &completion);
+    bool IsTargetDevice(const UsbPcapTransfer &transfer) const;
+
+public:
+    USBPcapImporter(uint16_t vendor, uint16_t product);
+
+    // Use the traffic of bus/device instead of looking for the device descriptor
+    void SetDeviceAddress(int bus, int device);
+
+    bool Import(const char *path);
+
+    // Build the device: interfaces/endpoints from the configuration descriptor, control responses and IN reports
+    // (Timestamps relative to the first report). Without configuration descriptor, a single interface is built
+    // with the endpoints seen in the capture.
+    std::unique_ptr<MockUSBDevice> CreateDevice(uint8_t defaultClass = USB_CLASS_HID) const;
+
+    // Same driver selection as the sysmodule for a device without configuration (Interface class/subclass/protocol)
+    std::string GetDefaultDriver() const;
+
+    inline bool IsDeviceFound() const { return m_deviceFound; }
+    inline bool HasConfigDescriptor() const { return !m_configDescriptor.empty(); }
+    inline size_t GetReportCount() const { return m_reports.size(); }
+    inline size_t GetControlResponseCount() const { return m_controlResponses.size(); }
+    inline uint64_t GetPacketCount() const { return m_packetCount; }
+    inline uint64_t GetUsbPacketCount() const { return m_usbPacketCount; }
+    inline int GetBus() const { return m_bus; }
+    inline int GetDevice() const { return m_device; }
+    inline const std::string &GetError() const { return m_error; }
+};
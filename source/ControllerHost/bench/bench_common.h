@@ -0,0 +1,39 @@
+#pragma once
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+
+// Minimal helpers shared by the host benchmarks, every benchmark is a standalone executable.
+namespace bench
+{
+    using Clock = std::chrono::steady_clock;
+
+    inline uint64_t NowNs()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+    }
+
+    // Prevent the compiler from optimizing away a result
+    template <typename T>
+    inline void DoNotOptimize(const T &value)
+    {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+
+    // Iterations can be reduced with BENCH_ITERATIONS=xxx (i.e: when running with sanitizers)
+    inline uint64_t Iterations(uint64_t defaultIterations)
+    {
+        const char *env = getenv("BENCH_ITERATIONS");
+        if (env == NULL)
+            return defaultIterations;
+
+        uint64_t iterations = strtoull(env, NULL, 10);
+        return iterations > 0 ? iterations : defaultIterations;
+    }
+
+    inline void Report(const char *name, uint64_t iterations, uint64_t elapsedNs)
+    {
+        printf("%-40s %12llu iterations %10.1f ns/op\n", name, (unsigned long long)iterations, iterations ? (double)elapsedNs / iterations : 0.0);
+    }
+} // namespace bench
@@ -0,0 +1,305 @@
+#include "ConfigStore.h"
+#include "IController.h"
+#include "HostLogger.h"
+#include "MockDeviceFactory.h"
+#include "bench_common.h"
+#include <atomic>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Cost of a live reload of config.ini (syscon::config_reload), on the shipped config.ini with one section edited:
+//  - reload: the file parsed again, compared section by section with the previous one (ConfigStore::GetChangedSections),
+//            then only the controllers depending on a section changed resolved again
+//  - before: nothing was applied while running, every controller had to be replugged (Its config resolved again, as all of them here)
+// For each edit ([vid-pid], [profile], [default], [global], nothing), the controllers resolved again must be exactly the ones whose config changed.
+// Then the handoff of the new config to the input thread (IController::SetConfig / ApplyPendingConfig):
+// its cost on each input loop iteration, and a config applied while reading must never be seen half written.
+
+namespace
+{
+    // Key -> last value applied, stands for ControllerConfig (As in bench_config_store)
+    typedef std::map<std::string, std::string> BenchConfig;
+
+    std::string ReadText(const std::string &path)
+    {
+        std::string text;
+        FILE *file = fopen(path.c_str(), "rb");
+        if (file == NULL)
+            return text;
+
+        char buffer[4096];
+        size_t size;
+        while ((size = fread(buffer, 1, sizeof(buffer), file)) > 0)
+            text.append(buffer, size);
+        fclose(file);
+        return text;
+    }
+
+    BenchConfig Resolve(const ConfigStore &store, const std::string &vidpid)
+    {
+        BenchConfig config;
+        const ConfigStore::Section *sections[ConfigStore::MaxControllerSections];
+        int count = store.GetControllerSections(vidpid, sections);
+
+        for (int i = 0; i < count; i++)
+        {
+            for (const ConfigStore::Entry &entry : sections[i]->entries)
+                config[store.GetKey(entry.key)] = entry.value;
+        }
+        return config;
+    }
+
+    bool IsControllerChanged(const ConfigStore &store, const std::vector<std::string> &changedSections, const std::string &vidpid)
+    {
+        std::string names[ConfigStore::MaxControllerSections];
+        int count = store.GetControllerSectionNames(vidpid, names);
+
+        for (int i = 0; i < count; i++)
+        {
+            for (const std::string &changed : changedSections)
+            {
+                if (changed == names[i])
+                    return true;
+            }
+        }
+        return false;
+    }
+
+    // One reload: parse, diff, resolve the controllers depending on a section changed. Returns the number of controllers resolved.
+    int Reload(const ConfigStore &previous, ConfigStore *store, const std::string &text, const std::vector<std::string> &controllers, std::vector<std::string> *changedSections)
+    {
+        int resolved = 0;
+        store->Parse(text.data(), text.size());
+
+        changedSections->clear();
+        store->GetChangedSections(previous, changedSections);
+
+        for (const std::string &vidpid : controllers)
+        {
+            if (changedSections->empty() || !IsControllerChanged(*store, *changedSections, vidpid))
+                continue;
+
+            bench::DoNotOptimize(Resolve(*store, vidpid).size());
+            resolved++;
+        }
+        return resolved;
+    }
+
+    struct Edit
+    {
+        const char *name;
+        std::string section; // Empty: the file saved unchanged
+    };
+
+    bool CheckEdit(const std::string &text, const ConfigStore &previous, const std::vector<std::string> &controllers, const Edit &edit, uint64_t iterations)
+    {
+        // The sections with the same name are merged: a line appended in a new [section] block edits it
+        std::string edited = text;
+        if (!edit.section.empty())
+            edited += "\n[" + edit.section + "]\nbench_reload=1\n";
+
+        ConfigStore store;
+        std::vector<std::string> changedSections;
+        int resolved = Reload(previous, &store, edited, controllers, &changedSections);
+
+        bool ok = true;
+        int differ = 0;
+        for (const std::string &vidpid : controllers)
+        {
+            bool changed = Resolve(previous, vidpid) != Resolve(store, vidpid);
+            differ += changed ? 1 : 0;
+            if (changed != IsControllerChanged(store, changedSections, vidpid))
+            {
+                printf("%s: [%s] %s (FAIL)\n", edit.name, vidpid.c_str(), changed ? "changed but not resolved again" : "resolved again but unchanged");
+                ok = false;
+            }
+        }
+
+        if (changedSections.size() != (edit.section.empty() ? 0u : 1u))
+        {
+            printf("%s: %zu sections changed (FAIL)\n", edit.name, changedSections.size());
+            ok = false;
+        }
+
+        uint64_t start = bench::NowNs();
+        for (uint64_t i = 0; i < iterations; i++)
+            bench::DoNotOptimize(Reload(previous, &store, edited, controllers, &changedSections));
+        uint64_t reload_ns = bench::NowNs() - start;
+
+        char name[64];
+        snprintf(name, sizeof(name), "reload: %s", edit.name);
+        printf("%-40s %d/%zu controllers resolved again (%d changed)\n", name, resolved, controllers.size(), differ);
+        bench::Report(name, iterations, reload_ns);
+        return ok;
+    }
+
+    class ReloadController : public IController
+    {
+    public:
+        using IController::IController;
+
+        ams::Result Initialize() override { R_SUCCEED(); }
+        void Exit() override {}
+        uint16_t GetInputCount() override { return 1; }
+        ams::Result ReadInput(NormalizedButtonData *normalData, uint16_t *input_idx, uint32_t timeout_us) override
+        {
+            (void)normalData;
+            (void)input_idx;
+            (void)timeout_us;
+            R_SUCCEED();
+        }
+        bool Support(ControllerFeature aFeature) override
+        {
+            (void)aFeature;
+            return false;
+        }
+        ams::Result SetRumble(uint16_t input_idx, float amp_high, float amp_low) override
+        {
+            (void)input_idx;
+            (void)amp_high;
+            (void)amp_low;
+            R_SUCCEED();
+        }
+    };
+
+    // Every field set from the same generation, a mix of two generations is a torn config
+    ControllerConfig MakeConfig(uint8_t generation)
+    {
+        ControllerConfig config;
+        config.profile = std::to_string(generation);
+        config.stickDeadzonePercent[0] = config.stickDeadzonePercent[1] = generation;
+        config.triggerDeadzonePercent[0] = config.triggerDeadzonePercent[1] = generation;
+        for (uint8_t &pin : config.buttons_pin)
+            pin = generation;
+        return config;
+    }
+
+    bool IsConsistent(const ControllerConfig &config)
+    {
+        uint8_t generation = config.stickDeadzonePercent[0];
+        for (uint8_t pin : config.buttons_pin)
+        {
+            if (pin != generation)
+                return false;
+        }
+        return config.stickDeadzonePercent[1] == generation && config.triggerDeadzonePercent[0] == generation &&
+               config.triggerDeadzonePercent[1] == generation && config.profile == std::to_string(generation);
+    }
+
+    // The main loop gives new configs while the input thread reads
+    bool CheckHandoff(uint64_t iterations)
+    {
+        ReloadController controller(MockDeviceFactory::CreateDevice("generic"), MakeConfig(0), std::make_unique<HostLogger>(HostLogger::LevelFromEnv(LogLevelWarning)));
+        std::atomic<bool> running{true};
+        uint64_t applied = 0;
+        uint64_t torn = 0;
+
+        std::thread reader([&]() {
+            while (running.load(std::memory_order_relaxed))
+            {
+                applied += controller.ApplyPendingConfig() ? 1 : 0;
+                torn += IsConsistent(controller.GetConfig()) ? 0 : 1;
+            }
+            applied += controller.ApplyPendingConfig() ? 1 : 0;
+        });
+
+        // Yield now and then: the reader must also apply configs while the next ones are given
+        for (uint64_t i = 1; i <= iterations; i++)
+        {
+            controller.SetConfig(MakeConfig((uint8_t)(i % 200)));
+            if (i % 16 == 0)
+                std::this_thread::yield();
+        }
+
+        running = false;
+        reader.join();
+
+        uint8_t last = (uint8_t)(iterations % 200);
+        printf("handoff: %llu configs given, %llu applied by the reader\n", (unsigned long long)iterations, (unsigned long long)applied);
+        if (torn > 0 || controller.GetConfig().stickDeadzonePercent[0] != last || applied == 0)
+        {
+            printf("handoff: %llu torn reads, last config %d instead of %d (FAIL)\n", (unsigned long long)torn, controller.GetConfig().stickDeadzonePercent[0], last);
+            return false;
+        }
+        return true;
+    }
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    uint64_t iterations = bench::Iterations(1000);
+    bool ok = true;
+
+    std::string path = argc > 1 ? argv[1] : std::string(__FILE__).substr(0, std::string(__FILE__).rfind('/')) + "/../../../dist/config/sys-con/config.ini";
+    std::string text = ReadText(path);
+    if (text.empty())
+    {
+        printf("Unable to read %s (FAIL)\n", path.c_str());
+        return 1;
+    }
+
+    ConfigStore previous;
+    previous.Parse(text.data(), text.size());
+
+    std::vector<std::string> controllers;
+    std::string profileUsed;
+    for (size_t i = 0; i < previous.GetSectionCount(); i++)
+    {
+        const std::string &name = previous.GetSection(i).name;
+        if (name.length() != 9 || name[4] != '-')
+            continue;
+
+        controllers.push_back(name);
+
+        std::string names[ConfigStore::MaxControllerSections];
+        if (profileUsed.empty() && previous.GetControllerSectionNames(name, names) == ConfigStore::MaxControllerSections)
+            profileUsed = names[1];
+    }
+
+    if (controllers.empty() || profileUsed.empty())
+    {
+        printf("%s: no [vid-pid] section or no profile used (FAIL)\n", path.c_str());
+        return 1;
+    }
+
+    // Before: every controller replugged, the file parsed and every config resolved again
+    uint64_t start = bench::NowNs();
+    for (uint64_t i = 0; i < iterations; i++)
+    {
+        ConfigStore store;
+        store.Parse(text.data(), text.size());
+        for (const std::string &vidpid : controllers)
+            bench::DoNotOptimize(Resolve(store, vidpid).size());
+    }
+    uint64_t replug_ns = bench::NowNs() - start;
+    bench::Report("before: every controller resolved again", iterations, replug_ns);
+
+    ok = CheckEdit(text, previous, controllers, {"unchanged", ""}, iterations) && ok;
+    ok = CheckEdit(text, previous, controllers, {"[vid-pid]", controllers[0]}, iterations) && ok;
+    ok = CheckEdit(text, previous, controllers, {"[profile]", profileUsed}, iterations) && ok;
+    ok = CheckEdit(text, previous, controllers, {"[default]", "default"}, iterations) && ok;
+    ok = CheckEdit(text, previous, controllers, {"[global]", "global"}, iterations) && ok;
+
+    // Handoff: the check done on every input loop iteration, then a config given and applied
+    ReloadController controller(MockDeviceFactory::CreateDevice("generic"), MakeConfig(0), std::make_unique<HostLogger>(HostLogger::LevelFromEnv(LogLevelWarning)));
+    uint64_t loops = iterations * 10000;
+    start = bench::NowNs();
+    for (uint64_t i = 0; i < loops; i++)
+        bench::DoNotOptimize(controller.ApplyPendingConfig());
+    bench::Report("input loop: no config pending", loops, bench::NowNs() - start);
+
+    ControllerConfig config = MakeConfig(1);
+    start = bench::NowNs();
+    for (uint64_t i = 0; i < iterations * 100; i++)
+    {
+        controller.SetConfig(config);
+        bench::DoNotOptimize(controller.ApplyPendingConfig());
+    }
+    bench::Report("SetConfig + ApplyPendingConfig", iterations * 100, bench::NowNs() - start);
+
+    ok = CheckHandoff(iterations * 100) && ok;
+
+    return ok ? 0 : 1;
+}
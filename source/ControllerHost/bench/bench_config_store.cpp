@@ -0,0 +1,298 @@
+#include "ConfigStore.h"
+#include "bench_common.h"
+#include <map>
+#include <string>
+#include <vector>
+
+// Cost of LoadControllerConfig on each controller connection, on the shipped config.ini (from memory, the SD card reads are not counted):
+//  - before: the file scanned line by line for each section (ams::util::ini), [default] then [vid-pid], then [profile] and [vid-pid] again,
+//            every section and key of every line lowercased to be compared
+//  - after:  the file parsed once into ConfigStore (Also reported), then the 3 sections looked up by name,
+//            or the resolved config copied from the cache (Same VID/PID, config.ini unchanged)
+// Every [vid-pid] of the file is resolved by both and must give the same values.
+
+namespace
+{
+    // Key -> value applied, stands for ControllerConfig (The decoding of the values is the same before and after)
+    typedef std::map<std::string, std::string> BenchConfig;
+
+    std::string Lowercase(const char *str)
+    {
+        std::string result = "";
+        for (const char *ch = str; *ch != '\0'; ch++)
+            result += tolower(*ch);
+        return result;
+    }
+
+    void Apply(BenchConfig *config, const std::string &nameStr, const char *value)
+    {
+        if (nameStr == "profile" || nameStr == "driver")
+            (*config)[nameStr] = Lowercase(value);
+        else
+            (*config)[nameStr] = value;
+    }
+
+    // ams::util::ini (inih): a line at a time, handler(section, name, value) for each key
+    typedef int (*IniHandler)(void *data, const char *section, const char *name, const char *value);
+
+    char *Rstrip(char *s)
+    {
+        char *p = s + strlen(s);
+        while (p > s && isspace((unsigned char)*--p))
+            *p = '\0';
+        return s;
+    }
+
+    char *Lskip(const char *s)
+    {
+        while (*s && isspace((unsigned char)*s))
+            s++;
+        return (char *)s;
+    }
+
+    char *FindCharsOrComment(const char *s, const char *chars)
+    {
+        int was_space = 0;
+        while (*s && (!chars || !strchr(chars, *s)) && !(was_space && *s == ';'))
+        {
+            was_space = isspace((unsigned char)*s);
+            s++;
+        }
+        return (char *)s;
+    }
+
+    void IniParse(const std::string &text, IniHandler handler, void *data)
+    {
+        char line[200];
+        char section[50] = "";
+        char prev_name[50] = "";
+        size_t offset = 0;
+
+        while (offset < text.size())
+        {
+            size_t eol = text.find('\n', offset);
+            if (eol == std::string::npos)
+                eol = text.size();
+            snprintf(line, sizeof(line), "%.*s", (int)(eol - offset), &text[offset]);
+            offset = eol + 1;
+
+            char *start = Lskip(Rstrip(line));
+            if (*start == ';' || *start == '#')
+                continue;
+            else if (*prev_name && *start && start > line)
+            {
+                char *end = FindCharsOrComment(start, NULL);
+                *end = '\0';
+                handler(data, section, prev_name, Rstrip(start));
+            }
+            else if (*start == '[')
+            {
+                char *end = FindCharsOrComment(start + 1, "]");
+                if (*end == ']')
+                {
+                    *end = '\0';
+                    snprintf(section, sizeof(section), "%s", start + 1);
+                    *prev_name = '\0';
+                }
+            }
+            else if (*start)
+            {
+                char *end = FindCharsOrComment(start, "=:");
+                if (*end == '=' || *end == ':')
+                {
+                    *end = '\0';
+                    char *name = Rstrip(start);
+                    char *value = Lskip(end + 1);
+                    end = FindCharsOrComment(value, NULL);
+                    *end = '\0';
+                    Rstrip(value);
+
+                    snprintf(prev_name, sizeof(prev_name), "%s", name);
+                    handler(data, section, name, value);
+                }
+            }
+        }
+    }
+
+    struct ScanData
+    {
+        std::string ini_section;
+        BenchConfig *config;
+        std::vector<std::pair<std::string, std::string>> *lines;
+    };
+
+    // ParseControllerConfigLine before ConfigStore
+    int ScanLine(void *data, const char *section, const char *name, const char *value)
+    {
+        ScanData *scan = static_cast<ScanData *>(data);
+        std::string sectionStr = Lowercase(section);
+        std::string nameStr = Lowercase(name);
+
+        if (scan->ini_section != sectionStr)
+            return 1;
+
+        if (scan->config != NULL)
+            Apply(scan->config, nameStr, value);
+        if (scan->lines != NULL)
+            scan->lines->push_back({nameStr, value});
+        return 1;
+    }
+
+    BenchConfig ResolveBefore(const std::string &text, const std::string &vidpid)
+    {
+        BenchConfig config;
+        ScanData scanDefault = {"default", &config, NULL};
+        ScanData scanController = {vidpid, &config, NULL};
+
+        IniParse(text, ScanLine, &scanDefault);
+        IniParse(text, ScanLine, &scanController);
+
+        auto profile = config.find("profile");
+        if (profile != config.end() && profile->second.length() > 0)
+        {
+            ScanData scanProfile = {profile->second, &config, NULL};
+            IniParse(text, ScanLine, &scanProfile);
+            IniParse(text, ScanLine, &scanController);
+        }
+
+        return config;
+    }
+
+    BenchConfig ResolveAfter(const ConfigStore &store, const std::string &vidpid)
+    {
+        BenchConfig config;
+        const ConfigStore::Section *sections[ConfigStore::MaxControllerSections];
+        int count = store.GetControllerSections(vidpid, sections);
+
+        for (int i = 0; i < count; i++)
+        {
+            for (const ConfigStore::Entry &entry : sections[i]->entries)
+            {
+                std::string value = entry.value;
+                Apply(&config, store.GetKey(entry.key), value.c_str());
+            }
+        }
+
+        return config;
+    }
+
+    struct Cached
+    {
+        std::string vidpid;
+        BenchConfig config;
+    };
+
+    BenchConfig ResolveCached(const std::vector<Cached> &cache, const std::string &vidpid)
+    {
+        for (const Cached &cached : cache)
+        {
+            if (cached.vidpid == vidpid)
+                return cached.config;
+        }
+        return BenchConfig();
+    }
+
+    // The lines of each section, as seen by the scans before
+    bool CheckSections(const std::string &text, const ConfigStore &store)
+    {
+        for (size_t i = 0; i < store.GetSectionCount(); i++)
+        {
+            const ConfigStore::Section &section = store.GetSection(i);
+            std::vector<std::pair<std::string, std::string>> lines;
+            ScanData scan = {section.name, NULL, &lines};
+            IniParse(text, ScanLine, &scan);
+
+            bool same = lines.size() == section.entries.size();
+            for (size_t k = 0; same && k < lines.size(); k++)
+                same = lines[k].first == store.GetKey(section.entries[k].key) && lines[k].second == section.entries[k].value;
+
+            if (!same)
+            {
+                printf("[%s]: %zu lines scanned, %zu in the store (FAIL)\n", section.name.c_str(), lines.size(), section.entries.size());
+                return false;
+            }
+        }
+        return true;
+    }
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    uint64_t iterations = bench::Iterations(2000);
+    bool ok = true;
+
+    std::string path = argc > 1 ? argv[1] : std::string(__FILE__).substr(0, std::string(__FILE__).rfind('/')) + "/../../../dist/config/sys-con/config.ini";
+    FILE *file = fopen(path.c_str(), "rb");
+    if (file == NULL)
+    {
+        printf("Unable to open %s (FAIL)\n", path.c_str());
+        return 1;
+    }
+
+    std::string text;
+    char buffer[4096];
+    size_t size;
+    while ((size = fread(buffer, 1, sizeof(buffer), file)) > 0)
+        text.append(buffer, size);
+    fclose(file);
+
+    ConfigStore store;
+    uint64_t start = bench::NowNs();
+    for (uint64_t i = 0; i < iterations; i++)
+        store.Parse(text.data(), text.size());
+    uint64_t parse_ns = bench::NowNs() - start;
+
+    // The controllers of the file
+    std::vector<std::string> controllers;
+    for (size_t i = 0; i < store.GetSectionCount(); i++)
+    {
+        const std::string &name = store.GetSection(i).name;
+        if (name.length() == 9 && name[4] == '-')
+            controllers.push_back(name);
+    }
+
+    printf("%s: %zu bytes, %zu sections, %zu keys, %zu controllers\n", path.c_str(), text.size(), store.GetSectionCount(), store.GetKeyCount(), controllers.size());
+    if (controllers.empty())
+    {
+        printf("No [vid-pid] section (FAIL)\n");
+        return 1;
+    }
+
+    std::vector<Cached> cache;
+    for (const std::string &vidpid : controllers)
+    {
+        BenchConfig before = ResolveBefore(text, vidpid);
+        BenchConfig after = ResolveAfter(store, vidpid);
+        if (before != after)
+        {
+            printf("[%s]: the configs differ (FAIL)\n", vidpid.c_str());
+            ok = false;
+        }
+        cache.push_back({vidpid, after});
+    }
+
+    ok = CheckSections(text, store) && ok;
+
+    uint64_t connects = std::max<uint64_t>(1, iterations / 10);
+    start = bench::NowNs();
+    for (uint64_t i = 0; i < connects; i++)
+        bench::DoNotOptimize(ResolveBefore(text, controllers[i % controllers.size()]).size());
+    uint64_t before_ns = bench::NowNs() - start;
+
+    start = bench::NowNs();
+    for (uint64_t i = 0; i < iterations; i++)
+        bench::DoNotOptimize(ResolveAfter(store, controllers[i % controllers.size()]).size());
+    uint64_t after_ns = bench::NowNs() - start;
+
+    start = bench::NowNs();
+    for (uint64_t i = 0; i < iterations; i++)
+        bench::DoNotOptimize(ResolveCached(cache, controllers[i % controllers.size()]).size());
+    uint64_t cached_ns = bench::NowNs() - start;
+
+    bench::Report("parse once (ConfigStore::Parse)", iterations, parse_ns);
+    bench::Report("connect: before (file scans)", connects, before_ns);
+    bench::Report("connect: after (section lookups)", iterations, after_ns);
+    bench::Report("connect: after (cached)", iterations, cached_ns);
+
+    return ok ? 0 : 1;
+}
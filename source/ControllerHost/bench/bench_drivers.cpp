@@ -0,0 +1,98 @@
+#include "MockDeviceFactory.h"
+#include "HostLogger.h"
+#include "bench_common.h"
+
+// Run every driver against its scripted mock device:
+//  - connect: Initialize() cost in wall time and in device time (control transfers, OUT packets, waits)
+//  - read: ReadInput(NormalizedButtonData) cost per report, USB transfer excluded (the mock never sleeps)
+//    and copies of the transfer buffer made per report by the endpoints (0 with USBReadView)
+
+namespace
+{
+    IUSBEndpoint::ReadStats GetReadStats(MockUSBDevice *mock)
+    {
+        IUSBEndpoint::ReadStats total;
+
+        for (size_t i = 0; mock->GetMockInterface(i) != NULL; i++)
+        {
+            for (uint8_t idx = 0;; idx++)
+            {
+                MockUSBEndpoint *endpoint = mock->GetMockInterface(i)->GetMockEndpoint(IUSBEndpoint::USB_ENDPOINT_IN, idx);
+                if (endpoint == NULL)
+                    break;
+
+                total.reports += endpoint->GetReadStats().reports;
+                total.copies += endpoint->GetReadStats().copies;
+                total.copiedBytes += endpoint->GetReadStats().copiedBytes;
+            }
+        }
+
+        return total;
+    }
+} // namespace
+
+int main()
+{
+    const uint64_t connectIterations = bench::Iterations(2000) / 10 + 1;
+    const uint64_t readIterations = bench::Iterations(2000000);
+
+    for (const std::string &driver : MockDeviceFactory::Drivers())
+    {
+        char name[64];
+
+        // Connect
+        uint64_t connectNs = 0;
+        uint64_t connectDeviceUs = 0;
+        for (uint64_t i = 0; i < connectIterations; i++)
+        {
+            std::unique_ptr<MockUSBDevice> device = MockDeviceFactory::CreateDevice(driver, 16);
+            MockUSBDevice *mock = device.get();
+            std::unique_ptr<IController> controller = MockDeviceFactory::CreateController(driver, std::move(device), MockDeviceFactory::DefaultConfig(), std::make_unique<HostLogger>(HostLogger::LevelFromEnv(LogLevelWarning)));
+
+            uint64_t start = bench::NowNs();
+            if (R_FAILED(controller->Initialize()))
+            {
+                fprintf(stderr, "%s: Initialize failed\n", driver.c_str());
+                return 1;
+            }
+            connectNs += bench::NowNs() - start;
+            connectDeviceUs += mock->GetClock().Now();
+        }
+        snprintf(name, sizeof(name), "%s connect", driver.c_str());
+        bench::Report(name, connectIterations, connectNs);
+        printf("%-40s %12s            %10.1f us device time\n", name, "", (double)connectDeviceUs / connectIterations);
+
+        // Read
+        std::unique_ptr<MockUSBDevice> device = MockDeviceFactory::CreateDevice(driver, 256);
+        MockUSBDevice *mock = device.get();
+        std::unique_ptr<IController> controller = MockDeviceFactory::CreateController(driver, std::move(device), MockDeviceFactory::DefaultConfig(), std::make_unique<HostLogger>(HostLogger::LevelFromEnv(LogLevelWarning)));
+        if (R_FAILED(controller->Initialize()))
+            return 1;
+
+        // The wireless receiver only scripts a finite session on the first slot, keep the clock in sync for the other ones
+        uint64_t iterations = driver == "xbox360w" ? std::min<uint64_t>(readIterations, 256) : readIterations;
+        uint64_t reports = 0;
+        uint64_t deviceStartUs = mock->GetClock().Now();
+        IUSBEndpoint::ReadStats statsStart = GetReadStats(mock);
+        NormalizedButtonData data;
+        uint16_t input_idx = 0;
+
+        uint64_t start = bench::NowNs();
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            if (R_SUCCEEDED(controller->ReadInput(&data, &input_idx, 100000)))
+                reports++;
+            bench::DoNotOptimize(data);
+        }
+        uint64_t elapsedNs = bench::NowNs() - start;
+        IUSBEndpoint::ReadStats stats = GetReadStats(mock);
+        uint64_t transfers = stats.reports - statsStart.reports;
+
+        snprintf(name, sizeof(name), "%s read", driver.c_str());
+        bench::Report(name, iterations, elapsedNs);
+        printf("%-40s %12llu reports    %10.1f us device time/op\n", name, (unsigned long long)reports, (double)(mock->GetClock().Now() - deviceStartUs) / iterations);
+        printf("%-40s %12.2f copies/rpt %10.1f bytes copied/rpt\n", name, transfers > 0 ? (double)(stats.copies - statsStart.copies) / transfers : 0.0, transfers > 0 ? (double)(stats.copiedBytes - statsStart.copiedBytes) / transfers : 0.0);
+    }
+
+    return 0;
+}
@@ -0,0 +1,148 @@
+#include "Controllers/HIDReportLayout.h"
+#include "MockDeviceFactory.h"
+#include "HIDJoystickReference.h"
+#include "HIDReportDescriptor.h"
+#include "HIDJoystick.h"
+#include "bench_common.h"
+#include <cstring>
+
+// Per report decoding cost of GenericHIDController:
+//  - HIDJoystick: HIDJoystick::parseData + hat switch comparisons + Normalize (path used before HIDReportLayout)
+//  - HIDReportLayout: compiled layout (current path), the report copied in a padded buffer or read in place from a read view
+// Both decode the reports of the "generic" mock device (4 axis, 1 hat, 16 buttons), see bench_hid_layouts for other descriptors.
+
+namespace
+{
+    // Reports of the generic mock device, read back from its IN endpoint
+    std::vector<std::vector<uint8_t>> LoadReports()
+    {
+        std::unique_ptr<MockUSBDevice> device = MockDeviceFactory::CreateDevice("generic", 256);
+        MockUSBEndpoint *endpoint = device->GetMockInterface(0)->GetMockEndpoint(IUSBEndpoint::USB_ENDPOINT_IN, 0);
+        std::vector<std::vector<uint8_t>> reports;
+
+        endpoint->SetLoop(false, 0);
+        endpoint->Open();
+        while (true)
+        {
+            uint8_t buffer[CONTROLLER_INPUT_BUFFER_SIZE];
+            size_t size = sizeof(buffer);
+            if (R_FAILED(endpoint->Read(buffer, &size, 1000000)))
+                break;
+            reports.emplace_back(buffer, buffer + size);
+        }
+        return reports;
+    }
+} // namespace
+
+int main()
+{
+    const std::vector<uint8_t> &descriptorBytes = MockDeviceFactory::GenericHIDReportDescriptor();
+    std::vector<std::vector<uint8_t>> reports = LoadReports();
+    const uint64_t iterations = bench::Iterations(5000000);
+
+    // Compile / parse cost (once per connection)
+    uint64_t start = bench::NowNs();
+    for (uint64_t i = 0; i < iterations / 1000; i++)
+    {
+        auto joystick = std::make_shared<HIDJoystick>(std::make_shared<HIDReportDescriptor>(descriptorBytes.data(), descriptorBytes.size()));
+        bench::DoNotOptimize(joystick);
+    }
+    bench::Report("HIDJoystick (parse descriptor)", iterations / 1000, bench::NowNs() - start);
+
+    start = bench::NowNs();
+    for (uint64_t i = 0; i < iterations / 1000; i++)
+    {
+        HIDReportLayout layout;
+        bench::DoNotOptimize(layout.Compile(descriptorBytes.data(), descriptorBytes.size()));
+    }
+    bench::Report("HIDReportLayout (compile descriptor)", iterations / 1000, bench::NowNs() - start);
+
+    // Layout restored from the persistent cache (IHIDLayoutCache) instead of compiled
+    std::vector<uint8_t> serialized;
+    {
+        HIDReportLayout layout;
+        layout.Compile(descriptorBytes.data(), descriptorBytes.size());
+        layout.Serialize(&serialized);
+    }
+
+    start = bench::NowNs();
+    for (uint64_t i = 0; i < iterations / 1000; i++)
+    {
+        HIDReportLayout layout;
+        bench::DoNotOptimize(layout.Deserialize(serialized.data(), serialized.size()));
+    }
+    bench::Report("HIDReportLayout (load from cache)", iterations / 1000, bench::NowNs() - start);
+
+    HIDJoystickReference joystick(descriptorBytes.data(), descriptorBytes.size());
+    HIDReportLayout layout;
+    if (!layout.Compile(descriptorBytes.data(), descriptorBytes.size()))
+    {
+        fprintf(stderr, "HIDReportLayout: failed to compile the descriptor\n");
+        return 1;
+    }
+
+    std::vector<uint8_t> reserialized;
+    HIDReportLayout cachedLayout;
+    if (cachedLayout.Deserialize(serialized.data(), serialized.size()))
+        cachedLayout.Serialize(&reserialized);
+
+    if (reserialized != serialized)
+    {
+        fprintf(stderr, "HIDReportLayout: serialized layout doesn't round trip\n");
+        return 1;
+    }
+
+    // Both paths must give the same result
+    for (const std::vector<uint8_t> &report : reports)
+    {
+        RawInputData expected, actual;
+        uint16_t expected_idx = 0, actual_idx = 0;
+        bool expected_ok = joystick.Decode(report.data(), report.size(), &expected, &expected_idx);
+        bool actual_ok = layout.Decode(report.data(), report.size(), &actual, &actual_idx);
+
+        if (expected_ok != actual_ok || !HIDJoystickReference::IsSameInput(expected, expected_idx, actual, actual_idx))
+        {
+            fprintf(stderr, "HIDReportLayout: decoded data differs from HIDJoystick (X %f/%f, Y %f/%f)\n", expected.X, actual.X, expected.Y, actual.Y);
+            return 1;
+        }
+    }
+
+    // Decode cost (every report)
+    uint16_t input_idx = 0;
+    start = bench::NowNs();
+    for (uint64_t i = 0; i < iterations; i++)
+    {
+        RawInputData rawData;
+        const std::vector<uint8_t> &report = reports[i % reports.size()];
+        joystick.Decode(report.data(), report.size(), &rawData, &input_idx);
+        bench::DoNotOptimize(rawData);
+    }
+    bench::Report("HIDJoystick (decode report)", iterations, bench::NowNs() - start);
+
+    start = bench::NowNs();
+    for (uint64_t i = 0; i < iterations; i++)
+    {
+        RawInputData rawData;
+        const std::vector<uint8_t> &report = reports[i % reports.size()];
+        layout.Decode(report.data(), report.size(), &rawData, &input_idx);
+        bench::DoNotOptimize(rawData);
+    }
+    bench::Report("HIDReportLayout (decode report)", iterations, bench::NowNs() - start);
+
+    // Same reports in transfer buffers, as given by a read view (GenericHIDController::ReadInput): decoded in place
+    std::vector<uint8_t> transferBuffers(reports.size() * CONTROLLER_INPUT_BUFFER_SIZE, 0);
+    for (size_t i = 0; i < reports.size(); i++)
+        memcpy(&transferBuffers[i * CONTROLLER_INPUT_BUFFER_SIZE], reports[i].data(), reports[i].size());
+
+    start = bench::NowNs();
+    for (uint64_t i = 0; i < iterations; i++)
+    {
+        RawInputData rawData;
+        size_t index = i % reports.size();
+        layout.Decode(&transferBuffers[index * CONTROLLER_INPUT_BUFFER_SIZE], reports[index].size(), &rawData, &input_idx, CONTROLLER_INPUT_BUFFER_SIZE);
+        bench::DoNotOptimize(rawData);
+    }
+    bench::Report("HIDReportLayout (decode read view)", iterations, bench::NowNs() - start);
+
+    return 0;
+}
@@ -0,0 +1,501 @@
+#include "Controllers/HIDReportLayout.h"
+#include "MockDeviceFactory.h"
+#include "HIDJoystickReference.h"
+#include "bench_common.h"
+#include <cstring>
+
+// HIDReportLayout replaced HIDJoystick for every HID report descriptor it compiles (GenericHIDController).
+// For each descriptor below (8/16 bits axes, signed or not, 4 and 8 positions hat switches, 0 or 1 based, report IDs,
+// several joysticks), reports are built from random field values, then decoded by:
+//  - HIDReportLayout: must give the values written, at the position written by hand from the descriptor (FieldSpec)
+//  - HIDJoystick (HIDJoystickReference): must give the same RawInputData as HIDReportLayout
+// Then the decoding cost of both, per descriptor.
+// Captures of real controllers can be checked the same way with: pcap_replay <capture> <vid-pid> --check-hid
+
+namespace
+{
+    enum FieldKind
+    {
+        FieldKind_Axis,
+        FieldKind_Hat,
+        FieldKind_Buttons,
+    };
+
+    // Where a field is in the report, read by hand from the descriptor
+    struct FieldSpec
+    {
+        FieldKind kind;
+        uint8_t index;      // Axis: 0:X 1:Y 2:Z 3:Rx 4:Ry 5:Rz, Buttons: first button
+        uint16_t bitOffset; // From the beginning of the report (Report ID included)
+        uint8_t bitSize;    // Buttons: number of buttons
+        int32_t min;        // Axis/Hat: logical range
+        int32_t max;
+    };
+
+    struct ReportSpec
+    {
+        uint8_t reportId; // 0: no report ID
+        uint16_t joystick;
+        size_t size;
+        std::vector<FieldSpec> fields;
+    };
+
+    struct DescriptorSpec
+    {
+        const char *name;
+        std::vector<uint8_t> descriptor;
+        uint8_t joystickCount;
+        std::vector<ReportSpec> reports;
+    };
+
+    float RawInputData::*const g_axes[] = {&RawInputData::X, &RawInputData::Y, &RawInputData::Z, &RawInputData::Rx, &RawInputData::Ry, &RawInputData::Rz};
+
+    const std::vector<DescriptorSpec> &Descriptors()
+    {
+        static const std::vector<DescriptorSpec> descriptors = {
+            {
+                "generic mock (8 bits axes, hat 0-7)",
+                MockDeviceFactory::GenericHIDReportDescriptor(),
+                1,
+                {{0, 0, 7, {{FieldKind_Axis, 0, 0, 8, 0, 255}, {FieldKind_Axis, 1, 8, 8, 0, 255}, {FieldKind_Axis, 2, 16, 8, 0, 255}, {FieldKind_Axis, 5, 24, 8, 0, 255}, {FieldKind_Hat, 0, 32, 4, 0, 7}, {FieldKind_Buttons, 1, 40, 16, 0, 1}}}},
+            },
+            {
+                "DragonRise 0079:0006 (8 bits axes, Z twice, hat 0-7)",
+                {
+                    0x05, 0x01,       // Usage Page (Generic Desktop)
+                    0x09, 0x04,       // Usage (Joystick)
+                    0xA1, 0x01,       // Collection (Application)
+                    0xA1, 0x02,       //   Collection (Logical)
+                    0x75, 0x08,       //     Report Size (8)
+                    0x95, 0x05,       //     Report Count (5)
+                    0x15, 0x00,       //     Logical Minimum (0)
+                    0x26, 0xFF, 0x00, //     Logical Maximum (255)
+                    0x35, 0x00,       //     Physical Minimum (0)
+                    0x46, 0xFF, 0x00, //     Physical Maximum (255)
+                    0x09, 0x30,       //     Usage (X)
+                    0x09, 0x31,       //     Usage (Y)
+                    0x09, 0x32,       //     Usage (Z)
+                    0x09, 0x32,       //     Usage (Z)
+                    0x09, 0x35,       //     Usage (Rz)
+                    0x81, 0x02,       //     Input (Data,Var,Abs)
+                    0x75, 0x04,       //     Report Size (4)
+                    0x95, 0x01,       //     Report Count (1)
+                    0x25, 0x07,       //     Logical Maximum (7)
+                    0x46, 0x3B, 0x01, //     Physical Maximum (315)
+                    0x65, 0x14,       //     Unit (Degrees)
+                    0x09, 0x39,       //     Usage (Hat switch)
+                    0x81, 0x42,       //     Input (Data,Var,Abs,Null State)
+                    0x65, 0x00,       //     Unit (None)
+                    0x75, 0x01,       //     Report Size (1)
+                    0x95, 0x0C,       //     Report Count (12)
+                    0x25, 0x01,       //     Logical Maximum (1)
+                    0x45, 0x01,       //     Physical Maximum (1)
+                    0x05, 0x09,       //     Usage Page (Button)
+                    0x19, 0x01,       //     Usage Minimum (1)
+                    0x29, 0x0C,       //     Usage Maximum (12)
+                    0x81, 0x02,       //     Input (Data,Var,Abs)
+                    0x06, 0x00, 0xFF, //     Usage Page (Vendor Defined)
+                    0x75, 0x01,       //     Report Size (1)
+                    0x95, 0x08,       //     Report Count (8)
+                    0x25, 0x01,       //     Logical Maximum (1)
+                    0x45, 0x01,       //     Physical Maximum (1)
+                    0x09, 0x01,       //     Usage (Vendor 1)
+                    0x81, 0x02,       //     Input (Data,Var,Abs)
+                    0xC0,             //   End Collection
+                    0xA1, 0x02,       //   Collection (Logical)
+                    0x75, 0x08,       //     Report Size (8)
+                    0x95, 0x07,       //     Report Count (7)
+                    0x46, 0xFF, 0x00, //     Physical Maximum (255)
+                    0x26, 0xFF, 0x00, //     Logical Maximum (255)
+                    0x09, 0x02,       //     Usage (Vendor 2)
+                    0x91, 0x02,       //     Output (Data,Var,Abs)
+                    0xC0,             //   End Collection
+                    0xC0,             // End Collection
+                },
+                1,
+                {{0, 0, 8, {{FieldKind_Axis, 0, 0, 8, 0, 255}, {FieldKind_Axis, 1, 8, 8, 0, 255}, {FieldKind_Axis, 2, 16, 8, 0, 255}, {FieldKind_Axis, 2, 24, 8, 0, 255}, {FieldKind_Axis, 5, 32, 8, 0, 255}, {FieldKind_Hat, 0, 40, 4, 0, 7}, {FieldKind_Buttons, 1, 44, 12, 0, 1}}}},
+            },
+            {
+                "Logitech Dual Action 046d:c216 (8 bits axes, hat 0-7)",
+                {
+                    0x05, 0x01,       // Usage Page (Generic Desktop)
+                    0x09, 0x04,       // Usage (Joystick)
+                    0xA1, 0x01,       // Collection (Application)
+                    0xA1, 0x02,       //   Collection (Logical)
+                    0x15, 0x00,       //     Logical Minimum (0)
+                    0x26, 0xFF, 0x00, //     Logical Maximum (255)
+                    0x35, 0x00,       //     Physical Minimum (0)
+                    0x46, 0xFF, 0x00, //     Physical Maximum (255)
+                    0x75, 0x08,       //     Report Size (8)
+                    0x95, 0x04,       //     Report Count (4)
+                    0x09, 0x30,       //     Usage (X)
+                    0x09, 0x31,       //     Usage (Y)
+                    0x09, 0x32,       //     Usage (Z)
+                    0x09, 0x35,       //     Usage (Rz)
+                    0x81, 0x02,       //     Input (Data,Var,Abs)
+                    0x25, 0x07,       //     Logical Maximum (7)
+                    0x46, 0x3B, 0x01, //     Physical Maximum (315)
+                    0x75, 0x04,       //     Report Size (4)
+                    0x95, 0x01,       //     Report Count (1)
+                    0x65, 0x14,       //     Unit (Degrees)
+                    0x09, 0x39,       //     Usage (Hat switch)
+                    0x81, 0x42,       //     Input (Data,Var,Abs,Null State)
+                    0x65, 0x00,       //     Unit (None)
+                    0x25, 0x01,       //     Logical Maximum (1)
+                    0x45, 0x01,       //     Physical Maximum (1)
+                    0x75, 0x01,       //     Report Size (1)
+                    0x95, 0x0C,       //     Report Count (12)
+                    0x05, 0x09,       //     Usage Page (Button)
+                    0x19, 0x01,       //     Usage Minimum (1)
+                    0x29, 0x0C,       //     Usage Maximum (12)
+                    0x81, 0x02,       //     Input (Data,Var,Abs)
+                    0x06, 0x00, 0xFF, //     Usage Page (Vendor Defined)
+                    0x75, 0x01,       //     Report Size (1)
+                    0x95, 0x10,       //     Report Count (16)
+                    0x25, 0x01,       //     Logical Maximum (1)
+                    0x45, 0x01,       //     Physical Maximum (1)
+                    0x09, 0x01,       //     Usage (Vendor 1)
+                    0x81, 0x02,       //     Input (Data,Var,Abs)
+                    0xC0,             //   End Collection
+                    0xA1, 0x02,       //   Collection (Logical)
+                    0x26, 0xFF, 0x00, //     Logical Maximum (255)
+                    0x46, 0xFF, 0x00, //     Physical Maximum (255)
+                    0x75, 0x08,       //     Report Size (8)
+                    0x95, 0x07,       //     Report Count (7)
+                    0x09, 0x02,       //     Usage (Vendor 2)
+                    0x91, 0x02,       //     Output (Data,Var,Abs)
+                    0xC0,             //   End Collection
+                    0xC0,             // End Collection
+                },
+                1,
+                {{0, 0, 8, {{FieldKind_Axis, 0, 0, 8, 0, 255}, {FieldKind_Axis, 1, 8, 8, 0, 255}, {FieldKind_Axis, 2, 16, 8, 0, 255}, {FieldKind_Axis, 5, 24, 8, 0, 255}, {FieldKind_Hat, 0, 32, 4, 0, 7}, {FieldKind_Buttons, 1, 36, 12, 0, 1}}}},
+            },
+            {
+                "Report ID 1, 16 bits axes 0-65535, hat 0-3 (4 positions)",
+                {
+                    0x05, 0x01,                   // Usage Page (Generic Desktop)
+                    0x09, 0x05,                   // Usage (Game Pad)
+                    0xA1, 0x01,                   // Collection (Application)
+                    0x85, 0x01,                   //   Report ID (1)
+                    0x05, 0x09,                   //   Usage Page (Button)
+                    0x19, 0x01,                   //   Usage Minimum (1)
+                    0x29, 0x10,                   //   Usage Maximum (16)
+                    0x15, 0x00,                   //   Logical Minimum (0)
+                    0x25, 0x01,                   //   Logical Maximum (1)
+                    0x75, 0x01,                   //   Report Size (1)
+                    0x95, 0x10,                   //   Report Count (16)
+                    0x81, 0x02,                   //   Input (Data,Var,Abs)
+                    0x05, 0x01,                   //   Usage Page (Generic Desktop)
+                    0x09, 0x39,                   //   Usage (Hat switch)
+                    0x15, 0x00,                   //   Logical Minimum (0)
+                    0x25, 0x03,                   //   Logical Maximum (3)
+                    0x35, 0x00,                   //   Physical Minimum (0)
+                    0x46, 0x0E, 0x01,             //   Physical Maximum (270)
+                    0x65, 0x14,                   //   Unit (Degrees)
+                    0x75, 0x04,                   //   Report Size (4)
+                    0x95, 0x01,                   //   Report Count (1)
+                    0x81, 0x42,                   //   Input (Data,Var,Abs,Null State)
+                    0x75, 0x04,                   //   Report Size (4)
+                    0x95, 0x01,                   //   Report Count (1)
+                    0x81, 0x03,                   //   Input (Const) - 4 bits padding
+                    0x65, 0x00,                   //   Unit (None)
+                    0x09, 0x01,                   //   Usage (Pointer)
+                    0xA1, 0x00,                   //   Collection (Physical)
+                    0x09, 0x30,                   //     Usage (X)
+                    0x09, 0x31,                   //     Usage (Y)
+                    0x09, 0x33,                   //     Usage (Rx)
+                    0x09, 0x34,                   //     Usage (Ry)
+                    0x15, 0x00,                   //     Logical Minimum (0)
+                    0x27, 0xFF, 0xFF, 0x00, 0x00, //     Logical Maximum (65535)
+                    0x75, 0x10,                   //     Report Size (16)
+                    0x95, 0x04,                   //     Report Count (4)
+                    0x81, 0x02,                   //     Input (Data,Var,Abs)
+                    0xC0,                         //   End Collection
+                    0x05, 0x02,                   //   Usage Page (Simulation Controls)
+                    0x09, 0xC5,                   //   Usage (Brake)
+                    0x09, 0xC4,                   //   Usage (Accelerator)
+                    0x15, 0x00,                   //   Logical Minimum (0)
+                    0x26, 0xFF, 0x03,             //   Logical Maximum (1023)
+                    0x75, 0x0A,                   //   Report Size (10)
+                    0x95, 0x02,                   //   Report Count (2)
+                    0x81, 0x02,                   //   Input (Data,Var,Abs)
+                    0x75, 0x04,                   //   Report Size (4)
+                    0x95, 0x01,                   //   Report Count (1)
+                    0x81, 0x03,                   //   Input (Const) - 4 bits padding
+                    0xC0,                         // End Collection
+                },
+                1,
+                {{1, 0, 15, {{FieldKind_Buttons, 1, 8, 16, 0, 1}, {FieldKind_Hat, 0, 24, 4, 0, 3}, {FieldKind_Axis, 0, 32, 16, 0, 65535}, {FieldKind_Axis, 1, 48, 16, 0, 65535}, {FieldKind_Axis, 3, 64, 16, 0, 65535}, {FieldKind_Axis, 4, 80, 16, 0, 65535}}}},
+            },
+            {
+                "Signed 16 bits axes, hat 1-8 (8 bits)",
+                {
+                    0x05, 0x01,             // Usage Page (Generic Desktop)
+                    0x09, 0x05,             // Usage (Game Pad)
+                    0xA1, 0x01,             // Collection (Application)
+                    0x09, 0x01,             //   Usage (Pointer)
+                    0xA1, 0x00,             //   Collection (Physical)
+                    0x09, 0x30,             //     Usage (X)
+                    0x09, 0x31,             //     Usage (Y)
+                    0x09, 0x32,             //     Usage (Z)
+                    0x09, 0x35,             //     Usage (Rz)
+                    0x16, 0x00, 0x80,       //     Logical Minimum (-32768)
+                    0x26, 0xFF, 0x7F,       //     Logical Maximum (32767)
+                    0x75, 0x10,             //     Report Size (16)
+                    0x95, 0x04,             //     Report Count (4)
+                    0x81, 0x02,             //     Input (Data,Var,Abs)
+                    0xC0,                   //   End Collection
+                    0x05, 0x09,             //   Usage Page (Button)
+                    0x19, 0x01,             //   Usage Minimum (1)
+                    0x29, 0x0A,             //   Usage Maximum (10)
+                    0x15, 0x00,             //   Logical Minimum (0)
+                    0x25, 0x01,             //   Logical Maximum (1)
+                    0x75, 0x01,             //   Report Size (1)
+                    0x95, 0x0A,             //   Report Count (10)
+                    0x81, 0x02,             //   Input (Data,Var,Abs)
+                    0x75, 0x06,             //   Report Size (6)
+                    0x95, 0x01,             //   Report Count (1)
+                    0x81, 0x03,             //   Input (Const) - 6 bits padding
+                    0x05, 0x01,             //   Usage Page (Generic Desktop)
+                    0x09, 0x39,             //   Usage (Hat switch)
+                    0x15, 0x01,             //   Logical Minimum (1)
+                    0x25, 0x08,             //   Logical Maximum (8)
+                    0x35, 0x00,             //   Physical Minimum (0)
+                    0x46, 0x3B, 0x01,       //   Physical Maximum (315)
+                    0x66, 0x14, 0x00,       //   Unit (Degrees)
+                    0x75, 0x08,             //   Report Size (8)
+                    0x95, 0x01,             //   Report Count (1)
+                    0x81, 0x42,             //   Input (Data,Var,Abs,Null State)
+                    0xC0,                   // End Collection
+                },
+                1,
+                {{0, 0, 11, {{FieldKind_Axis, 0, 0, 16, -32768, 32767}, {FieldKind_Axis, 1, 16, 16, -32768, 32767}, {FieldKind_Axis, 2, 32, 16, -32768, 32767}, {FieldKind_Axis, 5, 48, 16, -32768, 32767}, {FieldKind_Buttons, 1, 64, 10, 0, 1}, {FieldKind_Hat, 0, 80, 8, 1, 8}}}},
+            },
+            {
+                "2 joysticks, report IDs 1-2, 8 bits axes unsigned/signed",
+                {
+                    0x05, 0x01,       // Usage Page (Generic Desktop)
+                    0x09, 0x04,       // Usage (Joystick)
+                    0xA1, 0x01,       // Collection (Application)
+                    0x85, 0x01,       //   Report ID (1)
+                    0x09, 0x01,       //   Usage (Pointer)
+                    0xA1, 0x00,       //   Collection (Physical)
+                    0x09, 0x30,       //     Usage (X)
+                    0x09, 0x31,       //     Usage (Y)
+                    0x15, 0x00,       //     Logical Minimum (0)
+                    0x26, 0xFF, 0x00, //     Logical Maximum (255)
+                    0x75, 0x08,       //     Report Size (8)
+                    0x95, 0x02,       //     Report Count (2)
+                    0x81, 0x02,       //     Input (Data,Var,Abs)
+                    0xC0,             //   End Collection
+                    0x09, 0x39,       //   Usage (Hat switch)
+                    0x15, 0x00,       //   Logical Minimum (0)
+                    0x25, 0x07,       //   Logical Maximum (7)
+                    0x35, 0x00,       //   Physical Minimum (0)
+                    0x46, 0x3B, 0x01, //   Physical Maximum (315)
+                    0x65, 0x14,       //   Unit (Degrees)
+                    0x75, 0x04,       //   Report Size (4)
+                    0x95, 0x01,       //   Report Count (1)
+                    0x81, 0x42,       //   Input (Data,Var,Abs,Null State)
+                    0x65, 0x00,       //   Unit (None)
+                    0x81, 0x03,       //   Input (Const) - 4 bits padding
+                    0x05, 0x09,       //   Usage Page (Button)
+                    0x19, 0x01,       //   Usage Minimum (1)
+                    0x29, 0x08,       //   Usage Maximum (8)
+                    0x15, 0x00,       //   Logical Minimum (0)
+                    0x25, 0x01,       //   Logical Maximum (1)
+                    0x75, 0x01,       //   Report Size (1)
+                    0x95, 0x08,       //   Report Count (8)
+                    0x81, 0x02,       //   Input (Data,Var,Abs)
+                    0xC0,             // End Collection
+                    0x05, 0x01,       // Usage Page (Generic Desktop)
+                    0x09, 0x04,       // Usage (Joystick)
+                    0xA1, 0x01,       // Collection (Application)
+                    0x85, 0x02,       //   Report ID (2)
+                    0x09, 0x01,       //   Usage (Pointer)
+                    0xA1, 0x00,       //   Collection (Physical)
+                    0x09, 0x30,       //     Usage (X)
+                    0x09, 0x31,       //     Usage (Y)
+                    0x15, 0x81,       //     Logical Minimum (-127)
+                    0x25, 0x7F,       //     Logical Maximum (127)
+                    0x75, 0x08,       //     Report Size (8)
+                    0x95, 0x02,       //     Report Count (2)
+                    0x81, 0x02,       //     Input (Data,Var,Abs)
+                    0xC0,             //   End Collection
+                    0x09, 0x39,       //   Usage (Hat switch)
+                    0x15, 0x00,       //   Logical Minimum (0)
+                    0x25, 0x07,       //   Logical Maximum (7)
+                    0x35, 0x00,       //   Physical Minimum (0)
+                    0x46, 0x3B, 0x01, //   Physical Maximum (315)
+                    0x65, 0x14,       //   Unit (Degrees)
+                    0x75, 0x04,       //   Report Size (4)
+                    0x95, 0x01,       //   Report Count (1)
+                    0x81, 0x42,       //   Input (Data,Var,Abs,Null State)
+                    0x65, 0x00,       //   Unit (None)
+                    0x81, 0x03,       //   Input (Const) - 4 bits padding
+                    0x05, 0x09,       //   Usage Page (Button)
+                    0x19, 0x01,       //   Usage Minimum (1)
+                    0x29, 0x08,       //   Usage Maximum (8)
+                    0x15, 0x00,       //   Logical Minimum (0)
+                    0x25, 0x01,       //   Logical Maximum (1)
+                    0x75, 0x01,       //   Report Size (1)
+                    0x95, 0x08,       //   Report Count (8)
+                    0x81, 0x02,       //   Input (Data,Var,Abs)
+                    0xC0,             // End Collection
+                },
+                2,
+                {
+                    {1, 0, 5, {{FieldKind_Axis, 0, 8, 8, 0, 255}, {FieldKind_Axis, 1, 16, 8, 0, 255}, {FieldKind_Hat, 0, 24, 4, 0, 7}, {FieldKind_Buttons, 1, 32, 8, 0, 1}}},
+                    {2, 1, 5, {{FieldKind_Axis, 0, 8, 8, -127, 127}, {FieldKind_Axis, 1, 16, 8, -127, 127}, {FieldKind_Hat, 0, 24, 4, 0, 7}, {FieldKind_Buttons, 1, 32, 8, 0, 1}}},
+                },
+            },
+        };
+        return descriptors;
+    }
+
+    void WriteBits(uint8_t *report, uint16_t bitOffset, uint8_t bitSize, uint32_t value)
+    {
+        for (uint8_t i = 0; i < bitSize; i++)
+        {
+            uint8_t mask = 1 << ((bitOffset + i) & 7);
+            if ((value >> i) & 1)
+                report[(bitOffset + i) >> 3] |= mask;
+            else
+                report[(bitOffset + i) >> 3] &= ~mask;
+        }
+    }
+
+    // Random report (Constant and vendor bits too) and the RawInputData it must be decoded to
+    void MakeReport(const ReportSpec &spec, uint64_t *seed, std::vector<uint8_t> *report, RawInputData *expected)
+    {
+        auto next = [seed]() {
+            *seed = *seed * 6364136223846793005ULL + 1442695040888963407ULL;
+            return (uint32_t)(*seed >> 32);
+        };
+
+        report->resize(spec.size);
+        for (uint8_t &byte : *report)
+            byte = next();
+        if (spec.reportId != 0)
+            (*report)[0] = spec.reportId;
+
+        // A usage declared twice (i.e: Z) gets the same value
+        int32_t axes[6];
+        for (int32_t &axis : axes)
+            axis = next();
+
+        for (const FieldSpec &field : spec.fields)
+        {
+            switch (field.kind)
+            {
+                case FieldKind_Axis:
+                {
+                    int32_t value = field.min + (int32_t)((uint32_t)axes[field.index] % (uint32_t)(field.max - field.min + 1));
+                    WriteBits(report->data(), field.bitOffset, field.bitSize, (uint32_t)value);
+                    expected->*g_axes[field.index] = (float)(value - field.min) * 2.0f / (float)(field.max - field.min) - 1.0f;
+                    break;
+                }
+                case FieldKind_Hat:
+                {
+                    // Every value of the field, the ones out of the logical range are the neutral position
+                    uint32_t value = next() & ((1u << field.bitSize) - 1);
+                    WriteBits(report->data(), field.bitOffset, field.bitSize, value);
+
+                    int32_t position = (int32_t)value - field.min;
+                    int32_t positions = field.max - field.min + 1;
+                    int32_t direction = (position >= 0 && position < positions) ? position * 8 / positions : -1;
+                    expected->dpad_up = direction == 0 || direction == 1 || direction == 7;
+                    expected->dpad_right = direction == 1 || direction == 2 || direction == 3;
+                    expected->dpad_down = direction == 3 || direction == 4 || direction == 5;
+                    expected->dpad_left = direction == 5 || direction == 6 || direction == 7;
+                    break;
+                }
+                case FieldKind_Buttons:
+                {
+                    uint32_t value = next();
+                    WriteBits(report->data(), field.bitOffset, field.bitSize, value);
+                    for (uint8_t i = 0; i < field.bitSize; i++)
+                        expected->buttons[field.index + i] = (value >> i) & 1;
+                    break;
+                }
+            }
+        }
+    }
+
+    bool CheckDescriptor(const DescriptorSpec &spec, uint64_t reportsPerId, uint64_t iterations)
+    {
+        HIDReportLayout layout;
+        if (!layout.Compile(spec.descriptor.data(), spec.descriptor.size()) || layout.GetJoystickCount() != spec.joystickCount)
+        {
+            printf("%s: compiled %d joysticks instead of %d (FAIL)\n", spec.name, layout.GetJoystickCount(), spec.joystickCount);
+            return false;
+        }
+
+        HIDJoystickReference joystick(spec.descriptor.data(), spec.descriptor.size());
+        std::vector<std::vector<uint8_t>> reports;
+        uint64_t seed = 1;
+        uint64_t layoutErrors = 0, joystickErrors = 0;
+
+        for (uint64_t i = 0; i < reportsPerId * spec.reports.size(); i++)
+        {
+            const ReportSpec &reportSpec = spec.reports[i % spec.reports.size()];
+            std::vector<uint8_t> report;
+            RawInputData expected, layoutData, joystickData;
+            uint16_t layout_idx = 0, joystick_idx = 0;
+
+            MakeReport(reportSpec, &seed, &report, &expected);
+
+            bool layoutOk = layout.Decode(report.data(), report.size(), &layoutData, &layout_idx);
+            if (!layoutOk || !HIDJoystickReference::IsSameInput(expected, reportSpec.joystick, layoutData, layout_idx))
+            {
+                if (layoutErrors++ == 0)
+                    printf("%s: report %d: HIDReportLayout X %f/%f, Y %f/%f, input %d/%d (FAIL)\n", spec.name, reportSpec.reportId, layoutData.X, expected.X, layoutData.Y, expected.Y, layout_idx, reportSpec.joystick);
+            }
+
+            bool joystickOk = joystick.Decode(report.data(), report.size(), &joystickData, &joystick_idx);
+            if (joystickOk != layoutOk || !HIDJoystickReference::IsSameInput(joystickData, joystick_idx, layoutData, layout_idx))
+            {
+                if (joystickErrors++ == 0)
+                    printf("%s: report %d: HIDJoystick X %f/%f, Y %f/%f, input %d/%d differs from HIDReportLayout (FAIL)\n", spec.name, reportSpec.reportId, joystickData.X, layoutData.X, joystickData.Y, layoutData.Y, joystick_idx, layout_idx);
+            }
+
+            reports.push_back(std::move(report));
+        }
+
+        printf("%-60s %zu reports, %llu HIDReportLayout errors, %llu differences with HIDJoystick\n", spec.name, reports.size(), (unsigned long long)layoutErrors, (unsigned long long)joystickErrors);
+
+        uint16_t input_idx = 0;
+        uint64_t start = bench::NowNs();
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            RawInputData rawData;
+            const std::vector<uint8_t> &report = reports[i % reports.size()];
+            joystick.Decode(report.data(), report.size(), &rawData, &input_idx);
+            bench::DoNotOptimize(rawData);
+        }
+        bench::Report("  HIDJoystick (decode report)", iterations, bench::NowNs() - start);
+
+        start = bench::NowNs();
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            RawInputData rawData;
+            const std::vector<uint8_t> &report = reports[i % reports.size()];
+            layout.Decode(report.data(), report.size(), &rawData, &input_idx);
+            bench::DoNotOptimize(rawData);
+        }
+        bench::Report("  HIDReportLayout (decode report)", iterations, bench::NowNs() - start);
+
+        return layoutErrors == 0 && joystickErrors == 0;
+    }
+} // namespace
+
+int main()
+{
+    const uint64_t iterations = bench::Iterations(1000000);
+    bool ok = true;
+
+    for (const DescriptorSpec &spec : Descriptors())
+        ok = CheckDescriptor(spec, 4096, iterations) && ok;
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,257 @@
+#include "MockDeviceFactory.h"
+#include "HostLogger.h"
+#include "Controllers/Xbox360WirelessController.h"
+#include "bench_common.h"
+#include <algorithm>
+#include <vector>
+
+// Report latency of the two input modes of SwitchVirtualGamepadHandler::onRun, in device time:
+//  - polling: read with a timeout of one period, then sleep for the rest of the period
+//  - event:   read again as soon as a report has been processed, the period is only the read timeout
+// Latency = time between the arrival of a report (mock timestamp) and the end of its processing.
+// Reports arrive at random times around the report rate of the device, so they are not in phase with the loop.
+// The device only keeps its latest report between two reads: "lost" reports were replaced before being read.
+//
+// Receiver: one Xbox 360 pad sending a report around each millisecond, wired or on a slot of the 4-slot wireless receiver
+// (the other slots are idle), in event mode.
+//
+// Rumble: the same wired pad while a game changes the vibration at 60 Hz. Like SwitchHDLHandler::UpdateOutput, the vibration
+// value is polled once per bInterval of the OUT endpoint after the report was processed, and only changes are sent:
+//  - sync:   the former SwitchUSBEndpoint::Write, the input loop posts the transfer and sleeps bInterval
+//  - queued: SetRumble queues the write, the output thread sends it (See IUSBEndpoint::QueueWrite)
+// Fails (exit code 1) if the input latency with queued rumble is worse than without rumble.
+
+#define SIM_DURATION_US   (10 * 1000 * 1000)
+#define SIM_PROCESS_US    30 // ReadInput + hiddbgSetHdlsState IPC, rough value measured on the console
+#define SIM_VIBRATION_US  10 // hidGetActualVibrationValue IPC, rough value
+#define SIM_GAME_FRAME_US 16667
+
+namespace
+{
+    struct LatencyResult
+    {
+        uint64_t reports = 0;
+        uint64_t lost = 0;
+        uint64_t sum_us = 0;
+        uint64_t p99_us = 0;
+        uint64_t max_us = 0;
+        uint64_t rumbles = 0;
+    };
+
+    enum RumbleMode
+    {
+        RumbleMode_None,
+        RumbleMode_Sync,
+        RumbleMode_Queued,
+    };
+
+    std::unique_ptr<MockUSBDevice> CreateDevice(uint32_t interval_us, uint64_t duration_us)
+    {
+        auto device = std::make_unique<MockUSBDevice>(0x0079, 0x0006);
+        MockUSBInterface *interface = device->AddInterface(USB_CLASS_HID, 0x00, 0x00);
+        MockUSBEndpoint *in = interface->AddEndpoint(0x81, 8, 1);
+        in->SetLatestOnly(true);
+
+        const std::vector<uint8_t> &descriptor = MockDeviceFactory::GenericHIDReportDescriptor();
+        interface->AddControlResponse((uint8_t)USB_ENDPOINT_IN | (uint8_t)USB_RECIPIENT_INTERFACE, USB_REQUEST_GET_DESCRIPTOR, (USB_DT_REPORT << 8) | interface->GetDescriptor()->bInterfaceNumber, 0, descriptor.data(), descriptor.size());
+
+        // Fixed seed: every mode sees the same arrivals
+        uint32_t seed = 0x12345678;
+        uint64_t timestamp_us = 0;
+        while (timestamp_us < duration_us)
+        {
+            seed = seed * 1664525 + 1013904223;
+            timestamp_us += interval_us / 2 + (seed >> 8) % interval_us; // [0.5, 1.5] * interval
+
+            uint8_t report[7] = {0x80, 0x80, 0x80, 0x80, 0x0F, (uint8_t)(seed >> 24), 0x00};
+            in->QueueReport(timestamp_us, report, sizeof(report));
+        }
+
+        return device;
+    }
+
+    // One Xbox 360 pad, wired or on the given slot of the wireless receiver
+    std::unique_ptr<MockUSBDevice> CreateXbox360Device(bool wireless, uint8_t activeSlot, uint32_t interval_us, uint64_t duration_us)
+    {
+        auto device = std::make_unique<MockUSBDevice>(0x045e, wireless ? 0x0719 : 0x028e);
+        uint8_t slotCount = wireless ? XBOX360_MAX_INPUTS : 1;
+
+        for (uint8_t slot = 0; slot < slotCount; slot++)
+        {
+            MockUSBInterface *interface = device->AddInterface(USB_CLASS_VENDOR_SPEC, 0x5D, wireless ? 0x81 : 0x01);
+            interface->AddEndpoint(0x81 + slot * 2, 32, wireless ? 1 : 4);
+            interface->AddEndpoint(0x01 + slot * 2, 32, 8);
+        }
+
+        MockUSBEndpoint *in = device->FindMockEndpoint(0x81 + activeSlot * 2);
+        in->SetLatestOnly(true);
+
+        const uint8_t connect[] = {0x08, 0x80};
+        if (wireless)
+            in->QueueReport(0, connect, sizeof(connect));
+
+        uint32_t seed = 0x12345678;
+        uint64_t timestamp_us = 0;
+        while (timestamp_us < duration_us)
+        {
+            seed = seed * 1664525 + 1013904223;
+            timestamp_us += interval_us / 2 + (seed >> 8) % interval_us;
+
+            uint8_t report[24] = {0x00, 0x01, 0x00, 0xf0, 0x00, 0x13};
+            uint8_t *buttons = wireless ? &report[4] : &report[0];
+            buttons[1] = 0x14;
+            buttons[6] = (uint8_t)(seed >> 24);
+            in->QueueReport(timestamp_us, report, wireless ? sizeof(report) : 20);
+        }
+
+        return device;
+    }
+
+    LatencyResult Run(bool eventMode, uint32_t polling_frequency_ms, const std::string &driver, std::unique_ptr<MockUSBDevice> &&device, MockUSBEndpoint *in, RumbleMode rumble = RumbleMode_None)
+    {
+        MockUSBClock &clock = device->GetClock();
+        MockUSBEndpoint *out = device->FindMockEndpoint(0x01);
+        uint64_t rumbleInterval_us = out != NULL ? out->GetDescriptor()->bInterval * 1000 : 0;
+        uint64_t nextVibrationPoll_us = 0;
+        uint64_t lastGameFrame = UINT64_MAX;
+        std::unique_ptr<IController> controller = MockDeviceFactory::CreateController(driver, std::move(device), MockDeviceFactory::DefaultConfig(), std::make_unique<HostLogger>(HostLogger::LevelFromEnv(LogLevelWarning)));
+        std::vector<uint32_t> latencies;
+        LatencyResult result;
+
+        if (R_FAILED(controller->Initialize()))
+            return result;
+
+        // Same timeout as SwitchVirtualGamepadHandler::Initialize
+        uint64_t timeout_us = (polling_frequency_ms * 1000) / controller->GetInputCount();
+
+        while (in->GetPendingCount() > 0)
+        {
+            NormalizedButtonData data;
+            uint16_t input_idx = 0;
+            uint64_t start_us = clock.Now();
+
+            ams::Result rc = controller->ReadInput(&data, &input_idx, timeout_us);
+            if (R_SUCCEEDED(rc))
+            {
+                clock.Advance(SIM_PROCESS_US);
+                latencies.push_back(clock.Now() - in->GetLastArrival());
+            }
+
+            // UpdateOutput
+            if (rumble != RumbleMode_None && clock.Now() >= nextVibrationPoll_us)
+            {
+                clock.Advance(SIM_VIBRATION_US);
+                nextVibrationPoll_us = clock.Now() + rumbleInterval_us;
+
+                uint64_t gameFrame = clock.Now() / SIM_GAME_FRAME_US;
+                if (gameFrame != lastGameFrame)
+                {
+                    float amplitude = (gameFrame % 2) ? 0.75f : 0.25f;
+                    lastGameFrame = gameFrame;
+                    result.rumbles++;
+
+                    if (rumble == RumbleMode_Queued)
+                        controller->SetRumble(input_idx, amplitude, amplitude);
+                    else
+                    {
+                        uint8_t rumbleData[]{0x00, 0x08, 0x00, (uint8_t)(amplitude * 255), (uint8_t)(amplitude * 255), 0x00, 0x00, 0x00};
+                        out->Write(rumbleData, sizeof(rumbleData));
+                        clock.Advance(rumbleInterval_us);
+                    }
+                }
+            }
+
+            if (eventMode && R_SUCCEEDED(rc))
+                continue;
+
+            uint64_t execution_us = clock.Now() - start_us;
+            if (execution_us < timeout_us)
+                clock.Advance(timeout_us - execution_us);
+        }
+
+        controller->Exit();
+
+        result.lost = in->GetOverwrittenCount();
+        if (latencies.empty())
+            return result;
+
+        std::sort(latencies.begin(), latencies.end());
+        result.reports = latencies.size();
+        for (uint32_t latency : latencies)
+            result.sum_us += latency;
+        result.p99_us = latencies[latencies.size() * 99 / 100];
+        result.max_us = latencies.back();
+        return result;
+    }
+} // namespace
+
+int main()
+{
+    static const uint32_t pollingFrequencies[] = {1, 4, 8, 16};
+    static const uint32_t reportIntervals[] = {1000, 4000, 8000};
+
+    printf("%-8s %-9s %-10s %10s %10s %10s %10s %10s\n", "mode", "polling", "report", "reports", "lost", "avg (us)", "p99 (us)", "max (us)");
+    for (uint32_t interval_us : reportIntervals)
+    {
+        for (uint32_t polling_frequency_ms : pollingFrequencies)
+        {
+            for (bool eventMode : {false, true})
+            {
+                std::unique_ptr<MockUSBDevice> device = CreateDevice(interval_us, SIM_DURATION_US);
+                MockUSBEndpoint *in = device->FindMockEndpoint(0x81);
+                LatencyResult result = Run(eventMode, polling_frequency_ms, "generic", std::move(device), in);
+                printf("%-8s %6u ms %7u us %10llu %10llu %10.1f %10llu %10llu\n", eventMode ? "event" : "polling", polling_frequency_ms, interval_us,
+                       (unsigned long long)result.reports, (unsigned long long)result.lost, result.reports ? (double)result.sum_us / result.reports : 0.0,
+                       (unsigned long long)result.p99_us, (unsigned long long)result.max_us);
+            }
+        }
+    }
+
+    printf("\n%-12s %-9s %10s %10s %10s %10s %10s\n", "receiver", "polling", "reports", "lost", "avg (us)", "p99 (us)", "max (us)");
+    for (uint32_t polling_frequency_ms : pollingFrequencies)
+    {
+        for (int slot = -1; slot < XBOX360_MAX_INPUTS; slot++)
+        {
+            bool wireless = slot >= 0;
+            std::unique_ptr<MockUSBDevice> device = CreateXbox360Device(wireless, wireless ? slot : 0, 1000, SIM_DURATION_US);
+            MockUSBEndpoint *in = device->FindMockEndpoint(0x81 + (wireless ? slot : 0) * 2);
+            LatencyResult result = Run(true, polling_frequency_ms, wireless ? "xbox360w" : "xbox360", std::move(device), in);
+
+            char name[16];
+            snprintf(name, sizeof(name), wireless ? "slot %d/4" : "wired", slot + 1);
+            printf("%-12s %6u ms %10llu %10llu %10.1f %10llu %10llu\n", name, polling_frequency_ms, (unsigned long long)result.reports, (unsigned long long)result.lost,
+                   result.reports ? (double)result.sum_us / result.reports : 0.0, (unsigned long long)result.p99_us, (unsigned long long)result.max_us);
+        }
+    }
+
+    printf("\n%-12s %-9s %10s %10s %10s %10s %10s %10s %12s\n", "rumble", "polling", "reports", "lost", "avg (us)", "p99 (us)", "max (us)", "rumbles", "out lat (us)");
+    LatencyResult rumbleResults[3];
+    for (RumbleMode rumble : {RumbleMode_None, RumbleMode_Sync, RumbleMode_Queued})
+    {
+        std::unique_ptr<MockUSBDevice> device = CreateXbox360Device(false, 0, 1000, SIM_DURATION_US);
+        MockUSBEndpoint *in = device->FindMockEndpoint(0x81);
+        MockUSBEndpoint *out = device->FindMockEndpoint(0x01);
+        out->SetRecordWrites(false);
+
+        LatencyResult result = Run(true, 8, "xbox360", std::move(device), in, rumble);
+        const IUSBEndpoint::OutputStats &output = out->GetOutputStats();
+        rumbleResults[rumble] = result;
+
+        static const char *names[] = {"none", "sync", "queued"};
+        printf("%-12s %6u ms %10llu %10llu %10.1f %10llu %10llu %10llu %12.1f\n", names[rumble], 8, (unsigned long long)result.reports, (unsigned long long)result.lost,
+               result.reports ? (double)result.sum_us / result.reports : 0.0, (unsigned long long)result.p99_us, (unsigned long long)result.max_us,
+               (unsigned long long)result.rumbles, output.sent ? (double)output.latencyTotal_us / output.sent : 0.0);
+    }
+
+    // Only the vibration poll is left on the input path
+    const LatencyResult &none = rumbleResults[RumbleMode_None];
+    const LatencyResult &queued = rumbleResults[RumbleMode_Queued];
+    if (queued.rumbles == 0 || queued.p99_us > none.p99_us + SIM_VIBRATION_US || queued.sum_us * none.reports > none.sum_us * queued.reports * 105 / 100)
+    {
+        printf("FAIL: input latency regressed with rumble (avg %.1f us -> %.1f us, p99 %llu us -> %llu us)\n", (double)none.sum_us / none.reports, (double)queued.sum_us / queued.reports,
+               (unsigned long long)none.p99_us, (unsigned long long)queued.p99_us);
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,215 @@
+#include "MockDeviceFactory.h"
+#include "HostLogger.h"
+#include "bench_common.h"
+#include <algorithm>
+#include <vector>
+
+// Compare the two threading models of the input path, in device time, on a single core (sys-con threads share one core):
+//  - thread:  one input thread per controller (SwitchVirtualGamepadHandler, input_mode=1), woken up by its own transfer or timeout
+//  - reactor: one thread for every controller (SwitchInputReactor, input_threads=1), woken up by waitObjects on every transfer event.
+//             The waiters are kept until the controllers change, only the endpoints of the controllers run are re-armed
+//             (their read already posted the transfers again, the re-arm only takes the endpoint lock: not counted).
+//             A transfer already completed doesn't block (no wakeup), the wait is a syscall returning at once
+// Every pad sends a report around each millisecond (random arrival in [0.5, 1.5] ms), the polling period is 1 ms.
+// Latency = time between the arrival of a report and the end of its processing.
+
+#define SIM_DURATION_US  (10 * 1000 * 1000)
+#define SIM_REPORT_US    1000
+#define SIM_PERIOD_US    1000 // polling_frequency_ms=1
+#define SIM_WAKEUP_US    10   // Thread wakeup + context switch, rough value
+#define SIM_WAIT_US      1    // waitObjects returning without blocking (reactor)
+#define SIM_PROCESS_US   30   // ReadInput + hiddbgSetHdlsState IPC, rough value measured on the console
+#define SIM_IDLE_US      5    // Loop without report (timeout: keep-alive, output)
+#define THREAD_STACK_KB  4    // SwitchVirtualGamepadHandler::ThreadStack
+#define REACTOR_STACK_KB 8    // ReactorStack
+
+namespace
+{
+    struct ReactorResult
+    {
+        uint64_t wakeups = 0;
+        uint64_t reports = 0;
+        uint64_t lost = 0;
+        uint64_t busy_us = 0;
+        uint64_t sum_us = 0;
+        uint64_t p99_us = 0;
+        uint64_t max_us = 0;
+    };
+
+    struct Pad
+    {
+        std::unique_ptr<IController> controller;
+        MockUSBEndpoint *in;
+        MockUSBClock *clock;
+        std::vector<uint64_t> arrivals; // Pad time
+        size_t next = 0;                // First arrival not read yet
+        uint64_t phase_us;              // Pad time = simulation time - phase
+        uint64_t lastRun_us;            // Simulation time
+    };
+
+    std::unique_ptr<MockUSBDevice> CreateDevice(uint32_t seed, std::vector<uint64_t> *arrivals)
+    {
+        auto device = std::make_unique<MockUSBDevice>(0x0079, 0x0006);
+        MockUSBInterface *interface = device->AddInterface(USB_CLASS_HID, 0x00, 0x00);
+        MockUSBEndpoint *in = interface->AddEndpoint(0x81, 8, 1);
+        in->SetLatestOnly(true);
+
+        const std::vector<uint8_t> &descriptor = MockDeviceFactory::GenericHIDReportDescriptor();
+        interface->AddControlResponse((uint8_t)USB_ENDPOINT_IN | (uint8_t)USB_RECIPIENT_INTERFACE, USB_REQUEST_GET_DESCRIPTOR, (USB_DT_REPORT << 8) | interface->GetDescriptor()->bInterfaceNumber, 0, descriptor.data(), descriptor.size());
+
+        // Fixed seed per pad: both models see the same arrivals
+        uint64_t timestamp_us = 0;
+        while (timestamp_us < SIM_DURATION_US)
+        {
+            seed = seed * 1664525 + 1013904223;
+            timestamp_us += SIM_REPORT_US / 2 + (seed >> 8) % SIM_REPORT_US;
+
+            uint8_t report[7] = {0x80, 0x80, 0x80, 0x80, 0x0F, (uint8_t)(seed >> 24), 0x00};
+            in->QueueReport(timestamp_us, report, sizeof(report));
+            arrivals->push_back(timestamp_us);
+        }
+
+        return device;
+    }
+
+    // Next time the pad needs the CPU: its next report, or the end of its polling period
+    uint64_t NextEvent(const Pad &pad)
+    {
+        uint64_t deadline_us = pad.lastRun_us + SIM_PERIOD_US;
+        if (pad.next < pad.arrivals.size())
+            return std::min(deadline_us, pad.arrivals[pad.next] + pad.phase_us);
+        return deadline_us;
+    }
+
+    // Run the input loop of the pad at the given time, return the CPU time used
+    uint64_t RunPad(Pad *pad, uint64_t now_us, uint64_t cpuStart_us, std::vector<uint32_t> *latencies, ReactorResult *result)
+    {
+        NormalizedButtonData data;
+        uint16_t input_idx = 0;
+        uint64_t cost_us = SIM_IDLE_US;
+
+        pad->clock->AdvanceTo(now_us - pad->phase_us);
+        if (pad->next < pad->arrivals.size() && pad->arrivals[pad->next] + pad->phase_us <= now_us && R_SUCCEEDED(pad->controller->ReadInput(&data, &input_idx, 0)))
+        {
+            cost_us = SIM_PROCESS_US;
+            latencies->push_back(cpuStart_us + cost_us - (pad->in->GetLastArrival() + pad->phase_us));
+            result->reports++;
+        }
+
+        while (pad->next < pad->arrivals.size() && pad->arrivals[pad->next] + pad->phase_us <= now_us)
+            pad->next++;
+
+        pad->lastRun_us = now_us;
+        return cost_us;
+    }
+
+    ReactorResult Run(bool reactor, size_t padCount)
+    {
+        std::vector<Pad> pads(padCount);
+        std::vector<uint32_t> latencies;
+        ReactorResult result;
+
+        for (size_t i = 0; i < padCount; i++)
+        {
+            std::unique_ptr<MockUSBDevice> device = CreateDevice(0x12345678 + (uint32_t)i, &pads[i].arrivals);
+            pads[i].in = device->FindMockEndpoint(0x81);
+            pads[i].clock = &device->GetClock();
+            pads[i].phase_us = i * SIM_REPORT_US / padCount;
+            pads[i].lastRun_us = pads[i].phase_us;
+            pads[i].controller = MockDeviceFactory::CreateController("generic", std::move(device), MockDeviceFactory::DefaultConfig(), std::make_unique<HostLogger>(HostLogger::LevelFromEnv(LogLevelWarning)));
+            if (R_FAILED(pads[i].controller->Initialize()))
+                return result;
+        }
+
+        uint64_t cpuFree_us = 0;
+        uint64_t end_us = SIM_DURATION_US;
+
+        while (true)
+        {
+            // Earliest pad needing the CPU
+            Pad *pad = &pads[0];
+            for (Pad &candidate : pads)
+            {
+                if (NextEvent(candidate) < NextEvent(*pad))
+                    pad = &candidate;
+            }
+
+            uint64_t event_us = NextEvent(*pad);
+            if (event_us >= end_us)
+                break;
+
+            if (!reactor)
+            {
+                // Each thread blocks between two loops: every run is a wakeup
+                uint64_t start_us = std::max(cpuFree_us, event_us) + SIM_WAKEUP_US;
+                uint64_t cost_us = RunPad(pad, start_us, start_us, &latencies, &result);
+                result.wakeups++;
+                result.busy_us += SIM_WAKEUP_US + cost_us;
+                cpuFree_us = start_us + cost_us;
+                continue;
+            }
+
+            // Reactor: wait on the cached waiters, the thread only blocks if nothing is pending
+            uint64_t start_us = cpuFree_us + SIM_WAIT_US;
+            if (event_us > cpuFree_us)
+            {
+                start_us = event_us + SIM_WAKEUP_US;
+                result.wakeups++;
+                result.busy_us += SIM_WAKEUP_US;
+            }
+            else
+            {
+                result.busy_us += SIM_WAIT_US;
+            }
+
+            // The pad whose transfer completed, then the pads whose period expired
+            uint64_t cpu_us = start_us;
+            cpu_us += RunPad(pad, start_us, cpu_us, &latencies, &result);
+            for (Pad &other : pads)
+            {
+                if (&other != pad && other.lastRun_us + SIM_PERIOD_US <= start_us)
+                    cpu_us += RunPad(&other, start_us, cpu_us, &latencies, &result);
+            }
+
+            result.busy_us += cpu_us - start_us;
+            cpuFree_us = cpu_us;
+        }
+
+        for (Pad &pad : pads)
+        {
+            result.lost += pad.in->GetOverwrittenCount();
+            pad.controller->Exit();
+        }
+
+        if (latencies.empty())
+            return result;
+
+        std::sort(latencies.begin(), latencies.end());
+        for (uint32_t latency : latencies)
+            result.sum_us += latency;
+        result.p99_us = latencies[latencies.size() * 99 / 100];
+        result.max_us = latencies.back();
+        return result;
+    }
+} // namespace
+
+int main()
+{
+    static const size_t padCounts[] = {1, 4, 8};
+
+    printf("%-8s %5s %12s %10s %10s %8s %10s %10s %10s %11s\n", "model", "pads", "wakeups/s", "reports/s", "lost", "cpu %", "avg (us)", "p99 (us)", "max (us)", "stacks (KB)");
+    for (bool reactor : {false, true})
+    {
+        for (size_t padCount : padCounts)
+        {
+            ReactorResult result = Run(reactor, padCount);
+            double seconds = SIM_DURATION_US / 1000000.0;
+            printf("%-8s %5u %12.0f %10.0f %10llu %8.1f %10.1f %10llu %10llu %11u\n", reactor ? "reactor" : "thread", (unsigned)padCount,
+                   result.wakeups / seconds, result.reports / seconds, (unsigned long long)result.lost, result.busy_us * 100.0 / SIM_DURATION_US,
+                   result.reports ? (double)result.sum_us / result.reports : 0.0, (unsigned long long)result.p99_us, (unsigned long long)result.max_us,
+                   reactor ? REACTOR_STACK_KB : (unsigned)(THREAD_STACK_KB * padCount));
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,118 @@
+#include "LatencyHistogram.h"
+#include "bench_common.h"
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+// Cost of LatencyHistogram::Record (called by the input threads on every report, 3 times) and accuracy of its percentiles
+// against the exact ones: a percentile is the upper bound of its log2 bucket, it must be >= the exact value and < 2x of it (or the maximum).
+// The histogram is also recorded while another thread formats it, as syscon::latency does.
+
+namespace
+{
+    uint32_t g_seed = 0x12345678;
+
+    // Report latencies: mostly around a few hundred us, a tail up to a few ms
+    uint64_t NextLatency()
+    {
+        g_seed = g_seed * 1664525 + 1013904223;
+        uint64_t value_us = 100 + (g_seed >> 8) % 400;
+        if ((g_seed & 0xFF) < 3)
+            value_us *= 20;
+        return value_us;
+    }
+
+    bool CheckPercentile(const LatencyHistogram &histogram, const std::vector<uint64_t> &sorted, uint32_t percentile)
+    {
+        uint64_t rank = (sorted.size() * percentile + 99) / 100;
+        uint64_t exact_us = sorted[std::max<uint64_t>(rank, 1) - 1];
+        uint64_t estimate_us = histogram.GetPercentile(percentile);
+        bool ok = estimate_us >= exact_us && estimate_us < std::max<uint64_t>(2 * exact_us, 1);
+
+        printf("p%-3u exact %6llu us, histogram <= %6llu us %s\n", (unsigned)percentile, (unsigned long long)exact_us, (unsigned long long)estimate_us, ok ? "" : "(FAIL)");
+        return ok;
+    }
+} // namespace
+
+int main()
+{
+    uint64_t iterations = bench::Iterations(10000000);
+    bool ok = true;
+
+    {
+        LatencyHistogram histogram;
+        std::vector<uint64_t> values(4096);
+        for (uint64_t &value : values)
+            value = NextLatency();
+
+        uint64_t start = bench::NowNs();
+        for (uint64_t i = 0; i < iterations; i++)
+            histogram.Record(values[i & 4095]);
+        bench::Report("LatencyHistogram::Record", iterations, bench::NowNs() - start);
+        bench::DoNotOptimize(histogram.GetCount());
+
+        if (histogram.GetCount() != iterations)
+        {
+            printf("count %llu, expected %llu (FAIL)\n", (unsigned long long)histogram.GetCount(), (unsigned long long)iterations);
+            ok = false;
+        }
+    }
+
+    {
+        LatencyHistogram histogram;
+        std::vector<uint64_t> values;
+        for (int i = 0; i < 100000; i++)
+        {
+            values.push_back(NextLatency());
+            histogram.Record(values.back());
+        }
+
+        std::sort(values.begin(), values.end());
+        for (uint32_t percentile : {50, 90, 99, 100})
+            ok = CheckPercentile(histogram, values, percentile) && ok;
+
+        if (histogram.GetMax() != values.back())
+        {
+            printf("max %u, expected %llu (FAIL)\n", (unsigned)histogram.GetMax(), (unsigned long long)values.back());
+            ok = false;
+        }
+
+        char line[512];
+        histogram.Format(line, sizeof(line));
+        printf("%s\n", line);
+    }
+
+    // Recorded by one thread while another one formats it: no count lost
+    {
+        LatencyHistogram histogram;
+        std::atomic<bool> done{false};
+        uint64_t formats = 0;
+
+        std::thread reader([&]() {
+            char line[512];
+            while (!done.load())
+            {
+                histogram.Format(line, sizeof(line));
+                formats++;
+            }
+        });
+
+        uint64_t start = bench::NowNs();
+        for (uint64_t i = 0; i < iterations; i++)
+            histogram.Record(i & 1023);
+        bench::Report("LatencyHistogram::Record (read by Format)", iterations, bench::NowNs() - start);
+
+        done = true;
+        reader.join();
+        printf("%llu formats during the records\n", (unsigned long long)formats);
+
+        if (histogram.GetCount() != iterations)
+        {
+            printf("count %llu, expected %llu (FAIL)\n", (unsigned long long)histogram.GetCount(), (unsigned long long)iterations);
+            ok = false;
+        }
+    }
+
+    return ok ? 0 : 1;
+}
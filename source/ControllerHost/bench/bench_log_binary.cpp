@@ -0,0 +1,123 @@
+#include "LogBinary.h"
+#include "bench_common.h"
+#include <cstring>
+#include <string>
+
+// Cost of a log message on the calling thread (syscon::logger::Log), text vs binary (log_binary=1):
+//  - text:   timestamp header + vsnprintf of the message
+//  - binary: LogBinaryRecordHeader + format ID + raw arguments (LogBinaryWriteArgs), the format string is parsed once
+// Every binary message is decoded back (LogBinaryFormatMessage, as log_decode does) and compared to vsnprintf.
+
+#define LINE_SIZE 256 // LOG_RING_LINE_SIZE
+
+namespace
+{
+    struct Message
+    {
+        const char *name;
+        const char *fmt;
+        uint8_t types[LOG_BINARY_MAX_ARGS];
+        int count;
+    };
+
+    size_t FormatText(char *buffer, const char *fmt, ...)
+    {
+        ::std::va_list vl;
+        uint64_t now_ns = bench::NowNs();
+        size_t length = snprintf(buffer, LINE_SIZE, "|D|%02u:%02u:%02u.%03u|%08X| ", (unsigned)(now_ns / 3600000000000ULL % 24), (unsigned)(now_ns / 60000000000ULL % 60),
+                                 (unsigned)(now_ns / 1000000000 % 60), (unsigned)(now_ns / 1000000 % 1000), 0x1234);
+
+        va_start(vl, fmt);
+        vsnprintf(&buffer[length], LINE_SIZE - length, fmt, vl);
+        va_end(vl);
+        return strlen(buffer);
+    }
+
+    size_t FormatBinary(uint8_t *buffer, const Message &message, ...)
+    {
+        ::std::va_list vl;
+        uint16_t id = 1;
+        size_t size = sizeof(LogBinaryRecordHeader);
+
+        memcpy(&buffer[size], &id, sizeof(id));
+        size += sizeof(id);
+
+        va_start(vl, message);
+        size += LogBinaryWriteArgs(&buffer[size], LINE_SIZE - size, message.types, message.count, vl);
+        va_end(vl);
+
+        LogBinaryRecordHeader header = {(uint16_t)(size - sizeof(header)), LogBinaryRecordType_Message, 1, 0x1234, bench::NowNs() / 1000};
+        memcpy(buffer, &header, sizeof(header));
+        return size;
+    }
+
+    bool CheckDecode(const Message &message, const uint8_t *record, size_t size, const char *text)
+    {
+        char decoded[LINE_SIZE];
+        LogBinaryFormatMessage(decoded, sizeof(decoded), message.fmt, record + sizeof(LogBinaryRecordHeader) + sizeof(uint16_t), size - sizeof(LogBinaryRecordHeader) - sizeof(uint16_t));
+
+        // The text line starts with the header
+        const char *expected = strstr(text, "| ") + 2;
+        if (strcmp(decoded, expected) == 0)
+            return true;
+
+        printf("%s: decoded \"%s\", expected \"%s\" (FAIL)\n", message.name, decoded, expected);
+        return false;
+    }
+} // namespace
+
+// Each message is logged with the arguments of its call site in the sysmodule
+#define BENCH_MESSAGE(message, ...)                                                                                                              \
+    do                                                                                                                                           \
+    {                                                                                                                                            \
+        char text[LINE_SIZE];                                                                                                                    \
+        uint8_t record[LINE_SIZE];                                                                                                               \
+        uint64_t start = bench::NowNs();                                                                                                         \
+        for (uint64_t i = 0; i < iterations; i++)                                                                                                \
+        {                                                                                                                                        \
+            FormatText(text, (message).fmt, __VA_ARGS__);                                                                                        \
+            bench::DoNotOptimize(text[0]);                                                                                                       \
+        }                                                                                                                                        \
+        uint64_t text_ns = bench::NowNs() - start;                                                                                               \
+        start = bench::NowNs();                                                                                                                  \
+        size_t size = 0;                                                                                                                         \
+        for (uint64_t i = 0; i < iterations; i++)                                                                                                \
+        {                                                                                                                                        \
+            size = FormatBinary(record, (message), __VA_ARGS__);                                                                                 \
+            bench::DoNotOptimize(record[0]);                                                                                                     \
+        }                                                                                                                                        \
+        uint64_t binary_ns = bench::NowNs() - start;                                                                                             \
+        printf("%-16s text %7.1f ns %4d bytes, binary %7.1f ns %4d bytes\n", (message).name, (double)text_ns / iterations, (int)strlen(text) + 1, \
+               (double)binary_ns / iterations, (int)size);                                                                                       \
+        ok = CheckDecode((message), record, size, text) && ok;                                                                                   \
+    } while (0)
+
+int main()
+{
+    uint64_t iterations = bench::Iterations(1000000);
+    bool ok = true;
+
+    Message messages[] = {
+        {"ReadInput", "Controller[%04x-%04x] DATA: X=%d%%, Y=%d%%, Z=%d%%, Rz=%d%%, B1=%d, B2=%d, B3=%d, B4=%d, B5=%d, B6=%d, B7=%d, B8=%d, B9=%d, B10=%d", {}, 0},
+        {"UpdateHdlState", "SwitchHDLHandler[%04x-%04x] UpdateHdlState - Idx: %d [Button: 0x%016llX LeftX: %d LeftY: %d RightX: %d RightY: %d]", {}, 0},
+        {"EndpointRead", "SwitchUSBEndpoint: ReadAsync %d bytes", {}, 0},
+        {"Strings", "Controller[%04x-%04x] Using profile '%s' (%s) %.2f %-8s|", {}, 0},
+    };
+
+    for (Message &message : messages)
+    {
+        message.count = LogBinaryParseFormat(message.fmt, message.types, LOG_BINARY_MAX_ARGS);
+        if (message.count < 0)
+        {
+            printf("%s: format not supported (FAIL)\n", message.name);
+            return 1;
+        }
+    }
+
+    BENCH_MESSAGE(messages[0], 0x045e, 0x028e, 50, 49, 0, 100, 1, 0, 0, 1, 0, 0, 0, 0, 1, 0);
+    BENCH_MESSAGE(messages[1], 0x045e, 0x028e, 0, 0x0000000000400010ULL, 32767, -32768, 1200, -5);
+    BENCH_MESSAGE(messages[2], 64);
+    BENCH_MESSAGE(messages[3], 0x054c, 0x05c4, "dualshock4", "default", 3.14159, "x");
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,124 @@
+#include "IController.h"
+#include "MockDeviceFactory.h"
+#include "bench_common.h"
+
+// Cost of a driver debug log filtered out by its level, BaseController::ReadInput's "DATA:" message (14 arguments) on every report:
+//  - call:  LogPrint evaluates the arguments and makes the vararg call, the logger drops the message (Before CONTROLLER_LOG)
+//  - macro: CONTROLLER_LOG checks the level first, the arguments are not evaluated
+// Then the same message enabled, to check that CONTROLLER_LOG still logs it.
+
+namespace
+{
+    class CountingLogger : public ILogger
+    {
+    public:
+        LogLevel level;
+        uint64_t printed = 0;
+
+        CountingLogger(LogLevel lvl) : level(lvl) {}
+
+        void Print(LogLevel lvl, const char *format, ::std::va_list vl) override
+        {
+            (void)format;
+            (void)vl;
+            if (lvl >= level)
+                printed++;
+        }
+
+        void PrintBuffer(LogLevel lvl, const uint8_t *buffer, size_t size) override
+        {
+            (void)buffer;
+            (void)size;
+            if (lvl >= level)
+                printed++;
+        }
+
+        bool IsEnabled(LogLevel lvl) const override { return lvl >= level; }
+    };
+
+    class LogController : public IController
+    {
+    public:
+        float axes[4] = {0.5f, 0.25f, 0.0f, 1.0f};
+        bool buttons[16] = {};
+
+        using IController::IController;
+
+        ams::Result Initialize() override { R_SUCCEED(); }
+        void Exit() override {}
+        uint16_t GetInputCount() override { return 1; }
+        ams::Result ReadInput(NormalizedButtonData *normalData, uint16_t *input_idx, uint32_t timeout_us) override
+        {
+            (void)normalData;
+            (void)input_idx;
+            (void)timeout_us;
+            R_SUCCEED();
+        }
+        bool Support(ControllerFeature aFeature) override
+        {
+            (void)aFeature;
+            return false;
+        }
+        ams::Result SetRumble(uint16_t input_idx, float amp_high, float amp_low) override
+        {
+            (void)input_idx;
+            (void)amp_high;
+            (void)amp_low;
+            R_SUCCEED();
+        }
+
+        CountingLogger *GetLogger() { return static_cast<CountingLogger *>(m_logger.get()); }
+
+#define DATA_ARGS                                                                                                                     \
+    "Controller[%04x-%04x] DATA: X=%d%%, Y=%d%%, Z=%d%%, Rz=%d%%, B1=%d, B2=%d, B3=%d, B4=%d, B5=%d, B6=%d, B7=%d, B8=%d, B9=%d, B10=%d", \
+        m_device->GetVendor(), m_device->GetProduct(),                                                                                \
+        (int)(axes[0] * 100.0), (int)(axes[1] * 100.0), (int)(axes[2] * 100.0), (int)(axes[3] * 100.0),                               \
+        buttons[1] ? 1 : 0, buttons[2] ? 1 : 0, buttons[3] ? 1 : 0, buttons[4] ? 1 : 0, buttons[5] ? 1 : 0,                           \
+        buttons[6] ? 1 : 0, buttons[7] ? 1 : 0, buttons[8] ? 1 : 0, buttons[9] ? 1 : 0, buttons[10] ? 1 : 0
+
+        void LogCall() { LogPrint(LogLevelDebug, DATA_ARGS); }
+        void LogMacro() { CONTROLLER_LOG(LogLevelDebug, DATA_ARGS); }
+    };
+
+    uint64_t Run(LogController *controller, bool macro, uint64_t iterations)
+    {
+        uint64_t start = bench::NowNs();
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            controller->buttons[i & 15] = !controller->buttons[i & 15];
+            if (macro)
+                controller->LogMacro();
+            else
+                controller->LogCall();
+        }
+        return bench::NowNs() - start;
+    }
+} // namespace
+
+int main()
+{
+    uint64_t iterations = bench::Iterations(10000000);
+    bool ok = true;
+
+    LogController controller(MockDeviceFactory::CreateDevice("generic"), MockDeviceFactory::DefaultConfig(), std::make_unique<CountingLogger>(LogLevelInfo));
+    CountingLogger *logger = controller.GetLogger();
+
+    bench::Report("debug filtered: LogPrint", iterations, Run(&controller, false, iterations));
+    bench::Report("debug filtered: CONTROLLER_LOG", iterations, Run(&controller, true, iterations));
+
+    if (logger->printed != 0)
+    {
+        printf("%llu messages printed below the level (FAIL)\n", (unsigned long long)logger->printed);
+        ok = false;
+    }
+
+    logger->level = LogLevelDebug;
+    Run(&controller, true, 1000);
+    if (logger->printed != 1000)
+    {
+        printf("%llu messages printed out of 1000 enabled (FAIL)\n", (unsigned long long)logger->printed);
+        ok = false;
+    }
+
+    return ok ? 0 : 1;
+}
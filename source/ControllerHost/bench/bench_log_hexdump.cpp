@@ -0,0 +1,146 @@
+#include "LogHex.h"
+#include "bench_common.h"
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Cost of syscon::logger::LogBuffer, in bytes of buffer dumped per second:
+//  - before: one snprintf("%02X ") per byte, and each line of 16 bytes appended to the file on its own (open, write, flush, close)
+//  - after:  the whole dump rendered in one pass from the digit table (LogHex.h), appended to the file at once and flushed once
+// "format" only renders the text, "file" also writes it (host file system instead of the SD card).
+// The text of both versions must be identical.
+
+#define PREFIX "|T|00:00:01.234|0000ABCD| "
+
+namespace
+{
+    std::string g_path;
+
+    void AppendToFile(const char *text, size_t length)
+    {
+        FILE *file = fopen(g_path.c_str(), "ab");
+        if (file == NULL)
+            return;
+        fwrite(text, 1, length, file);
+        fflush(file);
+        fclose(file);
+    }
+
+    // LogBuffer before: a line for the size, then a line per 16 bytes
+    size_t DumpBefore(std::string *out, const uint8_t *buffer, size_t size, bool write)
+    {
+        char line[256];
+        size_t start_offset = strlen(PREFIX);
+        size_t written = 0;
+
+        memcpy(line, PREFIX, start_offset + 1);
+        snprintf(&line[start_offset], sizeof(line) - start_offset, "Buffer (%ld): ", (long)size);
+
+        out->clear();
+        out->append(line).append("\n");
+        if (write)
+        {
+            AppendToFile(line, strlen(line));
+            AppendToFile("\n", 1);
+        }
+
+        for (size_t i = 0; i < size; i += 16)
+        {
+            for (size_t k = 0; k < std::min((size_t)16, size - i); k++)
+                snprintf(&line[start_offset + (k * 3)], sizeof(line) - (start_offset + (k * 3)), "%02X ", buffer[i + k]);
+
+            out->append(line).append("\n");
+            if (write)
+            {
+                AppendToFile(line, strlen(line));
+                AppendToFile("\n", 1);
+            }
+            written += strlen(line) + 1;
+        }
+
+        return written;
+    }
+
+    // LogBuffer after (synchronous mode): rendered by chunks of the log buffer, written with the file opened once
+    size_t DumpAfter(std::string *out, const uint8_t *buffer, size_t size, bool write)
+    {
+        char text[1024];
+        size_t prefixLength = strlen(PREFIX);
+        size_t written = 0;
+
+        memcpy(text, PREFIX, prefixLength + 1);
+        snprintf(&text[prefixLength], sizeof(text) - prefixLength, "Buffer (%ld): ", (long)size);
+        size_t length = LogHexAppendLines(text, strlen(text), sizeof(text) - 1, PREFIX, prefixLength, &buffer, &size);
+
+        FILE *file = write ? fopen(g_path.c_str(), "ab") : NULL;
+        out->clear();
+        while (length > 0)
+        {
+            text[length++] = '\n';
+            out->append(text, length);
+            if (file != NULL)
+                fwrite(text, 1, length, file);
+            written += length;
+
+            length = LogHexAppendLines(text, 0, sizeof(text) - 1, PREFIX, prefixLength, &buffer, &size);
+        }
+
+        if (file != NULL)
+        {
+            fflush(file);
+            fclose(file);
+        }
+
+        return written;
+    }
+
+    double BytesPerSecond(size_t (*dump)(std::string *, const uint8_t *, size_t, bool), const std::vector<uint8_t> &buffer, bool write, uint64_t iterations)
+    {
+        std::string out;
+        uint64_t start = bench::NowNs();
+        for (uint64_t i = 0; i < iterations; i++)
+            bench::DoNotOptimize(dump(&out, buffer.data(), buffer.size(), write));
+        uint64_t elapsed_ns = bench::NowNs() - start;
+
+        remove(g_path.c_str());
+        return (double)buffer.size() * iterations * 1e9 / std::max<uint64_t>(1, elapsed_ns);
+    }
+} // namespace
+
+int main()
+{
+    uint64_t iterations = bench::Iterations(100000);
+    bool ok = true;
+
+    g_path = std::string(P_tmpdir) + "/bench_log_hexdump.log";
+
+    // Xbox One report, HID report descriptor, USB output buffer
+    printf("%-8s %-6s %14s %14s %8s\n", "size", "mode", "before B/s", "after B/s", "speedup");
+    for (size_t size : {64, 200, 512})
+    {
+        std::vector<uint8_t> buffer(size);
+        for (size_t i = 0; i < size; i++)
+            buffer[i] = (uint8_t)(i * 37 + 11);
+
+        std::string before, after;
+        DumpBefore(&before, buffer.data(), buffer.size(), false);
+        DumpAfter(&after, buffer.data(), buffer.size(), false);
+        if (before != after)
+        {
+            printf("%zu bytes: the dumps differ (FAIL)\n--- before\n%s--- after\n%s", size, before.c_str(), after.c_str());
+            ok = false;
+        }
+
+        for (bool write : {false, true})
+        {
+            uint64_t count = write ? std::max<uint64_t>(1, iterations / 100) : iterations;
+            double beforeRate = BytesPerSecond(DumpBefore, buffer, write, count);
+            double afterRate = BytesPerSecond(DumpAfter, buffer, write, count);
+
+            printf("%-8zu %-6s %14.0f %14.0f %7.1fx\n", size, write ? "file" : "format", beforeRate, afterRate, afterRate / beforeRate);
+        }
+    }
+
+    return ok ? 0 : 1;
+}
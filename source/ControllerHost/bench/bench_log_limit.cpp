@@ -0,0 +1,132 @@
+#include "LogLimit.h"
+#include "bench_common.h"
+#include <thread>
+#include <vector>
+
+// Log lines written by a call site logging on every report (i.e: UpdateHdlState at Debug) at polling_frequency_ms=1, for 10 s of reports:
+//  - the messages kept by the sampling and the token bucket (LogLimit.h), plus the "suppressed" lines
+//  - every message must be either kept or counted in a "suppressed" line (Also with several threads on the same call site)
+// Then the cost of LogLimitPass on the calling thread.
+
+#define REPORTS_PER_S 1000
+#define SECONDS       10
+
+namespace
+{
+    struct Lines
+    {
+        uint64_t kept = 0;
+        uint64_t summaries = 0;
+        uint64_t suppressed = 0;
+    };
+
+    Lines Simulate(const LogLimitConfig &config)
+    {
+        LogLimit limit;
+        Lines lines;
+        for (uint64_t i = 0; i < REPORTS_PER_S * SECONDS; i++)
+        {
+            uint32_t suppressed;
+            if (!LogLimitPass(&limit, config, 1000000000ULL + i * (1000000000ULL / REPORTS_PER_S), &suppressed))
+                continue;
+
+            lines.kept++;
+            lines.summaries += suppressed > 0 ? 1 : 0;
+            lines.suppressed += suppressed;
+        }
+        lines.suppressed += limit.suppressed.load();
+        return lines;
+    }
+
+    bool Check(const char *name, const LogLimitConfig &config, uint64_t maxKept)
+    {
+        Lines lines = Simulate(config);
+        printf("%-24s %6llu messages kept, %4llu suppressed lines, %6.1f lines/s\n", name, (unsigned long long)lines.kept, (unsigned long long)lines.summaries,
+               (double)(lines.kept + lines.summaries) / SECONDS);
+
+        if (lines.kept + lines.suppressed != REPORTS_PER_S * SECONDS)
+        {
+            printf("%s: %llu kept + %llu suppressed out of %d (FAIL)\n", name, (unsigned long long)lines.kept, (unsigned long long)lines.suppressed, REPORTS_PER_S * SECONDS);
+            return false;
+        }
+
+        if (lines.kept > maxKept)
+        {
+            printf("%s: %llu kept, expected at most %llu (FAIL)\n", name, (unsigned long long)lines.kept, (unsigned long long)maxKept);
+            return false;
+        }
+
+        return true;
+    }
+
+    // Several input threads on the same call site, with the real clock
+    bool CheckThreads(const LogLimitConfig &config, int threadCount, uint64_t iterations)
+    {
+        LogLimit limit;
+        std::vector<Lines> lines(threadCount);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < threadCount; t++)
+        {
+            threads.emplace_back([&, t]() {
+                for (uint64_t i = 0; i < iterations; i++)
+                {
+                    uint32_t suppressed;
+                    if (LogLimitPass(&limit, config, bench::NowNs(), &suppressed))
+                    {
+                        lines[t].kept++;
+                        lines[t].suppressed += suppressed;
+                    }
+                }
+            });
+        }
+        for (std::thread &thread : threads)
+            thread.join();
+
+        uint64_t total = limit.suppressed.load();
+        for (const Lines &l : lines)
+            total += l.kept + l.suppressed;
+
+        if (total != iterations * threadCount)
+        {
+            printf("%d threads: %llu messages accounted out of %llu (FAIL)\n", threadCount, (unsigned long long)total, (unsigned long long)(iterations * threadCount));
+            return false;
+        }
+
+        return true;
+    }
+
+    uint64_t Run(const LogLimitConfig &config, uint64_t iterations)
+    {
+        LogLimit limit;
+        uint64_t kept = 0;
+        uint64_t start = bench::NowNs();
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            uint32_t suppressed;
+            kept += LogLimitPass(&limit, config, bench::NowNs(), &suppressed) ? 1 : 0;
+        }
+        uint64_t elapsed_ns = bench::NowNs() - start;
+        bench::DoNotOptimize(kept);
+        return elapsed_ns;
+    }
+} // namespace
+
+int main()
+{
+    uint64_t iterations = bench::Iterations(10000000);
+    bool ok = true;
+
+    // Before: every message, or polling_frequency_ms raised to 100 ms at Debug (10 reports/s)
+    ok = Check("unlimited", {1, 0, 0}, REPORTS_PER_S * SECONDS) && ok;
+    ok = Check("log_sample=8", {8, 0, 0}, REPORTS_PER_S * SECONDS / 8) && ok;
+    ok = Check("log_rate_limit=10", {1, 10, 10}, 10 * SECONDS + 10) && ok;
+    ok = Check("log_sample=8, rate=10", {8, 10, 10}, 10 * SECONDS + 10) && ok;
+
+    ok = CheckThreads({3, 1000, 1000}, 4, iterations / 40) && ok;
+
+    bench::Report("LogLimitPass: unlimited", iterations, Run({1, 0, 0}, iterations));
+    bench::Report("LogLimitPass: log_sample=8", iterations, Run({8, 0, 0}, iterations));
+    bench::Report("LogLimitPass: log_rate_limit=10", iterations, Run({1, 10, 10}, iterations));
+
+    return ok ? 0 : 1;
+}
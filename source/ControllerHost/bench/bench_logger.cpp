@@ -0,0 +1,221 @@
+#include "LogRing.h"
+#include "bench_common.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Throughput of the sysmodule logger with 10 threads logging at the same time (syscon::logger, host file system instead of the SD card):
+//  - sync:  every line takes the mutex, opens the file, appends the line, flushes and closes it (Logger before the flush thread)
+//  - async: every line is formatted into LogRing without lock, one consumer thread appends the lines by 4 KB and flushes once per batch.
+//           A line logged while the ring is full is dropped and counted.
+// Each mode runs as fast as possible (burst), then paced (each thread logs a line every PACED_INTERVAL_US, i.e: a debug line per report at 1 ms polling, 10 controllers).
+// "producer" is the time spent in the logging call by the producer threads, which is what the input threads pay.
+
+#define PRODUCER_COUNT    10
+#define FLUSH_BUFFER      0x1000
+#define FLUSH_PERIOD_MS   100 // LOG_FLUSH_PERIOD_MS
+#define PACED_INTERVAL_US 1000
+
+namespace
+{
+    struct LoggerResult
+    {
+        uint64_t lines = 0;
+        uint64_t written = 0;
+        uint64_t dropped = 0;
+        uint64_t elapsed_ns = 0;
+        uint64_t producer_ns_total = 0;
+        uint64_t producer_ns_max = 0;
+    };
+
+    std::mutex g_printMutex;
+    std::string g_path;
+
+    // The flush thread is woken up when the ring is half full (ueventSignal on the console)
+    std::mutex g_flushMutex;
+    std::condition_variable g_flushEvent;
+
+    size_t FormatLine(char *buffer, size_t size, int thread, uint64_t i)
+    {
+        uint64_t now_ns = bench::NowNs();
+        return std::min<size_t>(snprintf(buffer, size, "|D|%02u:%02u:%02u.%03u|%08X| SwitchHDLHandler[045e-028e] UpdateHdlState - Idx: %d [Button: 0x%016llX LeftX: %d LeftY: %d]",
+                                         (unsigned)(now_ns / 3600000000000ULL % 24), (unsigned)(now_ns / 60000000000ULL % 60), (unsigned)(now_ns / 1000000000 % 60), (unsigned)(now_ns / 1000000 % 1000),
+                                         0x1000 + thread, thread % 4, (unsigned long long)i, (int)(i * 7 % 65536) - 32768, (int)(i * 13 % 65536) - 32768),
+                                size - 1);
+    }
+
+    void LogSync(int thread, uint64_t i)
+    {
+        char line[LOG_RING_LINE_SIZE];
+        FormatLine(line, sizeof(line), thread, i);
+
+        std::scoped_lock lock(g_printMutex);
+        FILE *file = fopen(g_path.c_str(), "ab");
+        if (file == NULL)
+            return;
+        fputs(line, file);
+        fflush(file);
+        fputc('\n', file);
+        fflush(file);
+        fclose(file);
+    }
+
+    bool LogAsync(LogRing *ring, int thread, uint64_t i)
+    {
+        LogRing::Entry *entry = ring->Reserve();
+        if (entry == NULL)
+            return false;
+
+        ring->Commit(entry, FormatLine(entry->data, sizeof(entry->data), thread, i));
+        if (ring->GetUsed() >= LOG_RING_ENTRIES / 2)
+            g_flushEvent.notify_one();
+        return true;
+    }
+
+    // Same as syscon::logger::Flush
+    uint64_t Flush(LogRing *ring, FILE *file)
+    {
+        char buffer[FLUSH_BUFFER];
+        size_t used = 0;
+        uint64_t lines = 0;
+
+        for (const LogRing::Entry *entry = ring->Peek(); entry != NULL; entry = ring->Peek())
+        {
+            if (used + entry->length + 1 > sizeof(buffer))
+            {
+                fwrite(buffer, 1, used, file);
+                used = 0;
+            }
+
+            memcpy(&buffer[used], entry->data, entry->length);
+            used += entry->length;
+            buffer[used++] = '\n';
+            ring->Pop();
+            lines++;
+        }
+
+        if (used > 0)
+            fwrite(buffer, 1, used, file);
+        if (lines > 0)
+            fflush(file);
+
+        return lines;
+    }
+
+    LoggerResult Run(bool async, bool paced, uint64_t linesPerThread)
+    {
+        std::unique_ptr<LogRing> ring = std::make_unique<LogRing>();
+        LoggerResult result;
+        std::vector<std::thread> producers;
+        std::vector<uint64_t> producer_ns_total(PRODUCER_COUNT), producer_ns_max(PRODUCER_COUNT);
+        std::atomic<bool> done{false};
+        uint64_t written = 0;
+
+        remove(g_path.c_str());
+
+        FILE *file = async ? fopen(g_path.c_str(), "ab") : NULL;
+        std::thread consumer;
+        if (async)
+        {
+            consumer = std::thread([&]() {
+                while (!done.load())
+                {
+                    {
+                        std::unique_lock lock(g_flushMutex);
+                        g_flushEvent.wait_for(lock, std::chrono::milliseconds(FLUSH_PERIOD_MS));
+                    }
+                    written += Flush(ring.get(), file);
+                }
+                written += Flush(ring.get(), file);
+            });
+        }
+
+        uint64_t start = bench::NowNs();
+        for (int t = 0; t < PRODUCER_COUNT; t++)
+        {
+            producers.emplace_back([&, t]() {
+                bench::Clock::time_point next = bench::Clock::now();
+                for (uint64_t i = 0; i < linesPerThread; i++)
+                {
+                    if (paced)
+                    {
+                        next += std::chrono::microseconds(PACED_INTERVAL_US);
+                        std::this_thread::sleep_until(next);
+                    }
+
+                    uint64_t lineStart = bench::NowNs();
+                    if (async)
+                        LogAsync(ring.get(), t, i);
+                    else
+                        LogSync(t, i);
+
+                    uint64_t line_ns = bench::NowNs() - lineStart;
+                    producer_ns_total[t] += line_ns;
+                    producer_ns_max[t] = std::max(producer_ns_max[t], line_ns);
+                }
+            });
+        }
+
+        for (std::thread &producer : producers)
+            producer.join();
+        result.elapsed_ns = bench::NowNs() - start;
+
+        if (async)
+        {
+            done = true;
+            g_flushEvent.notify_one();
+            consumer.join();
+            fclose(file);
+            result.written = written;
+        }
+        else
+        {
+            result.written = PRODUCER_COUNT * linesPerThread;
+        }
+
+        result.lines = PRODUCER_COUNT * linesPerThread;
+        result.dropped = async ? ring->GetDropped() : 0;
+        for (int t = 0; t < PRODUCER_COUNT; t++)
+        {
+            result.producer_ns_total += producer_ns_total[t];
+            result.producer_ns_max = std::max(result.producer_ns_max, producer_ns_max[t]);
+        }
+
+        remove(g_path.c_str());
+        return result;
+    }
+} // namespace
+
+int main()
+{
+    uint64_t linesPerThread = bench::Iterations(10000);
+    bool ok = true;
+
+    g_path = std::string(P_tmpdir) + "/bench_logger.log";
+
+    printf("%-6s %-6s %8s %10s %10s %12s %14s %14s\n", "mode", "rate", "threads", "lines", "dropped", "lines/s", "producer avg", "producer max");
+    for (int run = 0; run < 4; run++)
+    {
+        bool paced = run >= 2;
+        bool async = run % 2 == 1;
+        LoggerResult result = Run(async, paced, paced ? linesPerThread / 10 : linesPerThread);
+
+        printf("%-6s %-6s %8d %10llu %10llu %12.0f %11.0f ns %11.0f us\n", async ? "async" : "sync", paced ? "paced" : "burst", PRODUCER_COUNT, (unsigned long long)result.lines, (unsigned long long)result.dropped,
+               result.written * 1e9 / std::max<uint64_t>(1, result.elapsed_ns), (double)result.producer_ns_total / std::max<uint64_t>(1, result.lines), result.producer_ns_max / 1000.0);
+
+        // Every line is either written or counted as dropped
+        if (result.written + result.dropped != result.lines)
+        {
+            printf("%llu written + %llu dropped != %llu lines (FAIL)\n", (unsigned long long)result.written, (unsigned long long)result.dropped, (unsigned long long)result.lines);
+            ok = false;
+        }
+    }
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,90 @@
+#include "Controllers/BaseController.h"
+#include "HostLogger.h"
+#include "bench_common.h"
+
+// Measure the cost of BaseController::ReadInput(NormalizedButtonData) alone:
+// deadzones, analog bindings, buttons mapping and simulated home/capture.
+
+namespace
+{
+    class NullUSBDevice : public IUSBDevice
+    {
+    public:
+        NullUSBDevice()
+        {
+            m_vendorID = 0x1234;
+            m_productID = 0x5678;
+        }
+
+        ams::Result Open() override { R_SUCCEED(); }
+        void Close() override {}
+        void Reset() override {}
+        ams::Result WaitForInput(IUSBEndpoint *const *, size_t, size_t, size_t, size_t *, u64) override { R_RETURN(CONTROL_ERR_INVALID_ENDPOINT); }
+    };
+
+    class SyntheticController : public BaseController
+    {
+    private:
+        uint32_t m_frame = 0;
+
+    public:
+        using BaseController::BaseController;
+        using BaseController::ReadInput;
+
+        ams::Result ReadInput(RawInputData *rawData, uint16_t *input_idx, uint32_t timeout_us) override
+        {
+            (void)timeout_us;
+            *input_idx = 0;
+
+            m_frame++;
+            for (int i = 1; i < 16; i++)
+                rawData->buttons[i] = ((m_frame >> (i & 7)) & 1) != 0;
+
+            rawData->X = Normalize((int32_t)(m_frame * 37) % 65536 - 32768, -32768, 32767);
+            rawData->Y = Normalize((int32_t)(m_frame * 91) % 65536 - 32768, -32768, 32767);
+            rawData->Z = Normalize((int32_t)(m_frame * 13) % 65536 - 32768, -32768, 32767);
+            rawData->Rz = Normalize((int32_t)(m_frame * 7) % 65536 - 32768, -32768, 32767);
+            rawData->Rx = Normalize(m_frame % 256, 0, 255);
+            rawData->Ry = Normalize((m_frame * 3) % 256, 0, 255);
+            rawData->dpad_up = (m_frame & 0x10) != 0;
+            R_SUCCEED();
+        }
+    };
+
+    ControllerConfig MakeConfig()
+    {
+        ControllerConfig config;
+        for (int i = 0; i < ControllerButton::COUNT; i++)
+            config.buttons_pin[i] = (i % 14) + 1;
+
+        config.stickDeadzonePercent[0] = config.stickDeadzonePercent[1] = 20;
+        config.triggerDeadzonePercent[0] = config.triggerDeadzonePercent[1] = 5;
+        config.stickConfig[0].X.bind = ControllerAnalogBinding_X;
+        config.stickConfig[0].Y.bind = ControllerAnalogBinding_Y;
+        config.stickConfig[1].X.bind = ControllerAnalogBinding_Z;
+        config.stickConfig[1].Y.bind = ControllerAnalogBinding_RZ;
+        config.triggerConfig[0].bind = ControllerAnalogBinding_RX;
+        config.triggerConfig[1].bind = ControllerAnalogBinding_RY;
+        config.simulateHome[0] = ControllerButton::MINUS;
+        config.simulateHome[1] = ControllerButton::DPAD_UP;
+        return config;
+    }
+} // namespace
+
+int main()
+{
+    SyntheticController controller(std::make_unique<NullUSBDevice>(), MakeConfig(), std::make_unique<HostLogger>(HostLogger::LevelFromEnv(LogLevelWarning)));
+    NormalizedButtonData data;
+    uint16_t input_idx = 0;
+
+    const uint64_t iterations = bench::Iterations(5000000);
+    uint64_t start = bench::NowNs();
+    for (uint64_t i = 0; i < iterations; i++)
+    {
+        controller.ReadInput(&data, &input_idx, 0);
+        bench::DoNotOptimize(data);
+    }
+    bench::Report("BaseController::ReadInput (normalize)", iterations, bench::NowNs() - start);
+
+    return 0;
+}
@@ -0,0 +1,206 @@
+#include "MockDeviceFactory.h"
+#include "HostLogger.h"
+#include "bench_common.h"
+#include <algorithm>
+#include <vector>
+
+// Input latency with several controllers read by their own handler thread (SwitchVirtualGamepadHandler), in device time.
+// A read holds the USB lock from the post of the transfer until the report arrives (SwitchUSBEndpoint::Read waits for the transfer event):
+//  - global:   one lock for every endpoint (SwitchUSBLock on the data path)
+//  - endpoint: one lock per endpoint session
+// The threads are simulated: the lock is granted in request order, like ams::os::Mutex.
+// Every pad sends a report around each millisecond (random arrival in [0.5, 1.5] ms), out of phase with the other pads,
+// and only keeps its latest report.
+// Latency = time between the arrival of a report and the end of its processing.
+//
+// Hotplug: a controller is initialized by the USB event thread while 2 pads are streaming.
+// UsbEventThreadFunc keeps SwitchUSBLock for the whole bring-up (Fix for setLed failing on XBOX360 wired with several controllers at boot):
+// with the global lock on the data path it also stopped the streaming pads, with the endpoint locks only the usb:hs service calls wait.
+// The gap is the longest time between two reads of the streaming pads.
+
+#define SIM_DURATION_US (10 * 1000 * 1000)
+#define SIM_REPORT_US   1000
+#define SIM_TRANSFER_US 20 // usbHsEpPostBufferAsync + usbHsEpGetXferReport IPC, under the lock
+#define SIM_PROCESS_US  30 // ReadInput + hiddbgSetHdlsState IPC, rough value measured on the console
+#define SIM_HOTPLUG_US  (5 * 1000 * 1000)
+
+namespace
+{
+    struct LatencyResult
+    {
+        uint64_t reports = 0;
+        uint64_t lost = 0;
+        uint64_t sum_us = 0;
+        uint64_t wait_us = 0;
+        uint64_t p99_us = 0;
+        uint64_t max_us = 0;
+        uint64_t bringup_us = 0;
+        uint64_t gap_us = 0;
+    };
+
+    struct Pad
+    {
+        std::unique_ptr<IController> controller;
+        MockUSBEndpoint *in;
+        MockUSBClock *clock;
+        uint64_t phase_us;     // Pad time = simulation time - phase
+        uint64_t ready_us;     // Next read requested at (simulation time)
+        uint64_t lockFree_us;  // Lock of the endpoint released at (simulation time)
+        uint64_t lastRead_us;  // End of the last read (simulation time)
+    };
+
+    std::unique_ptr<MockUSBDevice> CreateDevice(uint32_t seed)
+    {
+        auto device = std::make_unique<MockUSBDevice>(0x0079, 0x0006);
+        MockUSBInterface *interface = device->AddInterface(USB_CLASS_HID, 0x00, 0x00);
+        MockUSBEndpoint *in = interface->AddEndpoint(0x81, 8, 1);
+        in->SetLatestOnly(true);
+
+        const std::vector<uint8_t> &descriptor = MockDeviceFactory::GenericHIDReportDescriptor();
+        interface->AddControlResponse((uint8_t)USB_ENDPOINT_IN | (uint8_t)USB_RECIPIENT_INTERFACE, USB_REQUEST_GET_DESCRIPTOR, (USB_DT_REPORT << 8) | interface->GetDescriptor()->bInterfaceNumber, 0, descriptor.data(), descriptor.size());
+
+        // Fixed seed per pad: every lock mode sees the same arrivals
+        uint64_t timestamp_us = 0;
+        while (timestamp_us < SIM_DURATION_US)
+        {
+            seed = seed * 1664525 + 1013904223;
+            timestamp_us += SIM_REPORT_US / 2 + (seed >> 8) % SIM_REPORT_US;
+
+            uint8_t report[7] = {0x80, 0x80, 0x80, 0x80, 0x0F, (uint8_t)(seed >> 24), 0x00};
+            in->QueueReport(timestamp_us, report, sizeof(report));
+        }
+
+        return device;
+    }
+
+    // Device time spent in Initialize() (control transfers, init packets and their waits)
+    uint64_t GetBringupTime(const std::string &driver)
+    {
+        std::unique_ptr<MockUSBDevice> device = MockDeviceFactory::CreateDevice(driver, 16);
+        MockUSBDevice *mock = device.get();
+        std::unique_ptr<IController> controller = MockDeviceFactory::CreateController(driver, std::move(device), MockDeviceFactory::DefaultConfig(), std::make_unique<HostLogger>(HostLogger::LevelFromEnv(LogLevelWarning)));
+
+        uint64_t start_us = mock->GetClock().Now();
+        controller->Initialize();
+        uint64_t bringup_us = mock->GetClock().Now() - start_us;
+        controller->Exit();
+        return bringup_us;
+    }
+
+    LatencyResult Run(bool globalLock, size_t padCount, const std::string &hotplugDriver = "")
+    {
+        std::vector<Pad> pads(padCount);
+        std::vector<uint32_t> latencies;
+        uint64_t globalLockFree_us = 0;
+        bool hotplugDone = hotplugDriver.empty();
+        LatencyResult result;
+
+        if (!hotplugDone)
+            result.bringup_us = GetBringupTime(hotplugDriver);
+
+        for (size_t i = 0; i < padCount; i++)
+        {
+            std::unique_ptr<MockUSBDevice> device = CreateDevice(0x12345678 + (uint32_t)i);
+            pads[i].in = device->FindMockEndpoint(0x81);
+            pads[i].clock = &device->GetClock();
+            pads[i].phase_us = i * SIM_REPORT_US / padCount;
+            pads[i].ready_us = pads[i].phase_us;
+            pads[i].lockFree_us = 0;
+            pads[i].lastRead_us = pads[i].phase_us;
+            pads[i].controller = MockDeviceFactory::CreateController("generic", std::move(device), MockDeviceFactory::DefaultConfig(), std::make_unique<HostLogger>(HostLogger::LevelFromEnv(LogLevelWarning)));
+            if (R_FAILED(pads[i].controller->Initialize()))
+                return result;
+        }
+
+        while (true)
+        {
+            // Next thread asking for the lock
+            Pad *pad = NULL;
+            for (Pad &candidate : pads)
+            {
+                if (candidate.in->GetPendingCount() > 0 && (pad == NULL || candidate.ready_us < pad->ready_us))
+                    pad = &candidate;
+            }
+
+            if (pad == NULL)
+                break;
+
+            // The event thread asks for SwitchUSBLock and keeps it for the whole bring-up, it only blocks the pads with the global lock
+            if (!hotplugDone && pad->ready_us >= SIM_HOTPLUG_US)
+            {
+                globalLockFree_us = std::max<uint64_t>(globalLockFree_us, SIM_HOTPLUG_US) + result.bringup_us;
+                hotplugDone = true;
+            }
+
+            uint64_t &lockFree_us = globalLock ? globalLockFree_us : pad->lockFree_us;
+            uint64_t start_us = std::max(pad->ready_us, lockFree_us);
+            result.wait_us += start_us - pad->ready_us;
+
+            NormalizedButtonData data;
+            uint16_t input_idx = 0;
+
+            pad->clock->AdvanceTo(start_us - pad->phase_us);
+            if (R_FAILED(pad->controller->ReadInput(&data, &input_idx, 100000)))
+            {
+                pad->ready_us = pad->clock->Now() + pad->phase_us;
+                lockFree_us = pad->ready_us;
+                continue;
+            }
+
+            pad->clock->Advance(SIM_TRANSFER_US);
+            lockFree_us = pad->clock->Now() + pad->phase_us;
+            result.gap_us = std::max(result.gap_us, lockFree_us - pad->lastRead_us);
+            pad->lastRead_us = lockFree_us;
+
+            pad->clock->Advance(SIM_PROCESS_US);
+            latencies.push_back(pad->clock->Now() - pad->in->GetLastArrival());
+            pad->ready_us = pad->clock->Now() + pad->phase_us;
+        }
+
+        for (Pad &pad : pads)
+        {
+            result.lost += pad.in->GetOverwrittenCount();
+            pad.controller->Exit();
+        }
+
+        if (latencies.empty())
+            return result;
+
+        std::sort(latencies.begin(), latencies.end());
+        result.reports = latencies.size();
+        for (uint32_t latency : latencies)
+            result.sum_us += latency;
+        result.p99_us = latencies[latencies.size() * 99 / 100];
+        result.max_us = latencies.back();
+        return result;
+    }
+} // namespace
+
+int main()
+{
+    static const size_t padCounts[] = {1, 2, 4, 8};
+
+    printf("%-9s %5s %10s %10s %10s %10s %10s %14s\n", "lock", "pads", "reports", "lost", "avg (us)", "p99 (us)", "max (us)", "lock wait (us)");
+    for (bool globalLock : {true, false})
+    {
+        for (size_t padCount : padCounts)
+        {
+            LatencyResult result = Run(globalLock, padCount);
+            printf("%-9s %5u %10llu %10llu %10.1f %10llu %10llu %14.1f\n", globalLock ? "global" : "endpoint", (unsigned)padCount,
+                   (unsigned long long)result.reports, (unsigned long long)result.lost, result.reports ? (double)result.sum_us / result.reports : 0.0,
+                   (unsigned long long)result.p99_us, (unsigned long long)result.max_us, result.reports ? (double)result.wait_us / result.reports : 0.0);
+        }
+    }
+
+    printf("\n%-9s %-10s %14s %16s\n", "lock", "hotplug", "bring-up (us)", "worst gap (us)");
+    for (bool globalLock : {true, false})
+    {
+        for (const std::string &driver : MockDeviceFactory::Drivers())
+        {
+            LatencyResult result = Run(globalLock, 2, driver);
+            printf("%-9s %-10s %14llu %16llu\n", globalLock ? "global" : "endpoint", driver.c_str(), (unsigned long long)result.bringup_us, (unsigned long long)result.gap_us);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+// Host replacement for <stratosphere.hpp>
+// Provides ams::Result and the R_xxx control flow macros with the same semantic as Atmosphere-libs,
+// nothing else. Any Switch specific API (os, fs, ...) must stay in ControllerSwitch / Sysmodule.
+
+#include "switch.h"
+#include <memory>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cstring>
+#include <cstdarg>
+
+namespace ams
+{
+    class Result
+    {
+    private:
+        u32 m_value;
+
+    public:
+        constexpr Result() : m_value(0) {}
+        constexpr Result(u32 value) : m_value(value) {}
+
+        constexpr u32 GetValue() const { return m_value; }
+        constexpr bool IsSuccess() const { return m_value == 0; }
+        constexpr bool IsFailure() const { return !IsSuccess(); }
+    };
+
+    constexpr Result ResultSuccess() { return Result(); }
+} // namespace ams
+
+#define R_SUCCEEDED(res) (static_cast<::ams::Result>(res).IsSuccess())
+#define R_FAILED(res)    (static_cast<::ams::Result>(res).IsFailure())
+
+#define R_SUCCEED()                    \
+    {                                  \
+        return ::ams::ResultSuccess(); \
+    }
+
+#define R_RETURN(res_expr)                           \
+    {                                                \
+        return static_cast<::ams::Result>(res_expr); \
+    }
+
+#define R_TRY(res_expr)                                                            \
+    {                                                                              \
+        const ::ams::Result _tmp_r_try_rc = static_cast<::ams::Result>(res_expr); \
+        if (R_FAILED(_tmp_r_try_rc))                                               \
+            return _tmp_r_try_rc;                                                  \
+    }
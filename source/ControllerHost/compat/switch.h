@@ -0,0 +1,82 @@
+#pragma once
+
+// Host replacement for libnx <switch.h>
+// Only the types and constants referenced by ControllerLib are declared here, so the drivers can be
+// built and profiled on a regular Linux/macOS machine (See ControllerHost/Makefile)
+
+#include <cstdint>
+#include <cstddef>
+
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+typedef int8_t s8;
+typedef int16_t s16;
+typedef int32_t s32;
+typedef int64_t s64;
+
+typedef u32 Result;
+
+#ifndef BIT
+    #define BIT(n) (1U << (n))
+#endif
+
+#define R_MODULE(res)      ((res) & 0x1FF)
+#define R_DESCRIPTION(res) (((res) >> 9) & 0x1FFF)
+
+// usb.h
+enum usb_endpoint_direction
+{
+    USB_ENDPOINT_IN = 0x80,
+    USB_ENDPOINT_OUT = 0x00,
+};
+
+enum usb_standard_request
+{
+    USB_REQUEST_GET_STATUS = 0x00,
+    USB_REQUEST_CLEAR_FEATURE = 0x01,
+    USB_REQUEST_SET_FEATURE = 0x03,
+    USB_REQUEST_SET_ADDRESS = 0x05,
+    USB_REQUEST_GET_DESCRIPTOR = 0x06,
+    USB_REQUEST_SET_DESCRIPTOR = 0x07,
+    USB_REQUEST_GET_CONFIGURATION = 0x08,
+    USB_REQUEST_SET_CONFIGURATION = 0x09,
+    USB_REQUEST_GET_INTERFACE = 0x0A,
+    USB_REQUEST_SET_INTERFACE = 0x0B,
+    USB_REQUEST_SYNCH_FRAME = 0x0C,
+};
+
+enum usb_descriptor_type
+{
+    USB_DT_DEVICE = 0x01,
+    USB_DT_CONFIG = 0x02,
+    USB_DT_STRING = 0x03,
+    USB_DT_INTERFACE = 0x04,
+    USB_DT_ENDPOINT = 0x05,
+    USB_DT_HID = 0x21,
+    USB_DT_REPORT = 0x22,
+};
+
+enum usb_class_code
+{
+    USB_CLASS_PER_INTERFACE = 0x00,
+    USB_CLASS_HID = 0x03,
+    USB_CLASS_VENDOR_SPEC = 0xFF,
+};
+
+// hid.h
+typedef enum
+{
+    HidDeviceType_FullKey3 = 3,
+    HidDeviceType_FullKey6 = 6,
+    HidDeviceType_LarkHvcLeft = 7,
+    HidDeviceType_LarkNesLeft = 9,
+    HidDeviceType_Lucia = 11,
+    HidDeviceType_Palma = 12,
+    HidDeviceType_FullKey13 = 13,
+    HidDeviceType_FullKey15 = 15,
+    HidDeviceType_System19 = 19,
+    HidDeviceType_Lagon = 22,
+    HidDeviceType_Lager = 28,
+} HidDeviceType;
@@ -0,0 +1,129 @@
+#include "LogBinary.h"
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Rebuild the text of a binary log recorded by the sysmodule (log.bin, log_binary=1), in the same form as log.log
+//   log_decode <log.bin>
+
+namespace
+{
+    const char g_levels[] = {'T', 'D', 'I', 'W', 'E'};
+
+    struct Format
+    {
+        std::vector<uint8_t> types;
+        std::string text;
+    };
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "Usage: %s <log.bin>\n", argv[0]);
+        return 1;
+    }
+
+    FILE *file = fopen(argv[1], "rb");
+    if (file == NULL)
+    {
+        fprintf(stderr, "Unable to open %s\n", argv[1]);
+        return 1;
+    }
+
+    std::unordered_map<uint16_t, Format> formats;
+    LogBinaryRecordHeader header;
+    std::vector<uint8_t> payload;
+    uint64_t records = 0;
+    uint64_t unknown = 0;
+    bool started = false;
+
+    while (fread(&header, sizeof(header), 1, file) == 1)
+    {
+        payload.resize(header.length);
+        if (payload.size() > 0 && fread(payload.data(), payload.size(), 1, file) != 1)
+        {
+            fprintf(stderr, "Truncated record at the end of the log\n");
+            break;
+        }
+        records++;
+
+        if (header.type == LogBinaryRecordType_Start)
+        {
+            LogBinaryStart start = {};
+            if (payload.size() >= sizeof(start))
+                memcpy(&start, payload.data(), sizeof(start));
+
+            if (start.magic != LOG_BINARY_MAGIC || start.version != LOG_BINARY_VERSION)
+            {
+                fprintf(stderr, "%s: not a sys-con binary log (or unsupported version)\n", argv[1]);
+                fclose(file);
+                return 1;
+            }
+
+            // New boot: the format IDs start over
+            formats.clear();
+            started = true;
+            continue;
+        }
+
+        if (!started)
+        {
+            fprintf(stderr, "%s: not a sys-con binary log\n", argv[1]);
+            fclose(file);
+            return 1;
+        }
+
+        if (header.type == LogBinaryRecordType_Text)
+        {
+            printf("%.*s\n", (int)payload.size(), (const char *)payload.data());
+        }
+        else if (header.type == LogBinaryRecordType_Format)
+        {
+            uint16_t id;
+            if (payload.size() < sizeof(id) + 1)
+                continue;
+
+            memcpy(&id, payload.data(), sizeof(id));
+            uint8_t count = payload[sizeof(id)];
+            size_t textOffset = sizeof(id) + 1 + count;
+            if (textOffset > payload.size())
+                continue;
+
+            Format &format = formats[id];
+            format.types.assign(payload.begin() + sizeof(id) + 1, payload.begin() + textOffset);
+            format.text.assign((const char *)payload.data() + textOffset, payload.size() - textOffset);
+        }
+        else if (header.type == LogBinaryRecordType_Message)
+        {
+            uint16_t id;
+            if (payload.size() < sizeof(id))
+                continue;
+            memcpy(&id, payload.data(), sizeof(id));
+
+            printf("|%c|%02llu:%02llu:%02llu.%03llu|%08X| ", header.level < sizeof(g_levels) ? g_levels[header.level] : '?',
+                   (unsigned long long)(header.timestamp_us / 3600000000ULL % 24), (unsigned long long)(header.timestamp_us / 60000000ULL % 60),
+                   (unsigned long long)(header.timestamp_us / 1000000ULL % 60), (unsigned long long)(header.timestamp_us / 1000ULL % 1000), header.threadId);
+
+            auto it = formats.find(id);
+            if (it == formats.end())
+            {
+                printf("<unknown format %d>\n", id);
+                unknown++;
+                continue;
+            }
+
+            char text[1024];
+            LogBinaryFormatMessage(text, sizeof(text), it->second.text.c_str(), payload.data() + sizeof(id), payload.size() - sizeof(id));
+            printf("%s\n", text);
+        }
+    }
+
+    fclose(file);
+
+    fprintf(stderr, "%llu records, %llu messages with an unknown format\n", (unsigned long long)records, (unsigned long long)unknown);
+    return 0;
+}
@@ -0,0 +1,225 @@
+#include "USBPcapImporter.h"
+#include "MockDeviceFactory.h"
+#include "HostLogger.h"
+#include "HIDJoystickReference.h"
+#include "Controllers/HIDReportLayout.h"
+#include "../bench/bench_common.h"
+#include <cstring>
+#include <cstdlib>
+
+// Replay a Wireshark capture (USBPcap or usbmon, pcapng) through the real driver
+//   pcap_replay <capture.pcapng> <vid-pid> [--driver name] [--device bus:address] [--quiet] [--check-hid]
+//
+// The traffic of the device is rebuilt as a MockUSBDevice, then the driver is initialized and
+// ReadInput is called until every captured IN report has been consumed.
+// Every decoded report (NormalizedButtonData) is printed, unless --quiet, followed by the decoding cost.
+//
+// --check-hid: the captured HID report descriptor is compiled by HIDReportLayout, then every captured IN report
+// is decoded by HIDReportLayout and HIDJoystick (GenericHIDController before HIDReportLayout), both must give the same RawInputData.
+
+namespace
+{
+    void Usage(const char *name)
+    {
+        fprintf(stderr, "Usage: %s <capture.pcapng> <vid-pid> [--driver xbox360|xbox360w|xboxone|xbox|dualshock3|generic] [--device bus:address] [--quiet] [--check-hid]\n", name);
+    }
+
+    size_t GetPendingReports(MockUSBDevice *device)
+    {
+        size_t pending = 0;
+
+        for (size_t i = 0;; i++)
+        {
+            MockUSBInterface *interface = device->GetMockInterface(i);
+            if (interface == NULL)
+                break;
+
+            for (uint8_t idx = 0; idx < MOCK_USB_MAX_ENDPOINTS; idx++)
+            {
+                MockUSBEndpoint *endpoint = interface->GetMockEndpoint(IUSBEndpoint::USB_ENDPOINT_IN, idx);
+                if (endpoint == NULL)
+                    break;
+                pending += endpoint->GetPendingCount();
+            }
+        }
+
+        return pending;
+    }
+
+    int CheckHID(const USBPcapImporter &importer, bool quiet)
+    {
+        std::unique_ptr<MockUSBDevice> device = importer.CreateDevice();
+        MockUSBInterface *interface = device->GetMockInterface(0);
+        MockUSBEndpoint *endpoint = interface != NULL ? interface->GetMockEndpoint(IUSBEndpoint::USB_ENDPOINT_IN, 0) : NULL;
+        if (endpoint == NULL)
+        {
+            fprintf(stderr, "--check-hid: no HID interface with an IN endpoint\n");
+            return 1;
+        }
+
+        uint8_t descriptor[CONTROLLER_HID_REPORT_BUFFER_SIZE];
+        uint16_t descriptorSize = sizeof(descriptor);
+        ams::Result rc = interface->ControlTransferInput((uint8_t)USB_ENDPOINT_IN | (uint8_t)USB_RECIPIENT_INTERFACE, USB_REQUEST_GET_DESCRIPTOR, (USB_DT_REPORT << 8) | interface->GetDescriptor()->bInterfaceNumber, 0, descriptor, &descriptorSize);
+        if (R_FAILED(rc))
+        {
+            fprintf(stderr, "--check-hid: HID report descriptor not captured (0x%X)\n", rc.GetValue());
+            return 1;
+        }
+
+        HIDReportLayout layout;
+        if (!layout.Compile(descriptor, descriptorSize))
+        {
+            fprintf(stderr, "--check-hid: HID report descriptor not supported by HIDReportLayout (%d bytes)\n", descriptorSize);
+            return 1;
+        }
+
+        HIDJoystickReference joystick(descriptor, descriptorSize);
+        uint64_t reports = 0, differences = 0;
+
+        endpoint->Open();
+        while (endpoint->GetPendingCount() > 0)
+        {
+            uint8_t report[CONTROLLER_INPUT_BUFFER_SIZE];
+            size_t size = sizeof(report);
+            if (R_FAILED(endpoint->Read(report, &size, 100000)) || size == 0)
+                continue;
+
+            RawInputData layoutData, joystickData;
+            uint16_t layout_idx = 0, joystick_idx = 0;
+            bool layoutOk = layout.Decode(report, size, &layoutData, &layout_idx);
+            bool joystickOk = joystick.Decode(report, size, &joystickData, &joystick_idx);
+
+            reports++;
+            if (layoutOk != joystickOk || (layoutOk && !HIDJoystickReference::IsSameInput(layoutData, layout_idx, joystickData, joystick_idx)))
+            {
+                if (!quiet && differences < 10)
+                    printf("%10.3f ms: HIDReportLayout [%d] X %+.3f Y %+.3f, HIDJoystick [%d] X %+.3f Y %+.3f\n", device->GetClock().Now() / 1000.0,
+                           layout_idx, layoutData.X, layoutData.Y, joystick_idx, joystickData.X, joystickData.Y);
+                differences++;
+            }
+        }
+        endpoint->Close();
+
+        fprintf(stderr, "--check-hid: %llu reports, %llu differences between HIDReportLayout and HIDJoystick\n", (unsigned long long)reports, (unsigned long long)differences);
+        return differences == 0 ? 0 : 1;
+    }
+
+    void PrintReport(uint64_t timestamp_us, uint16_t input_idx, const NormalizedButtonData &data)
+    {
+        printf("%10.3f ms [%d] buttons:", timestamp_us / 1000.0, input_idx);
+        for (int i = 0; i < ControllerButton::COUNT; i++)
+        {
+            if (data.buttons[i])
+                printf(" %d", i);
+        }
+        printf("  L(%+.2f,%+.2f) R(%+.2f,%+.2f) LT %.2f RT %.2f\n",
+               data.sticks[0].axis_x, data.sticks[0].axis_y, data.sticks[1].axis_x, data.sticks[1].axis_y, data.triggers[0], data.triggers[1]);
+    }
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    if (argc < 3)
+    {
+        Usage(argv[0]);
+        return 1;
+    }
+
+    const char *path = argv[1];
+    unsigned vendor = 0, product = 0;
+    if (sscanf(argv[2], "%x-%x", &vendor, &product) != 2)
+    {
+        Usage(argv[0]);
+        return 1;
+    }
+
+    std::string driver;
+    bool quiet = false;
+    bool checkHID = false;
+    int bus = -1, address = -1;
+
+    for (int i = 3; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--driver") == 0 && i + 1 < argc)
+            driver = argv[++i];
+        else if (strcmp(argv[i], "--device") == 0 && i + 1 < argc && sscanf(argv[i + 1], "%d:%d", &bus, &address) == 2)
+            i++;
+        else if (strcmp(argv[i], "--quiet") == 0)
+            quiet = true;
+        else if (strcmp(argv[i], "--check-hid") == 0)
+            checkHID = true;
+        else
+        {
+            Usage(argv[0]);
+            return 1;
+        }
+    }
+
+    USBPcapImporter importer(vendor, product);
+    if (address >= 0)
+        importer.SetDeviceAddress(bus, address);
+
+    uint64_t start = bench::NowNs();
+    bool imported = importer.Import(path);
+    uint64_t importNs = bench::NowNs() - start;
+
+    fprintf(stderr, "%s: %llu packets (%llu USB) read in %.1f ms\n", path, (unsigned long long)importer.GetPacketCount(), (unsigned long long)importer.GetUsbPacketCount(), importNs / 1e6);
+    if (!imported)
+        fprintf(stderr, "%s: %s (continue with the packets read so far)\n", path, importer.GetError().c_str());
+
+    if (!importer.IsDeviceFound())
+    {
+        fprintf(stderr, "Device %04x-%04x not found (The capture must contain the device enumeration, or use --device bus:address)\n", vendor, product);
+        return 1;
+    }
+
+    if (driver.empty())
+        driver = importer.GetDefaultDriver();
+
+    fprintf(stderr, "Device %04x-%04x: bus %d address %d, %zu reports, %zu control responses, config descriptor: %s, driver: %s\n",
+            vendor, product, importer.GetBus(), importer.GetDevice(), importer.GetReportCount(), importer.GetControlResponseCount(),
+            importer.HasConfigDescriptor() ? "yes" : "no", driver.c_str());
+
+    if (checkHID)
+        return CheckHID(importer, quiet);
+
+    std::unique_ptr<MockUSBDevice> device = importer.CreateDevice();
+    MockUSBDevice *mock = device.get();
+    std::unique_ptr<IController> controller = MockDeviceFactory::CreateController(driver, std::move(device), MockDeviceFactory::DefaultConfig(), std::make_unique<HostLogger>(HostLogger::LevelFromEnv(LogLevelWarning)));
+
+    ams::Result rc = controller->Initialize();
+    if (R_FAILED(rc))
+    {
+        fprintf(stderr, "Initialize failed: 0x%X\n", rc.GetValue());
+        return 1;
+    }
+
+    NormalizedButtonData data;
+    uint16_t input_idx = 0;
+    uint64_t reports = 0, errors = 0;
+    uint64_t decodeNs = 0;
+
+    // The timeout only moves the virtual clock, it never sleeps
+    while (GetPendingReports(mock) > 0)
+    {
+        start = bench::NowNs();
+        rc = controller->ReadInput(&data, &input_idx, 100000);
+        decodeNs += bench::NowNs() - start;
+
+        if (R_SUCCEEDED(rc))
+        {
+            reports++;
+            if (!quiet)
+                PrintReport(mock->GetClock().Now(), input_idx, data);
+        }
+        else if (rc.GetValue() != MOCKUSB_RESULT_TIMEOUT)
+        {
+            errors++;
+        }
+    }
+
+    controller->Exit();
+
+    fprintf(stderr, "%llu reports decoded, %llu ignored/errors, %.1f ns/report\n", (unsigned long long)reports, (unsigned long long)errors, reports ? (double)decodeNs / reports : 0.0);
+    return 0;
+}
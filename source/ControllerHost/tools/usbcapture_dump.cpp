@@ -0,0 +1,112 @@
+#include "USBCapture.h"
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+// Print a capture recorded by the sysmodule (usb_capture.scap) in a readable form
+//   usbcapture_dump <file.scap>
+
+namespace
+{
+    const char *RecordTypeName(uint8_t type)
+    {
+        switch (type)
+        {
+            case UsbCaptureRecordType_In:
+                return "IN";
+            case UsbCaptureRecordType_Out:
+                return "OUT";
+            case UsbCaptureRecordType_ControlIn:
+                return "CTRL_IN";
+            case UsbCaptureRecordType_ControlOut:
+                return "CTRL_OUT";
+            case UsbCaptureRecordType_Interface:
+                return "INTERFACE";
+            case UsbCaptureRecordType_Dropped:
+                return "DROPPED";
+        }
+        return "?";
+    }
+
+    void PrintHex(const uint8_t *data, size_t size)
+    {
+        for (size_t i = 0; i < size; i++)
+            printf("%02X ", data[i]);
+    }
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "Usage: %s <file.scap>\n", argv[0]);
+        return 1;
+    }
+
+    FILE *file = fopen(argv[1], "rb");
+    if (file == NULL)
+    {
+        fprintf(stderr, "Unable to open %s\n", argv[1]);
+        return 1;
+    }
+
+    UsbCaptureFileHeader fileHeader;
+    if (fread(&fileHeader, sizeof(fileHeader), 1, file) != 1 || fileHeader.magic != USB_CAPTURE_MAGIC || fileHeader.version != USB_CAPTURE_VERSION)
+    {
+        fprintf(stderr, "%s: not a sys-con USB capture (or unsupported version)\n", argv[1]);
+        fclose(file);
+        return 1;
+    }
+    fseek(file, fileHeader.headerSize, SEEK_SET);
+
+    UsbCaptureRecordHeader header;
+    std::vector<uint8_t> payload;
+    uint64_t timestamp_us = 0;
+    uint64_t records = 0;
+
+    while (fread(&header, sizeof(header), 1, file) == 1)
+    {
+        payload.resize(USB_CAPTURE_ALIGN(header.length));
+        if (payload.size() > 0 && fread(payload.data(), payload.size(), 1, file) != 1)
+        {
+            fprintf(stderr, "Truncated record at the end of the capture\n");
+            break;
+        }
+
+        // Unwrap the 32 bits timestamp, records are in chronological order
+        uint64_t wrapped = (timestamp_us & ~(uint64_t)UINT32_MAX) | header.timestamp_us;
+        timestamp_us = wrapped < timestamp_us ? wrapped + ((uint64_t)1 << 32) : wrapped;
+
+        printf("%10.3f ms  if=%-3d %-9s ep=0x%02X rc=0x%08X len=%-4d ", timestamp_us / 1000.0, header.interfaceId, RecordTypeName(header.type), header.endpoint, header.result, header.length);
+
+        if (header.type == UsbCaptureRecordType_Interface && header.length >= sizeof(UsbCaptureInterfaceInfo))
+        {
+            UsbCaptureInterfaceInfo info;
+            memcpy(&info, payload.data(), sizeof(info));
+            printf("%04x-%04x interface %d class 0x%02X/0x%02X/0x%02X", info.idVendor, info.idProduct, info.bInterfaceNumber, info.bInterfaceClass, info.bInterfaceSubClass, info.bInterfaceProtocol);
+        }
+        else if ((header.type == UsbCaptureRecordType_ControlIn || header.type == UsbCaptureRecordType_ControlOut) && header.length >= sizeof(UsbCaptureSetupPacket))
+        {
+            UsbCaptureSetupPacket setup;
+            memcpy(&setup, payload.data(), sizeof(setup));
+            printf("[%02X %02X %04X %04X %d] ", setup.bmRequestType, setup.bmRequest, setup.wValue, setup.wIndex, setup.wLength);
+            PrintHex(payload.data() + sizeof(setup), header.length - sizeof(setup));
+        }
+        else if (header.type == UsbCaptureRecordType_Dropped && header.length >= sizeof(uint32_t))
+        {
+            uint32_t count;
+            memcpy(&count, payload.data(), sizeof(count));
+            printf("%u records lost", count);
+        }
+        else
+        {
+            PrintHex(payload.data(), header.length);
+        }
+        printf("\n");
+        records++;
+    }
+
+    fclose(file);
+    fprintf(stderr, "%llu records\n", (unsigned long long)records);
+    return 0;
+}
@@ -0,0 +1,281 @@
+#pragma once
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// config.ini parsed once in memory (Same syntax as ams::util::ini / inih):
+//  - the sections are indexed by their lowercase name, the lines of all the sections with the same name are merged in file order
+//  - the keys are lowercased and interned once, an entry only keeps the ID of its key
+// A controller config is then resolved from 3 sections looked up by name: [default], [<profile>], [<vid-pid>] (See GetControllerSections).
+// When the file is parsed again, only the controllers depending on a section changed need to be resolved again (See GetChangedSections).
+
+class ConfigStore
+{
+public:
+    struct Entry
+    {
+        uint16_t key;
+        std::string value;
+    };
+
+    struct Section
+    {
+        std::string name;
+        std::vector<Entry> entries;
+    };
+
+    static constexpr int MaxControllerSections = 3;
+
+    void Clear()
+    {
+        m_keys.clear();
+        m_keyIds.clear();
+        m_sections.clear();
+        m_sectionIds.clear();
+    }
+
+    void Parse(const char *text, size_t size)
+    {
+        Clear();
+
+        const char *end = text + size;
+        int section = -1;
+        int prevKey = -1;
+        std::string line;
+
+        // UTF-8 BOM
+        if (size >= 3 && memcmp(text, "\xEF\xBB\xBF", 3) == 0)
+            text += 3;
+
+        while (text < end)
+        {
+            const char *eol = (const char *)memchr(text, '\n', end - text);
+            if (eol == NULL)
+                eol = end;
+
+            line.assign(text, eol - text);
+            text = eol + 1;
+
+            size_t start = 0;
+            while (start < line.size() && isspace((unsigned char)line[start]))
+                start++;
+            size_t stop = TrimRight(line, start, line.size());
+
+            if (start == stop || line[start] == ';' || line[start] == '#')
+                continue;
+
+            if (prevKey >= 0 && start > 0)
+            {
+                // Continuation of the previous value (Indented line)
+                AddEntry(section, prevKey, line, start, FindCharsOrComment(line, start, stop, NULL));
+            }
+            else if (line[start] == '[')
+            {
+                size_t close = FindCharsOrComment(line, start + 1, stop, "]");
+                if (close < stop && line[close] == ']')
+                {
+                    section = GetSection(line.substr(start + 1, close - start - 1));
+                    prevKey = -1;
+                }
+            }
+            else
+            {
+                size_t separator = FindCharsOrComment(line, start, stop, "=:");
+                if (separator >= stop || (line[separator] != '=' && line[separator] != ':'))
+                    continue;
+
+                size_t valueStart = separator + 1;
+                while (valueStart < stop && isspace((unsigned char)line[valueStart]))
+                    valueStart++;
+
+                prevKey = InternKey(line.substr(start, TrimRight(line, start, separator) - start));
+                AddEntry(section, prevKey, line, valueStart, FindCharsOrComment(line, valueStart, stop, NULL));
+            }
+        }
+    }
+
+    // lowercaseName: i.e "default", "045e-028e"
+    const Section *FindSection(const std::string &lowercaseName) const
+    {
+        auto it = m_sectionIds.find(lowercaseName);
+        return it != m_sectionIds.end() ? &m_sections[it->second] : NULL;
+    }
+
+    // ID of a lowercase key, -1 when no line uses it
+    int FindKey(const char *lowercaseName) const
+    {
+        auto it = m_keyIds.find(lowercaseName);
+        return it != m_keyIds.end() ? it->second : -1;
+    }
+
+    const std::string &GetKey(uint16_t key) const { return m_keys[key]; }
+
+    // Last value of a key in a section (The one applied), NULL when not set
+    const std::string *FindValue(const Section *section, int key) const
+    {
+        if (section == NULL || key < 0)
+            return NULL;
+
+        for (auto it = section->entries.rbegin(); it != section->entries.rend(); ++it)
+        {
+            if (it->key == key)
+                return &it->value;
+        }
+        return NULL;
+    }
+
+    // Sections applied in order for a controller: [default], then [<profile>] (profile= of [<vid-pid>], else of [default]), then [<vid-pid>].
+    // Each one overrides the previous ones, the missing sections are skipped. Returns the number of sections.
+    int GetControllerSections(const std::string &lowercaseVidPid, const Section *out[MaxControllerSections]) const
+    {
+        const Section *defaultSection = FindSection("default");
+        const Section *controllerSection = FindSection(lowercaseVidPid);
+        const std::string *profile = FindProfile(defaultSection, controllerSection);
+        int count = 0;
+
+        if (defaultSection != NULL)
+            out[count++] = defaultSection;
+
+        if (profile != NULL && profile->length() > 0)
+        {
+            const Section *profileSection = FindSection(ToLowercase(*profile));
+            if (profileSection != NULL && profileSection != defaultSection && profileSection != controllerSection)
+                out[count++] = profileSection;
+        }
+
+        if (controllerSection != NULL && controllerSection != defaultSection)
+            out[count++] = controllerSection;
+
+        return count;
+    }
+
+    // Names of the sections a controller depends on, the missing ones included (A section added later changes its config):
+    // "default", its profile when set, its vid-pid. Returns the number of names.
+    int GetControllerSectionNames(const std::string &lowercaseVidPid, std::string out[MaxControllerSections]) const
+    {
+        const std::string *profile = FindProfile(FindSection("default"), FindSection(lowercaseVidPid));
+        int count = 0;
+
+        out[count++] = "default";
+        if (profile != NULL && profile->length() > 0)
+            out[count++] = ToLowercase(*profile);
+        out[count++] = lowercaseVidPid;
+
+        return count;
+    }
+
+    // Names of the sections whose lines differ from previous: added, removed, or any key or value changed (The keys are compared by name)
+    void GetChangedSections(const ConfigStore &previous, std::vector<std::string> *out) const
+    {
+        for (const Section &section : m_sections)
+        {
+            const Section *previousSection = previous.FindSection(section.name);
+            if (previousSection == NULL || !IsSameSection(section, previous, *previousSection))
+                out->push_back(section.name);
+        }
+
+        for (const Section &previousSection : previous.m_sections)
+        {
+            if (FindSection(previousSection.name) == NULL)
+                out->push_back(previousSection.name);
+        }
+    }
+
+    size_t GetSectionCount() const { return m_sections.size(); }
+    const Section &GetSection(size_t index) const { return m_sections[index]; }
+    size_t GetKeyCount() const { return m_keys.size(); }
+
+    static std::string ToLowercase(const std::string &str)
+    {
+        std::string result(str);
+        for (char &ch : result)
+            ch = tolower((unsigned char)ch);
+        return result;
+    }
+
+private:
+    std::vector<std::string> m_keys;
+    std::unordered_map<std::string, uint16_t> m_keyIds;
+    std::vector<Section> m_sections;
+    std::unordered_map<std::string, uint32_t> m_sectionIds;
+
+    static size_t TrimRight(const std::string &line, size_t start, size_t stop)
+    {
+        while (stop > start && isspace((unsigned char)line[stop - 1]))
+            stop--;
+        return stop;
+    }
+
+    // Position of the first of chars, or of an inline comment (';' after a space), stop when none
+    static size_t FindCharsOrComment(const std::string &line, size_t start, size_t stop, const char *chars)
+    {
+        bool wasSpace = false;
+        for (size_t i = start; i < stop; i++)
+        {
+            if ((chars != NULL && line[i] != '\0' && strchr(chars, line[i]) != NULL) || (wasSpace && line[i] == ';'))
+                return i;
+            wasSpace = isspace((unsigned char)line[i]);
+        }
+        return stop;
+    }
+
+    int GetSection(const std::string &name)
+    {
+        std::string lowercaseName = ToLowercase(name);
+        auto it = m_sectionIds.find(lowercaseName);
+        if (it != m_sectionIds.end())
+            return it->second;
+
+        m_sectionIds.emplace(lowercaseName, (uint32_t)m_sections.size());
+        m_sections.push_back({lowercaseName, {}});
+        return (int)m_sections.size() - 1;
+    }
+
+    int InternKey(const std::string &name)
+    {
+        std::string lowercaseName = ToLowercase(name);
+        auto it = m_keyIds.find(lowercaseName);
+        if (it != m_keyIds.end())
+            return it->second;
+
+        if (m_keys.size() > UINT16_MAX)
+            return -1;
+
+        m_keyIds.emplace(lowercaseName, (uint16_t)m_keys.size());
+        m_keys.push_back(lowercaseName);
+        return (int)m_keys.size() - 1;
+    }
+
+    // profile= of [<vid-pid>], else of [default], NULL when not set
+    const std::string *FindProfile(const Section *defaultSection, const Section *controllerSection) const
+    {
+        int profileKey = FindKey("profile");
+        const std::string *profile = FindValue(controllerSection, profileKey);
+        return profile != NULL ? profile : FindValue(defaultSection, profileKey);
+    }
+
+    bool IsSameSection(const Section &section, const ConfigStore &previous, const Section &previousSection) const
+    {
+        if (section.entries.size() != previousSection.entries.size())
+            return false;
+
+        for (size_t i = 0; i < section.entries.size(); i++)
+        {
+            if (section.entries[i].value != previousSection.entries[i].value || GetKey(section.entries[i].key) != previous.GetKey(previousSection.entries[i].key))
+                return false;
+        }
+        return true;
+    }
+
+    // The lines before the first section are ignored (As by LoadGlobalConfig/LoadControllerConfig)
+    void AddEntry(int section, int key, const std::string &line, size_t start, size_t stop)
+    {
+        if (section < 0 || key < 0)
+            return;
+
+        m_sections[section].entries.push_back({(uint16_t)key, line.substr(start, TrimRight(line, start, stop) - start)});
+    }
+};
@@ -6,7 +6,7 @@
 BaseController::BaseController(std::unique_ptr<IUSBDevice> &&device, const ControllerConfig &config, std::unique_ptr<ILogger> &&logger)
     : IController(std::move(device), config, std::move(logger))
 {
-    LogPrint(LogLevelDebug, "Controller[%04x-%04x] Created !", m_device->GetVendor(), m_device->GetProduct());
+    CONTROLLER_LOG(LogLevelDebug, "Controller[%04x-%04x] Created !", m_device->GetVendor(), m_device->GetProduct());
 }
 
 BaseController::~BaseController()
@@ -15,7 +15,7 @@ BaseController::~BaseController()
 
 ams::Result BaseController::Initialize()
 {
-    LogPrint(LogLevelDebug, "Controller[%04x-%04x] Initializing ...", m_device->GetVendor(), m_device->GetProduct());
+    CONTROLLER_LOG(LogLevelDebug, "Controller[%04x-%04x] Initializing ...", m_device->GetVendor(), m_device->GetProduct());
 
     R_TRY(OpenInterfaces());
 
@@ -35,7 +35,7 @@ uint16_t BaseController::GetInputCount()
 ams::Result BaseController::OpenInterfaces()
 {
     int interfaceCount = 0;
-    LogPrint(LogLevelDebug, "Controller[%04x-%04x] Opening interfaces ...", m_device->GetVendor(), m_device->GetProduct());
+    CONTROLLER_LOG(LogLevelDebug, "Controller[%04x-%04x] Opening interfaces ...", m_device->GetVendor(), m_device->GetProduct());
 
     ams::Result rc = m_device->Open();
     if (R_FAILED(rc))
@@ -47,7 +47,7 @@ ams::Result BaseController::OpenInterfaces()
     std::vector<std::unique_ptr<IUSBInterface>> &interfaces = m_device->GetInterfaces();
     for (auto &&interface : interfaces)
     {
-        LogPrint(LogLevelDebug, "Controller[%04x-%04x] Opening interface idx=%d ...", m_device->GetVendor(), m_device->GetProduct(), interfaceCount++);
+        CONTROLLER_LOG(LogLevelDebug, "Controller[%04x-%04x] Opening interface idx=%d ...", m_device->GetVendor(), m_device->GetProduct(), interfaceCount++);
 
         R_TRY(interface->Open());
 
@@ -92,7 +92,7 @@ ams::Result BaseController::OpenInterfaces()
         R_RETURN(CONTROL_ERR_INVALID_ENDPOINT);
     }
 
-    LogPrint(LogLevelDebug, "Controller[%04x-%04x] successfully opened !", m_device->GetVendor(), m_device->GetProduct());
+    CONTROLLER_LOG(LogLevelDebug, "Controller[%04x-%04x] successfully opened !", m_device->GetVendor(), m_device->GetProduct());
     R_SUCCEED();
 }
 
@@ -125,19 +125,19 @@ ams::Result BaseController::ReadInput(NormalizedButtonData *normalData, uint16_t
 
     R_TRY(ReadInput(&rawData, input_idx, timeout_us));
 
-    LogPrint(LogLevelDebug, "Controller[%04x-%04x] DATA: X=%d%%, Y=%d%%, Z=%d%%, Rz=%d%%, B1=%d, B2=%d, B3=%d, B4=%d, B5=%d, B6=%d, B7=%d, B8=%d, B9=%d, B10=%d",
-             m_device->GetVendor(), m_device->GetProduct(),
-             (int)(rawData.X * 100.0), (int)(rawData.Y * 100.0), (int)(rawData.Z * 100.0), (int)(rawData.Rz * 100.0),
-             rawData.buttons[1] ? 1 : 0,
-             rawData.buttons[2] ? 1 : 0,
-             rawData.buttons[3] ? 1 : 0,
-             rawData.buttons[4] ? 1 : 0,
-             rawData.buttons[5] ? 1 : 0,
-             rawData.buttons[6] ? 1 : 0,
-             rawData.buttons[7] ? 1 : 0,
-             rawData.buttons[8] ? 1 : 0,
-             rawData.buttons[9] ? 1 : 0,
-             rawData.buttons[10] ? 1 : 0);
+    CONTROLLER_LOG_LIMITED(LogLevelDebug, "Controller[%04x-%04x] DATA: X=%d%%, Y=%d%%, Z=%d%%, Rz=%d%%, B1=%d, B2=%d, B3=%d, B4=%d, B5=%d, B6=%d, B7=%d, B8=%d, B9=%d, B10=%d",
+                     m_device->GetVendor(), m_device->GetProduct(),
+                     (int)(rawData.X * 100.0), (int)(rawData.Y * 100.0), (int)(rawData.Z * 100.0), (int)(rawData.Rz * 100.0),
+                     rawData.buttons[1] ? 1 : 0,
+                     rawData.buttons[2] ? 1 : 0,
+                     rawData.buttons[3] ? 1 : 0,
+                     rawData.buttons[4] ? 1 : 0,
+                     rawData.buttons[5] ? 1 : 0,
+                     rawData.buttons[6] ? 1 : 0,
+                     rawData.buttons[7] ? 1 : 0,
+                     rawData.buttons[8] ? 1 : 0,
+                     rawData.buttons[9] ? 1 : 0,
+                     rawData.buttons[10] ? 1 : 0);
 
     float bindAnalog[ControllerAnalogBinding_Count] = {
         0.0,
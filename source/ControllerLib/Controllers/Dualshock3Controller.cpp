@@ -32,16 +32,16 @@ ams::Result Dualshock3Controller::OpenInterfaces()
 
 ams::Result Dualshock3Controller::ReadInput(RawInputData *rawData, uint16_t *input_idx, uint32_t timeout_us)
 {
-    uint8_t input_bytes[CONTROLLER_INPUT_BUFFER_SIZE];
-    size_t size = sizeof(input_bytes);
+    USBReadView view(m_inPipe[0]);
+    R_TRY(view.Acquire(CONTROLLER_INPUT_BUFFER_SIZE, timeout_us));
 
-    R_TRY(m_inPipe[0]->Read(input_bytes, &size, timeout_us));
+    const uint8_t *input_bytes = view.GetData();
 
     *input_idx = 0;
 
     if (input_bytes[0] == Ds3InputPacket_Button)
     {
-        Dualshock3ButtonData *buttonData = reinterpret_cast<Dualshock3ButtonData *>(input_bytes);
+        const Dualshock3ButtonData *buttonData = reinterpret_cast<const Dualshock3ButtonData *>(input_bytes);
 
         rawData->buttons[1] = buttonData->button1;
         rawData->buttons[2] = buttonData->button2;
@@ -5,11 +5,27 @@
 
 // https://www.usb.org/sites/default/files/documents/hid1_11.pdf  p55
 
-GenericHIDController::GenericHIDController(std::unique_ptr<IUSBDevice> &&device, const ControllerConfig &config, std::unique_ptr<ILogger> &&logger)
+namespace
+{
+    // FNV-1a, only used to detect a descriptor change between two connections
+    uint64_t HashDescriptor(const uint8_t *buffer, size_t size)
+    {
+        uint64_t hash = 0xCBF29CE484222325ULL;
+        for (size_t i = 0; i < size; i++)
+        {
+            hash ^= buffer[i];
+            hash *= 0x100000001B3ULL;
+        }
+        return hash ^ size;
+    }
+} // namespace
+
+GenericHIDController::GenericHIDController(std::unique_ptr<IUSBDevice> &&device, const ControllerConfig &config, std::unique_ptr<ILogger> &&logger, std::unique_ptr<IHIDLayoutCache> &&layoutCache)
     : BaseController(std::move(device), config, std::move(logger)),
-      m_joystick_count(0)
+      m_joystick_count(0),
+      m_layoutCache(std::move(layoutCache))
 {
-    LogPrint(LogLevelDebug, "GenericHIDController[%04x-%04x] Created !", m_device->GetVendor(), m_device->GetProduct());
+    CONTROLLER_LOG(LogLevelDebug, "GenericHIDController[%04x-%04x] Created !", m_device->GetVendor(), m_device->GetProduct());
 }
 
 GenericHIDController::~GenericHIDController()
@@ -24,19 +40,44 @@ ams::Result GenericHIDController::Initialize()
     uint16_t size = sizeof(buffer);
     // https://www.usb.org/sites/default/files/hid1_11.pdf
 
-    LogPrint(LogLevelDebug, "GenericHIDController[%04x-%04x] Reading report descriptor ...", m_device->GetVendor(), m_device->GetProduct());
+    CONTROLLER_LOG(LogLevelDebug, "GenericHIDController[%04x-%04x] Reading report descriptor ...", m_device->GetVendor(), m_device->GetProduct());
     // Get HID report descriptor
     R_TRY(m_interfaces[0]->ControlTransferInput((uint8_t)USB_ENDPOINT_IN | (uint8_t)USB_RECIPIENT_INTERFACE, USB_REQUEST_GET_DESCRIPTOR, (USB_DT_REPORT << 8) | m_interfaces[0]->GetDescriptor()->bInterfaceNumber, 0, buffer, &size));
 
-    LogPrint(LogLevelTrace, "GenericHIDController[%04x-%04x] Got descriptor for interface %d", m_device->GetVendor(), m_device->GetProduct(), m_interfaces[0]->GetDescriptor()->bInterfaceNumber);
-    LogBuffer(LogLevelTrace, buffer, size);
+    CONTROLLER_LOG(LogLevelTrace, "GenericHIDController[%04x-%04x] Got descriptor for interface %d", m_device->GetVendor(), m_device->GetProduct(), m_interfaces[0]->GetDescriptor()->bInterfaceNumber);
+    CONTROLLER_LOG_BUFFER(LogLevelTrace, buffer, size);
 
-    LogPrint(LogLevelDebug, "GenericHIDController[%04x-%04x] Parsing descriptor ...", m_device->GetVendor(), m_device->GetProduct());
-    std::shared_ptr<HIDReportDescriptor> descriptor = std::make_shared<HIDReportDescriptor>(buffer, size);
+    uint64_t descriptorHash = HashDescriptor(buffer, size);
+    std::vector<uint8_t> layoutData;
 
-    LogPrint(LogLevelDebug, "GenericHIDController[%04x-%04x] Looking for joystick/gamepad profile ...", m_device->GetVendor(), m_device->GetProduct());
-    m_joystick = std::make_shared<HIDJoystick>(descriptor);
-    m_joystick_count = m_joystick->getCount();
+    if (m_layoutCache != nullptr && m_layoutCache->Load(m_device->GetVendor(), m_device->GetProduct(), descriptorHash, &layoutData) && m_layout.Deserialize(layoutData.data(), layoutData.size()))
+    {
+        CONTROLLER_LOG(LogLevelDebug, "GenericHIDController[%04x-%04x] Report layout loaded from cache (hash: %016llx)", m_device->GetVendor(), m_device->GetProduct(), (unsigned long long)descriptorHash);
+        m_joystick_count = m_layout.GetJoystickCount();
+    }
+    else
+    {
+        CONTROLLER_LOG(LogLevelDebug, "GenericHIDController[%04x-%04x] Compiling report layout ...", m_device->GetVendor(), m_device->GetProduct());
+        if (m_layout.Compile(buffer, size))
+        {
+            m_joystick_count = m_layout.GetJoystickCount();
+
+            if (m_layoutCache != nullptr)
+            {
+                m_layout.Serialize(&layoutData);
+                m_layoutCache->Store(m_device->GetVendor(), m_device->GetProduct(), descriptorHash, layoutData.data(), layoutData.size());
+            }
+        }
+        else
+        {
+            CONTROLLER_LOG(LogLevelDebug, "GenericHIDController[%04x-%04x] Report layout not supported, parsing descriptor ...", m_device->GetVendor(), m_device->GetProduct());
+            std::shared_ptr<HIDReportDescriptor> descriptor = std::make_shared<HIDReportDescriptor>(buffer, size);
+
+            CONTROLLER_LOG(LogLevelDebug, "GenericHIDController[%04x-%04x] Looking for joystick/gamepad profile ...", m_device->GetVendor(), m_device->GetProduct());
+            m_joystick = std::make_shared<HIDJoystick>(descriptor);
+            m_joystick_count = m_joystick->getCount();
+        }
+    }
 
     if (m_joystick_count == 0)
     {
@@ -57,13 +98,26 @@ uint16_t GenericHIDController::GetInputCount()
 ams::Result GenericHIDController::ReadInput(RawInputData *rawData, uint16_t *input_idx, uint32_t timeout_us)
 {
     HIDJoystickData joystick_data;
-    uint8_t input_bytes[CONTROLLER_INPUT_BUFFER_SIZE];
-    size_t size = std::min(m_inPipe[0]->GetDescriptor()->wMaxPacketSize, (uint16_t)sizeof(input_bytes));
+    USBReadView view(m_inPipe[0]);
+
+    R_TRY(view.Acquire(std::min(m_inPipe[0]->GetDescriptor()->wMaxPacketSize, (uint16_t)CONTROLLER_INPUT_BUFFER_SIZE), timeout_us));
 
-    R_TRY(m_inPipe[0]->Read(input_bytes, &size, timeout_us));
+    const uint8_t *input_bytes = view.GetData();
+    size_t size = view.GetSize();
     if (size == 0)
         R_RETURN(CONTROL_ERR_NOTHING_TODO);
 
+    if (m_layout.IsValid())
+    {
+        if (!m_layout.Decode(input_bytes, size, rawData, input_idx, CONTROLLER_INPUT_BUFFER_SIZE))
+        {
+            LogPrint(LogLevelError, "GenericHIDController[%04x-%04x] Failed to decode input data (size=%d)", m_device->GetVendor(), m_device->GetProduct(), size);
+            R_RETURN(CONTROL_ERR_UNEXPECTED_DATA);
+        }
+
+        R_SUCCEED();
+    }
+
     if (!m_joystick->parseData(input_bytes, size, &joystick_data))
     {
         LogPrint(LogLevelError, "GenericHIDController[%04x-%04x] Failed to parse input data (size=%d)", m_device->GetVendor(), m_device->GetProduct(), size);
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "BaseController.h"
+#include "HIDReportLayout.h"
+#include "IHIDLayoutCache.h"
 
 class HIDJoystick;
 
@@ -9,9 +11,12 @@ class GenericHIDController : public BaseController
 private:
     std::shared_ptr<HIDJoystick> m_joystick;
     uint8_t m_joystick_count = 0;
+    // Compiled report layout, when the descriptor is not supported by HIDReportLayout, m_joystick is used instead
+    HIDReportLayout m_layout;
+    std::unique_ptr<IHIDLayoutCache> m_layoutCache;
 
 public:
-    GenericHIDController(std::unique_ptr<IUSBDevice> &&device, const ControllerConfig &config, std::unique_ptr<ILogger> &&logger);
+    GenericHIDController(std::unique_ptr<IUSBDevice> &&device, const ControllerConfig &config, std::unique_ptr<ILogger> &&logger, std::unique_ptr<IHIDLayoutCache> &&layoutCache = nullptr);
     virtual ~GenericHIDController() override;
 
     virtual ams::Result Initialize() override;
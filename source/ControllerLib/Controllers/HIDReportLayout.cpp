@@ -0,0 +1,542 @@
+#include "Controllers/HIDReportLayout.h"
+#include <string.h>
+#include <algorithm>
+
+// https://www.usb.org/sites/default/files/hid1_11.pdf  p23 (Items), p55 (Report descriptor)
+
+#define HID_ITEM_TYPE_MAIN   0
+#define HID_ITEM_TYPE_GLOBAL 1
+#define HID_ITEM_TYPE_LOCAL  2
+
+#define HID_MAIN_INPUT          0x8
+#define HID_MAIN_COLLECTION     0xA
+#define HID_MAIN_END_COLLECTION 0xC
+
+#define HID_GLOBAL_USAGE_PAGE   0x0
+#define HID_GLOBAL_LOGICAL_MIN  0x1
+#define HID_GLOBAL_LOGICAL_MAX  0x2
+#define HID_GLOBAL_REPORT_SIZE  0x7
+#define HID_GLOBAL_REPORT_ID    0x8
+#define HID_GLOBAL_REPORT_COUNT 0x9
+#define HID_GLOBAL_PUSH         0xA
+#define HID_GLOBAL_POP          0xB
+
+#define HID_LOCAL_USAGE     0x0
+#define HID_LOCAL_USAGE_MIN 0x1
+#define HID_LOCAL_USAGE_MAX 0x2
+
+#define HID_INPUT_CONSTANT 0x01
+#define HID_INPUT_VARIABLE 0x02
+
+#define HID_COLLECTION_APPLICATION 0x01
+
+#define HID_PAGE_GENERIC_DESKTOP 0x01
+#define HID_PAGE_BUTTON          0x09
+
+#define HID_USAGE_JOYSTICK 0x04
+#define HID_USAGE_GAMEPAD  0x05
+#define HID_USAGE_X        0x30
+#define HID_USAGE_RZ       0x35
+#define HID_USAGE_HAT      0x39
+
+#define HID_DPAD_UP    0x01
+#define HID_DPAD_RIGHT 0x02
+#define HID_DPAD_DOWN  0x04
+#define HID_DPAD_LEFT  0x08
+
+namespace
+{
+    struct GlobalState
+    {
+        uint16_t usagePage = 0;
+        int32_t logicalMin = 0;
+        int32_t logicalMax = 0;
+        uint32_t reportSize = 0;
+        uint32_t reportCount = 0;
+        uint8_t reportId = 0;
+    };
+
+    // Usages are 32 bits: page << 16 | id
+    struct LocalState
+    {
+        std::vector<uint32_t> usages;
+        uint32_t usageMin = 0;
+        uint32_t usageMax = 0;
+        bool hasRange = false;
+
+        void reset()
+        {
+            usages.clear();
+            usageMin = usageMax = 0;
+            hasRange = false;
+        }
+
+        uint32_t get(size_t i) const
+        {
+            if (hasRange)
+                return (usageMin + i <= usageMax) ? usageMin + i : 0;
+            if (usages.empty())
+                return 0;
+            return usages[std::min(i, usages.size() - 1)];
+        }
+    };
+
+    // 8 button bits -> 8 bools (Byte i = bit i, little endian)
+    struct ButtonBytesTable
+    {
+        uint64_t values[256];
+
+        constexpr ButtonBytesTable() : values()
+        {
+            for (int bits = 0; bits < 256; bits++)
+            {
+                for (int i = 0; i < 8; i++)
+                    values[bits] |= (uint64_t)((bits >> i) & 1) << (i * 8);
+            }
+        }
+    };
+    constexpr ButtonBytesTable g_buttonBytes;
+
+    float RawInputData::*const g_axes[] = {&RawInputData::X, &RawInputData::Y, &RawInputData::Z, &RawInputData::Rx, &RawInputData::Ry, &RawInputData::Rz};
+
+    inline uint32_t ExtractBits(const uint8_t *report, uint16_t bitOffset, uint8_t bitSize)
+    {
+        uint64_t value;
+        memcpy(&value, &report[bitOffset >> 3], sizeof(value));
+        value >>= (bitOffset & 7);
+        return static_cast<uint32_t>(value & ((1ULL << bitSize) - 1));
+    }
+
+    // Serialized layouts are only read back by the same console, values are stored in native byte order
+    template <typename T>
+    void Append(std::vector<uint8_t> *data, T value)
+    {
+        const uint8_t *bytes = reinterpret_cast<const uint8_t *>(&value);
+        data->insert(data->end(), bytes, bytes + sizeof(T));
+    }
+
+    template <typename T>
+    bool Take(const uint8_t *data, size_t size, size_t *pos, T *value)
+    {
+        if (*pos + sizeof(T) > size)
+            return false;
+        memcpy(value, &data[*pos], sizeof(T));
+        *pos += sizeof(T);
+        return true;
+    }
+} // namespace
+
+HIDReportLayout::HIDReportLayout()
+{
+    memset(m_hatTable, 0, sizeof(m_hatTable));
+}
+
+void HIDReportLayout::BuildHatTable()
+{
+    memset(m_hatTable, 0, sizeof(m_hatTable));
+
+    // Positions are spread clockwise from UP, i.e: 8 positions = 45 degrees each, 4 positions = 90 degrees each
+    // Anything out of the logical range is the neutral position.
+    static const uint8_t directions[8] = {
+        HID_DPAD_UP,
+        HID_DPAD_UP | HID_DPAD_RIGHT,
+        HID_DPAD_RIGHT,
+        HID_DPAD_DOWN | HID_DPAD_RIGHT,
+        HID_DPAD_DOWN,
+        HID_DPAD_DOWN | HID_DPAD_LEFT,
+        HID_DPAD_LEFT,
+        HID_DPAD_UP | HID_DPAD_LEFT,
+    };
+
+    int32_t positions = m_hatMax - m_hatMin + 1;
+    if (positions <= 0)
+        return;
+
+    for (int32_t value = m_hatMin; value <= m_hatMax && value < 256; value++)
+    {
+        if (value < 0)
+            continue;
+        m_hatTable[value] = directions[((value - m_hatMin) * 8 / positions) % 8];
+    }
+}
+
+bool HIDReportLayout::Compile(const uint8_t *descriptor, size_t size)
+{
+    GlobalState global;
+    std::vector<GlobalState> globalStack;
+    LocalState local;
+    int collectionDepth = 0;
+    int joystickDepth = -1; // Depth of the current joystick collection, -1 outside
+    uint8_t joystick = 0;
+    uint16_t bitOffsets[256] = {0};
+
+    m_reports.clear();
+    m_useReportId = false;
+    m_joystickCount = 0;
+    m_hatMin = 0;
+    m_hatMax = -1;
+
+    size_t pos = 0;
+    while (pos < size)
+    {
+        uint8_t prefix = descriptor[pos++];
+
+        // Long items are not used by any known gamepad
+        if (prefix == 0xFE)
+        {
+            if (pos >= size)
+                break;
+            pos += 2 + descriptor[pos];
+            continue;
+        }
+
+        uint8_t dataSize = (prefix & 0x03) == 3 ? 4 : (prefix & 0x03);
+        uint8_t type = (prefix >> 2) & 0x03;
+        uint8_t tag = prefix >> 4;
+
+        if (pos + dataSize > size)
+            break;
+
+        uint32_t udata = 0;
+        for (uint8_t i = 0; i < dataSize; i++)
+            udata |= (uint32_t)descriptor[pos + i] << (8 * i);
+        int32_t sdata = dataSize == 0 ? 0 : (dataSize == 4 ? (int32_t)udata : (int32_t)(udata << (32 - 8 * dataSize)) >> (32 - 8 * dataSize));
+        pos += dataSize;
+
+        if (type == HID_ITEM_TYPE_GLOBAL)
+        {
+            switch (tag)
+            {
+                case HID_GLOBAL_USAGE_PAGE:
+                    global.usagePage = udata;
+                    break;
+                case HID_GLOBAL_LOGICAL_MIN:
+                    global.logicalMin = sdata;
+                    break;
+                case HID_GLOBAL_LOGICAL_MAX:
+                    // Common mistake: Logical max 255 encoded on 1 byte (0xFF = -1) with a positive minimum
+                    global.logicalMax = (sdata < global.logicalMin) ? (int32_t)udata : sdata;
+                    break;
+                case HID_GLOBAL_REPORT_SIZE:
+                    global.reportSize = udata;
+                    break;
+                case HID_GLOBAL_REPORT_ID:
+                    global.reportId = udata;
+                    m_useReportId = true;
+                    break;
+                case HID_GLOBAL_REPORT_COUNT:
+                    global.reportCount = udata;
+                    break;
+                case HID_GLOBAL_PUSH:
+                    globalStack.push_back(global);
+                    break;
+                case HID_GLOBAL_POP:
+                    if (!globalStack.empty())
+                    {
+                        global = globalStack.back();
+                        globalStack.pop_back();
+                    }
+                    break;
+            }
+        }
+        else if (type == HID_ITEM_TYPE_LOCAL)
+        {
+            uint32_t usage = dataSize == 4 ? udata : ((uint32_t)global.usagePage << 16) | udata;
+            switch (tag)
+            {
+                case HID_LOCAL_USAGE:
+                    local.usages.push_back(usage);
+                    break;
+                case HID_LOCAL_USAGE_MIN:
+                    local.usageMin = usage;
+                    local.hasRange = true;
+                    break;
+                case HID_LOCAL_USAGE_MAX:
+                    local.usageMax = usage;
+                    local.hasRange = true;
+                    break;
+            }
+        }
+        else if (type == HID_ITEM_TYPE_MAIN)
+        {
+            if (tag == HID_MAIN_COLLECTION)
+            {
+                uint32_t usage = local.get(0);
+                if (joystickDepth < 0 && udata == HID_COLLECTION_APPLICATION &&
+                    (usage == ((HID_PAGE_GENERIC_DESKTOP << 16) | HID_USAGE_JOYSTICK) || usage == ((HID_PAGE_GENERIC_DESKTOP << 16) | HID_USAGE_GAMEPAD)))
+                {
+                    if (m_joystickCount >= HID_LAYOUT_MAX_JOYSTICKS)
+                        return false;
+
+                    joystickDepth = collectionDepth;
+                    joystick = m_joystickCount++;
+                }
+                collectionDepth++;
+            }
+            else if (tag == HID_MAIN_END_COLLECTION)
+            {
+                collectionDepth--;
+                if (collectionDepth == joystickDepth)
+                    joystickDepth = -1;
+            }
+            else if (tag == HID_MAIN_INPUT)
+            {
+                uint16_t &bitOffset = bitOffsets[global.reportId];
+                if (bitOffset == 0 && m_useReportId)
+                    bitOffset = 8; // Report ID byte
+
+                uint32_t fieldBits = global.reportSize * global.reportCount;
+
+                if (joystickDepth >= 0 && !(udata & HID_INPUT_CONSTANT) && global.reportSize > 0)
+                {
+                    // Arrays (usage selected by the value) are only used by keyboards, not supported here
+                    if (!(udata & HID_INPUT_VARIABLE))
+                    {
+                        if (((local.get(0) >> 16) == HID_PAGE_BUTTON))
+                            return false;
+                    }
+                    else
+                    {
+                        Report *report = NULL;
+                        for (Report &r : m_reports)
+                        {
+                            if (r.reportId == global.reportId)
+                                report = &r;
+                        }
+                        if (report == NULL)
+                        {
+                            if (m_reports.size() >= HID_LAYOUT_MAX_REPORTS)
+                                return false;
+                            m_reports.push_back(Report{global.reportId, joystick, 0, {}});
+                            report = &m_reports.back();
+                        }
+
+                        for (uint32_t i = 0; i < global.reportCount; i++)
+                        {
+                            uint32_t usage = local.get(i);
+                            uint16_t page = usage >> 16;
+                            uint16_t id = usage & 0xFFFF;
+                            uint32_t offset = bitOffset + i * global.reportSize;
+
+                            // Decode() works on a CONTROLLER_INPUT_BUFFER_SIZE buffer
+                            if (offset + global.reportSize > CONTROLLER_INPUT_BUFFER_SIZE * 8)
+                                return false;
+
+                            if (page == HID_PAGE_BUTTON && global.reportSize == 1 && id > 0 && id < MAX_CONTROLLER_BUTTONS)
+                            {
+                                // Consecutive buttons are merged in the same field
+                                Field *last = report->fields.empty() ? NULL : &report->fields.back();
+                                if (last != NULL && last->type == FieldType_Buttons && last->bitOffset + last->bitSize == offset && last->index + last->bitSize == id && last->bitSize < 32)
+                                    last->bitSize++;
+                                else
+                                    report->fields.push_back(Field{FieldType_Buttons, 1, (uint16_t)offset, false, (uint8_t)id, 0.0f, 0.0f});
+                            }
+                            else if (page == HID_PAGE_GENERIC_DESKTOP && id >= HID_USAGE_X && id <= HID_USAGE_RZ && global.reportSize <= 32)
+                            {
+                                float range = (float)global.logicalMax - (float)global.logicalMin;
+                                if (range <= 0)
+                                    continue;
+
+                                // Map [logicalMin, logicalMax] to [-1.0, 1.0]
+                                float scale = 2.0f / range;
+                                float bias = -1.0f - global.logicalMin * scale;
+                                report->fields.push_back(Field{FieldType_Axis, (uint8_t)global.reportSize, (uint16_t)offset, global.logicalMin < 0, (uint8_t)(id - HID_USAGE_X), scale, bias});
+                            }
+                            else if (page == HID_PAGE_GENERIC_DESKTOP && id == HID_USAGE_HAT && global.reportSize <= 8)
+                            {
+                                // A single hat table is shared by every joystick
+                                if (m_hatMax >= m_hatMin && (m_hatMin != global.logicalMin || m_hatMax != global.logicalMax))
+                                    return false;
+
+                                m_hatMin = global.logicalMin;
+                                m_hatMax = global.logicalMax;
+                                report->fields.push_back(Field{FieldType_Hat, (uint8_t)global.reportSize, (uint16_t)offset, false, 0, 0.0f, 0.0f});
+                            }
+                        }
+
+                        report->size = std::max<uint16_t>(report->size, (bitOffset + fieldBits + 7) / 8);
+                    }
+                }
+
+                bitOffset += fieldBits;
+            }
+
+            local.reset();
+        }
+    }
+
+    if (m_reports.empty())
+        m_joystickCount = 0;
+
+    BuildHatTable();
+
+    return IsValid();
+}
+
+void HIDReportLayout::Serialize(std::vector<uint8_t> *data) const
+{
+    data->clear();
+
+    Append<uint8_t>(data, HID_LAYOUT_SERIALIZE_VERSION);
+    Append<uint8_t>(data, m_useReportId);
+    Append<uint8_t>(data, m_joystickCount);
+    Append<uint8_t>(data, m_reports.size());
+    Append<int32_t>(data, m_hatMin);
+    Append<int32_t>(data, m_hatMax);
+
+    for (const Report &report : m_reports)
+    {
+        Append<uint8_t>(data, report.reportId);
+        Append<uint8_t>(data, report.joystick);
+        Append<uint16_t>(data, report.size);
+        Append<uint16_t>(data, report.fields.size());
+
+        for (const Field &field : report.fields)
+        {
+            Append<uint8_t>(data, field.type);
+            Append<uint8_t>(data, field.bitSize);
+            Append<uint16_t>(data, field.bitOffset);
+            Append<uint8_t>(data, field.isSigned);
+            Append<uint8_t>(data, field.index);
+            Append<float>(data, field.scale);
+            Append<float>(data, field.bias);
+        }
+    }
+}
+
+bool HIDReportLayout::Deserialize(const uint8_t *data, size_t size)
+{
+    size_t pos = 0;
+    uint8_t version, useReportId, joystickCount, reportCount;
+
+    m_reports.clear();
+    m_joystickCount = 0;
+
+    if (!Take(data, size, &pos, &version) || version != HID_LAYOUT_SERIALIZE_VERSION ||
+        !Take(data, size, &pos, &useReportId) || !Take(data, size, &pos, &joystickCount) || !Take(data, size, &pos, &reportCount) ||
+        !Take(data, size, &pos, &m_hatMin) || !Take(data, size, &pos, &m_hatMax))
+        return false;
+
+    if (joystickCount == 0 || joystickCount > HID_LAYOUT_MAX_JOYSTICKS || reportCount == 0 || reportCount > HID_LAYOUT_MAX_REPORTS)
+        return false;
+
+    std::vector<Report> reports(reportCount);
+    for (Report &report : reports)
+    {
+        uint16_t fieldCount;
+        if (!Take(data, size, &pos, &report.reportId) || !Take(data, size, &pos, &report.joystick) ||
+            !Take(data, size, &pos, &report.size) || !Take(data, size, &pos, &fieldCount))
+            return false;
+
+        if (report.joystick >= joystickCount || report.size > CONTROLLER_INPUT_BUFFER_SIZE)
+            return false;
+
+        report.fields.resize(fieldCount);
+        for (Field &field : report.fields)
+        {
+            uint8_t type, isSigned;
+            if (!Take(data, size, &pos, &type) || !Take(data, size, &pos, &field.bitSize) || !Take(data, size, &pos, &field.bitOffset) ||
+                !Take(data, size, &pos, &isSigned) || !Take(data, size, &pos, &field.index) ||
+                !Take(data, size, &pos, &field.scale) || !Take(data, size, &pos, &field.bias))
+                return false;
+
+            field.type = static_cast<FieldType>(type);
+            field.isSigned = isSigned != 0;
+
+            // Same limits as Compile(), every field ends within the report size (Decode() reads the report in place)
+            if (field.bitSize == 0 || field.bitSize > 32 || field.bitOffset + field.bitSize > report.size * 8)
+                return false;
+            if (field.type == FieldType_Axis && field.index > HID_USAGE_RZ - HID_USAGE_X)
+                return false;
+            if (field.type == FieldType_Hat && field.bitSize > 8)
+                return false;
+            if (field.type == FieldType_Buttons && field.index + field.bitSize > MAX_CONTROLLER_BUTTONS)
+                return false;
+            if (field.type > FieldType_Buttons)
+                return false;
+        }
+    }
+
+    if (pos != size)
+        return false;
+
+    m_reports = std::move(reports);
+    m_useReportId = useReportId != 0;
+    m_joystickCount = joystickCount;
+    BuildHatTable();
+
+    return IsValid();
+}
+
+bool HIDReportLayout::Decode(const uint8_t *report, size_t size, RawInputData *rawData, uint16_t *input_idx, size_t readable) const
+{
+    const Report *program = NULL;
+
+    if (m_useReportId)
+    {
+        if (size == 0)
+            return false;
+
+        for (const Report &r : m_reports)
+        {
+            if (r.reportId == report[0])
+            {
+                program = &r;
+                break;
+            }
+        }
+    }
+    else if (!m_reports.empty())
+    {
+        program = &m_reports[0];
+    }
+
+    if (program == NULL || size < program->size)
+        return false;
+
+    // Fields are read 8 bytes at a time, without any bound check: every field ends before program->size
+    uint8_t buffer[CONTROLLER_INPUT_BUFFER_SIZE + sizeof(uint64_t)];
+    if (std::max(size, readable) < program->size + sizeof(uint64_t))
+    {
+        memcpy(buffer, report, program->size);
+        memset(buffer + program->size, 0, sizeof(uint64_t));
+        report = buffer;
+    }
+
+    *input_idx = program->joystick;
+
+    for (const Field &field : program->fields)
+    {
+        uint32_t value = ExtractBits(report, field.bitOffset, field.bitSize);
+
+        switch (field.type)
+        {
+            case FieldType_Axis:
+            {
+                int32_t svalue = field.isSigned ? ((int32_t)(value << (32 - field.bitSize)) >> (32 - field.bitSize)) : (int32_t)value;
+                rawData->*g_axes[field.index] = std::clamp(svalue * field.scale + field.bias, -1.0f, 1.0f);
+                break;
+            }
+            case FieldType_Hat:
+            {
+                uint8_t dpad = m_hatTable[value];
+                rawData->dpad_up = (dpad & HID_DPAD_UP) != 0;
+                rawData->dpad_right = (dpad & HID_DPAD_RIGHT) != 0;
+                rawData->dpad_down = (dpad & HID_DPAD_DOWN) != 0;
+                rawData->dpad_left = (dpad & HID_DPAD_LEFT) != 0;
+                break;
+            }
+            case FieldType_Buttons:
+            {
+                for (uint8_t i = 0; i < field.bitSize; i += 8)
+                {
+                    uint64_t bytes = g_buttonBytes.values[(value >> i) & 0xFF];
+                    memcpy(&rawData->buttons[field.index + i], &bytes, std::min(8, field.bitSize - i));
+                }
+                break;
+            }
+        }
+    }
+
+    return true;
+}
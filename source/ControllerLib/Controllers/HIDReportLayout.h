@@ -0,0 +1,81 @@
+#pragma once
+
+#include "BaseController.h"
+#include <vector>
+
+#define HID_LAYOUT_MAX_REPORTS   8
+#define HID_LAYOUT_MAX_JOYSTICKS CONTROLLER_MAX_INPUTS
+
+// Bump when Field/Report change, serialized layouts of another version are rejected
+#define HID_LAYOUT_SERIALIZE_VERSION 1
+
+// Flat decoding program for the input reports of a HID joystick/gamepad
+// Compile() walks the HID report descriptor once (when the device is connected) and keeps, for each report,
+// only the fields used by sys-con: axes (X, Y, Z, Rx, Ry, Rz), hat switch and buttons.
+// Decode() then extracts each field at a fixed bit offset, applies a precomputed scale/bias and
+// looks up the hat switch in a table - no descriptor interpretation per report.
+//
+// Results are the same as HIDJoystick + Normalize: axes are mapped from the logical range to [-1.0, 1.0],
+// buttons are indexed by their usage (Button 1 -> buttons[1]), one joystick per Joystick/GamePad application collection.
+class HIDReportLayout
+{
+public:
+    enum FieldType : uint8_t
+    {
+        FieldType_Axis,
+        FieldType_Hat,
+        FieldType_Buttons,
+    };
+
+    struct Field
+    {
+        FieldType type;
+        uint8_t bitSize;       // Axis/Hat: size of the value, Buttons: number of buttons (1 bit each, up to 32)
+        uint16_t bitOffset;    // From the beginning of the report (Report ID included)
+        bool isSigned;         // Sign extend the value (Logical minimum < 0)
+        uint8_t index;         // Axis: 0:X 1:Y 2:Z 3:Rx 4:Ry 5:Rz (Usage - 0x30), Buttons: index of the first button
+        float scale;           // Axis: value * scale + bias = [-1.0, 1.0]
+        float bias;
+    };
+
+    struct Report
+    {
+        uint8_t reportId;
+        uint8_t joystick;
+        uint16_t size; // Minimum report size in bytes to decode every field
+        std::vector<Field> fields;
+    };
+
+private:
+    std::vector<Report> m_reports;
+    bool m_useReportId = false;
+    uint8_t m_joystickCount = 0;
+
+    // Hat switch value -> dpad mask (bit 0: up, 1: right, 2: down, 3: left)
+    int32_t m_hatMin = 0;
+    int32_t m_hatMax = -1;
+    uint8_t m_hatTable[256];
+
+    void BuildHatTable();
+
+public:
+    HIDReportLayout();
+
+    // Return false if the descriptor doesn't describe any joystick/gamepad, or uses features not supported
+    // by the flat program (i.e: buttons declared as an array). The caller should use HIDJoystick in this case.
+    bool Compile(const uint8_t *descriptor, size_t size);
+
+    // Compiled layout <-> bytes, used to keep layouts across connections (See IHIDLayoutCache)
+    // Deserialize() checks every field against the decoding buffer, so a corrupted or outdated blob is only rejected.
+    void Serialize(std::vector<uint8_t> *data) const;
+    bool Deserialize(const uint8_t *data, size_t size);
+
+    // Decode an input report, the fields absent from the report are left untouched in rawData
+    // readable: bytes that can be read behind report (i.e: CONTROLLER_INPUT_BUFFER_SIZE for a read view, See IUSBEndpoint),
+    // the report is read in place when the fields can be read 8 bytes at a time, otherwise it is first copied in a padded buffer.
+    bool Decode(const uint8_t *report, size_t size, RawInputData *rawData, uint16_t *input_idx, size_t readable = 0) const;
+
+    inline bool IsValid() const { return m_joystickCount > 0; }
+    inline uint8_t GetJoystickCount() const { return m_joystickCount; }
+    inline const std::vector<Report> &GetReports() const { return m_reports; }
+};
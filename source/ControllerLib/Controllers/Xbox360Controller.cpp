@@ -22,12 +22,12 @@ ams::Result Xbox360Controller::Initialize()
 
 ams::Result Xbox360Controller::ReadInput(RawInputData *rawData, uint16_t *input_idx, uint32_t timeout_us)
 {
-    uint8_t input_bytes[CONTROLLER_INPUT_BUFFER_SIZE];
-    size_t size = sizeof(input_bytes);
+    USBReadView view(m_inPipe[0]);
+    R_TRY(view.Acquire(CONTROLLER_INPUT_BUFFER_SIZE, timeout_us));
 
-    R_TRY(m_inPipe[0]->Read(input_bytes, &size, timeout_us));
+    const uint8_t *input_bytes = view.GetData();
 
-    Xbox360ButtonData *buttonData = reinterpret_cast<Xbox360ButtonData *>(input_bytes);
+    const Xbox360ButtonData *buttonData = reinterpret_cast<const Xbox360ButtonData *>(input_bytes);
 
     *input_idx = 0;
 
@@ -76,7 +76,7 @@ bool Xbox360Controller::Support(ControllerFeature feature)
 ams::Result Xbox360Controller::SetRumble(uint16_t input_idx, float amp_high, float amp_low)
 {
     uint8_t rumbleData[]{0x00, 0x08, 0x00, (uint8_t)(amp_high * 255), (uint8_t)(amp_low * 255), 0x00, 0x00, 0x00};
-    R_RETURN(m_outPipe[input_idx]->Write(rumbleData, sizeof(rumbleData)));
+    R_RETURN(m_outPipe[input_idx]->QueueWrite(rumbleData, sizeof(rumbleData), IUSBEndpoint::OUTPUT_KEY_RUMBLE));
 }
 
 ams::Result Xbox360Controller::SetLED(uint16_t input_idx, Xbox360LEDValue value)
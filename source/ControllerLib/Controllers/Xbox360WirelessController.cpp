@@ -43,15 +43,19 @@ void Xbox360WirelessController::CloseInterfaces()
 
 ams::Result Xbox360WirelessController::ReadInput(RawInputData *rawData, uint16_t *input_idx, uint32_t timeout_us)
 {
-    uint8_t input_bytes[CONTROLLER_INPUT_BUFFER_SIZE];
-    size_t size = sizeof(input_bytes);
+    size_t controller_idx = 0;
 
-    uint16_t controller_idx = m_current_controller_idx;
-    m_current_controller_idx = (m_current_controller_idx + 1) % XBOX360_MAX_INPUTS;
+    // Transfers are kept in flight on the 4 slots, the first one to complete is read.
+    // The search starts after the last slot read so that an active pad doesn't starve the others.
+    R_TRY(m_device->WaitForInput(m_inPipe.data(), XBOX360_MAX_INPUTS, m_current_controller_idx, CONTROLLER_INPUT_BUFFER_SIZE, &controller_idx, timeout_us));
+    m_current_controller_idx = (controller_idx + 1) % XBOX360_MAX_INPUTS;
 
-    R_TRY(m_inPipe[controller_idx]->Read(input_bytes, &size, timeout_us));
+    USBReadView view(m_inPipe[controller_idx]);
+    R_TRY(view.Acquire(CONTROLLER_INPUT_BUFFER_SIZE, 0));
 
-    Xbox360ButtonData *buttonData = reinterpret_cast<Xbox360ButtonData *>(input_bytes);
+    const uint8_t *input_bytes = view.GetData();
+
+    const Xbox360ButtonData *buttonData = reinterpret_cast<const Xbox360ButtonData *>(input_bytes);
 
     *input_idx = controller_idx;
 
@@ -72,7 +76,7 @@ ams::Result Xbox360WirelessController::ReadInput(RawInputData *rawData, uint16_t
     }
     else if (input_bytes[0] == 0x00 && input_bytes[1] == 0x01 && input_bytes[2] == 0x00 && input_bytes[3] == 0xf0)
     {
-        buttonData = reinterpret_cast<Xbox360ButtonData *>(input_bytes + 4);
+        buttonData = reinterpret_cast<const Xbox360ButtonData *>(input_bytes + 4);
 
         if (buttonData->type == XBOX360INPUT_BUTTON) // Button data
         {
@@ -125,7 +129,7 @@ uint16_t Xbox360WirelessController::GetInputCount()
 ams::Result Xbox360WirelessController::SetRumble(uint16_t input_idx, float amp_high, float amp_low)
 {
     uint8_t rumbleData[]{0x00, (uint8_t)(input_idx + 1), 0x0F, 0xC0, 0x00, (uint8_t)(amp_high * 255), (uint8_t)(amp_low * 255), 0x00, 0x00, 0x00, 0x00, 0x00};
-    R_RETURN(m_outPipe[input_idx]->Write(rumbleData, sizeof(rumbleData)));
+    R_RETURN(m_outPipe[input_idx]->QueueWrite(rumbleData, sizeof(rumbleData), IUSBEndpoint::OUTPUT_KEY_RUMBLE));
 }
 
 bool Xbox360WirelessController::IsControllerConnected(uint16_t input_idx)
@@ -136,15 +140,16 @@ bool Xbox360WirelessController::IsControllerConnected(uint16_t input_idx)
 ams::Result Xbox360WirelessController::SetLED(uint16_t input_idx, Xbox360LEDValue value)
 {
     uint8_t ledPacket[]{0x00, (uint8_t)(input_idx + 1), 0x08, (uint8_t)(value | 0x40), 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
-    R_RETURN(m_outPipe[input_idx]->Write(ledPacket, sizeof(ledPacket)));
+    R_RETURN(m_outPipe[input_idx]->QueueWrite(ledPacket, sizeof(ledPacket), IUSBEndpoint::OUTPUT_KEY_LED));
 }
 
 ams::Result Xbox360WirelessController::OnControllerConnect(uint16_t input_idx)
 {
     LogPrint(LogLevelInfo, "Xbox360WirelessController Wireless controller connected (Idx: %d) ...", input_idx);
 
-    m_outPipe[input_idx]->Write(reconnectPacket, sizeof(reconnectPacket));
-    m_outPipe[input_idx]->Write(initDriverPacket, sizeof(initDriverPacket));
+    // Called from ReadInput: queued, not to block the input loop
+    m_outPipe[input_idx]->QueueWrite(reconnectPacket, sizeof(reconnectPacket));
+    m_outPipe[input_idx]->QueueWrite(initDriverPacket, sizeof(initDriverPacket));
 
     SetLED(input_idx, (Xbox360LEDValue)((int)XBOX360LED_TOPLEFT + input_idx));
 
@@ -157,7 +162,7 @@ ams::Result Xbox360WirelessController::OnControllerDisconnect(uint16_t input_idx
 {
     LogPrint(LogLevelInfo, "Xbox360WirelessController Wireless controller disconnected (Idx: %d) ...", input_idx);
 
-    m_outPipe[input_idx]->Write(poweroffPacket, sizeof(poweroffPacket));
+    m_outPipe[input_idx]->QueueWrite(poweroffPacket, sizeof(poweroffPacket));
 
     m_is_connected[input_idx] = false;
 
@@ -11,12 +11,12 @@ XboxController::~XboxController()
 
 ams::Result XboxController::ReadInput(RawInputData *rawData, uint16_t *input_idx, uint32_t timeout_us)
 {
-    uint8_t input_bytes[CONTROLLER_INPUT_BUFFER_SIZE];
-    size_t size = sizeof(input_bytes);
+    USBReadView view(m_inPipe[0]);
+    R_TRY(view.Acquire(CONTROLLER_INPUT_BUFFER_SIZE, timeout_us));
 
-    R_TRY(m_inPipe[0]->Read(input_bytes, &size, timeout_us));
+    const uint8_t *input_bytes = view.GetData();
 
-    XboxButtonData *buttonData = reinterpret_cast<XboxButtonData *>(input_bytes);
+    const XboxButtonData *buttonData = reinterpret_cast<const XboxButtonData *>(input_bytes);
 
     *input_idx = 0;
 
@@ -59,5 +59,5 @@ ams::Result XboxController::SetRumble(uint16_t input_idx, float amp_high, float
 {
     (void)input_idx;
     uint8_t rumbleData[]{0x00, 0x06, 0x00, (uint8_t)(amp_high * 255), (uint8_t)(amp_low * 255), 0x00, 0x00, 0x00};
-    R_RETURN(m_outPipe[input_idx]->Write(rumbleData, sizeof(rumbleData)));
+    R_RETURN(m_outPipe[input_idx]->QueueWrite(rumbleData, sizeof(rumbleData), IUSBEndpoint::OUTPUT_KEY_RUMBLE));
 }
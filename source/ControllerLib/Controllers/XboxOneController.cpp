@@ -116,10 +116,10 @@ ams::Result XboxOneController::Initialize()
 
 ams::Result XboxOneController::ReadInput(RawInputData *rawData, uint16_t *input_idx, uint32_t timeout_us)
 {
-    uint8_t input_bytes[CONTROLLER_INPUT_BUFFER_SIZE];
-    size_t size = sizeof(input_bytes);
+    USBReadView view(m_inPipe[0]);
+    R_TRY(view.Acquire(CONTROLLER_INPUT_BUFFER_SIZE, timeout_us));
 
-    R_TRY(m_inPipe[0]->Read(input_bytes, &size, timeout_us));
+    const uint8_t *input_bytes = view.GetData();
 
     uint8_t type = input_bytes[0];
 
@@ -127,7 +127,7 @@ ams::Result XboxOneController::ReadInput(RawInputData *rawData, uint16_t *input_
 
     if (type == GIP_CMD_INPUT) // Button data
     {
-        XboxOneButtonData *buttonData = reinterpret_cast<XboxOneButtonData *>(input_bytes);
+        const XboxOneButtonData *buttonData = reinterpret_cast<const XboxOneButtonData *>(input_bytes);
 
         m_rawInput.buttons[1] = buttonData->button1;
         m_rawInput.buttons[2] = buttonData->button2;
@@ -204,7 +204,7 @@ ams::Result XboxOneController::WriteAckModeReport(uint16_t input_idx, uint8_t se
         sequence,
         GIP_PL_LEN(9), 0x00, GIP_CMD_VIRTUAL_KEY, GIP_OPT_INTERNAL, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00};
 
-    R_RETURN(m_outPipe[input_idx]->Write(report, sizeof(report)));
+    R_RETURN(m_outPipe[input_idx]->QueueWrite(report, sizeof(report)));
 }
 
 bool XboxOneController::Support(ControllerFeature feature)
@@ -224,5 +224,5 @@ ams::Result XboxOneController::SetRumble(uint16_t input_idx, float amp_high, flo
         (uint8_t)(amp_high * 255),
         (uint8_t)(amp_low * 255),
         0xff, 0x00, 0x00};
-    R_RETURN(m_outPipe[input_idx]->Write(rumble_data, sizeof(rumble_data)));
+    R_RETURN(m_outPipe[input_idx]->QueueWrite(rumble_data, sizeof(rumble_data), IUSBEndpoint::OUTPUT_KEY_RUMBLE));
 }
\ No newline at end of file
@@ -3,6 +3,39 @@
 #include "ILogger.h"
 #include "ControllerTypes.h"
 #include "ControllerConfig.h"
+#include <atomic>
+
+// Trace/Debug logs of the drivers: the arguments are only evaluated when the level is enabled, never below SYSCON_LOG_MIN_LEVEL
+#define CONTROLLER_LOG(lvl, ...)          \
+    do                                    \
+    {                                     \
+        if (IsLogEnabled(lvl))            \
+            LogPrint((lvl), __VA_ARGS__); \
+    } while (0)
+
+#define CONTROLLER_LOG_BUFFER(lvl, buffer, size) \
+    do                                           \
+    {                                            \
+        if (IsLogEnabled(lvl))                   \
+            LogBuffer((lvl), (buffer), (size));  \
+    } while (0)
+
+// Trace/Debug logs on every report: sampled and rate limited per call site (See ILogger::PassLimit), the messages dropped are reported at most once per second
+#define CONTROLLER_LOG_LIMITED(lvl, ...)                                                                                            \
+    do                                                                                                                              \
+    {                                                                                                                               \
+        if (IsLogEnabled(lvl))                                                                                                      \
+        {                                                                                                                           \
+            static LogLimit _logLimit;                                                                                              \
+            uint32_t _suppressed;                                                                                                   \
+            if (m_logger->PassLimit(&_logLimit, &_suppressed))                                                                      \
+            {                                                                                                                       \
+                if (_suppressed > 0)                                                                                                \
+                    LogPrint((lvl), LOG_LIMIT_SUPPRESSED_FORMAT, (unsigned)_suppressed, LogLimitFileName(__FILE__), (int)__LINE__); \
+                LogPrint((lvl), __VA_ARGS__);                                                                                       \
+            }                                                                                                                       \
+        }                                                                                                                           \
+    } while (0)
 
 struct NormalizedStick
 {
@@ -24,6 +57,9 @@ protected:
     ControllerConfig m_config;
     std::unique_ptr<ILogger> m_logger;
 
+    // Config given by SetConfig, not yet applied by the input thread (See ApplyPendingConfig)
+    std::atomic<ControllerConfig *> m_pendingConfig{nullptr};
+
     void LogPrint(LogLevel lvl, const char *format, ...)
     {
         ::std::va_list vl;
@@ -37,13 +73,21 @@ protected:
         m_logger->PrintBuffer(lvl, buffer, size);
     }
 
+    inline bool IsLogEnabled(LogLevel lvl) const
+    {
+        return lvl >= SYSCON_LOG_MIN_LEVEL && m_logger->IsEnabled(lvl);
+    }
+
 public:
     IController(std::unique_ptr<IUSBDevice> &&device, const ControllerConfig &config, std::unique_ptr<ILogger> &&logger) : m_device(std::move(device)),
                                                                                                                            m_config(config),
                                                                                                                            m_logger(std::move(logger))
     {
     }
-    virtual ~IController() = default;
+    virtual ~IController()
+    {
+        delete m_pendingConfig.exchange(nullptr);
+    }
 
     virtual ams::Result Initialize() = 0;
     virtual void Exit() = 0;
@@ -63,5 +107,27 @@ public:
 
     inline const ControllerConfig &GetConfig() const { return m_config; }
 
+    // Replace the config of a controller running (i.e: config.ini reloaded), from any thread:
+    // the input thread applies it between two reads, the reads in progress keep the previous one
+    void SetConfig(const ControllerConfig &config)
+    {
+        delete m_pendingConfig.exchange(new ControllerConfig(config), std::memory_order_acq_rel);
+    }
+
+    // Called by the input thread before a read, true when a config given by SetConfig was applied
+    bool ApplyPendingConfig()
+    {
+        if (m_pendingConfig.load(std::memory_order_relaxed) == nullptr)
+            return false;
+
+        ControllerConfig *config = m_pendingConfig.exchange(nullptr, std::memory_order_acq_rel);
+        if (config == nullptr)
+            return false;
+
+        m_config = std::move(*config);
+        delete config;
+        return true;
+    }
+
     inline IUSBDevice *GetDevice() { return m_device.get(); }
 };
\ No newline at end of file
@@ -0,0 +1,14 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+// Storage for compiled HID report layouts (See HIDReportLayout::Serialize)
+// Entries are keyed by VID/PID and the hash of the raw report descriptor: a firmware update that changes the
+// descriptor simply misses the cache. The content is opaque to the cache.
+class IHIDLayoutCache
+{
+public:
+    virtual ~IHIDLayoutCache() = default;
+    virtual bool Load(uint16_t vendor, uint16_t product, uint64_t descriptorHash, std::vector<uint8_t> *data) = 0;
+    virtual void Store(uint16_t vendor, uint16_t product, uint64_t descriptorHash, const uint8_t *data, size_t size) = 0;
+};
@@ -1,5 +1,11 @@
 #pragma once
 #include <cstdarg>
+#include "LogLimit.h"
+
+// Trace and debug logs below this level are compiled out (i.e: -DSYSCON_LOG_MIN_LEVEL=2 removes them and the evaluation of their arguments)
+#ifndef SYSCON_LOG_MIN_LEVEL
+    #define SYSCON_LOG_MIN_LEVEL 0
+#endif
 
 typedef enum LogLevel
 {
@@ -16,4 +22,15 @@ public:
     virtual ~ILogger() = default;
     virtual void Print(LogLevel aLogLevel, const char *format, ::std::va_list vl) = 0;
     virtual void PrintBuffer(LogLevel aLogLevel, const uint8_t *buffer, size_t size) = 0;
+
+    // False when a message at this level would be filtered out: checked before the arguments are evaluated (See CONTROLLER_LOG)
+    virtual bool IsEnabled(LogLevel aLogLevel) const = 0;
+
+    // Sampling and rate limit of a high frequency call site (See CONTROLLER_LOG_LIMITED, LogLimit.h), every message is kept by default
+    virtual bool PassLimit(LogLimit *limit, uint32_t *suppressed)
+    {
+        (void)limit;
+        *suppressed = 0;
+        return true;
+    }
 };
\ No newline at end of file
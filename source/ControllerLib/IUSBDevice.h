@@ -21,6 +21,11 @@ public:
     // Reset the device.
     virtual void Reset() = 0;
 
+    // Wait until a transfer completes on one of the given IN endpoints, transfers of maxSize bytes are kept in flight on all of them
+    // (i.e: wireless receivers, one endpoint per pad). *readyIndex is the endpoint to read, its read returns without waiting.
+    // Endpoints with a report already waiting are picked in order from firstIndex, so that a busy endpoint doesn't starve the others.
+    virtual ams::Result WaitForInput(IUSBEndpoint *const *endpoints, size_t count, size_t firstIndex, size_t maxSize, size_t *readyIndex, u64 aTimeoutUs) = 0;
+
     // Get the raw reference to interfaces vector.
     virtual std::vector<std::unique_ptr<IUSBInterface>> &GetInterfaces() { return m_interfaces; }
 
@@ -28,14 +28,103 @@ public:
     virtual ams::Result Open(int maxPacketSize = 0) = 0;
     virtual void Close() = 0;
 
+    // Writes replacing the previous one with the same key while it is still queued (See QueueWrite)
+    enum OutputKey : uint32_t
+    {
+        OUTPUT_KEY_NONE = 0,
+        OUTPUT_KEY_RUMBLE,
+        OUTPUT_KEY_LED,
+    };
+
     // This will read from the inBuffer pointer for the specified size and write it to the endpoint.
+    // Synchronous, sent after the writes still queued. Writes are spaced by bInterval ms.
     virtual ams::Result Write(const uint8_t *inBuffer, size_t bufferSize) = 0;
 
+    // Queue the write and return right away, the queue is sent in order and spaced by bInterval ms like Write().
+    // A write with a key replaces the one with the same key still waiting in the queue (i.e: only the latest rumble value matters).
+    // To be used from the input loop (rumble, LED, acknowledgements), the data is copied.
+    virtual ams::Result QueueWrite(const uint8_t *inBuffer, size_t bufferSize, OutputKey key = OUTPUT_KEY_NONE) = 0;
+
     // This will read from the endpoint and put the data in the outBuffer pointer for the specified size.
     virtual ams::Result Read(uint8_t *outBuffer, size_t *bufferSizeInOut, u64 aTimeoutUs) = 0;
 
+    // Zero-copy read: lend a read-only view of the completed transfer buffer instead of copying it (See USBReadView).
+    // *sizeInOut is the maximum transfer size on input and the received size on output, at least CONTROLLER_INPUT_BUFFER_SIZE
+    // bytes are readable behind *outData. The view stays valid until ReleaseReadView(), which gives the buffer back
+    // to the endpoint (posted again right away). Only one view can be held at a time, none is held if the read failed.
+    virtual ams::Result AcquireReadView(const uint8_t **outData, size_t *sizeInOut, u64 aTimeoutUs) = 0;
+    virtual void ReleaseReadView() = 0;
+
     // Get endpoint's direction. (IN or OUT)
     virtual IUSBEndpoint::Direction GetDirection() = 0;
     // Get the endpoint descriptor
     virtual EndpointDescriptor *GetDescriptor() = 0;
+
+    // Reports received and copies of them made by the endpoint (1 per Read(), 0 per view)
+    struct ReadStats
+    {
+        uint64_t reports = 0;
+        uint64_t copies = 0;
+        uint64_t copiedBytes = 0;
+    };
+
+    inline const ReadStats &GetReadStats() const { return m_readStats; }
+
+    // Writes queued by QueueWrite
+    struct OutputStats
+    {
+        uint64_t queued = 0;
+        uint64_t sent = 0;
+        uint64_t coalesced = 0; // Replaced by a newer write before being sent
+        uint64_t dropped = 0;   // Queue full
+        uint64_t failed = 0;
+        uint32_t depth = 0; // Writes waiting now
+        uint32_t depthMax = 0;
+        uint64_t latencyTotal_us = 0; // From QueueWrite to the end of the transfer
+        uint64_t latencyMax_us = 0;
+    };
+
+    inline const OutputStats &GetOutputStats() const { return m_outputStats; }
+
+protected:
+    ReadStats m_readStats;
+    OutputStats m_outputStats;
+};
+
+// Scope of a zero-copy read, the view is released when the object goes out of scope
+//   USBReadView view(m_inPipe[0]);
+//   R_TRY(view.Acquire(CONTROLLER_INPUT_BUFFER_SIZE, timeout_us));
+//   Decode(view.GetData(), view.GetSize());
+class USBReadView
+{
+private:
+    IUSBEndpoint *m_endpoint;
+    const uint8_t *m_data = NULL;
+    size_t m_size = 0;
+
+public:
+    explicit USBReadView(IUSBEndpoint *endpoint) : m_endpoint(endpoint) {}
+    USBReadView(const USBReadView &) = delete;
+    USBReadView &operator=(const USBReadView &) = delete;
+
+    ~USBReadView()
+    {
+        if (m_data != NULL)
+            m_endpoint->ReleaseReadView();
+    }
+
+    ams::Result Acquire(size_t maxSize, u64 aTimeoutUs)
+    {
+        const uint8_t *data = NULL;
+        size_t size = maxSize;
+
+        // No view is held when the read failed
+        ams::Result rc = m_endpoint->AcquireReadView(&data, &size, aTimeoutUs);
+        m_data = R_SUCCEEDED(rc) ? data : NULL;
+        m_size = R_SUCCEEDED(rc) ? size : 0;
+        R_RETURN(rc);
+    }
+
+    inline const uint8_t *GetData() const { return m_data; }
+    inline size_t GetSize() const { return m_size; }
 };
\ No newline at end of file
@@ -0,0 +1,121 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+
+// Number of buckets of LatencyHistogram, the last one counts every value >= 2^(LATENCY_HISTOGRAM_BUCKETS - 2) us (~4 s)
+#define LATENCY_HISTOGRAM_BUCKETS 24
+
+// Fixed log2 buckets of microseconds: bucket 0 counts the values < 1 us, bucket i the values in [2^(i-1), 2^i) us.
+// Record() is a few relaxed atomic operations and never allocates: it's called from the input threads on every report,
+// while another thread reads the histogram (See Format). The percentiles are the upper bound of their bucket (at most 2x the real value).
+class LatencyHistogram
+{
+private:
+    std::atomic<uint32_t> m_buckets[LATENCY_HISTOGRAM_BUCKETS];
+    std::atomic<uint64_t> m_total_us{0};
+    std::atomic<uint32_t> m_max_us{0};
+
+public:
+    LatencyHistogram()
+    {
+        Reset();
+    }
+
+    void Reset()
+    {
+        for (size_t i = 0; i < LATENCY_HISTOGRAM_BUCKETS; i++)
+            m_buckets[i].store(0, std::memory_order_relaxed);
+        m_total_us.store(0, std::memory_order_relaxed);
+        m_max_us.store(0, std::memory_order_relaxed);
+    }
+
+    static inline size_t GetBucket(uint64_t value_us)
+    {
+        if (value_us == 0)
+            return 0;
+
+        size_t bucket = 64 - __builtin_clzll(value_us);
+        return bucket < LATENCY_HISTOGRAM_BUCKETS ? bucket : LATENCY_HISTOGRAM_BUCKETS - 1;
+    }
+
+    // Exclusive upper bound of the bucket, UINT64_MAX for the last one
+    static inline uint64_t GetBucketLimit(size_t bucket)
+    {
+        return bucket < LATENCY_HISTOGRAM_BUCKETS - 1 ? (uint64_t)1 << bucket : UINT64_MAX;
+    }
+
+    inline void Record(uint64_t value_us)
+    {
+        m_buckets[GetBucket(value_us)].fetch_add(1, std::memory_order_relaxed);
+        m_total_us.fetch_add(value_us, std::memory_order_relaxed);
+
+        uint32_t value32 = value_us < UINT32_MAX ? (uint32_t)value_us : UINT32_MAX;
+        uint32_t max_us = m_max_us.load(std::memory_order_relaxed);
+        while (value32 > max_us && !m_max_us.compare_exchange_weak(max_us, value32, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    uint64_t GetCount() const
+    {
+        uint64_t count = 0;
+        for (size_t i = 0; i < LATENCY_HISTOGRAM_BUCKETS; i++)
+            count += m_buckets[i].load(std::memory_order_relaxed);
+        return count;
+    }
+
+    inline uint64_t GetTotal() const { return m_total_us.load(std::memory_order_relaxed); }
+    inline uint32_t GetMax() const { return m_max_us.load(std::memory_order_relaxed); }
+    inline uint32_t GetBucketCount(size_t bucket) const { return m_buckets[bucket].load(std::memory_order_relaxed); }
+
+    // Upper bound of the bucket which contains the given percentile (0 to 100), limited to the maximum value recorded
+    uint64_t GetPercentile(uint32_t percentile) const
+    {
+        uint64_t count = GetCount();
+        if (count == 0)
+            return 0;
+
+        uint64_t rank = (count * percentile + 99) / 100;
+        uint64_t seen = 0;
+        for (size_t i = 0; i < LATENCY_HISTOGRAM_BUCKETS; i++)
+        {
+            seen += GetBucketCount(i);
+            if (seen >= rank && seen > 0)
+                return GetBucketLimit(i) < GetMax() ? GetBucketLimit(i) : GetMax();
+        }
+
+        return GetMax();
+    }
+
+    // One line: "count=N avg=N p50<=N p90<=N p99<=N max=N |<1:N 1-2:N 2-4:N ..." (only the buckets used), returns the length written
+    size_t Format(char *buffer, size_t size) const
+    {
+        uint64_t count = GetCount();
+        size_t length = 0;
+
+        if (size == 0)
+            return 0;
+
+        length += snprintf(buffer, size, "count=%llu avg=%llu p50<=%llu p90<=%llu p99<=%llu max=%u |",
+                           (unsigned long long)count, (unsigned long long)(count ? GetTotal() / count : 0),
+                           (unsigned long long)GetPercentile(50), (unsigned long long)GetPercentile(90), (unsigned long long)GetPercentile(99), (unsigned)GetMax());
+
+        for (size_t i = 0; i < LATENCY_HISTOGRAM_BUCKETS && length < size; i++)
+        {
+            uint32_t bucketCount = GetBucketCount(i);
+            if (bucketCount == 0)
+                continue;
+
+            if (i == 0)
+                length += snprintf(buffer + length, size - length, " <1:%u", (unsigned)bucketCount);
+            else if (i == LATENCY_HISTOGRAM_BUCKETS - 1)
+                length += snprintf(buffer + length, size - length, " >=%llu:%u", (unsigned long long)GetBucketLimit(i - 1), (unsigned)bucketCount);
+            else
+                length += snprintf(buffer + length, size - length, " %llu-%llu:%u", (unsigned long long)GetBucketLimit(i - 1), (unsigned long long)GetBucketLimit(i), (unsigned)bucketCount);
+        }
+
+        return length < size ? length : size - 1;
+    }
+};
@@ -0,0 +1,353 @@
+#pragma once
+#include <cstdarg>
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+
+// Binary format of the log written by the sysmodule when log_binary=1 (log.bin, See syscon::logger::EnableBinaryLog)
+// The messages are not formatted by the sysmodule: it records the format string once, then its ID and the raw arguments of each message.
+// The text is rebuilt on a computer (ControllerHost/tools/log_decode).
+//
+// File: records, LogBinaryRecordHeader followed by 'length' bytes of payload.
+//  - Start:   payload is LogBinaryStart, written each time the file is opened. The format IDs are only valid until the next Start.
+//  - Format:  payload is a uint16_t format ID, a uint8_t argument count, the argument types (LogBinaryArgType) and the format string (not terminated).
+//             Written the first time the format string is logged, before any message using it.
+//  - Message: payload is a uint16_t format ID followed by the arguments:
+//             Int32 4 bytes, Int64/Double/Pointer 8 bytes, String uint8_t length followed by the characters (truncated, not terminated)
+//  - Text:    payload is a line already formatted (Hex dumps, format strings not supported, dropped lines)
+//
+// All values are little endian.
+
+#define LOG_BINARY_MAGIC    0x474C4253 // "SBLG"
+#define LOG_BINARY_VERSION  1
+#define LOG_BINARY_MAX_ARGS 16
+
+enum LogBinaryRecordType : uint8_t
+{
+    LogBinaryRecordType_Start = 0,
+    LogBinaryRecordType_Format,
+    LogBinaryRecordType_Message,
+    LogBinaryRecordType_Text,
+};
+
+enum LogBinaryArgType : uint8_t
+{
+    LogBinaryArgType_Int32 = 0,
+    LogBinaryArgType_Int64,
+    LogBinaryArgType_Double,
+    LogBinaryArgType_String,
+    LogBinaryArgType_Pointer,
+};
+
+struct LogBinaryRecordHeader
+{
+    uint16_t length;       // Payload length
+    uint8_t type;          // LogBinaryRecordType
+    uint8_t level;         // LOG_LEVEL_xxx (Message only)
+    uint32_t threadId;     // Message only
+    uint64_t timestamp_us; // System tick (Message only)
+};
+
+struct LogBinaryStart
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t reserved;
+};
+
+// One conversion of a printf format string
+struct LogBinaryConversion
+{
+    const char *start; // '%'
+    const char *end;   // After the conversion character
+    uint8_t types[3];  // Arguments taken: '*' width and precision (Int32), then the value
+    uint8_t typeCount; // 0 for "%%"
+};
+
+// Parse the next conversion from *fmt and move *fmt after it.
+// Returns 1 when a conversion was found, 0 at the end of the format, -1 if the conversion is not supported (%n, long double, wide strings)
+inline int LogBinaryNextConversion(const char **fmt, LogBinaryConversion *conversion)
+{
+    const char *p = strchr(*fmt, '%');
+    bool is64 = false;
+
+    if (p == NULL)
+    {
+        *fmt += strlen(*fmt);
+        return 0;
+    }
+
+    conversion->start = p++;
+    conversion->typeCount = 0;
+
+    if (*p != '%')
+    {
+        while (*p != '\0' && strchr("-+ #0'", *p) != NULL)
+            p++;
+
+        if (*p == '*')
+        {
+            conversion->types[conversion->typeCount++] = LogBinaryArgType_Int32;
+            p++;
+        }
+        while (*p >= '0' && *p <= '9')
+            p++;
+
+        if (*p == '.')
+        {
+            p++;
+            if (*p == '*')
+            {
+                conversion->types[conversion->typeCount++] = LogBinaryArgType_Int32;
+                p++;
+            }
+            while (*p >= '0' && *p <= '9')
+                p++;
+        }
+
+        if (*p == 'h')
+        {
+            p++;
+            if (*p == 'h')
+                p++;
+        }
+        else if (*p == 'l' || *p == 'z' || *p == 'j' || *p == 't')
+        {
+            is64 = true;
+            if (*p++ == 'l' && *p == 'l')
+                p++;
+        }
+
+        switch (*p)
+        {
+            case 'd':
+            case 'i':
+            case 'u':
+            case 'o':
+            case 'x':
+            case 'X':
+            case 'c':
+                conversion->types[conversion->typeCount++] = is64 ? LogBinaryArgType_Int64 : LogBinaryArgType_Int32;
+                break;
+            case 'f':
+            case 'F':
+            case 'e':
+            case 'E':
+            case 'g':
+            case 'G':
+            case 'a':
+            case 'A':
+                conversion->types[conversion->typeCount++] = LogBinaryArgType_Double;
+                break;
+            case 's':
+                if (is64)
+                    return -1;
+                conversion->types[conversion->typeCount++] = LogBinaryArgType_String;
+                break;
+            case 'p':
+                conversion->types[conversion->typeCount++] = LogBinaryArgType_Pointer;
+                break;
+            default:
+                return -1;
+        }
+    }
+
+    conversion->end = ++p;
+    *fmt = p;
+    return 1;
+}
+
+// Argument types of a whole format string, -1 if it's not supported or takes more than maxTypes arguments
+inline int LogBinaryParseFormat(const char *fmt, uint8_t *types, size_t maxTypes)
+{
+    LogBinaryConversion conversion;
+    size_t count = 0;
+    int rc;
+
+    while ((rc = LogBinaryNextConversion(&fmt, &conversion)) > 0)
+    {
+        if (count + conversion.typeCount > maxTypes)
+            return -1;
+
+        memcpy(&types[count], conversion.types, conversion.typeCount);
+        count += conversion.typeCount;
+    }
+
+    return rc < 0 ? -1 : (int)count;
+}
+
+// Write the arguments of a Message record (after the format ID), returns the size written.
+// Strings are truncated to leave room for the arguments after them: size must be at least 8 bytes per argument.
+inline size_t LogBinaryWriteArgs(uint8_t *out, size_t size, const uint8_t *types, uint8_t count, ::std::va_list vl)
+{
+    size_t offset = 0;
+
+    for (uint8_t i = 0; i < count; i++)
+    {
+        switch (types[i])
+        {
+            case LogBinaryArgType_Int32:
+            {
+                int32_t value = va_arg(vl, int);
+                memcpy(&out[offset], &value, sizeof(value));
+                offset += sizeof(value);
+                break;
+            }
+            case LogBinaryArgType_Int64:
+            {
+                int64_t value = va_arg(vl, long long);
+                memcpy(&out[offset], &value, sizeof(value));
+                offset += sizeof(value);
+                break;
+            }
+            case LogBinaryArgType_Double:
+            {
+                double value = va_arg(vl, double);
+                memcpy(&out[offset], &value, sizeof(value));
+                offset += sizeof(value);
+                break;
+            }
+            case LogBinaryArgType_Pointer:
+            {
+                uint64_t value = (uint64_t)(uintptr_t)va_arg(vl, void *);
+                memcpy(&out[offset], &value, sizeof(value));
+                offset += sizeof(value);
+                break;
+            }
+            case LogBinaryArgType_String:
+            {
+                const char *value = va_arg(vl, const char *);
+                if (value == NULL)
+                    value = "(null)";
+
+                size_t room = size - offset - 1 - (count - i - 1) * 8;
+                size_t length = strlen(value);
+                length = length < room ? length : room;
+                length = length < UINT8_MAX ? length : UINT8_MAX;
+
+                out[offset++] = (uint8_t)length;
+                memcpy(&out[offset], value, length);
+                offset += length;
+                break;
+            }
+        }
+    }
+
+    return offset;
+}
+
+template <typename T>
+inline int LogBinaryFormatValue(char *out, size_t size, const char *spec, const int *stars, int starCount, T value)
+{
+    if (starCount == 2)
+        return snprintf(out, size, spec, stars[0], stars[1], value);
+    if (starCount == 1)
+        return snprintf(out, size, spec, stars[0], value);
+    return snprintf(out, size, spec, value);
+}
+
+// Rebuild the text of a Message record from its format string and arguments, returns the length of the text (Always terminated)
+inline size_t LogBinaryFormatMessage(char *out, size_t size, const char *fmt, const uint8_t *args, size_t argsSize)
+{
+    LogBinaryConversion conversion;
+    size_t length = 0;
+    size_t offset = 0;
+
+    if (size == 0)
+        return 0;
+
+    out[0] = '\0';
+
+    while (length < size - 1)
+    {
+        const char *literal = fmt;
+        int rc = LogBinaryNextConversion(&fmt, &conversion);
+        const char *literalEnd = rc != 0 ? conversion.start : fmt;
+
+        length += snprintf(&out[length], size - length, "%.*s", (int)(literalEnd - literal), literal);
+        if (rc <= 0 || length >= size - 1)
+            break;
+
+        if (conversion.typeCount == 0)
+        {
+            length += snprintf(&out[length], size - length, "%%");
+            continue;
+        }
+
+        char spec[32];
+        int stars[2] = {0, 0};
+        int starCount = conversion.typeCount - 1;
+        size_t specLength = conversion.end - conversion.start;
+        if (specLength >= sizeof(spec))
+            break;
+
+        memcpy(spec, conversion.start, specLength);
+        spec[specLength] = '\0';
+
+        for (int i = 0; i < starCount; i++)
+        {
+            if (offset + sizeof(int32_t) > argsSize)
+                return length;
+            memcpy(&stars[i], &args[offset], sizeof(int32_t));
+            offset += sizeof(int32_t);
+        }
+
+        size_t valueSize = conversion.types[starCount] == LogBinaryArgType_Int32 ? sizeof(int32_t) : conversion.types[starCount] == LogBinaryArgType_String ? 1 : 8;
+        if (offset + valueSize > argsSize)
+        {
+            length += snprintf(&out[length], size - length, "<truncated>");
+            break;
+        }
+
+        int written = 0;
+        switch (conversion.types[starCount])
+        {
+            case LogBinaryArgType_Int32:
+            {
+                int32_t value;
+                memcpy(&value, &args[offset], sizeof(value));
+                written = LogBinaryFormatValue(&out[length], size - length, spec, stars, starCount, value);
+                break;
+            }
+            case LogBinaryArgType_Int64:
+            {
+                long long value;
+                memcpy(&value, &args[offset], sizeof(value));
+                written = LogBinaryFormatValue(&out[length], size - length, spec, stars, starCount, value);
+                break;
+            }
+            case LogBinaryArgType_Double:
+            {
+                double value;
+                memcpy(&value, &args[offset], sizeof(value));
+                written = LogBinaryFormatValue(&out[length], size - length, spec, stars, starCount, value);
+                break;
+            }
+            case LogBinaryArgType_Pointer:
+            {
+                uint64_t value;
+                memcpy(&value, &args[offset], sizeof(value));
+                written = LogBinaryFormatValue(&out[length], size - length, spec, stars, starCount, (void *)(uintptr_t)value);
+                break;
+            }
+            case LogBinaryArgType_String:
+            {
+                char value[UINT8_MAX + 1];
+                size_t stringLength = args[offset];
+                if (offset + 1 + stringLength > argsSize)
+                    stringLength = argsSize - offset - 1;
+                memcpy(value, &args[offset + 1], stringLength);
+                value[stringLength] = '\0';
+                written = LogBinaryFormatValue(&out[length], size - length, spec, stars, starCount, (const char *)value);
+                valueSize = 1 + stringLength;
+                break;
+            }
+        }
+
+        offset += valueSize;
+        length += written > 0 ? written : 0;
+    }
+
+    return length < size ? length : size - 1;
+}
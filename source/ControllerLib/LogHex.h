@@ -0,0 +1,64 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+// Hex dump of the logs: lines of LOG_HEX_BYTES_PER_LINE bytes "XX XX ... ", each starting with a prefix (The log line header)
+// The bytes are encoded from a table of the 256 digit pairs, in a single pass, without printf.
+
+#define LOG_HEX_BYTES_PER_LINE 16
+
+struct LogHexTable
+{
+    char digits[256][2];
+
+    constexpr LogHexTable()
+        : digits()
+    {
+        const char hex[] = "0123456789ABCDEF";
+        for (int i = 0; i < 256; i++)
+        {
+            digits[i][0] = hex[i >> 4];
+            digits[i][1] = hex[i & 0x0F];
+        }
+    }
+};
+
+inline constexpr LogHexTable g_logHexTable;
+
+// "XX " for each byte, returns the length written (count * 3, not terminated)
+inline size_t LogHexEncode(char *out, const uint8_t *data, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        memcpy(&out[i * 3], g_logHexTable.digits[data[i]], 2);
+        out[i * 3 + 2] = ' ';
+    }
+
+    return count * 3;
+}
+
+// Append to text (length characters already used out of size) as many whole lines as fit, separated by '\n' (No trailing '\n', not terminated).
+// *data and *count are moved past the bytes dumped, returns the new length of text.
+inline size_t LogHexAppendLines(char *text, size_t length, size_t size, const char *prefix, size_t prefixLength, const uint8_t **data, size_t *count)
+{
+    while (*count > 0)
+    {
+        size_t bytes = *count < LOG_HEX_BYTES_PER_LINE ? *count : LOG_HEX_BYTES_PER_LINE;
+        size_t lineLength = (length > 0 ? 1 : 0) + prefixLength + bytes * 3;
+        if (length + lineLength > size)
+            break;
+
+        if (length > 0)
+            text[length++] = '\n';
+
+        memcpy(&text[length], prefix, prefixLength);
+        length += prefixLength;
+        length += LogHexEncode(&text[length], *data, bytes);
+
+        *data += bytes;
+        *count -= bytes;
+    }
+
+    return length;
+}
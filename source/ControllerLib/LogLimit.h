@@ -0,0 +1,71 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
+// Limit of a high frequency log call site (i.e: a message on every report), shared by all the threads logging there:
+//  - sampling:     1 message out of `sample` is kept (1: every message)
+//  - token bucket: at most `rate` messages per second are kept, in bursts of up to `burst` messages (rate 0: unlimited)
+// The messages dropped are counted, a message kept is preceded by LOG_LIMIT_SUPPRESSED_FORMAT with that count at most once per LOG_LIMIT_REPORT_NS.
+
+#define LOG_LIMIT_SUPPRESSED_FORMAT "%u messages suppressed at %s:%d"
+#define LOG_LIMIT_REPORT_NS         1000000000ULL
+
+struct LogLimitConfig
+{
+    uint32_t sample;
+    uint32_t rate;
+    uint32_t burst;
+};
+
+struct LogLimit
+{
+    std::atomic<uint32_t> count{0};      // Messages reaching the call site
+    std::atomic<uint64_t> full_ns{0};    // Token bucket: time at which it's full again, each message kept moves it 1/rate s later
+    std::atomic<uint32_t> suppressed{0}; // Messages dropped since the last report
+    std::atomic<uint64_t> report_ns{0};  // Time of the next report
+};
+
+// True when the message is kept, *suppressed is then the number of messages dropped to report before it (0: nothing to report yet)
+inline bool LogLimitPass(LogLimit *limit, const LogLimitConfig &config, uint64_t now_ns, uint32_t *suppressed)
+{
+    if (config.sample > 1 && limit->count.fetch_add(1, std::memory_order_relaxed) % config.sample != 0)
+    {
+        limit->suppressed.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    if (config.rate > 0)
+    {
+        uint64_t interval_ns = 1000000000ULL / config.rate;
+        uint64_t tolerance_ns = (config.burst > 1 ? config.burst - 1 : 0) * interval_ns;
+        uint64_t full_ns = limit->full_ns.load(std::memory_order_relaxed);
+        uint64_t next_ns;
+        do
+        {
+            // The bucket has burst - (full_ns - now_ns) / interval_ns tokens left
+            uint64_t start_ns = full_ns > now_ns ? full_ns : now_ns;
+            if (start_ns - now_ns > tolerance_ns)
+            {
+                limit->suppressed.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            next_ns = start_ns + interval_ns;
+        } while (!limit->full_ns.compare_exchange_weak(full_ns, next_ns, std::memory_order_relaxed));
+    }
+
+    *suppressed = 0;
+    uint64_t report_ns = limit->report_ns.load(std::memory_order_relaxed);
+    if (now_ns >= report_ns && limit->suppressed.load(std::memory_order_relaxed) > 0 &&
+        limit->report_ns.compare_exchange_strong(report_ns, now_ns + LOG_LIMIT_REPORT_NS, std::memory_order_relaxed))
+        *suppressed = limit->suppressed.exchange(0, std::memory_order_relaxed);
+
+    return true;
+}
+
+// __FILE__ without its directories, for LOG_LIMIT_SUPPRESSED_FORMAT
+inline const char *LogLimitFileName(const char *path)
+{
+    const char *name = strrchr(path, '/');
+    return name != NULL ? name + 1 : path;
+}
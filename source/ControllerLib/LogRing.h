@@ -0,0 +1,106 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+// Number of entries the ring can hold (Power of 2) and size of an entry, a longer line takes several consecutive entries (See Reserve)
+#define LOG_RING_ENTRIES   128
+#define LOG_RING_LINE_SIZE 256
+
+// Bounded multi-producer / single-consumer ring of log lines, lock-free (Vyukov's bounded queue).
+// A producer reserves an entry with one CAS, formats its line directly into it and commits it; the consumer takes the entries in order.
+// When the ring is full the line is dropped and counted: a producer never waits for the consumer, nor for the SD card
+// (except the logger for its error lines, See syscon::logger).
+// An entry reserved but not committed yet holds back the consumer (not the producers) until it is committed.
+class LogRing
+{
+public:
+    struct Entry
+    {
+        std::atomic<uint32_t> sequence;
+        uint16_t length;
+        uint8_t kind; // Set by the producer for the consumer (i.e: text or binary line)
+        char data[LOG_RING_LINE_SIZE];
+    };
+
+private:
+    Entry m_entries[LOG_RING_ENTRIES];
+    alignas(64) std::atomic<uint32_t> m_tail{0}; // Next entry reserved by a producer
+    alignas(64) std::atomic<uint32_t> m_head{0}; // Next entry taken by the consumer (Only written by the consumer)
+    std::atomic<uint32_t> m_dropped{0};
+
+    static_assert((LOG_RING_ENTRIES & (LOG_RING_ENTRIES - 1)) == 0, "LOG_RING_ENTRIES must be a power of 2");
+
+public:
+    LogRing()
+    {
+        for (uint32_t i = 0; i < LOG_RING_ENTRIES; i++)
+            m_entries[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    // Producer: count consecutive entries (See Next), the consumer gets them in a row.
+    // NULL if the ring is full, the line is counted as dropped unless the caller writes it another way (countDropped = false)
+    Entry *Reserve(uint32_t count = 1, bool countDropped = true)
+    {
+        uint32_t position = m_tail.load(std::memory_order_relaxed);
+
+        while (true)
+        {
+            // The entries are freed in order: when the last one is free, the ones before it are too
+            Entry *last = &m_entries[(position + count - 1) & (LOG_RING_ENTRIES - 1)];
+            int32_t diff = (int32_t)(last->sequence.load(std::memory_order_acquire) - (position + count - 1));
+
+            if (diff == 0)
+            {
+                if (m_tail.compare_exchange_weak(position, position + count, std::memory_order_relaxed))
+                    return &m_entries[position & (LOG_RING_ENTRIES - 1)];
+            }
+            else if (diff < 0)
+            {
+                if (countDropped)
+                    m_dropped.fetch_add(1, std::memory_order_relaxed);
+                return NULL;
+            }
+            else
+            {
+                position = m_tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Producer: the entry reserved after this one (Reserve with count > 1)
+    inline Entry *Next(Entry *entry) { return &m_entries[(entry - m_entries + 1) & (LOG_RING_ENTRIES - 1)]; }
+
+    // Producer: publish the line written in entry->data
+    void Commit(Entry *entry, size_t length, uint8_t kind = 0)
+    {
+        entry->kind = kind;
+        entry->length = length < LOG_RING_LINE_SIZE ? (uint16_t)length : LOG_RING_LINE_SIZE;
+        entry->sequence.store(entry->sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // Consumer: the oldest committed line, NULL if there is none
+    const Entry *Peek() const
+    {
+        uint32_t position = m_head.load(std::memory_order_relaxed);
+        const Entry *entry = &m_entries[position & (LOG_RING_ENTRIES - 1)];
+
+        if (entry->sequence.load(std::memory_order_acquire) != position + 1)
+            return NULL;
+
+        return entry;
+    }
+
+    // Consumer: give the entry returned by Peek back to the producers
+    void Pop()
+    {
+        uint32_t position = m_head.load(std::memory_order_relaxed);
+        m_entries[position & (LOG_RING_ENTRIES - 1)].sequence.store(position + LOG_RING_ENTRIES, std::memory_order_release);
+        m_head.store(position + 1, std::memory_order_relaxed);
+    }
+
+    // Lines reserved and not taken by the consumer yet (Approximate when read by a producer)
+    inline uint32_t GetUsed() const { return m_tail.load(std::memory_order_relaxed) - m_head.load(std::memory_order_relaxed); }
+
+    inline uint32_t GetDropped() const { return m_dropped.load(std::memory_order_relaxed); }
+};
@@ -0,0 +1,74 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+// Binary format of the USB captures written by the sysmodule (See SwitchUSBCapture)
+//
+// File: UsbCaptureFileHeader, followed by records.
+// Record: UsbCaptureRecordHeader, followed by 'length' bytes of payload, padded to 4 bytes.
+//  - In/Out:                 payload is the data transferred (empty on error)
+//  - ControlIn/ControlOut:   payload is UsbCaptureSetupPacket followed by the data transferred
+//  - Interface:              payload is UsbCaptureInterfaceInfo, written when an interface is opened
+//  - Dropped:                payload is a uint32_t, number of records lost because the RAM ring was full
+//
+// All values are little endian.
+
+#define USB_CAPTURE_MAGIC   0x50414353 // "SCAP"
+#define USB_CAPTURE_VERSION 1
+
+#define USB_CAPTURE_ALIGN(size) (((size) + 3) & ~(size_t)3)
+
+enum UsbCaptureRecordType : uint8_t
+{
+    UsbCaptureRecordType_In = 0,
+    UsbCaptureRecordType_Out,
+    UsbCaptureRecordType_ControlIn,
+    UsbCaptureRecordType_ControlOut,
+    UsbCaptureRecordType_Interface,
+    UsbCaptureRecordType_Dropped,
+    UsbCaptureRecordType_Padding, // Never written to the file, used to wrap the RAM ring
+};
+
+struct UsbCaptureFileHeader
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t headerSize;
+    uint64_t startTimestamp_us; // System tick when the capture started, record timestamps are relative to it
+};
+
+struct UsbCaptureRecordHeader
+{
+    uint32_t timestamp_us; // Relative to startTimestamp_us, wraps after ~71 minutes. When the transfer completed: the records of an
+                           // endpoint are in order, but an IN transfer may be recorded after a later record of another endpoint
+    uint16_t interfaceId;  // Unique per opened interface (usbHs session ID)
+    uint8_t type;          // UsbCaptureRecordType
+    uint8_t endpoint;      // bEndpointAddress, 0 for control transfers
+    uint32_t result;       // ams::Result of the transfer
+    uint16_t length;       // Payload length (without padding)
+    uint16_t reserved;
+};
+
+struct UsbCaptureSetupPacket
+{
+    uint8_t bmRequestType;
+    uint8_t bmRequest;
+    uint16_t wValue;
+    uint16_t wIndex;
+    uint16_t wLength;
+};
+
+struct UsbCaptureInterfaceInfo
+{
+    uint16_t idVendor;
+    uint16_t idProduct;
+    uint8_t bInterfaceNumber;
+    uint8_t bInterfaceClass;
+    uint8_t bInterfaceSubClass;
+    uint8_t bInterfaceProtocol;
+};
+
+static_assert(sizeof(UsbCaptureFileHeader) == 16);
+static_assert(sizeof(UsbCaptureRecordHeader) == 16);
+static_assert(sizeof(UsbCaptureSetupPacket) == 8);
+static_assert(sizeof(UsbCaptureInterfaceInfo) == 8);
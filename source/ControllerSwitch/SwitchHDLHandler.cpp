@@ -1,9 +1,19 @@
 #include "SwitchHDLHandler.h"
 #include "SwitchLogger.h"
 #include <cmath>
+#include <algorithm>
+#include <cstdlib>
+
+// Period of the "sent/suppressed" debug summary
+#define HDL_STATS_PERIOD_MS 10000
 
 static HiddbgHdlsSessionId g_hdlsSessionId;
 
+static bool IsStickMoved(const HidAnalogStickState &stick, const HidAnalogStickState &lastSent, s32 deadband)
+{
+    return std::abs(stick.x - lastSent.x) > deadband || std::abs(stick.y - lastSent.y) > deadband;
+}
+
 static uint32_t GetHidNpadMask()
 {
     uint32_t HidNpadMask = 0;
@@ -19,8 +29,11 @@ static uint32_t GetHidNpadMask()
     return HidNpadMask;
 }
 
-SwitchHDLHandler::SwitchHDLHandler(std::unique_ptr<IController> &&controller, int polling_frequency_ms)
-    : SwitchVirtualGamepadHandler(std::move(controller), polling_frequency_ms)
+SwitchHDLHandler::SwitchHDLHandler(std::unique_ptr<IController> &&controller, int polling_frequency_ms, SwitchInputMode input_mode, int hdl_keepalive_ms, int hdl_stick_deadband)
+    : SwitchVirtualGamepadHandler(std::move(controller), polling_frequency_ms, input_mode),
+      m_hdl_keepalive_ms(std::max(0, hdl_keepalive_ms)),
+      m_hdl_stick_deadband(std::max(0, hdl_stick_deadband)),
+      m_hdlStatsTick(ams::os::GetSystemTick())
 {
     for (int i = 0; i < CONTROLLER_MAX_INPUTS; i++)
         m_controllerData[i].m_is_sync = true;
@@ -33,12 +46,24 @@ SwitchHDLHandler::~SwitchHDLHandler()
 
 ams::Result SwitchHDLHandler::Initialize()
 {
-    syscon::logger::LogDebug("SwitchHDLHandler[%04x-%04x] Initializing ...", m_controller->GetDevice()->GetVendor(), m_controller->GetDevice()->GetProduct());
+    SYSCON_LOG_DEBUG(LOG_MODULE_HDL, "SwitchHDLHandler[%04x-%04x] Initializing ...", m_controller->GetDevice()->GetVendor(), m_controller->GetDevice()->GetProduct());
 
     R_TRY(SwitchVirtualGamepadHandler::Initialize());
 
     R_TRY(InitHdlState());
 
+    // Rumble writes are spaced by bInterval anyway, polling the vibration value more often would only cost IPC
+    if (m_controller->Support(SUPPORTS_RUMBLE))
+    {
+        m_rumble_interval_ms = 1;
+        for (auto &&interface : m_controller->GetDevice()->GetInterfaces())
+        {
+            IUSBEndpoint *endpoint = interface->GetEndpoint(IUSBEndpoint::USB_ENDPOINT_OUT, 0);
+            if (endpoint != NULL)
+                m_rumble_interval_ms = std::max<s32>(m_rumble_interval_ms, endpoint->GetDescriptor()->bInterval);
+        }
+    }
+
     R_TRY(InitThread());
 
     syscon::logger::LogInfo("SwitchHDLHandler[%04x-%04x] Initialized !", m_controller->GetDevice()->GetVendor(), m_controller->GetDevice()->GetProduct());
@@ -48,13 +73,17 @@ ams::Result SwitchHDLHandler::Initialize()
 
 void SwitchHDLHandler::Exit()
 {
-    syscon::logger::LogDebug("SwitchHDLHandler[%04x-%04x] Exiting ...", m_controller->GetDevice()->GetVendor(), m_controller->GetDevice()->GetProduct());
+    SYSCON_LOG_DEBUG(LOG_MODULE_HDL, "SwitchHDLHandler[%04x-%04x] Exiting ...", m_controller->GetDevice()->GetVendor(), m_controller->GetDevice()->GetProduct());
 
-    SwitchVirtualGamepadHandler::Exit();
+    // The input thread is stopped first, then the vibration is stopped and the HDL devices detached while the endpoints are still open:
+    // the rumble off is sent when the controller closes them (SwitchVirtualGamepadHandler::Exit order, with UninitHdlState in between)
+    ExitThread();
 
     UninitHdlState();
 
-    syscon::logger::LogInfo("SwitchHDLHandler[%04x-%04x] Uninitialized !", m_controller->GetDevice()->GetVendor(), m_controller->GetDevice()->GetProduct());
+    m_controller->Exit();
+
+    syscon::logger::LogInfo("SwitchHDLHandler[%04x-%04x] Uninitialized ! (HDL states sent: %lu, suppressed: %lu, rumble values sent: %lu)", m_controller->GetDevice()->GetVendor(), m_controller->GetDevice()->GetProduct(), m_hdlSentCount, m_hdlSuppressedCount, m_rumbleSentCount);
 }
 
 ams::Result SwitchHDLHandler::Attach(uint16_t input_idx)
@@ -62,12 +91,13 @@ ams::Result SwitchHDLHandler::Attach(uint16_t input_idx)
     if (IsVirtualDeviceAttached(input_idx))
         R_SUCCEED();
 
-    syscon::logger::LogDebug("SwitchHDLHandler[%04x-%04x] Attaching device for input: %d ...", m_controller->GetDevice()->GetVendor(), m_controller->GetDevice()->GetProduct(), input_idx);
+    SYSCON_LOG_DEBUG(LOG_MODULE_HDL, "SwitchHDLHandler[%04x-%04x] Attaching device for input: %d ...", m_controller->GetDevice()->GetVendor(), m_controller->GetDevice()->GetProduct(), input_idx);
 
     uint32_t HidNpadBefore = GetHidNpadMask();
     R_TRY(hiddbgAttachHdlsVirtualDevice(&m_controllerData[input_idx].m_hdlHandle, &m_controllerData[input_idx].m_deviceInfo));
+    m_controllerData[input_idx].m_hdlStateSent = false; // The new virtual device must receive the current state
 
-    syscon::logger::LogTrace("SwitchHDLHandler[%04x-%04x] Searching for NpadId ...", m_controller->GetDevice()->GetVendor(), m_controller->GetDevice()->GetProduct());
+    SYSCON_LOG_TRACE(LOG_MODULE_HDL, "SwitchHDLHandler[%04x-%04x] Searching for NpadId ...", m_controller->GetDevice()->GetVendor(), m_controller->GetDevice()->GetProduct());
     // Wait until the controller is attached to a HidNpadIdType_xxx
     uint32_t HidNpadDiff = 0;
     for (int i = 0; i < 1000; i++) // Timeout after 1 second
@@ -89,18 +119,57 @@ ams::Result SwitchHDLHandler::Attach(uint16_t input_idx)
         }
     }
 
-    syscon::logger::LogDebug("SwitchHDLHandler[%04x-%04x] Attach - Idx: %d [NpadId: %d]", m_controller->GetDevice()->GetVendor(), m_controller->GetDevice()->GetProduct(), input_idx, m_controllerData[input_idx].m_npadId);
-    // R_TRY(hidInitializeVibrationDevices(&m_controllerData[input_idx].m_vibrationDeviceHandle, 1, m_controllerData[input_idx].m_npadId, HidNpadStyleTag_NpadFullKey));
+    SYSCON_LOG_DEBUG(LOG_MODULE_HDL, "SwitchHDLHandler[%04x-%04x] Attach - Idx: %d [NpadId: %d]", m_controller->GetDevice()->GetVendor(), m_controller->GetDevice()->GetProduct(), input_idx, m_controllerData[input_idx].m_npadId);
+
+    InitVibration(input_idx);
 
     R_SUCCEED();
 }
 
+void SwitchHDLHandler::InitVibration(uint16_t input_idx)
+{
+    SwitchHDLHandlerData *controllerData = &m_controllerData[input_idx];
+
+    controllerData->m_vibrationInitialized = false;
+    memset(&controllerData->m_vibrationLastValue, 0, sizeof(controllerData->m_vibrationLastValue));
+
+    if (m_rumble_interval_ms == 0 || controllerData->m_npadId == HidNpadIdType_Other)
+        return;
+
+    // Not fatal: the controller works without rumble
+    Result rc = hidInitializeVibrationDevices(&controllerData->m_vibrationDeviceHandle, 1, controllerData->m_npadId, HidNpadStyleTag_NpadFullKey);
+    if (R_FAILED(rc))
+    {
+        syscon::logger::LogError("SwitchHDLHandler[%04x-%04x] Failed to initialize the vibration device for idx: %d (Ret: 0x%X)", m_controller->GetDevice()->GetVendor(), m_controller->GetDevice()->GetProduct(), input_idx, rc);
+        return;
+    }
+
+    controllerData->m_vibrationInitialized = true;
+}
+
+// Don't leave the controller vibrating once its virtual device is gone
+void SwitchHDLHandler::StopVibration(uint16_t input_idx)
+{
+    SwitchHDLHandlerData *controllerData = &m_controllerData[input_idx];
+
+    if (!controllerData->m_vibrationInitialized)
+        return;
+
+    if (controllerData->m_vibrationLastValue.amp_high != 0 || controllerData->m_vibrationLastValue.amp_low != 0)
+        m_controller->SetRumble(input_idx, 0, 0);
+
+    memset(&controllerData->m_vibrationLastValue, 0, sizeof(controllerData->m_vibrationLastValue));
+    controllerData->m_vibrationInitialized = false;
+}
+
 ams::Result SwitchHDLHandler::Detach(uint16_t input_idx)
 {
     if (!IsVirtualDeviceAttached(input_idx))
         R_SUCCEED();
 
-    syscon::logger::LogDebug("SwitchHDLHandler[%04x-%04x] Detaching device for input: %d ...", m_controller->GetDevice()->GetVendor(), m_controller->GetDevice()->GetProduct(), input_idx);
+    SYSCON_LOG_DEBUG(LOG_MODULE_HDL, "SwitchHDLHandler[%04x-%04x] Detaching device for input: %d ...", m_controller->GetDevice()->GetVendor(), m_controller->GetDevice()->GetProduct(), input_idx);
+
+    StopVibration(input_idx);
 
     hiddbgDetachHdlsVirtualDevice(m_controllerData[input_idx].m_hdlHandle);
     m_controllerData[input_idx].m_hdlHandle.handle = 0;
@@ -110,13 +179,13 @@ ams::Result SwitchHDLHandler::Detach(uint16_t input_idx)
 
 ams::Result SwitchHDLHandler::InitHdlState()
 {
-    syscon::logger::LogDebug("SwitchHDLHandler[%04x-%04x] Initializing HDL state ...", m_controller->GetDevice()->GetVendor(), m_controller->GetDevice()->GetProduct());
+    SYSCON_LOG_DEBUG(LOG_MODULE_HDL, "SwitchHDLHandler[%04x-%04x] Initializing HDL state ...", m_controller->GetDevice()->GetVendor(), m_controller->GetDevice()->GetProduct());
 
     for (int i = 0; i < m_controller->GetInputCount(); i++)
     {
         m_controllerData[i].reset();
 
-        syscon::logger::LogDebug("SwitchHDLHandler[%04x-%04x] Initializing HDL device idx: %d (Controller type: %d) ...", m_controller->GetDevice()->GetVendor(), m_controller->GetDevice()->GetProduct(), i, m_controller->GetConfig().controllerType);
+        SYSCON_LOG_DEBUG(LOG_MODULE_HDL, "SwitchHDLHandler[%04x-%04x] Initializing HDL device idx: %d (Controller type: %d) ...", m_controller->GetDevice()->GetVendor(), m_controller->GetDevice()->GetProduct(), i, m_controller->GetConfig().controllerType);
 
         // Set the controller type to Pro-Controller, and set the npadInterfaceType.
         m_controllerData[i].m_deviceInfo.deviceType = m_controller->GetConfig().controllerType;
@@ -135,13 +204,13 @@ ams::Result SwitchHDLHandler::InitHdlState()
         m_controllerData[i].m_hdlState.analog_stick_r.y = 0;
     }
 
-    syscon::logger::LogDebug("SwitchHDLHandler[%04x-%04x] HDL state successfully initialized !", m_controller->GetDevice()->GetVendor(), m_controller->GetDevice()->GetProduct());
+    SYSCON_LOG_DEBUG(LOG_MODULE_HDL, "SwitchHDLHandler[%04x-%04x] HDL state successfully initialized !", m_controller->GetDevice()->GetVendor(), m_controller->GetDevice()->GetProduct());
     R_SUCCEED();
 }
 
 ams::Result SwitchHDLHandler::UninitHdlState()
 {
-    syscon::logger::LogDebug("SwitchHDLHandler[%04x-%04x] UninitHdlState .. !", m_controller->GetDevice()->GetVendor(), m_controller->GetDevice()->GetProduct());
+    SYSCON_LOG_DEBUG(LOG_MODULE_HDL, "SwitchHDLHandler[%04x-%04x] UninitHdlState .. !", m_controller->GetDevice()->GetVendor(), m_controller->GetDevice()->GetProduct());
 
     for (int i = 0; i < m_controller->GetInputCount(); i++)
         Detach(i);
@@ -154,6 +223,54 @@ bool SwitchHDLHandler::IsVirtualDeviceAttached(uint16_t input_idx)
     return m_controllerData[input_idx].m_hdlHandle.handle != 0;
 }
 
+bool SwitchHDLHandler::IsHdlStateChanged(uint16_t input_idx)
+{
+    SwitchHDLHandlerData *controllerData = &m_controllerData[input_idx];
+
+    if (m_hdl_keepalive_ms == 0 || !controllerData->m_hdlStateSent)
+        return true;
+
+    // Only the inputs are compared: the buttons exactly, the sticks beyond the deadband (Noise of a stick at rest).
+    // The other fields (i.e: battery level) are sent with the next change or keep-alive.
+    const HiddbgHdlsState &state = controllerData->m_hdlState;
+    const HiddbgHdlsState &lastSent = controllerData->m_lastSentHdlState;
+    if (state.buttons != lastSent.buttons ||
+        IsStickMoved(state.analog_stick_l, lastSent.analog_stick_l, m_hdl_stick_deadband) ||
+        IsStickMoved(state.analog_stick_r, lastSent.analog_stick_r, m_hdl_stick_deadband))
+        return true;
+
+    // Keep-alive: resend the same state periodically so the virtual device never goes stale
+    return ams::os::ConvertToTimeSpan(ams::os::GetSystemTick() - controllerData->m_lastSentTick).GetMilliSeconds() >= m_hdl_keepalive_ms;
+}
+
+// Nothing was read (Controllers which only send reports on change), resend the last states if the keep-alive expired
+void SwitchHDLHandler::UpdateHdlKeepAlive()
+{
+    if (m_hdl_keepalive_ms == 0)
+        return;
+
+    for (uint16_t input_idx = 0; input_idx < m_controller->GetInputCount(); input_idx++)
+    {
+        SwitchHDLHandlerData *controllerData = &m_controllerData[input_idx];
+
+        if (!IsVirtualDeviceAttached(input_idx) || !controllerData->m_hdlStateSent)
+            continue;
+
+        if (ams::os::ConvertToTimeSpan(ams::os::GetSystemTick() - controllerData->m_lastSentTick).GetMilliSeconds() < m_hdl_keepalive_ms)
+            continue;
+
+        if (R_FAILED(hiddbgSetHdlsState(controllerData->m_hdlHandle, &controllerData->m_lastSentHdlState)))
+        {
+            controllerData->m_is_sync = false;
+            Detach(input_idx);
+            continue;
+        }
+
+        controllerData->m_lastSentTick = ams::os::GetSystemTick();
+        m_hdlSentCount++;
+    }
+}
+
 // Sets the state of the class's HDL controller to the state stored in class's hdl.state
 ams::Result SwitchHDLHandler::UpdateHdlState(const NormalizedButtonData &data, uint16_t input_idx)
 {
@@ -208,9 +325,13 @@ ams::Result SwitchHDLHandler::UpdateHdlState(const NormalizedButtonData &data, u
     if (m_controllerData[input_idx].m_is_connected && m_controllerData[input_idx].m_is_sync)
         Attach(input_idx);
 
-    if (IsVirtualDeviceAttached(input_idx))
+    if (IsVirtualDeviceAttached(input_idx) && !IsHdlStateChanged(input_idx))
+    {
+        m_hdlSuppressedCount++;
+    }
+    else if (IsVirtualDeviceAttached(input_idx))
     {
-        syscon::logger::LogDebug("SwitchHDLHandler[%04x-%04x] UpdateHdlState - Idx: %d [Button: 0x%016X LeftX: %d LeftY: %d RightX: %d RightY: %d]", m_controller->GetDevice()->GetVendor(), m_controller->GetDevice()->GetProduct(), input_idx, hdlState->buttons, hdlState->analog_stick_l.x, hdlState->analog_stick_l.y, hdlState->analog_stick_r.x, hdlState->analog_stick_r.y);
+        SYSCON_LOG_LIMITED(LOG_MODULE_HDL, LOG_LEVEL_DEBUG, "SwitchHDLHandler[%04x-%04x] UpdateHdlState - Idx: %d [Button: 0x%016X LeftX: %d LeftY: %d RightX: %d RightY: %d]", m_controller->GetDevice()->GetVendor(), m_controller->GetDevice()->GetProduct(), input_idx, hdlState->buttons, hdlState->analog_stick_l.x, hdlState->analog_stick_l.y, hdlState->analog_stick_r.x, hdlState->analog_stick_r.y);
         Result rc = hiddbgSetHdlsState(m_controllerData[input_idx].m_hdlHandle, hdlState);
         if (R_FAILED(rc))
         {
@@ -226,17 +347,29 @@ ams::Result SwitchHDLHandler::UpdateHdlState(const NormalizedButtonData &data, u
 
             R_RETURN(rc);
         }
+
+        m_controllerData[input_idx].m_lastSentHdlState = *hdlState;
+        m_controllerData[input_idx].m_lastSentTick = ams::os::GetSystemTick();
+        m_controllerData[input_idx].m_hdlStateSent = true;
+        m_hdlSentCount++;
+    }
+
+    if (ams::os::ConvertToTimeSpan(ams::os::GetSystemTick() - m_hdlStatsTick).GetMilliSeconds() >= HDL_STATS_PERIOD_MS)
+    {
+        SYSCON_LOG_DEBUG(LOG_MODULE_HDL, "SwitchHDLHandler[%04x-%04x] HDL states sent: %lu, suppressed: %lu", m_controller->GetDevice()->GetVendor(), m_controller->GetDevice()->GetProduct(), m_hdlSentCount, m_hdlSuppressedCount);
+        m_hdlStatsTick = ams::os::GetSystemTick();
     }
 
     R_SUCCEED();
 }
 
-void SwitchHDLHandler::UpdateInput(s32 timeout_us)
+ams::Result SwitchHDLHandler::UpdateInput(s32 timeout_us)
 {
     uint16_t input_idx = 0;
     NormalizedButtonData buttonData = {0};
 
     ams::Result read_rc = m_controller->ReadInput(&buttonData, &input_idx, timeout_us);
+    ams::os::Tick decodedTick = ams::os::GetSystemTick();
 
     /*
         Note: We must not return here if readInput fail, because it might have change the ControllerConnected state.
@@ -254,39 +387,60 @@ void SwitchHDLHandler::UpdateInput(s32 timeout_us)
     }
 
     if (R_FAILED(read_rc))
-        return;
+    {
+        UpdateHdlKeepAlive();
+        R_RETURN(read_rc);
+    }
+
+    RecordDecodeLatency(input_idx, decodedTick);
 
     // We get the button inputs from the input packet and update the state of our controller
-    UpdateHdlState(buttonData, input_idx);
+    u64 sentCount = m_hdlSentCount;
+    R_TRY(UpdateHdlState(buttonData, input_idx));
+
+    // Only the states actually given to HID, a suppressed state has no submit latency
+    if (m_hdlSentCount != sentCount)
+        m_latency[input_idx].decodeToHdl.Record(ams::os::ConvertToTimeSpan(ams::os::GetSystemTick() - decodedTick).GetMicroSeconds());
+
+    R_SUCCEED();
 }
 
+// Runs after the report was given to HID, and only once per rumble interval: the input latency doesn't depend on the rumble.
+// SetRumble only queues the write (See IUSBEndpoint::QueueWrite), the USB transfer is done by the output thread.
 void SwitchHDLHandler::UpdateOutput()
 {
-    // Process rumble values if supported
-    /*if (GetController()->Support(SUPPORTS_RUMBLE))
+    if (m_rumble_interval_ms == 0)
+        return;
+
+    for (uint16_t input_idx = 0; input_idx < m_controller->GetInputCount(); input_idx++)
     {
+        SwitchHDLHandlerData *controllerData = &m_controllerData[input_idx];
         HidVibrationValue value;
 
-        for (uint16_t input_idx = 0; input_idx < m_controller->GetInputCount(); input_idx++)
-        {
-            if (!IsVirtualDeviceAttached(input_idx))
-                continue;
-
-            if (R_FAILED(hidGetActualVibrationValue(m_controllerData[input_idx].m_vibrationDeviceHandle, &value)))
-            {
-                syscon::logger::LogError("SwitchHDLHandler[%04x-%04x] UpdateOutput - Failed to get vibration value for idx: %d", m_controller->GetDevice()->GetVendor(), m_controller->GetDevice()->GetProduct(), input_idx);
-                continue;
-            }
+        if (!IsVirtualDeviceAttached(input_idx) || !controllerData->m_vibrationInitialized)
+            continue;
 
-            if (value.amp_high == m_controllerData[input_idx].m_vibrationLastValue.amp_high && value.amp_low == m_controllerData[input_idx].m_vibrationLastValue.amp_low)
-                continue; // Do nothing if the values are the same
+        if (ams::os::ConvertToTimeSpan(ams::os::GetSystemTick() - controllerData->m_vibrationTick).GetMilliSeconds() < m_rumble_interval_ms)
+            continue;
 
-            syscon::logger::LogDebug("SwitchHDLHandler[%04x-%04x] UpdateOutput - Idx: %d [AmpHigh: %d%% AmpLow: %d%%]", m_controller->GetDevice()->GetVendor(), m_controller->GetDevice()->GetProduct(), input_idx, (uint8_t)(value.amp_high * 100), (uint8_t)(value.amp_low * 100));
-            m_controller->SetRumble(input_idx, value.amp_high, value.amp_low);
+        controllerData->m_vibrationTick = ams::os::GetSystemTick();
 
-            m_controllerData[input_idx].m_vibrationLastValue = value;
+        if (R_FAILED(hidGetActualVibrationValue(controllerData->m_vibrationDeviceHandle, &value)))
+        {
+            syscon::logger::LogError("SwitchHDLHandler[%04x-%04x] UpdateOutput - Failed to get vibration value for idx: %d", m_controller->GetDevice()->GetVendor(), m_controller->GetDevice()->GetProduct(), input_idx);
+            continue;
         }
-    }*/
+
+        if (value.amp_high == controllerData->m_vibrationLastValue.amp_high && value.amp_low == controllerData->m_vibrationLastValue.amp_low)
+            continue; // Do nothing if the values are the same
+
+        SYSCON_LOG_LIMITED(LOG_MODULE_HDL, LOG_LEVEL_TRACE, "SwitchHDLHandler[%04x-%04x] UpdateOutput - Idx: %d [AmpHigh: %d%% AmpLow: %d%%]", m_controller->GetDevice()->GetVendor(), m_controller->GetDevice()->GetProduct(), input_idx, (uint8_t)(value.amp_high * 100), (uint8_t)(value.amp_low * 100));
+        if (R_FAILED(m_controller->SetRumble(input_idx, std::clamp(value.amp_high, 0.0f, 1.0f), std::clamp(value.amp_low, 0.0f, 1.0f))))
+            continue; // Sent again on the next poll
+
+        controllerData->m_vibrationLastValue = value;
+        m_rumbleSentCount++;
+    }
 }
 
 HiddbgHdlsSessionId &SwitchHDLHandler::GetHdlsSessionId()
@@ -20,6 +20,12 @@ public:
         memset(&m_deviceInfo, 0, sizeof(m_deviceInfo));
         memset(&m_hdlState, 0, sizeof(m_hdlState));
         memset(&m_vibrationDeviceHandle, 0, sizeof(m_vibrationDeviceHandle));
+        memset(&m_lastSentHdlState, 0, sizeof(m_lastSentHdlState));
+        m_lastSentTick = ams::os::Tick(0);
+        m_hdlStateSent = false;
+        memset(&m_vibrationLastValue, 0, sizeof(m_vibrationLastValue));
+        m_vibrationTick = ams::os::Tick(0);
+        m_vibrationInitialized = false;
     }
 
     HidNpadIdType m_npadId;
@@ -27,9 +33,17 @@ public:
     HiddbgHdlsDeviceInfo m_deviceInfo;
     HiddbgHdlsState m_hdlState;
     HidVibrationDeviceHandle m_vibrationDeviceHandle;
+    // Last rumble value given to the controller, and when the vibration value was polled
     HidVibrationValue m_vibrationLastValue;
+    ams::os::Tick m_vibrationTick;
+    bool m_vibrationInitialized;
     bool m_is_connected;
     bool m_is_sync;
+
+    // Last state given to hiddbgSetHdlsState, identical states are not sent again until the keep-alive expires
+    HiddbgHdlsState m_lastSentHdlState;
+    ams::os::Tick m_lastSentTick;
+    bool m_hdlStateSent;
 };
 
 class SwitchHDLHandler : public SwitchVirtualGamepadHandler
@@ -37,12 +51,30 @@ class SwitchHDLHandler : public SwitchVirtualGamepadHandler
 private:
     SwitchHDLHandlerData m_controllerData[CONTROLLER_MAX_INPUTS];
 
+    // 0: Every state is sent
+    s32 m_hdl_keepalive_ms;
+    // A stick move up to this distance (Switch axis units, 32767: full range) is not a change, the keep-alive sends it
+    s32 m_hdl_stick_deadband;
+    u64 m_hdlSentCount = 0;
+    u64 m_hdlSuppressedCount = 0;
+    ams::os::Tick m_hdlStatsTick;
+
+    // The vibration value is polled at most once per rumble interval (bInterval of the OUT endpoints), 0: no rumble
+    s32 m_rumble_interval_ms = 0;
+    u64 m_rumbleSentCount = 0;
+
+    bool IsHdlStateChanged(uint16_t input_idx);
+    void UpdateHdlKeepAlive();
+
     ams::Result Detach(uint16_t input_idx);
     ams::Result Attach(uint16_t input_idx);
 
+    void InitVibration(uint16_t input_idx);
+    void StopVibration(uint16_t input_idx);
+
 public:
     // Initialize the class with specified controller
-    SwitchHDLHandler(std::unique_ptr<IController> &&controller, int polling_frequency_ms);
+    SwitchHDLHandler(std::unique_ptr<IController> &&controller, int polling_frequency_ms, SwitchInputMode input_mode, int hdl_keepalive_ms, int hdl_stick_deadband);
     ~SwitchHDLHandler();
 
     // Initialize controller handler, HDL state
@@ -50,8 +82,8 @@ public:
     virtual void Exit() override;
 
     // This will be called periodically by the input threads
-    virtual void UpdateInput(s32 timeout_us) override;
-    // This will be called periodically by the output threads
+    virtual ams::Result UpdateInput(s32 timeout_us) override;
+    // This will be called periodically by the input thread, after UpdateInput: forward the vibration value of the virtual devices to the controller
     virtual void UpdateOutput() override;
 
     // Separately init and close the HDL state
@@ -60,8 +92,12 @@ public:
 
     bool IsVirtualDeviceAttached(uint16_t input_idx);
 
-    // Fills out the HDL state with the specified button data and passes it to HID
+    // Fills out the HDL state with the specified button data and passes it to HID (Only if it changed or the keep-alive expired)
     ams::Result UpdateHdlState(const NormalizedButtonData &data, uint16_t input_idx);
 
+    // Number of hiddbgSetHdlsState calls made and avoided since the handler was created
+    inline u64 GetHdlSentCount() const { return m_hdlSentCount; }
+    inline u64 GetHdlSuppressedCount() const { return m_hdlSuppressedCount; }
+
     static HiddbgHdlsSessionId &GetHdlsSessionId();
 };
\ No newline at end of file
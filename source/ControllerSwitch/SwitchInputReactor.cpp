@@ -0,0 +1,264 @@
+#include "SwitchInputReactor.h"
+#include "SwitchVirtualGamepadHandler.h"
+#include "SwitchUSBEndpoint.h"
+#include "SwitchLogger.h"
+#include <algorithm>
+#include <atomic>
+#include <new>
+#include <vector>
+
+// Maximum number of events waited by a reactor thread (waitObjects limit), the first one wakes the thread up when its controllers change
+#define REACTOR_MAX_WAITERS 0x40
+// Period of the reactor debug summary
+#define REACTOR_STATS_PERIOD_MS 10000
+// A wait shorter than this returned at once: the event was already signaled before it started (See SetSignaledTick)
+#define REACTOR_BLOCKED_WAIT_US 10
+
+bool SwitchInputReactor::s_enabled = false;
+
+namespace
+{
+    struct alignas(ams::os::ThreadStackAlignment) ReactorStack
+    {
+        u8 data[0x2000];
+    };
+
+    struct ReactorThread
+    {
+        std::unique_ptr<ReactorStack> stack;
+        Thread thread;
+        UEvent wakeEvent;
+        ams::os::SdkMutex mutex;
+        std::vector<SwitchVirtualGamepadHandler *> handlers;
+        u32 generation = 0;
+        std::atomic<bool> running = false;
+
+        u64 wakeups = 0;
+        u64 dispatches = 0;
+        ams::os::Tick statsTick;
+    };
+
+    ReactorThread g_threads[SWITCH_INPUT_REACTOR_MAX_THREADS];
+    u32 g_threadCount = 0;
+
+    void LogReactorStats(u32 index, ReactorThread *ctx)
+    {
+        s64 elapsed_ms = std::max<s64>(1, ams::os::ConvertToTimeSpan(ams::os::GetSystemTick() - ctx->statsTick).GetMilliSeconds());
+
+        SYSCON_LOG_DEBUG(LOG_MODULE_HDL, "SwitchInputReactor[%d]: %d controllers, %d wakeups/s, %d dispatches/s", index, (int)ctx->handlers.size(),
+                                   (int)(ctx->wakeups * 1000 / elapsed_ms), (int)(ctx->dispatches * 1000 / elapsed_ms));
+
+        ctx->wakeups = 0;
+        ctx->dispatches = 0;
+        ctx->statsTick = ams::os::GetSystemTick();
+    }
+} // namespace
+
+void SwitchInputReactor::ThreadFunc(void *arg)
+{
+    ReactorThread *ctx = static_cast<ReactorThread *>(arg);
+    u32 index = ctx - g_threads;
+    Waiter waiters[REACTOR_MAX_WAITERS];
+    SwitchVirtualGamepadHandler *owners[REACTOR_MAX_WAITERS];
+    SwitchUSBEndpoint *endpoints[REACTOR_MAX_WAITERS];
+
+    SYSCON_LOG_DEBUG(LOG_MODULE_HDL, "SwitchInputReactor[%d] running ...", index);
+
+    ctx->statsTick = ams::os::GetSystemTick();
+
+    s32 count = 0;
+    u32 generation = 0;
+    bool rebuild = true;
+
+    while (ctx->running)
+    {
+        s64 timeout_us = -1;
+
+        {
+            std::scoped_lock lock(ctx->mutex);
+
+            // The waiters are kept until the controllers change (the transfer event of an endpoint doesn't change while it's open)
+            if (rebuild || ctx->generation != generation)
+            {
+                generation = ctx->generation;
+                rebuild = false;
+                count = 0;
+
+                waiters[count] = waiterForUEvent(&ctx->wakeEvent);
+                endpoints[count] = NULL;
+                owners[count++] = NULL;
+
+                for (SwitchVirtualGamepadHandler *handler : ctx->handlers)
+                {
+                    size_t added = handler->GetInputWaiters(&waiters[count], &endpoints[count], REACTOR_MAX_WAITERS - count);
+                    for (size_t i = 0; i < added; i++)
+                        owners[count++] = handler;
+                }
+            }
+
+            // Wait for a transfer of any controller, or until the polling period of one of them expires
+            for (SwitchVirtualGamepadHandler *handler : ctx->handlers)
+            {
+                s64 remaining_us = handler->m_read_input_timeout_us - ams::os::ConvertToTimeSpan(ams::os::GetSystemTick() - handler->m_reactorRunTick).GetMicroSeconds();
+                timeout_us = timeout_us < 0 ? std::max<s64>(0, remaining_us) : std::min(timeout_us, std::max<s64>(0, remaining_us));
+            }
+        }
+
+        s32 idx = -1;
+        ams::os::Tick waitTick = ams::os::GetSystemTick();
+        Result rc = waitObjects(&idx, waiters, count, timeout_us < 0 ? UINT64_MAX : timeout_us * 1000);
+        ams::os::Tick signaledTick = ams::os::GetSystemTick();
+
+        std::scoped_lock lock(ctx->mutex);
+        ctx->wakeups++;
+
+        // The controllers changed while waiting, the waiters may not be valid anymore
+        if (ctx->generation != generation)
+            continue;
+
+        if (R_FAILED(rc) && R_VALUE(rc) != KERNELRESULT(TimedOut))
+        {
+            ::syscon::logger::LogError("SwitchInputReactor[%d] waitObjects failed: %08X", index, rc);
+            svcSleepThread(1000000);
+            continue;
+        }
+
+        // The transfer completion time is only known when this wait saw the event being signaled, not when it was already signaled
+        if (R_SUCCEEDED(rc) && endpoints[idx] != NULL && ams::os::ConvertToTimeSpan(signaledTick - waitTick).GetMicroSeconds() >= REACTOR_BLOCKED_WAIT_US)
+            endpoints[idx]->SetSignaledTick(signaledTick);
+
+        // The completed transfer is taken by the read without waiting, the other controllers only run when their period expired
+        for (SwitchVirtualGamepadHandler *handler : ctx->handlers)
+        {
+            bool ready = R_SUCCEEDED(rc) && owners[idx] == handler;
+            if (!ready && ams::os::ConvertToTimeSpan(ams::os::GetSystemTick() - handler->m_reactorRunTick).GetMicroSeconds() < handler->m_read_input_timeout_us)
+                continue;
+
+            handler->m_reactorRunTick = ams::os::GetSystemTick();
+            handler->RunInputLoopOnce(0);
+            ctx->dispatches++;
+
+            // Only the endpoints of the controller run are re-armed, the others are still waiting
+            for (s32 i = 1; i < count; i++)
+            {
+                if (owners[i] == handler && !endpoints[i]->ArmInTransfers(&waiters[i]))
+                    rebuild = true;
+            }
+        }
+
+        if (ams::os::ConvertToTimeSpan(ams::os::GetSystemTick() - ctx->statsTick).GetMilliSeconds() >= REACTOR_STATS_PERIOD_MS)
+            LogReactorStats(index, ctx);
+    }
+
+    SYSCON_LOG_DEBUG(LOG_MODULE_HDL, "SwitchInputReactor[%d] stopped !", index);
+}
+
+ams::Result SwitchInputReactor::Initialize(u32 threadCount)
+{
+    threadCount = std::min<u32>(threadCount, SWITCH_INPUT_REACTOR_MAX_THREADS);
+    if (threadCount == 0)
+        R_SUCCEED();
+
+    for (g_threadCount = 0; g_threadCount < threadCount; g_threadCount++)
+    {
+        ReactorThread *ctx = &g_threads[g_threadCount];
+
+        ctx->stack.reset(new (std::nothrow) ReactorStack);
+        if (ctx->stack == nullptr)
+            break;
+
+        ueventCreate(&ctx->wakeEvent, true);
+        ctx->running = true;
+        R_ABORT_UNLESS(threadCreate(&ctx->thread, &SwitchInputReactor::ThreadFunc, ctx, ctx->stack->data, sizeof(ctx->stack->data), 0x30, -2));
+        R_ABORT_UNLESS(threadStart(&ctx->thread));
+    }
+
+    if (g_threadCount == 0)
+        R_RETURN(CONTROL_ERR_OUT_OF_MEMORY);
+
+    s_enabled = true;
+
+    ::syscon::logger::LogInfo("SwitchInputReactor: Controllers are serviced by %d reactor thread(s)", g_threadCount);
+
+    R_SUCCEED();
+}
+
+void SwitchInputReactor::Exit()
+{
+    if (!s_enabled)
+        return;
+
+    s_enabled = false;
+
+    for (u32 i = 0; i < g_threadCount; i++)
+    {
+        ReactorThread *ctx = &g_threads[i];
+
+        ctx->running = false;
+        ueventSignal(&ctx->wakeEvent);
+        threadWaitForExit(&ctx->thread);
+        threadClose(&ctx->thread);
+        ctx->stack.reset();
+    }
+
+    g_threadCount = 0;
+}
+
+ams::Result SwitchInputReactor::Register(SwitchVirtualGamepadHandler *handler)
+{
+    if (!s_enabled)
+        R_RETURN(CONTROL_ERR_NOTHING_TODO);
+
+    // The least loaded thread gets the controller (handlers is changed under the lock of its thread)
+    ReactorThread *ctx = NULL;
+    size_t ctxHandlerCount = 0;
+    for (u32 i = 0; i < g_threadCount; i++)
+    {
+        size_t handlerCount;
+        {
+            std::scoped_lock lock(g_threads[i].mutex);
+            handlerCount = g_threads[i].handlers.size();
+        }
+
+        if (ctx == NULL || handlerCount < ctxHandlerCount)
+        {
+            ctx = &g_threads[i];
+            ctxHandlerCount = handlerCount;
+        }
+    }
+
+    {
+        std::scoped_lock lock(ctx->mutex);
+        handler->m_reactorRunTick = ams::os::GetSystemTick();
+        ctx->handlers.push_back(handler);
+        ctx->generation++;
+    }
+
+    ueventSignal(&ctx->wakeEvent);
+
+    SYSCON_LOG_DEBUG(LOG_MODULE_HDL, "SwitchInputReactor[%d]: Controller[%04x-%04x] registered", (int)(ctx - g_threads), handler->GetController()->GetDevice()->GetVendor(), handler->GetController()->GetDevice()->GetProduct());
+
+    R_SUCCEED();
+}
+
+void SwitchInputReactor::Unregister(SwitchVirtualGamepadHandler *handler)
+{
+    for (u32 i = 0; i < g_threadCount; i++)
+    {
+        ReactorThread *ctx = &g_threads[i];
+
+        // Once removed under the lock, the reactor thread doesn't use the handler anymore
+        {
+            std::scoped_lock lock(ctx->mutex);
+            auto it = std::find(ctx->handlers.begin(), ctx->handlers.end(), handler);
+            if (it == ctx->handlers.end())
+                continue;
+
+            ctx->handlers.erase(it);
+            ctx->generation++;
+        }
+
+        ueventSignal(&ctx->wakeEvent);
+        return;
+    }
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include "switch.h"
+#include <stratosphere.hpp>
+
+// Maximum number of reactor threads (See Initialize)
+#define SWITCH_INPUT_REACTOR_MAX_THREADS 4
+
+class SwitchVirtualGamepadHandler;
+
+// Input reactor
+// Instead of one input thread per controller, a few threads wait for the transfer events of every controller
+// with waitObjects and run the input loop (decode + HDL update) of the controller whose transfer completed.
+// Controllers are spread over the threads, each thread also runs the loop of its controllers when their polling period expires
+// without report (keep-alive, output).
+// When disabled (default), every SwitchVirtualGamepadHandler has its own thread.
+
+class SwitchInputReactor
+{
+private:
+    static bool s_enabled;
+
+    static void ThreadFunc(void *arg);
+
+public:
+    // threadCount: 0 disables the reactor, otherwise 1 to SWITCH_INPUT_REACTOR_MAX_THREADS threads are started
+    static ams::Result Initialize(u32 threadCount);
+    static void Exit();
+
+    static inline bool IsEnabled() { return s_enabled; }
+
+    // The handler is serviced until Unregister() returns
+    static ams::Result Register(SwitchVirtualGamepadHandler *handler);
+    static void Unregister(SwitchVirtualGamepadHandler *handler);
+};
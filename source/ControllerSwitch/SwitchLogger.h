@@ -1,4 +1,7 @@
 #pragma once
+#include <cstdint>
+#include <cstddef>
+#include "ILogger.h"
 
 #define LOG_LEVEL_TRACE   0
 #define LOG_LEVEL_DEBUG   1
@@ -7,12 +10,84 @@
 #define LOG_LEVEL_ERROR   4
 #define LOG_LEVEL_COUNT   5
 
+// Modules with their own log level (log_level_xxx in config.ini, log_level when not set)
+#define LOG_MODULE_USB    0 // USB devices, interfaces and endpoints
+#define LOG_MODULE_HDL    1 // Virtual controllers (HDL) and input threads
+#define LOG_MODULE_DRIVER 2 // Controller drivers (ControllerLib)
+#define LOG_MODULE_CONFIG 3 // Configuration and caches
+#define LOG_MODULE_COUNT  4
+
+// Trace/Debug logs of a module: the arguments are only evaluated when the module logs at this level, never below SYSCON_LOG_MIN_LEVEL
+#define SYSCON_LOG(module, lvl, ...)                                                         \
+    do                                                                                       \
+    {                                                                                        \
+        if ((lvl) >= SYSCON_LOG_MIN_LEVEL && (lvl) >= ::syscon::logger::moduleLevel[module]) \
+            ::syscon::logger::LogAt((lvl), __VA_ARGS__);                                     \
+    } while (0)
+
+#define SYSCON_LOG_BUFFER(module, lvl, buffer, size)                                         \
+    do                                                                                       \
+    {                                                                                        \
+        if ((lvl) >= SYSCON_LOG_MIN_LEVEL && (lvl) >= ::syscon::logger::moduleLevel[module]) \
+            ::syscon::logger::LogBufferAt((lvl), (buffer), (size));                          \
+    } while (0)
+
+// Trace/Debug logs on every report (or transfer): sampled and rate limited per call site (log_sample and log_rate_limit, See LogLimit.h),
+// the messages dropped are reported by a "N messages suppressed at file:line" line before a message kept (At most once per second).
+// SYSCON_LOG_LIMITED_BUFFER keeps or drops the message and its hex dump together.
+#define SYSCON_LOG_LIMITED(module, lvl, ...)                                                 \
+    do                                                                                       \
+    {                                                                                        \
+        if ((lvl) >= SYSCON_LOG_MIN_LEVEL && (lvl) >= ::syscon::logger::moduleLevel[module]) \
+        {                                                                                    \
+            static LogLimit _logLimit;                                                       \
+            uint32_t _suppressed;                                                            \
+            if (::syscon::logger::PassLogLimit(&_logLimit, &_suppressed))                    \
+            {                                                                                \
+                if (_suppressed > 0)                                                         \
+                    ::syscon::logger::LogSuppressed((lvl), _suppressed, __FILE__, __LINE__); \
+                ::syscon::logger::LogAt((lvl), __VA_ARGS__);                                 \
+            }                                                                                \
+        }                                                                                    \
+    } while (0)
+
+#define SYSCON_LOG_LIMITED_BUFFER(module, lvl, buffer, size, ...)                            \
+    do                                                                                       \
+    {                                                                                        \
+        if ((lvl) >= SYSCON_LOG_MIN_LEVEL && (lvl) >= ::syscon::logger::moduleLevel[module]) \
+        {                                                                                    \
+            static LogLimit _logLimit;                                                       \
+            uint32_t _suppressed;                                                            \
+            if (::syscon::logger::PassLogLimit(&_logLimit, &_suppressed))                    \
+            {                                                                                \
+                if (_suppressed > 0)                                                         \
+                    ::syscon::logger::LogSuppressed((lvl), _suppressed, __FILE__, __LINE__); \
+                ::syscon::logger::LogAt((lvl), __VA_ARGS__);                                 \
+                ::syscon::logger::LogBufferAt((lvl), (buffer), (size));                      \
+            }                                                                                \
+        }                                                                                    \
+    } while (0)
+
+#define SYSCON_LOG_TRACE(module, ...) SYSCON_LOG(module, LOG_LEVEL_TRACE, __VA_ARGS__)
+#define SYSCON_LOG_DEBUG(module, ...) SYSCON_LOG(module, LOG_LEVEL_DEBUG, __VA_ARGS__)
+
 namespace syscon::logger
 {
+    // Effective level of each module (See SetModuleLogLevel), read by SYSCON_LOG without a call
+    extern int moduleLevel[LOG_MODULE_COUNT];
+
     void LogTrace(const char *fmt, ...);
     void LogDebug(const char *fmt, ...);
     void LogInfo(const char *fmt, ...);
     void LogWarning(const char *fmt, ...);
     void LogError(const char *fmt, ...);
     void LogBuffer(int lvl, const uint8_t *buffer, size_t size);
+
+    // Already filtered by the caller (SYSCON_LOG)
+    void LogAt(int lvl, const char *fmt, ...);
+    void LogBufferAt(int lvl, const uint8_t *buffer, size_t size);
+
+    // Sampling and rate limit of a call site (SYSCON_LOG_LIMITED), then the line reporting the messages dropped there
+    bool PassLogLimit(LogLimit *limit, uint32_t *suppressed);
+    void LogSuppressed(int lvl, uint32_t count, const char *file, int line);
 } // namespace syscon::logger
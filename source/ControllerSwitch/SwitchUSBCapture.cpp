@@ -0,0 +1,259 @@
+#include "SwitchUSBCapture.h"
+#include "SwitchLogger.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <stratosphere/fs/fs_filesystem.hpp>
+#include <stratosphere/fs/fs_file.hpp>
+
+#define USB_CAPTURE_FLUSH_PERIOD_MS 50
+
+bool SwitchUSBCapture::s_enabled = false;
+
+namespace
+{
+    constinit ams::os::SdkMutex g_ringMutex;
+
+    // Ring of records, each record is contiguous. When a record does not fit at the end of the ring,
+    // the end is filled with a padding record (or left empty if it's smaller than a header) and the record is put at the beginning.
+    u8 *g_ring = NULL;
+    size_t g_ringSize = 0;
+    size_t g_ringHead = 0; // Write offset
+    size_t g_ringTail = 0; // Read offset
+    size_t g_ringUsed = 0;
+    u32 g_dropped = 0;
+
+    u64 g_startTimestamp_us = 0;
+
+    ams::fs::FileHandle g_file;
+    s64 g_fileOffset = 0;
+    s64 g_fileMaxSize = 0;
+
+    alignas(ams::os::ThreadStackAlignment) u8 g_thread_stack[0x2000];
+    Thread g_thread;
+    std::atomic<bool> g_threadIsRunning{false};
+
+    inline u64 GetTimestampUs()
+    {
+        return ams::os::ConvertToTimeSpan(ams::os::GetSystemTick()).GetMicroSeconds();
+    }
+
+    // Must be called with g_ringMutex locked
+    u8 *RingReserve(size_t size)
+    {
+        if (g_ringUsed + size > g_ringSize)
+            return NULL;
+
+        if (g_ringHead + size > g_ringSize)
+        {
+            size_t padding = g_ringSize - g_ringHead;
+            if (g_ringUsed + padding + size > g_ringSize)
+                return NULL;
+
+            if (padding >= sizeof(UsbCaptureRecordHeader))
+            {
+                UsbCaptureRecordHeader *header = reinterpret_cast<UsbCaptureRecordHeader *>(&g_ring[g_ringHead]);
+                memset(header, 0, sizeof(UsbCaptureRecordHeader));
+                header->type = UsbCaptureRecordType_Padding;
+            }
+
+            g_ringUsed += padding;
+            g_ringHead = 0;
+        }
+
+        u8 *ptr = &g_ring[g_ringHead];
+        g_ringHead = (g_ringHead + size) % g_ringSize;
+        g_ringUsed += size;
+        return ptr;
+    }
+
+    ams::Result FileWrite(const void *buffer, size_t size)
+    {
+        if (g_fileOffset + (s64)size > g_fileMaxSize)
+            R_RETURN(CONTROL_ERR_OUT_OF_MEMORY);
+
+        R_TRY(ams::fs::WriteFile(g_file, g_fileOffset, buffer, size, ams::fs::WriteOption::None));
+        g_fileOffset += size;
+        R_SUCCEED();
+    }
+
+    // Write everything available in the ring to the file, the ring is not locked during the file access
+    void Flush()
+    {
+        size_t tail, used;
+        u32 dropped;
+        {
+            std::scoped_lock lock(g_ringMutex);
+            tail = g_ringTail;
+            used = g_ringUsed;
+            dropped = g_dropped;
+            g_dropped = 0;
+        }
+
+        if (dropped > 0)
+        {
+            struct
+            {
+                UsbCaptureRecordHeader header;
+                u32 count;
+            } record = {{static_cast<u32>(GetTimestampUs() - g_startTimestamp_us), 0, UsbCaptureRecordType_Dropped, 0, 0, sizeof(u32), 0}, dropped};
+
+            FileWrite(&record, sizeof(record));
+        }
+
+        size_t consumed = 0;
+        size_t spanStart = tail;
+        size_t spanSize = 0;
+        while (consumed < used)
+        {
+            size_t remaining = g_ringSize - tail;
+            size_t recordSize;
+            bool skip = false;
+
+            if (remaining < sizeof(UsbCaptureRecordHeader))
+            {
+                recordSize = remaining;
+                skip = true;
+            }
+            else
+            {
+                const UsbCaptureRecordHeader *header = reinterpret_cast<const UsbCaptureRecordHeader *>(&g_ring[tail]);
+                if (header->type == UsbCaptureRecordType_Padding)
+                {
+                    recordSize = remaining;
+                    skip = true;
+                }
+                else
+                {
+                    recordSize = sizeof(UsbCaptureRecordHeader) + USB_CAPTURE_ALIGN(header->length);
+                }
+            }
+
+            if (skip)
+            {
+                if (spanSize > 0)
+                    FileWrite(&g_ring[spanStart], spanSize);
+                spanStart = 0;
+                spanSize = 0;
+            }
+            else
+            {
+                spanSize += recordSize;
+            }
+
+            tail = (tail + recordSize) % g_ringSize;
+            consumed += recordSize;
+        }
+
+        if (spanSize > 0)
+            FileWrite(&g_ring[spanStart], spanSize);
+
+        if (used > 0)
+            ams::fs::FlushFile(g_file);
+
+        {
+            std::scoped_lock lock(g_ringMutex);
+            g_ringTail = tail;
+            g_ringUsed -= consumed;
+        }
+    }
+
+    void CaptureThreadFunc(void *arg)
+    {
+        AMS_UNUSED(arg);
+
+        do
+        {
+            svcSleepThread(USB_CAPTURE_FLUSH_PERIOD_MS * 1000000ULL);
+            Flush();
+        } while (g_threadIsRunning);
+    }
+} // namespace
+
+ams::Result SwitchUSBCapture::Initialize(const char *path, size_t ringSize, size_t maxFileSize)
+{
+    ringSize = ringSize & ~(size_t)3;
+    if (ringSize < 0x1000)
+        R_RETURN(CONTROL_ERR_INVALID_ARGUMENT);
+
+    ams::fs::DeleteFile(path);
+    R_TRY(ams::fs::CreateFile(path, 0));
+    R_TRY(ams::fs::OpenFile(std::addressof(g_file), path, ams::fs::OpenMode_Write | ams::fs::OpenMode_AllowAppend));
+
+    g_ring = new (std::nothrow) u8[ringSize];
+    if (g_ring == NULL)
+    {
+        ams::fs::CloseFile(g_file);
+        R_RETURN(CONTROL_ERR_OUT_OF_MEMORY);
+    }
+
+    g_ringSize = ringSize;
+    g_ringHead = g_ringTail = g_ringUsed = 0;
+    g_dropped = 0;
+    g_fileOffset = 0;
+    g_fileMaxSize = maxFileSize;
+    g_startTimestamp_us = GetTimestampUs();
+
+    UsbCaptureFileHeader fileHeader{USB_CAPTURE_MAGIC, USB_CAPTURE_VERSION, sizeof(UsbCaptureFileHeader), g_startTimestamp_us};
+    FileWrite(&fileHeader, sizeof(fileHeader));
+
+    g_threadIsRunning = true;
+    R_ABORT_UNLESS(threadCreate(&g_thread, &CaptureThreadFunc, NULL, g_thread_stack, sizeof(g_thread_stack), 0x3F, -2));
+    R_ABORT_UNLESS(threadStart(&g_thread));
+
+    s_enabled = true;
+
+    ::syscon::logger::LogInfo("SwitchUSBCapture: Recording USB traffic to '%s' (Ring: %d KB, Max: %d KB)", path, (int)(ringSize / 1024), (int)(maxFileSize / 1024));
+
+    R_SUCCEED();
+}
+
+void SwitchUSBCapture::Exit()
+{
+    if (!s_enabled)
+        return;
+
+    s_enabled = false;
+
+    g_threadIsRunning = false;
+    threadWaitForExit(&g_thread);
+    threadClose(&g_thread);
+
+    Flush();
+    ams::fs::CloseFile(g_file);
+
+    {
+        std::scoped_lock lock(g_ringMutex);
+        delete[] g_ring;
+        g_ring = NULL;
+        g_ringSize = 0;
+    }
+}
+
+void SwitchUSBCapture::Record(u16 interfaceId, u8 type, u8 endpoint, ams::Result rc, const void *prefix, size_t prefixSize, const void *data, size_t size, ams::os::Tick tick)
+{
+    size_t length = std::min(prefixSize + size, (size_t)UINT16_MAX);
+    size = length - prefixSize;
+
+    u64 timestamp_us = tick.GetInt64Value() != 0 ? ams::os::ConvertToTimeSpan(tick).GetMicroSeconds() : GetTimestampUs();
+    timestamp_us = std::max(timestamp_us, g_startTimestamp_us);
+
+    UsbCaptureRecordHeader header{static_cast<u32>(timestamp_us - g_startTimestamp_us), interfaceId, type, endpoint, rc.GetValue(), static_cast<u16>(length), 0};
+
+    std::scoped_lock lock(g_ringMutex);
+
+    u8 *record = g_ring != NULL ? RingReserve(sizeof(UsbCaptureRecordHeader) + USB_CAPTURE_ALIGN(length)) : NULL;
+    if (record == NULL)
+    {
+        g_dropped++;
+        return;
+    }
+
+    memcpy(record, &header, sizeof(header));
+    record += sizeof(header);
+
+    if (prefixSize > 0)
+        memcpy(record, prefix, prefixSize);
+    if (data != NULL && size > 0)
+        memcpy(record + prefixSize, data, size);
+}
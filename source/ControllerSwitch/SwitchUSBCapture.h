@@ -0,0 +1,55 @@
+#pragma once
+#include "switch.h"
+#include "USBCapture.h"
+#include <stratosphere.hpp>
+
+// USB flight recorder
+// Every IN/OUT/control transfer done by SwitchUSBEndpoint and SwitchUSBInterface is copied in a RAM ring
+// allocated once in Initialize(), a low priority thread streams the ring to the SD card (Format in USBCapture.h).
+// Recording a transfer is a timestamp + a memcpy under a short lock, no allocation and no file access,
+// if the ring is full the record is dropped and counted.
+// When the capture is disabled, the cost is a single boolean check.
+
+class SwitchUSBCapture
+{
+private:
+    static bool s_enabled;
+
+    // tick: when the transfer completed, 0: now
+    static void Record(u16 interfaceId, u8 type, u8 endpoint, ams::Result rc, const void *prefix, size_t prefixSize, const void *data, size_t size, ams::os::Tick tick = ams::os::Tick(0));
+
+public:
+    // ringSize: RAM used to buffer the transfers, maxFileSize: capture is stopped when the file reaches this size
+    static ams::Result Initialize(const char *path, size_t ringSize, size_t maxFileSize);
+    static void Exit();
+
+    static inline bool IsEnabled() { return s_enabled; }
+
+    // completedTick: when USB completed the transfer, for the asynchronous ones taken later by the reader. 0: completed now
+    static inline void RecordTransfer(u16 interfaceId, u8 endpoint, ams::Result rc, const void *data, size_t size, ams::os::Tick completedTick = ams::os::Tick(0))
+    {
+        if (!s_enabled)
+            return;
+
+        Record(interfaceId, (endpoint & USB_ENDPOINT_IN) ? UsbCaptureRecordType_In : UsbCaptureRecordType_Out, endpoint, rc, NULL, 0, data, size, completedTick);
+    }
+
+    static inline void RecordControl(u16 interfaceId, u8 bmRequestType, u8 bmRequest, u16 wValue, u16 wIndex, u16 wLength, ams::Result rc, const void *data, size_t size)
+    {
+        if (!s_enabled)
+            return;
+
+        UsbCaptureSetupPacket setup{bmRequestType, bmRequest, wValue, wIndex, wLength};
+        Record(interfaceId, (bmRequestType & USB_ENDPOINT_IN) ? UsbCaptureRecordType_ControlIn : UsbCaptureRecordType_ControlOut, 0, rc, &setup, sizeof(setup), data, size);
+    }
+
+    static inline void RecordInterface(u16 interfaceId, const UsbHsInterface &interface)
+    {
+        if (!s_enabled)
+            return;
+
+        UsbCaptureInterfaceInfo info{interface.device_desc.idVendor, interface.device_desc.idProduct, interface.inf.interface_desc.bInterfaceNumber,
+                                     interface.inf.interface_desc.bInterfaceClass, interface.inf.interface_desc.bInterfaceSubClass, interface.inf.interface_desc.bInterfaceProtocol};
+        Record(interfaceId, UsbCaptureRecordType_Interface, 0, 0, NULL, 0, &info, sizeof(info));
+    }
+};
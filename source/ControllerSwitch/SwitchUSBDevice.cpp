@@ -1,6 +1,7 @@
 #include "SwitchUSBDevice.h"
 #include "SwitchLogger.h"
 #include <cstring> //for memset
+#include <algorithm>
 
 SwitchUSBDevice::SwitchUSBDevice(UsbHsInterface interfaces[], int size)
 {
@@ -46,3 +47,38 @@ void SwitchUSBDevice::Reset()
     if (m_interfaces.size() != 0)
         m_interfaces[0]->Reset();
 }
+
+ams::Result SwitchUSBDevice::WaitForInput(IUSBEndpoint *const *endpoints, size_t count, size_t firstIndex, size_t maxSize, size_t *readyIndex, u64 aTimeoutUs)
+{
+    Waiter waiters[MAX_WAIT_OBJECTS];
+    size_t owners[MAX_WAIT_OBJECTS];
+    s32 waiterCount = 0;
+    s32 idx = -1;
+
+    count = std::min<size_t>(count, MAX_WAIT_OBJECTS);
+
+    // Waiters in rotated order: waitObjects returns the first signaled one
+    for (size_t i = 0; i < count; i++)
+    {
+        size_t endpointIdx = (firstIndex + i) % count;
+        SwitchUSBEndpoint *endpoint = static_cast<SwitchUSBEndpoint *>(endpoints[endpointIdx]);
+
+        // Collected by a previous read with the other completed transfers, its event was already cleared
+        if (endpoint->HasCompletedInTransfer())
+        {
+            *readyIndex = endpointIdx;
+            R_SUCCEED();
+        }
+
+        if (endpoint->ArmInTransfers(&waiters[waiterCount], maxSize))
+            owners[waiterCount++] = endpointIdx;
+    }
+
+    if (waiterCount == 0)
+        R_RETURN(CONTROL_ERR_INVALID_ENDPOINT);
+
+    R_TRY(waitObjects(&idx, waiters, waiterCount, aTimeoutUs == UINT64_MAX ? UINT64_MAX : aTimeoutUs * 1000));
+
+    *readyIndex = owners[idx];
+    R_SUCCEED();
+}
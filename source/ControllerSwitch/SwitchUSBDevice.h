@@ -20,4 +20,7 @@ public:
 
     // Resets the device
     virtual void Reset() override;
+
+    // Wait for the transfer events of the endpoints with waitObjects
+    virtual ams::Result WaitForInput(IUSBEndpoint *const *endpoints, size_t count, size_t firstIndex, size_t maxSize, size_t *readyIndex, u64 aTimeoutUs) override;
 };
\ No newline at end of file
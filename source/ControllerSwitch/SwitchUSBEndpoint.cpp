@@ -1,65 +1,332 @@
 #include "SwitchUSBEndpoint.h"
 #include "SwitchUSBLock.h"
+#include "SwitchUSBCapture.h"
+#include "SwitchUSBOutput.h"
 #include "SwitchLogger.h"
 #include <cstring>
+#include <algorithm>
 #include <malloc.h>
+#include <new>
+
+u32 SwitchUSBEndpoint::s_inTransferCount = 1;
+
+void SwitchUSBEndpoint::SetInTransferCount(u32 count)
+{
+    s_inTransferCount = std::clamp<u32>(count, 1, SWITCH_USB_MAX_IN_TRANSFERS);
+}
 
 SwitchUSBEndpoint::SwitchUSBEndpoint(UsbHsClientIfSession &if_session, usb_endpoint_descriptor &desc)
     : m_ifSession(&if_session),
       m_descriptor(&desc)
 {
+    // Registered while closed: the output thread skips the endpoints which are not open
+    if (GetDirection() == USB_ENDPOINT_OUT && SwitchUSBOutput::IsEnabled())
+    {
+        SwitchUSBOutput::Register(this);
+        m_outRegistered = true;
+    }
 }
 
 SwitchUSBEndpoint::~SwitchUSBEndpoint()
 {
+    if (m_outRegistered)
+        SwitchUSBOutput::Unregister(this);
 }
 
 ams::Result SwitchUSBEndpoint::Open(int maxPacketSize)
 {
     SwitchUSBLock usbLock;
+    std::scoped_lock epLock(m_mutex);
 
     maxPacketSize = maxPacketSize != 0 ? maxPacketSize : m_descriptor->wMaxPacketSize;
 
-    ::syscon::logger::LogDebug("SwitchUSBEndpoint Opening 0x%x (Pkt size: %d)...", m_descriptor->bEndpointAddress, maxPacketSize);
+    SYSCON_LOG_DEBUG(LOG_MODULE_USB, "SwitchUSBEndpoint Opening 0x%x (Pkt size: %d)...", m_descriptor->bEndpointAddress, maxPacketSize);
 
     R_TRY(usbHsIfOpenUsbEp(m_ifSession, &m_epSession, 1, maxPacketSize, m_descriptor));
 
-    ::syscon::logger::LogDebug("SwitchUSBEndpoint successfully opened!");
+    // The first slot uses the embedded buffer, the others are allocated only if more than 1 transfer is configured
+    m_slotCount = GetDirection() == USB_ENDPOINT_IN ? s_inTransferCount : 1;
+    m_slotHead = 0;
+    for (u32 i = 0; i < m_slotCount; i++)
+    {
+        if (i > 0)
+        {
+            m_slotBuffers[i].reset(new (std::nothrow) TransferBuffer);
+            if (m_slotBuffers[i] == nullptr)
+            {
+                m_slotCount = i;
+                break;
+            }
+        }
+
+        m_slots[i].buffer = i == 0 ? m_usb_buffer_in : m_slotBuffers[i]->data;
+        m_slots[i].state = SlotState_Free;
+    }
+
+    m_isOpen = true;
+
+    SYSCON_LOG_DEBUG(LOG_MODULE_USB, "SwitchUSBEndpoint successfully opened! (Transfers: %d)", m_slotCount);
 
     R_SUCCEED();
 }
 
 void SwitchUSBEndpoint::Close()
 {
+    // What is still queued is sent before closing (i.e: power off packet), usbHsEpClose ends a write still in flight.
+    // The flush waits for the USB transfers and the output pacing, it's done without the USB lock shared by every controller.
+    {
+        std::scoped_lock epLock(m_mutex);
+
+        if (GetDirection() == USB_ENDPOINT_IN)
+            SYSCON_LOG_DEBUG(LOG_MODULE_USB, "SwitchUSBEndpoint: Closing 0x%x (Reports: %lu, Copies: %lu, Bytes copied: %lu)", m_descriptor->bEndpointAddress, m_readStats.reports, m_readStats.copies, m_readStats.copiedBytes);
+        else
+            SYSCON_LOG_DEBUG(LOG_MODULE_USB, "SwitchUSBEndpoint: Closing 0x%x (Queued: %lu, Sent: %lu, Coalesced: %lu, Dropped: %lu, Failed: %lu, Depth max: %d, Latency avg: %lu us max: %lu us)", m_descriptor->bEndpointAddress,
+                                       m_outputStats.queued, m_outputStats.sent, m_outputStats.coalesced, m_outputStats.dropped, m_outputStats.failed, m_outputStats.depthMax,
+                                       m_outputStats.latencyTotal_us / std::max<u64>(1, m_outputStats.sent), m_outputStats.latencyMax_us);
+
+        if (m_isOpen)
+            FlushOutput();
+    }
+
+    // Same order as Open: the USB lock, then the endpoint lock
     SwitchUSBLock usbLock;
+    std::scoped_lock epLock(m_mutex);
 
     usbHsEpClose(&m_epSession);
+    m_isOpen = false;
+
+    for (u32 i = 0; i < SWITCH_USB_MAX_IN_TRANSFERS; i++)
+    {
+        m_slots[i].state = SlotState_Free;
+        m_slotBuffers[i].reset();
+    }
+    m_slotCount = 1;
+    m_slotHead = 0;
+    m_lentSlot = SWITCH_USB_MAX_IN_TRANSFERS;
+    m_outHead = 0;
+    m_outCount = 0;
+    m_outPosted = false;
 }
 
 ams::Result SwitchUSBEndpoint::Write(const uint8_t *inBuffer, size_t bufferSize)
 {
     u32 transferredSize = 0;
 
-    SwitchUSBLock usbLock;
+    std::scoped_lock epLock(m_mutex);
+
+    // The queued writes are sent first, in order
+    R_TRY(FlushOutput());
+    WaitOutputPacing();
 
     memcpy(m_usb_buffer_out, inBuffer, bufferSize);
 
     if (GetDirection() == USB_ENDPOINT_IN)
         ::syscon::logger::LogError("SwitchUSBEndpoint:: Trying to write an INPUT endpoint!");
 
-    ::syscon::logger::LogTrace("SwitchUSBEndpoint: Write %d bytes", bufferSize);
-    ::syscon::logger::LogBuffer(LOG_LEVEL_TRACE, m_usb_buffer_out, bufferSize);
+    SYSCON_LOG_LIMITED_BUFFER(LOG_MODULE_USB, LOG_LEVEL_TRACE, m_usb_buffer_out, bufferSize, "SwitchUSBEndpoint: Write %d bytes", bufferSize);
+
+    ams::Result rc = usbHsEpPostBuffer(&m_epSession, m_usb_buffer_out, bufferSize, &transferredSize);
+    SwitchUSBCapture::RecordTransfer(m_ifSession->ID, m_descriptor->bEndpointAddress, rc, m_usb_buffer_out, R_SUCCEEDED(rc) ? transferredSize : 0);
+    m_outNextTick = ams::os::GetSystemTick() + ams::os::ConvertToTick(ams::TimeSpan::FromMilliSeconds(m_descriptor->bInterval));
+    R_TRY(rc);
+
+    R_SUCCEED();
+}
+
+ams::Result SwitchUSBEndpoint::QueueWrite(const uint8_t *inBuffer, size_t bufferSize, OutputKey key)
+{
+    if (!m_outRegistered || bufferSize > sizeof(m_outQueue[0].data))
+        R_RETURN(Write(inBuffer, bufferSize));
+
+    {
+        std::scoped_lock epLock(m_mutex);
+
+        if (!m_isOpen)
+            R_RETURN(CONTROL_ERR_INVALID_ENDPOINT);
+
+        // Only a waiting write can be replaced, the head one may be in flight
+        OutputEntry *entry = NULL;
+        for (u32 i = m_outPosted ? 1 : 0; key != OUTPUT_KEY_NONE && i < m_outCount; i++)
+        {
+            OutputEntry *candidate = &m_outQueue[(m_outHead + i) % SWITCH_USB_OUTPUT_QUEUE_SIZE];
+            if (candidate->key == key)
+            {
+                entry = candidate;
+                m_outputStats.coalesced++;
+                break;
+            }
+        }
+
+        if (entry == NULL)
+        {
+            if (m_outCount == SWITCH_USB_OUTPUT_QUEUE_SIZE)
+            {
+                m_outputStats.dropped++;
+                R_RETURN(CONTROL_ERR_OUT_OF_MEMORY);
+            }
+
+            entry = &m_outQueue[(m_outHead + m_outCount) % SWITCH_USB_OUTPUT_QUEUE_SIZE];
+            m_outCount++;
+        }
+
+        memcpy(entry->data, inBuffer, bufferSize);
+        entry->size = bufferSize;
+        entry->key = key;
+        entry->queuedTick = ams::os::GetSystemTick();
+
+        m_outputStats.queued++;
+        m_outputStats.depth = m_outCount;
+        m_outputStats.depthMax = std::max(m_outputStats.depthMax, m_outCount);
+    }
+
+    SwitchUSBOutput::Signal();
+
+    R_SUCCEED();
+}
+
+bool SwitchUSBEndpoint::ServiceOutput(Waiter *waiter, u64 *wait_ns)
+{
+    // Busy with a synchronous write, which also sends the queue: don't hold the output thread
+    std::unique_lock epLock(m_mutex, std::try_to_lock);
+    if (!epLock.owns_lock())
+    {
+        *wait_ns = 1000000;
+        return false;
+    }
+
+    if (!m_isOpen)
+        return false;
+
+    if (m_outPosted && R_SUCCEEDED(eventWait(usbHsEpGetXferEvent(&m_epSession), 0)))
+    {
+        UsbHsXferReport report;
+        u32 count = 0;
+
+        eventClear(usbHsEpGetXferEvent(&m_epSession));
+        memset(&report, 0, sizeof(report));
+
+        ams::Result rc = usbHsEpGetXferReport(&m_epSession, &report, 1, &count);
+        if (R_FAILED(rc))
+            CompleteOutput(rc, 0);
+        else if (count > 0)
+            CompleteOutput(report.res, report.transferredSize);
+    }
+
+    if (!m_outPosted && m_outCount > 0)
+    {
+        s64 remaining_ns = ams::os::ConvertToTimeSpan(m_outNextTick - ams::os::GetSystemTick()).GetNanoSeconds();
+        if (remaining_ns <= 0)
+            PostOutput();
+        else
+            *wait_ns = remaining_ns;
+    }
+
+    if (!m_outPosted)
+        return false;
+
+    *waiter = waiterForEvent(usbHsEpGetXferEvent(&m_epSession));
+    return true;
+}
+
+void SwitchUSBEndpoint::PostOutput()
+{
+    OutputEntry *entry = &m_outQueue[m_outHead];
+
+    memcpy(m_usb_buffer_out, entry->data, entry->size);
+
+    SYSCON_LOG_LIMITED_BUFFER(LOG_MODULE_USB, LOG_LEVEL_TRACE, m_usb_buffer_out, entry->size, "SwitchUSBEndpoint: WriteAsync %d bytes", entry->size);
+
+    u32 xferId;
+    ams::Result rc = usbHsEpPostBufferAsync(&m_epSession, m_usb_buffer_out, entry->size, 0, &xferId);
+    if (R_FAILED(rc))
+    {
+        CompleteOutput(rc, 0);
+        return;
+    }
+
+    m_outPosted = true;
+}
+
+// Account for the head write and remove it from the queue
+void SwitchUSBEndpoint::CompleteOutput(ams::Result rc, u32 transferredSize)
+{
+    OutputEntry *entry = &m_outQueue[m_outHead];
+
+    SwitchUSBCapture::RecordTransfer(m_ifSession->ID, m_descriptor->bEndpointAddress, rc, entry->data, R_SUCCEEDED(rc) ? transferredSize : 0);
+
+    if (R_FAILED(rc))
+    {
+        ::syscon::logger::LogError("SwitchUSBEndpoint: WriteAsync failed: %08X", rc);
+        m_outputStats.failed++;
+    }
+    else
+    {
+        u64 latency_us = ams::os::ConvertToTimeSpan(ams::os::GetSystemTick() - entry->queuedTick).GetMicroSeconds();
+        m_outputStats.sent++;
+        m_outputStats.latencyTotal_us += latency_us;
+        m_outputStats.latencyMax_us = std::max(m_outputStats.latencyMax_us, latency_us);
+    }
+
+    m_outHead = (m_outHead + 1) % SWITCH_USB_OUTPUT_QUEUE_SIZE;
+    m_outCount--;
+    m_outPosted = false;
+    m_outputStats.depth = m_outCount;
+    m_outNextTick = ams::os::GetSystemTick() + ams::os::ConvertToTick(ams::TimeSpan::FromMilliSeconds(m_descriptor->bInterval));
+}
+
+// Send the whole queue synchronously, the endpoint lock must be held.
+// Given up when the write in flight doesn't complete: the transfer still owns m_usb_buffer_out, nothing else can be sent from it.
+ams::Result SwitchUSBEndpoint::FlushOutput()
+{
+    if (m_outPosted)
+    {
+        UsbHsXferReport report;
+        u32 count = 0;
+
+        memset(&report, 0, sizeof(report));
+
+        ams::Result rc = eventWait(usbHsEpGetXferEvent(&m_epSession), 100000000);
+        if (R_FAILED(rc))
+        {
+            ::syscon::logger::LogError("SwitchUSBEndpoint: WriteAsync still in flight after 100 ms, %d queued writes not sent", (int)m_outCount);
+            R_RETURN(rc);
+        }
+
+        eventClear(usbHsEpGetXferEvent(&m_epSession));
+        rc = usbHsEpGetXferReport(&m_epSession, &report, 1, &count);
+
+        if (R_FAILED(rc))
+            CompleteOutput(rc, 0);
+        else if (count == 0)
+            CompleteOutput(CONTROL_ERR_NO_DATA_AVAILABLE, 0);
+        else
+            CompleteOutput(report.res, report.transferredSize);
+    }
+
+    while (m_outCount > 0)
+    {
+        OutputEntry *entry = &m_outQueue[m_outHead];
+        u32 transferredSize = 0;
 
-    R_TRY(usbHsEpPostBuffer(&m_epSession, m_usb_buffer_out, bufferSize, &transferredSize));
+        WaitOutputPacing();
 
-    svcSleepThread(m_descriptor->bInterval * 1000000);
+        memcpy(m_usb_buffer_out, entry->data, entry->size);
+        CompleteOutput(usbHsEpPostBuffer(&m_epSession, m_usb_buffer_out, entry->size, &transferredSize), transferredSize);
+    }
 
     R_SUCCEED();
 }
 
+void SwitchUSBEndpoint::WaitOutputPacing()
+{
+    s64 remaining_ns = ams::os::ConvertToTimeSpan(m_outNextTick - ams::os::GetSystemTick()).GetNanoSeconds();
+    if (remaining_ns > 0)
+        svcSleepThread(remaining_ns);
+}
+
 ams::Result SwitchUSBEndpoint::Read(uint8_t *outBuffer, size_t *bufferSizeInOut, u64 aTimeoutUs)
 {
-    SwitchUSBLock usbLock;
+    std::scoped_lock epLock(m_mutex);
 
     if (GetDirection() == USB_ENDPOINT_OUT)
         ::syscon::logger::LogError("SwitchUSBEndpoint: Trying to read an OUTPUT endpoint!");
@@ -69,6 +336,8 @@ ams::Result SwitchUSBEndpoint::Read(uint8_t *outBuffer, size_t *bufferSizeInOut,
         u32 transferredSize;
 
         ams::Result rc = usbHsEpPostBuffer(&m_epSession, m_usb_buffer_in, *bufferSizeInOut, &transferredSize);
+        m_lastCompletionTick = ams::os::GetSystemTick();
+        SwitchUSBCapture::RecordTransfer(m_ifSession->ID, m_descriptor->bEndpointAddress, rc, m_usb_buffer_in, R_SUCCEEDED(rc) ? transferredSize : 0);
         if (R_FAILED(rc))
         {
             ::syscon::logger::LogError("SwitchUSBEndpoint: Read failed: %08X", rc);
@@ -78,60 +347,230 @@ ams::Result SwitchUSBEndpoint::Read(uint8_t *outBuffer, size_t *bufferSizeInOut,
         memcpy(outBuffer, m_usb_buffer_in, transferredSize);
         *bufferSizeInOut = transferredSize;
 
+        m_readStats.reports++;
+        m_readStats.copies++;
+        m_readStats.copiedBytes += transferredSize;
+
         if (transferredSize == 0)
         {
             ::syscon::logger::LogError("SwitchUSBEndpoint: Read returned no data !");
             R_RETURN(CONTROL_ERR_NO_DATA_AVAILABLE);
         }
 
-        ::syscon::logger::LogTrace("SwitchUSBEndpoint: Read %d bytes", *bufferSizeInOut);
-        ::syscon::logger::LogBuffer(LOG_LEVEL_TRACE, outBuffer, *bufferSizeInOut);
+        SYSCON_LOG_LIMITED_BUFFER(LOG_MODULE_USB, LOG_LEVEL_TRACE, outBuffer, *bufferSizeInOut, "SwitchUSBEndpoint: Read %d bytes", *bufferSizeInOut);
 
         R_SUCCEED()
     }
     else
     {
-        u32 count = 0;
-        UsbHsXferReport report;
-        u32 tmpXcferId = 0;
+        TransferSlot *slot = NULL;
+        R_TRY(NextInTransfer(*bufferSizeInOut, aTimeoutUs, &slot));
+
+        // Reports are returned in order, the slot is posted again on the next Read
+        slot->state = SlotState_Free;
+
+        *bufferSizeInOut = std::min<size_t>(*bufferSizeInOut, slot->transferredSize);
+        memcpy(outBuffer, slot->buffer, *bufferSizeInOut);
+
+        m_readStats.reports++;
+        m_readStats.copies++;
+        m_readStats.copiedBytes += *bufferSizeInOut;
+
+        if (*bufferSizeInOut == 0)
+            R_RETURN(CONTROL_ERR_NO_DATA_AVAILABLE);
+
+        SYSCON_LOG_LIMITED_BUFFER(LOG_MODULE_USB, LOG_LEVEL_TRACE, outBuffer, *bufferSizeInOut, "SwitchUSBEndpoint: ReadAsync %d bytes", *bufferSizeInOut);
+
+        R_RETURN(slot->res);
+    }
+    R_RETURN(CONTROL_ERR_INVALID_ARGUMENT);
+}
+
+ams::Result SwitchUSBEndpoint::AcquireReadView(const uint8_t **outData, size_t *sizeInOut, u64 aTimeoutUs)
+{
+    std::scoped_lock epLock(m_mutex);
+
+    *outData = NULL;
+
+    if (GetDirection() == USB_ENDPOINT_OUT)
+        ::syscon::logger::LogError("SwitchUSBEndpoint: Trying to read an OUTPUT endpoint!");
+
+    if (m_lentSlot != SWITCH_USB_MAX_IN_TRANSFERS)
+    {
+        ::syscon::logger::LogError("SwitchUSBEndpoint: Read view already acquired !");
+        R_RETURN(CONTROL_ERR_INVALID_ARGUMENT);
+    }
+
+    TransferSlot *slot = NULL;
+    R_TRY(NextInTransfer(*sizeInOut, aTimeoutUs, &slot));
+
+    *sizeInOut = std::min<size_t>(*sizeInOut, slot->transferredSize);
+    m_readStats.reports++;
+
+    // Nothing to lend, the slot is posted again on the next read
+    if (R_FAILED(slot->res) || *sizeInOut == 0)
+    {
+        slot->state = SlotState_Free;
+        R_TRY(slot->res);
+        R_RETURN(CONTROL_ERR_NO_DATA_AVAILABLE);
+    }
+
+    SYSCON_LOG_LIMITED_BUFFER(LOG_MODULE_USB, LOG_LEVEL_TRACE, slot->buffer, *sizeInOut, "SwitchUSBEndpoint: ReadView %d bytes", *sizeInOut);
+
+    slot->state = SlotState_Lent;
+    m_lentSlot = slot - m_slots;
+    *outData = slot->buffer;
+
+    R_SUCCEED();
+}
+
+void SwitchUSBEndpoint::ReleaseReadView()
+{
+    std::scoped_lock epLock(m_mutex);
+
+    if (m_lentSlot == SWITCH_USB_MAX_IN_TRANSFERS)
+        return;
+
+    m_slots[m_lentSlot].state = SlotState_Free;
+    m_lentSlot = SWITCH_USB_MAX_IN_TRANSFERS;
+
+    // Give the buffer back to the controller right away, the next report can be received while this one is processed
+    PostInTransfers(m_postSize);
+}
+
+bool SwitchUSBEndpoint::ArmInTransfers(Waiter *waiter, size_t size)
+{
+    std::scoped_lock epLock(m_mutex);
+
+    if (!m_isOpen || GetDirection() != USB_ENDPOINT_IN)
+        return false;
 
-        if (m_xferIdRead == 0)
+    if (size > 0)
+        m_postSize = size;
+
+    // Nothing is posted until the first read gives the transfer size
+    if (m_postSize > 0 && R_FAILED(PostInTransfers(m_postSize)))
+        return false;
+
+    *waiter = waiterForEvent(usbHsEpGetXferEvent(&m_epSession));
+    return true;
+}
+
+bool SwitchUSBEndpoint::HasCompletedInTransfer()
+{
+    std::scoped_lock epLock(m_mutex);
+
+    return m_isOpen && m_slots[m_slotHead].state == SlotState_Completed;
+}
+
+// Return the oldest completed transfer, the caller must free the slot
+ams::Result SwitchUSBEndpoint::NextInTransfer(size_t size, u64 aTimeoutUs, TransferSlot **outSlot)
+{
+    m_postSize = size;
+    R_TRY(PostInTransfers(size));
+
+    TransferSlot *slot = &m_slots[m_slotHead];
+    if (slot->state != SlotState_Completed)
+    {
+        R_TRY(WaitInTransfers(aTimeoutUs));
+
+        if (slot->state != SlotState_Completed)
         {
-            ams::Result rc = usbHsEpPostBufferAsync(&m_epSession, m_usb_buffer_in, *bufferSizeInOut, 0, &m_xferIdRead);
-            if (R_FAILED(rc))
-            {
-                ::syscon::logger::LogError("SwitchUSBEndpoint: ReadAsync failed: %08X", rc);
-                R_RETURN(rc);
-            }
+            ::syscon::logger::LogError("SwitchUSBEndpoint: ReadAsync failed (NoData returned - xferId %d)", slot->xferId);
+            R_RETURN(CONTROL_ERR_NO_DATA_AVAILABLE);
         }
+    }
 
-        R_TRY(eventWait(usbHsEpGetXferEvent(&m_epSession), aTimeoutUs * 1000));
-        eventClear(usbHsEpGetXferEvent(&m_epSession));
+    m_slotHead = (m_slotHead + 1) % m_slotCount;
+    m_lastCompletionTick = slot->completedTick;
 
-        tmpXcferId = m_xferIdRead;
-        m_xferIdRead = 0;
+    // Timestamped when USB completed the transfer, not now: the reader may take it one polling period later, or a burst at once
+    SwitchUSBCapture::RecordTransfer(m_ifSession->ID, m_descriptor->bEndpointAddress, slot->res, slot->buffer, slot->transferredSize,
+                                     slot->completedTick.GetInt64Value() != 0 ? slot->completedTick : slot->collectedTick);
 
-        memset(&report, 0, sizeof(report));
-        R_TRY(usbHsEpGetXferReport(&m_epSession, &report, 1, &count));
+    *outSlot = slot;
+    R_SUCCEED();
+}
 
-        if ((count <= 0) || (tmpXcferId != report.xferId))
+// Post every free slot, in ring order from the oldest one so that the completions stay in order
+ams::Result SwitchUSBEndpoint::PostInTransfers(size_t size)
+{
+    size = std::min(size, sizeof(m_usb_buffer_in));
+
+    for (u32 i = 0; i < m_slotCount; i++)
+    {
+        TransferSlot *slot = &m_slots[(m_slotHead + i) % m_slotCount];
+        if (slot->state != SlotState_Free)
+            continue;
+
+        ams::Result rc = usbHsEpPostBufferAsync(&m_epSession, slot->buffer, size, 0, &slot->xferId);
+        if (R_FAILED(rc))
         {
-            ::syscon::logger::LogError("SwitchUSBEndpoint: ReadAsync failed (Invalid XFerId or NoData returned - Count: %d, xferId %d/%d)", count, tmpXcferId, report.xferId);
-            R_RETURN(CONTROL_ERR_NO_DATA_AVAILABLE);
+            ::syscon::logger::LogError("SwitchUSBEndpoint: ReadAsync failed: %08X", rc);
+            R_RETURN(rc);
         }
 
-        memcpy(outBuffer, m_usb_buffer_in, report.transferredSize);
-        *bufferSizeInOut = report.transferredSize;
+        slot->state = SlotState_Posted;
+    }
 
-        if (report.transferredSize == 0)
-            R_RETURN(CONTROL_ERR_NO_DATA_AVAILABLE);
+    R_SUCCEED();
+}
 
-        ::syscon::logger::LogTrace("SwitchUSBEndpoint: ReadAsync %d bytes", *bufferSizeInOut);
-        ::syscon::logger::LogBuffer(LOG_LEVEL_TRACE, outBuffer, *bufferSizeInOut);
+void SwitchUSBEndpoint::SetSignaledTick(ams::os::Tick tick)
+{
+    std::scoped_lock epLock(m_mutex);
+    m_signaledTick = tick;
+}
 
-        R_RETURN(report.res);
+// Wait for at least one transfer and collect every completed one
+ams::Result SwitchUSBEndpoint::WaitInTransfers(u64 aTimeoutUs)
+{
+    UsbHsXferReport reports[SWITCH_USB_MAX_IN_TRANSFERS];
+    u32 count = 0;
+
+    Event *event = usbHsEpGetXferEvent(&m_epSession);
+
+    // The completion time is only known when a wait sees the event being signaled: this one, or the reactor one (See SetSignaledTick).
+    // An event already signaled here (i.e: the report landed while the polling thread was sleeping) gives no completion time (0).
+    ams::os::Tick completedTick = m_signaledTick;
+    m_signaledTick = ams::os::Tick(0);
+    if (R_FAILED(eventWait(event, 0)))
+    {
+        R_TRY(eventWait(event, aTimeoutUs == UINT64_MAX ? UINT64_MAX : aTimeoutUs * 1000));
+        completedTick = ams::os::GetSystemTick();
     }
-    R_RETURN(CONTROL_ERR_INVALID_ARGUMENT);
+    eventClear(event);
+
+    memset(reports, 0, sizeof(reports));
+    R_TRY(usbHsEpGetXferReport(&m_epSession, reports, m_slotCount, &count));
+    ams::os::Tick collectedTick = ams::os::GetSystemTick();
+
+    for (u32 i = 0; i < count; i++)
+    {
+        TransferSlot *slot = NULL;
+        for (u32 j = 0; j < m_slotCount; j++)
+        {
+            if (m_slots[j].state == SlotState_Posted && m_slots[j].xferId == reports[i].xferId)
+            {
+                slot = &m_slots[j];
+                break;
+            }
+        }
+
+        if (slot == NULL)
+        {
+            ::syscon::logger::LogError("SwitchUSBEndpoint: ReadAsync failed (Invalid XFerId %d)", reports[i].xferId);
+            continue;
+        }
+
+        slot->state = SlotState_Completed;
+        slot->transferredSize = reports[i].transferredSize;
+        slot->res = reports[i].res;
+        slot->completedTick = completedTick;
+        slot->collectedTick = collectedTick;
+    }
+
+    R_SUCCEED();
 }
 
 IUSBEndpoint::Direction SwitchUSBEndpoint::GetDirection()
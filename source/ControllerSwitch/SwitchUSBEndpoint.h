@@ -3,16 +3,84 @@
 #include "IUSBEndpoint.h"
 #include <memory>
 
+// Maximum number of asynchronous IN transfers in flight per endpoint (See SetInTransferCount)
+#define SWITCH_USB_MAX_IN_TRANSFERS 8
+// Maximum number of writes waiting in the output queue of an OUT endpoint (See QueueWrite)
+#define SWITCH_USB_OUTPUT_QUEUE_SIZE 8
+
 class SwitchUSBEndpoint : public IUSBEndpoint
 {
 private:
+    // Transfer buffers must be 0x1000 aligned
+    struct alignas(0x1000) TransferBuffer
+    {
+        u8 data[0x1000];
+    };
+
+    enum SlotState : u8
+    {
+        SlotState_Free,
+        SlotState_Posted,
+        SlotState_Completed,
+        SlotState_Lent, // Completed and lent to the caller (See AcquireReadView)
+    };
+
+    // Asynchronous IN transfers: a ring of slots posted and completed in order, the oldest one (m_slotHead) is returned first
+    struct TransferSlot
+    {
+        u8 *buffer;
+        u32 xferId;
+        SlotState state;
+        u32 transferredSize;
+        Result res;
+        ams::os::Tick completedTick; // When the transfer event was signaled, 0: unknown (See WaitInTransfers)
+        ams::os::Tick collectedTick; // When WaitInTransfers collected the completion, the capture timestamp when completedTick is unknown
+    };
+
+    // Output queue: a ring of writes sent in order by the output thread, the oldest one (m_outHead) is the one in flight
+    struct OutputEntry
+    {
+        u8 data[64];
+        u16 size;
+        OutputKey key;
+        ams::os::Tick queuedTick;
+    };
+
+    static u32 s_inTransferCount;
+
+    // Serialize the transfers of this endpoint only (See SwitchUSBLock)
+    ams::os::Mutex m_mutex{false};
+
     UsbHsClientEpSession m_epSession{};
     UsbHsClientIfSession *m_ifSession;
     usb_endpoint_descriptor *m_descriptor;
-    u32 m_xferIdRead = 0;
+    TransferSlot m_slots[SWITCH_USB_MAX_IN_TRANSFERS];
+    std::unique_ptr<TransferBuffer> m_slotBuffers[SWITCH_USB_MAX_IN_TRANSFERS];
+    u32 m_slotCount = 1;
+    u32 m_slotHead = 0;
+    u32 m_lentSlot = SWITCH_USB_MAX_IN_TRANSFERS;
+    bool m_isOpen = false;
+    size_t m_postSize = 0;
+    ams::os::Tick m_lastCompletionTick;
+    ams::os::Tick m_signaledTick; // Given by the reactor when its wait saw the transfer event signaled (See SetSignaledTick)
+    OutputEntry m_outQueue[SWITCH_USB_OUTPUT_QUEUE_SIZE];
+    u32 m_outHead = 0;
+    u32 m_outCount = 0;
+    bool m_outPosted = false;
+    bool m_outRegistered = false;
+    ams::os::Tick m_outNextTick; // No OUT transfer before this tick (bInterval after the previous one)
     alignas(0x1000) u8 m_usb_buffer_in[512];
     alignas(0x1000) u8 m_usb_buffer_out[512];
 
+    ams::Result PostInTransfers(size_t size);
+    ams::Result WaitInTransfers(u64 aTimeoutUs);
+    ams::Result NextInTransfer(size_t size, u64 aTimeoutUs, TransferSlot **outSlot);
+
+    void PostOutput();
+    void CompleteOutput(ams::Result rc, u32 transferredSize);
+    ams::Result FlushOutput();
+    void WaitOutputPacing();
+
 public:
     // Pass the necessary information to be able to open the endpoint
     SwitchUSBEndpoint(UsbHsClientIfSession &if_session, usb_endpoint_descriptor &desc);
@@ -25,15 +93,50 @@ public:
     // buffer should point to the data array, and only the specified size will be read.
     virtual ams::Result Write(const uint8_t *inBuffer, size_t bufferSize) override;
 
+    // Sent by the output thread (See SwitchUSBOutput), synchronous if the thread is not running
+    virtual ams::Result QueueWrite(const uint8_t *inBuffer, size_t bufferSize, OutputKey key = OUTPUT_KEY_NONE) override;
+
     // The data received will be put in the outBuffer array for the length of the specified size.
     virtual ams::Result Read(uint8_t *outBuffer, size_t *bufferSizeInOut, u64 aTimeoutUs) override;
 
+    // The view points to the transfer buffer of the slot, which is posted again when the view is released.
+    // Always asynchronous, even without timeout.
+    virtual ams::Result AcquireReadView(const uint8_t **outData, size_t *sizeInOut, u64 aTimeoutUs) override;
+    virtual void ReleaseReadView() override;
+
     // Gets the direction of this endpoint (IN or OUT)
     virtual IUSBEndpoint::Direction GetDirection() override;
 
     // get the endpoint descriptor
     virtual IUSBEndpoint::EndpointDescriptor *GetDescriptor() override;
 
+    // Post the IN transfers which are not in flight (size bytes, 0: same size as the last read) and get the event signaled when one completes,
+    // to wait for several endpoints at once (See SwitchInputReactor, SwitchUSBDevice::WaitForInput). The completed transfer is then taken by a read.
+    bool ArmInTransfers(Waiter *waiter, size_t size = 0);
+
+    // The oldest transfer already completed, a read returns it without waiting
+    bool HasCompletedInTransfer();
+
+    // Called by the output thread: collect the write in flight and post the next one when its pacing allows it.
+    // Return true and set *waiter while a write is in flight, *wait_ns is the time until the next write can be posted.
+    bool ServiceOutput(Waiter *waiter, u64 *wait_ns);
+
+    // When the transfer of the last report returned by a read completed, 0: unknown or already taken (Only accessed by the reading thread)
+    inline ams::os::Tick TakeLastCompletionTick()
+    {
+        ams::os::Tick tick = m_lastCompletionTick;
+        m_lastCompletionTick = ams::os::Tick(0);
+        return tick;
+    }
+
+    // Reactor mode: the transfer event was seen signaled at this tick by the reactor wait, used by the next read as the completion time
+    void SetSignaledTick(ams::os::Tick tick);
+
     // Get the current EpSession (after it was opened)
     inline UsbHsClientEpSession &GetSession() { return m_epSession; }
+
+    // Number of IN transfers kept in flight by Read() with a timeout, for the endpoints opened afterward (1 to SWITCH_USB_MAX_IN_TRANSFERS)
+    // With more than 1, a report that arrives while the previous one is being processed is not NAKed/lost anymore,
+    // but reports are returned in order: the caller must read them as fast as they arrive (See SwitchInputMode_Event).
+    static void SetInTransferCount(u32 count);
 };
\ No newline at end of file
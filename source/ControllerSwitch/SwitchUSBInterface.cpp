@@ -1,6 +1,7 @@
 #include "SwitchUSBInterface.h"
 #include "SwitchUSBEndpoint.h"
 #include "SwitchUSBLock.h"
+#include "SwitchUSBCapture.h"
 #include "SwitchLogger.h"
 #include <malloc.h>
 #include <cstring>
@@ -18,7 +19,7 @@ ams::Result SwitchUSBInterface::Open()
 {
     SwitchUSBLock usbLock;
 
-    ::syscon::logger::LogDebug("SwitchUSBInterface[%04x-%04x] Openning ...", m_interface.device_desc.idVendor, m_interface.device_desc.idProduct);
+    SYSCON_LOG_DEBUG(LOG_MODULE_USB, "SwitchUSBInterface[%04x-%04x] Openning ...", m_interface.device_desc.idVendor, m_interface.device_desc.idProduct);
 
     ams::Result rc = usbHsAcquireUsbIf(&m_session, &m_interface);
     if (R_FAILED(rc))
@@ -27,12 +28,14 @@ ams::Result SwitchUSBInterface::Open()
         R_RETURN(CONTROL_ERR_USB_INTERFACE_ACQUIRE);
     }
 
+    SwitchUSBCapture::RecordInterface(m_session.ID, m_interface);
+
     for (int i = 0; i < SWITCH_USB_MAX_ENDPOINTS; i++)
     {
         usb_endpoint_descriptor &epdesc = m_session.inf.inf.input_endpoint_descs[i];
         if (epdesc.bLength != 0)
         {
-            ::syscon::logger::LogDebug("SwitchUSBInterface[%04x-%04x] Input endpoint found 0x%x (Idx: %d)", m_interface.device_desc.idVendor, m_interface.device_desc.idProduct, epdesc.bEndpointAddress, i);
+            SYSCON_LOG_DEBUG(LOG_MODULE_USB, "SwitchUSBInterface[%04x-%04x] Input endpoint found 0x%x (Idx: %d)", m_interface.device_desc.idVendor, m_interface.device_desc.idProduct, epdesc.bEndpointAddress, i);
             m_inEndpoints[i] = std::make_unique<SwitchUSBEndpoint>(m_session, epdesc);
         }
         else
@@ -46,7 +49,7 @@ ams::Result SwitchUSBInterface::Open()
         usb_endpoint_descriptor &epdesc = m_session.inf.inf.output_endpoint_descs[i];
         if (epdesc.bLength != 0)
         {
-            ::syscon::logger::LogDebug("SwitchUSBInterface[%04x-%04x] Output endpoint found 0x%x (Idx: %d)", m_interface.device_desc.idVendor, m_interface.device_desc.idProduct, epdesc.bEndpointAddress, i);
+            SYSCON_LOG_DEBUG(LOG_MODULE_USB, "SwitchUSBInterface[%04x-%04x] Output endpoint found 0x%x (Idx: %d)", m_interface.device_desc.idVendor, m_interface.device_desc.idProduct, epdesc.bEndpointAddress, i);
             m_outEndpoints[i] = std::make_unique<SwitchUSBEndpoint>(m_session, epdesc);
         }
         else
@@ -60,10 +63,9 @@ ams::Result SwitchUSBInterface::Open()
 
 void SwitchUSBInterface::Close()
 {
-    ::syscon::logger::LogDebug("SwitchUSBInterface[%04x-%04x] Closing...", m_interface.device_desc.idVendor, m_interface.device_desc.idProduct);
-
-    SwitchUSBLock usbLock;
+    SYSCON_LOG_DEBUG(LOG_MODULE_USB, "SwitchUSBInterface[%04x-%04x] Closing...", m_interface.device_desc.idVendor, m_interface.device_desc.idProduct);
 
+    // Each endpoint takes the USB lock itself, only to close its session: its queued writes are flushed without it
     for (int i = 0; i < SWITCH_USB_MAX_ENDPOINTS; i++)
     {
         if (m_inEndpoints[i])
@@ -72,14 +74,15 @@ void SwitchUSBInterface::Close()
             m_outEndpoints[i]->Close();
     }
 
+    SwitchUSBLock usbLock;
     usbHsIfClose(&m_session);
 }
 
 ams::Result SwitchUSBInterface::ControlTransferInput(u8 bmRequestType, u8 bmRequest, u16 wValue, u16 wIndex, void *buffer, u16 *wLength)
 {
-    SwitchUSBLock usbLock;
+    std::scoped_lock ifLock(m_mutex);
 
-    ::syscon::logger::LogDebug("SwitchUSBInterface[%04x-%04x] ControlTransferInput (bmRequestType=0x%02X, bmRequest=0x%02X, wValue=0x%04X, wIndex=0x%04X, wLength=%d)...", m_interface.device_desc.idVendor, m_interface.device_desc.idProduct, bmRequestType, bmRequest, wValue, wIndex, *wLength);
+    SYSCON_LOG_DEBUG(LOG_MODULE_USB, "SwitchUSBInterface[%04x-%04x] ControlTransferInput (bmRequestType=0x%02X, bmRequest=0x%02X, wValue=0x%04X, wIndex=0x%04X, wLength=%d)...", m_interface.device_desc.idVendor, m_interface.device_desc.idProduct, bmRequestType, bmRequest, wValue, wIndex, *wLength);
 
     if (!(bmRequestType & USB_ENDPOINT_IN))
     {
@@ -90,6 +93,7 @@ ams::Result SwitchUSBInterface::ControlTransferInput(u8 bmRequestType, u8 bmRequ
     u32 transferredSize = 0;
 
     ams::Result rc = usbHsIfCtrlXfer(&m_session, bmRequestType, bmRequest, wValue, wIndex, *wLength, m_usb_buffer, &transferredSize);
+    SwitchUSBCapture::RecordControl(m_session.ID, bmRequestType, bmRequest, wValue, wIndex, *wLength, rc, m_usb_buffer, R_SUCCEEDED(rc) ? transferredSize : 0);
     if (R_SUCCEEDED(rc))
     {
         if (bmRequestType & USB_ENDPOINT_IN)
@@ -112,9 +116,9 @@ ams::Result SwitchUSBInterface::ControlTransferInput(u8 bmRequestType, u8 bmRequ
 
 ams::Result SwitchUSBInterface::ControlTransferOutput(u8 bmRequestType, u8 bmRequest, u16 wValue, u16 wIndex, const void *buffer, u16 wLength)
 {
-    SwitchUSBLock usbLock;
+    std::scoped_lock ifLock(m_mutex);
 
-    ::syscon::logger::LogDebug("SwitchUSBInterface[%04x-%04x] ControlTransferOutput (bmRequestType=0x%02X, bmRequest=0x%02X, wValue=0x%04X, wIndex=0x%04X, wLength=%d)...", m_interface.device_desc.idVendor, m_interface.device_desc.idProduct, bmRequestType, bmRequest, wValue, wIndex, wLength);
+    SYSCON_LOG_DEBUG(LOG_MODULE_USB, "SwitchUSBInterface[%04x-%04x] ControlTransferOutput (bmRequestType=0x%02X, bmRequest=0x%02X, wValue=0x%04X, wIndex=0x%04X, wLength=%d)...", m_interface.device_desc.idVendor, m_interface.device_desc.idProduct, bmRequestType, bmRequest, wValue, wIndex, wLength);
 
     u32 transferredSize = 0;
 
@@ -127,7 +131,9 @@ ams::Result SwitchUSBInterface::ControlTransferOutput(u8 bmRequestType, u8 bmReq
     if (buffer != NULL && wLength > 0)
         memcpy(m_usb_buffer, buffer, wLength);
 
-    R_TRY(usbHsIfCtrlXfer(&m_session, bmRequestType, bmRequest, wValue, wIndex, wLength, m_usb_buffer, &transferredSize));
+    ams::Result rc = usbHsIfCtrlXfer(&m_session, bmRequestType, bmRequest, wValue, wIndex, wLength, m_usb_buffer, &transferredSize);
+    SwitchUSBCapture::RecordControl(m_session.ID, bmRequestType, bmRequest, wValue, wIndex, wLength, rc, m_usb_buffer, wLength);
+    R_TRY(rc);
 
     R_SUCCEED();
 }
@@ -146,8 +152,9 @@ IUSBEndpoint *SwitchUSBInterface::GetEndpoint(IUSBEndpoint::Direction direction,
 ams::Result SwitchUSBInterface::Reset()
 {
     SwitchUSBLock usbLock;
+    std::scoped_lock ifLock(m_mutex);
 
-    ::syscon::logger::LogDebug("SwitchUSBInterface[%04x-%04x] Reset...", m_interface.device_desc.idVendor, m_interface.device_desc.idProduct);
+    SYSCON_LOG_DEBUG(LOG_MODULE_USB, "SwitchUSBInterface[%04x-%04x] Reset...", m_interface.device_desc.idVendor, m_interface.device_desc.idProduct);
 
     usbHsIfResetDevice(&m_session);
 
@@ -11,6 +11,9 @@ class IUSBEndpoint;
 class SwitchUSBInterface : public IUSBInterface
 {
 private:
+    // Serialize the control transfers of this interface only (See SwitchUSBLock)
+    ams::os::Mutex m_mutex{false};
+
     UsbHsClientIfSession m_session;
     UsbHsInterface m_interface;
     std::unique_ptr<IUSBEndpoint> m_inEndpoints[SWITCH_USB_MAX_ENDPOINTS];
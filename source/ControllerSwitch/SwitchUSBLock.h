@@ -1,9 +1,12 @@
 #pragma once
 
 //This lock is a global lock for the whole application
-//Everytime you call an api usbHsXXXX, you have to create this lock.
-//For unknown reason, usbHsxxxx APIs cannot be called in parallel, they have to be called one by one.
-//Make sure to create this object everytime you call usbHsxxx API
+//Everytime you call an api usbHsXXXX on the usb:hs service, you have to create this lock.
+//For unknown reason, these APIs cannot be called in parallel, they have to be called one by one.
+//Make sure to create this object everytime you call usbHsxxx API that opens, closes, queries or acquires an interface/endpoint.
+//Transfers on an opened session (usbHsEpXXX, usbHsIfCtrlXfer) only take the lock of their session
+//(SwitchUSBEndpoint / SwitchUSBInterface), so that controllers don't wait for each other.
+//Lock order: SwitchUSBLock first, then the lock of the session.
 
 class SwitchUSBLock
 {
@@ -0,0 +1,115 @@
+#include "SwitchUSBOutput.h"
+#include "SwitchUSBEndpoint.h"
+#include "SwitchLogger.h"
+#include <algorithm>
+#include <atomic>
+#include <new>
+#include <vector>
+
+bool SwitchUSBOutput::s_enabled = false;
+
+namespace
+{
+    struct alignas(ams::os::ThreadStackAlignment) OutputStack
+    {
+        u8 data[0x2000];
+    };
+
+    std::unique_ptr<OutputStack> g_stack;
+    Thread g_thread;
+    UEvent g_wakeEvent;
+    ams::os::SdkMutex g_mutex;
+    std::vector<SwitchUSBEndpoint *> g_endpoints;
+    std::atomic<bool> g_running = false;
+} // namespace
+
+void SwitchUSBOutput::ThreadFunc(void *arg)
+{
+    (void)arg;
+    Waiter waiters[MAX_WAIT_OBJECTS];
+
+    SYSCON_LOG_DEBUG(LOG_MODULE_USB, "SwitchUSBOutput running ...");
+
+    while (g_running)
+    {
+        s32 count = 0;
+        s32 idx = -1;
+        u64 timeout_ns = UINT64_MAX;
+
+        {
+            std::scoped_lock lock(g_mutex);
+
+            waiters[count++] = waiterForUEvent(&g_wakeEvent);
+
+            // Collect the completed writes, post the next ones whose pacing allows it
+            for (SwitchUSBEndpoint *endpoint : g_endpoints)
+            {
+                u64 wait_ns = UINT64_MAX;
+                if (endpoint->ServiceOutput(&waiters[count], &wait_ns))
+                {
+                    // No room left to wait for its transfer event, check it again in 1 ms
+                    if (count < MAX_WAIT_OBJECTS - 1)
+                        count++;
+                    else
+                        wait_ns = std::min<u64>(wait_ns, 1000000);
+                }
+                timeout_ns = std::min(timeout_ns, wait_ns);
+            }
+        }
+
+        // Whatever woke the thread up, every endpoint is serviced again
+        waitObjects(&idx, waiters, count, timeout_ns);
+    }
+
+    SYSCON_LOG_DEBUG(LOG_MODULE_USB, "SwitchUSBOutput stopped !");
+}
+
+ams::Result SwitchUSBOutput::Initialize()
+{
+    g_stack.reset(new (std::nothrow) OutputStack);
+    if (g_stack == nullptr)
+        R_RETURN(CONTROL_ERR_OUT_OF_MEMORY);
+
+    ueventCreate(&g_wakeEvent, true);
+    g_running = true;
+    R_ABORT_UNLESS(threadCreate(&g_thread, &SwitchUSBOutput::ThreadFunc, NULL, g_stack->data, sizeof(g_stack->data), 0x30, -2));
+    R_ABORT_UNLESS(threadStart(&g_thread));
+
+    s_enabled = true;
+
+    R_SUCCEED();
+}
+
+void SwitchUSBOutput::Exit()
+{
+    if (!s_enabled)
+        return;
+
+    s_enabled = false;
+    g_running = false;
+    ueventSignal(&g_wakeEvent);
+    threadWaitForExit(&g_thread);
+    threadClose(&g_thread);
+    g_stack.reset();
+}
+
+void SwitchUSBOutput::Register(SwitchUSBEndpoint *endpoint)
+{
+    std::scoped_lock lock(g_mutex);
+    g_endpoints.push_back(endpoint);
+}
+
+void SwitchUSBOutput::Unregister(SwitchUSBEndpoint *endpoint)
+{
+    std::scoped_lock lock(g_mutex);
+
+    auto it = std::find(g_endpoints.begin(), g_endpoints.end(), endpoint);
+    if (it != g_endpoints.end())
+        g_endpoints.erase(it);
+}
+
+void SwitchUSBOutput::Signal()
+{
+    if (s_enabled)
+        ueventSignal(&g_wakeEvent);
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include "switch.h"
+#include <stratosphere.hpp>
+
+class SwitchUSBEndpoint;
+
+// USB output thread
+// The writes queued by SwitchUSBEndpoint::QueueWrite (rumble, LED, acknowledgements) are posted asynchronously by a single thread,
+// which also spaces them by bInterval ms on each endpoint: the input loop never waits for an OUT transfer.
+// The thread waits for the transfer events of the endpoints with a write in flight, the next pacing deadline, or a new write.
+// When disabled, QueueWrite is synchronous like Write.
+
+class SwitchUSBOutput
+{
+private:
+    static bool s_enabled;
+
+    static void ThreadFunc(void *arg);
+
+public:
+    static ams::Result Initialize();
+    static void Exit();
+
+    static inline bool IsEnabled() { return s_enabled; }
+
+    // Endpoints are registered for their whole life (See SwitchUSBEndpoint), the endpoint is not used anymore once Unregister() returns
+    static void Register(SwitchUSBEndpoint *endpoint);
+    static void Unregister(SwitchUSBEndpoint *endpoint);
+
+    // A write was queued
+    static void Signal();
+};
@@ -1,9 +1,15 @@
 #include "SwitchVirtualGamepadHandler.h"
+#include "SwitchInputReactor.h"
+#include "SwitchUSBInterface.h"
 #include "SwitchLogger.h"
 
-SwitchVirtualGamepadHandler::SwitchVirtualGamepadHandler(std::unique_ptr<IController> &&controller, s32 polling_frequency_ms)
+// Period of the input loop debug summary
+#define INPUT_STATS_PERIOD_MS 10000
+
+SwitchVirtualGamepadHandler::SwitchVirtualGamepadHandler(std::unique_ptr<IController> &&controller, s32 polling_frequency_ms, SwitchInputMode input_mode)
     : m_controller(std::move(controller)),
-      m_polling_frequency_ms(std::max(1, polling_frequency_ms))
+      m_polling_frequency_ms(std::max(1, polling_frequency_ms)),
+      m_input_mode(input_mode)
 {
 }
 
@@ -16,6 +22,7 @@ ams::Result SwitchVirtualGamepadHandler::Initialize()
     R_TRY(m_controller->Initialize())
 
     m_read_input_timeout_us = (m_polling_frequency_ms * 1000) / m_controller->GetInputCount();
+    m_latencyStartTick = ams::os::GetSystemTick();
 
     R_SUCCEED();
 }
@@ -27,30 +34,240 @@ void SwitchVirtualGamepadHandler::Exit()
     m_controller->Exit();
 }
 
+void SwitchVirtualGamepadHandler::StartInputLoop()
+{
+    m_inputStats = SwitchInputLoopStats();
+    m_inputStatsTick = ams::os::GetSystemTick();
+    m_inputLoopReadTick = ams::os::GetSystemTick();
+    m_lastReadTick = m_inputLoopReadTick.GetInt64Value();
+}
+
+void SwitchVirtualGamepadHandler::SetPollingFrequency(s32 polling_frequency_ms)
+{
+    m_pendingPollingFrequencyMs = std::max(1, polling_frequency_ms);
+}
+
+void SwitchVirtualGamepadHandler::ApplyPendingConfig()
+{
+    if (m_controller->ApplyPendingConfig())
+        SYSCON_LOG_DEBUG(LOG_MODULE_HDL, "SwitchVirtualGamepadHandler[%04x-%04x] Config reloaded", m_controller->GetDevice()->GetVendor(), m_controller->GetDevice()->GetProduct());
+
+    if (m_pendingPollingFrequencyMs.load(std::memory_order_relaxed) == 0)
+        return;
+
+    s32 polling_frequency_ms = m_pendingPollingFrequencyMs.exchange(0);
+    if (polling_frequency_ms == 0 || polling_frequency_ms == m_polling_frequency_ms)
+        return;
+
+    // The sleep of the thread (Or the wait of the reactor) uses the new period from this iteration
+    m_polling_frequency_ms = polling_frequency_ms;
+    m_read_input_timeout_us = (m_polling_frequency_ms * 1000) / m_controller->GetInputCount();
+    SYSCON_LOG_DEBUG(LOG_MODULE_HDL, "SwitchVirtualGamepadHandler[%04x-%04x] Polling frequency: %d ms", m_controller->GetDevice()->GetVendor(), m_controller->GetDevice()->GetProduct(), (int)m_polling_frequency_ms);
+}
+
+ams::Result SwitchVirtualGamepadHandler::RunInputLoopOnce(s32 timeout_us)
+{
+    ApplyPendingConfig();
+
+    ams::os::Tick startTick = ams::os::GetSystemTick();
+    u64 blind_us = ams::os::ConvertToTimeSpan(startTick - m_inputLoopReadTick).GetMicroSeconds();
+
+    ams::Result rc = UpdateInput(timeout_us);
+    ams::os::Tick readTick = ams::os::GetSystemTick();
+    u64 gap_us = ams::os::ConvertToTimeSpan(readTick - m_inputLoopReadTick).GetMicroSeconds();
+    m_inputLoopReadTick = readTick;
+
+    m_lastReadTick = readTick.GetInt64Value();
+    if (gap_us > m_inputGapUsMax)
+        m_inputGapUsMax = gap_us;
+
+    UpdateOutput();
+
+    m_inputStats.iterations++;
+    m_inputStats.blind_us_total += blind_us;
+    m_inputStats.blind_us_max = std::max(m_inputStats.blind_us_max, blind_us);
+    m_inputStats.gap_us_max = std::max(m_inputStats.gap_us_max, gap_us);
+    if (R_SUCCEEDED(rc))
+    {
+        u64 process_us = ams::os::ConvertToTimeSpan(ams::os::GetSystemTick() - readTick).GetMicroSeconds();
+        m_inputStats.reports++;
+        m_inputStats.process_us_total += process_us;
+        m_inputStats.process_us_max = std::max(m_inputStats.process_us_max, process_us);
+    }
+
+    if (ams::os::ConvertToTimeSpan(ams::os::GetSystemTick() - m_inputStatsTick).GetMilliSeconds() >= INPUT_STATS_PERIOD_MS)
+        LogInputLoopStats();
+
+    R_RETURN(rc);
+}
+
 void SwitchVirtualGamepadHandler::onRun()
 {
-    ::syscon::logger::LogDebug("SwitchVirtualGamepadHandler InputThread running ...");
+    SYSCON_LOG_DEBUG(LOG_MODULE_HDL, "SwitchVirtualGamepadHandler InputThread running (Mode: %s) ...", m_input_mode == SwitchInputMode_Event ? "event" : "polling");
+
+    StartInputLoop();
 
     do
     {
-        ams::TimeSpan startTimer = ams::os::ConvertToTimeSpan(ams::os::GetSystemTick());
+        ams::os::Tick startTick = ams::os::GetSystemTick();
 
-        UpdateInput(m_read_input_timeout_us);
-        UpdateOutput();
+        ams::Result rc = RunInputLoopOnce(m_read_input_timeout_us);
 
-        s64 execution_time_us = (ams::os::ConvertToTimeSpan(ams::os::GetSystemTick()) - startTimer).GetMicroSeconds();
+        s64 execution_time_us = ams::os::ConvertToTimeSpan(ams::os::GetSystemTick() - startTick).GetMicroSeconds();
 
         /*
         if ((execution_time_us - m_read_input_timeout_us) > 1000)
             ::syscon::logger::LogError("SwitchVirtualGamepadHandler UpdateInputOutput took: %d us !", execution_time_us);
         */
 
+        // Event mode: read again immediately after a report, the transfer is re-posted right away.
+        // The remaining of the period is only waited when the read failed early (i.e: error, unexpected packet) to not spin on a broken device.
+        if (m_input_mode == SwitchInputMode_Event && R_SUCCEEDED(rc))
+            continue;
+
         if (execution_time_us < m_read_input_timeout_us)
             svcSleepThread((m_read_input_timeout_us - execution_time_us) * 1000);
 
     } while (m_ThreadIsRunning);
 
-    ::syscon::logger::LogDebug("SwitchVirtualGamepadHandler InputThread stopped !");
+    SYSCON_LOG_DEBUG(LOG_MODULE_HDL, "SwitchVirtualGamepadHandler InputThread stopped !");
+}
+
+size_t SwitchVirtualGamepadHandler::GetInputWaiters(Waiter *waiters, SwitchUSBEndpoint **endpoints, size_t maxWaiters)
+{
+    size_t count = 0;
+
+    for (auto &&interface : m_controller->GetDevice()->GetInterfaces())
+    {
+        for (uint8_t i = 0; i < SWITCH_USB_MAX_ENDPOINTS && count < maxWaiters; i++)
+        {
+            SwitchUSBEndpoint *endpoint = static_cast<SwitchUSBEndpoint *>(interface->GetEndpoint(IUSBEndpoint::USB_ENDPOINT_IN, i));
+            if (endpoint != NULL && endpoint->ArmInTransfers(&waiters[count]))
+                endpoints[count++] = endpoint;
+        }
+    }
+
+    return count;
+}
+
+void SwitchVirtualGamepadHandler::RecordDecodeLatency(uint16_t input_idx, ams::os::Tick decodedTick)
+{
+    SwitchInputLatency *latency = &m_latency[input_idx];
+    s64 completedTick = 0;
+
+    // The endpoint which returned the report is the one with the latest completion
+    for (auto &&interface : m_controller->GetDevice()->GetInterfaces())
+    {
+        for (uint8_t i = 0; i < SWITCH_USB_MAX_ENDPOINTS; i++)
+        {
+            SwitchUSBEndpoint *endpoint = static_cast<SwitchUSBEndpoint *>(interface->GetEndpoint(IUSBEndpoint::USB_ENDPOINT_IN, i));
+            if (endpoint != NULL)
+                completedTick = std::max(completedTick, endpoint->TakeLastCompletionTick().GetInt64Value());
+        }
+    }
+
+    // The transfer completed while nobody was waiting for it (Polling mode): its USB -> decode latency can't be measured
+    if (completedTick == 0)
+    {
+        latency->usbToDecodeUnmeasured++;
+        return;
+    }
+
+    latency->usbToDecode.Record(ams::os::ConvertToTimeSpan(decodedTick - ams::os::Tick(completedTick)).GetMicroSeconds());
+
+    if (latency->lastCompletionTick.GetInt64Value() != 0)
+        latency->interArrival.Record(ams::os::ConvertToTimeSpan(ams::os::Tick(completedTick) - latency->lastCompletionTick).GetMicroSeconds());
+    latency->lastCompletionTick = ams::os::Tick(completedTick);
+}
+
+void SwitchVirtualGamepadHandler::FormatLatency(std::string *out) const
+{
+    char line[512];
+
+    snprintf(line, sizeof(line), "Controller[%04x-%04x] %s, polling %d ms, plugged for %d s\n", m_controller->GetDevice()->GetVendor(), m_controller->GetDevice()->GetProduct(),
+             m_input_mode == SwitchInputMode_Event ? "event" : "polling", (int)m_polling_frequency_ms, (int)ams::os::ConvertToTimeSpan(ams::os::GetSystemTick() - m_latencyStartTick).GetSeconds());
+    out->append(line);
+
+    for (uint16_t input_idx = 0; input_idx < m_controller->GetInputCount() && input_idx < CONTROLLER_MAX_INPUTS; input_idx++)
+    {
+        const SwitchInputLatency *latency = &m_latency[input_idx];
+        const struct
+        {
+            const char *name;
+            const LatencyHistogram *histogram;
+        } histograms[] = {
+            {"usb->decode", &latency->usbToDecode},
+            {"decode->hdl", &latency->decodeToHdl},
+            {"inter-arrival", &latency->interArrival},
+        };
+
+        for (auto &&histogram : histograms)
+        {
+            size_t length = snprintf(line, sizeof(line), "  input %d %-14s ", input_idx, histogram.name);
+            histogram.histogram->Format(line + length, sizeof(line) - length - 1);
+            out->append(line);
+            out->append("\n");
+        }
+
+        snprintf(line, sizeof(line), "  input %d %-14s %llu reports (Completed while not waited for, i.e: polling mode)\n", input_idx, "unmeasured", (unsigned long long)latency->usbToDecodeUnmeasured);
+        out->append(line);
+    }
+}
+
+void SwitchVirtualGamepadHandler::LogInputLoopStats()
+{
+    s64 elapsed_ms = std::max<s64>(1, ams::os::ConvertToTimeSpan(ams::os::GetSystemTick() - m_inputStatsTick).GetMilliSeconds());
+    u64 iterations = std::max<u64>(1, m_inputStats.iterations);
+    u64 reports = std::max<u64>(1, m_inputStats.reports);
+
+    SYSCON_LOG_DEBUG(LOG_MODULE_HDL, "SwitchVirtualGamepadHandler[%04x-%04x] Input loop (%s): %d reports/s, blind avg %d us max %d us, process avg %d us max %d us, gap max %d us",
+                               m_controller->GetDevice()->GetVendor(), m_controller->GetDevice()->GetProduct(), m_input_mode == SwitchInputMode_Event ? "event" : "polling",
+                               (int)(m_inputStats.reports * 1000 / elapsed_ms), (int)(m_inputStats.blind_us_total / iterations), (int)m_inputStats.blind_us_max,
+                               (int)(m_inputStats.process_us_total / reports), (int)m_inputStats.process_us_max, (int)m_inputStats.gap_us_max);
+
+    // Output queues of the controller, since it was opened
+    IUSBEndpoint::OutputStats output;
+    for (auto &&interface : m_controller->GetDevice()->GetInterfaces())
+    {
+        for (uint8_t i = 0; i < SWITCH_USB_MAX_ENDPOINTS; i++)
+        {
+            IUSBEndpoint *endpoint = interface->GetEndpoint(IUSBEndpoint::USB_ENDPOINT_OUT, i);
+            if (endpoint == NULL)
+                continue;
+
+            const IUSBEndpoint::OutputStats &stats = endpoint->GetOutputStats();
+            output.queued += stats.queued;
+            output.sent += stats.sent;
+            output.coalesced += stats.coalesced;
+            output.dropped += stats.dropped;
+            output.depth += stats.depth;
+            output.depthMax = std::max(output.depthMax, stats.depthMax);
+            output.latencyTotal_us += stats.latencyTotal_us;
+            output.latencyMax_us = std::max(output.latencyMax_us, stats.latencyMax_us);
+        }
+    }
+
+    if (output.queued > 0)
+        SYSCON_LOG_DEBUG(LOG_MODULE_HDL, "SwitchVirtualGamepadHandler[%04x-%04x] Output: %d queued, %d sent, %d coalesced, %d dropped, depth %d max %d, latency avg %d us max %d us",
+                                   m_controller->GetDevice()->GetVendor(), m_controller->GetDevice()->GetProduct(), (int)output.queued, (int)output.sent, (int)output.coalesced,
+                                   (int)output.dropped, (int)output.depth, (int)output.depthMax, (int)(output.latencyTotal_us / std::max<u64>(1, output.sent)), (int)output.latencyMax_us);
+
+    m_inputStats = SwitchInputLoopStats();
+    m_inputStatsTick = ams::os::GetSystemTick();
+}
+
+void SwitchVirtualGamepadHandler::ResetInputGap()
+{
+    m_inputGapUsMax = 0;
+}
+
+u64 SwitchVirtualGamepadHandler::GetInputGap() const
+{
+    if (m_lastReadTick == 0)
+        return m_inputGapUsMax;
+
+    u64 gap_us = ams::os::ConvertToTimeSpan(ams::os::GetSystemTick() - ams::os::Tick(m_lastReadTick)).GetMicroSeconds();
+    return std::max<u64>(m_inputGapUsMax, gap_us);
 }
 
 void SwitchVirtualGamepadHandlerThreadFunc(void *handler)
@@ -60,18 +277,42 @@ void SwitchVirtualGamepadHandlerThreadFunc(void *handler)
 
 ams::Result SwitchVirtualGamepadHandler::InitThread()
 {
+    // Reactor mode: the input is serviced by the shared reactor threads, no thread (nor stack) for this handler
+    if (SwitchInputReactor::IsEnabled())
+    {
+        StartInputLoop();
+        R_TRY(SwitchInputReactor::Register(this));
+        m_reactorRegistered = true;
+        R_SUCCEED();
+    }
+
+    m_threadStack.reset(new (std::nothrow) ThreadStack);
+    if (m_threadStack == nullptr)
+        R_RETURN(CONTROL_ERR_OUT_OF_MEMORY);
+
     m_ThreadIsRunning = true;
-    R_ABORT_UNLESS(threadCreate(&m_Thread, &SwitchVirtualGamepadHandlerThreadFunc, this, thread_stack, sizeof(thread_stack), 0x30, -2));
+    R_ABORT_UNLESS(threadCreate(&m_Thread, &SwitchVirtualGamepadHandlerThreadFunc, this, m_threadStack->data, sizeof(m_threadStack->data), 0x30, -2));
     R_ABORT_UNLESS(threadStart(&m_Thread));
     return 0;
 }
 
 void SwitchVirtualGamepadHandler::ExitThread()
 {
+    if (m_reactorRegistered)
+    {
+        SwitchInputReactor::Unregister(this);
+        m_reactorRegistered = false;
+        return;
+    }
+
+    if (!m_ThreadIsRunning)
+        return;
+
     m_ThreadIsRunning = false;
     svcCancelSynchronization(m_Thread.handle);
     threadWaitForExit(&m_Thread);
     threadClose(&m_Thread);
+    m_threadStack.reset();
 }
 
 void SwitchVirtualGamepadHandler::ConvertAxisToSwitchAxis(float x, float y, s32 *x_out, s32 *y_out)
@@ -1,26 +1,104 @@
 #pragma once
 #include "switch.h"
 #include "IController.h"
+#include "LatencyHistogram.h"
 #include <stratosphere.hpp>
+#include <atomic>
+#include <string>
+
+class SwitchUSBEndpoint;
+
+// How the input thread is paced
+//  - Polling: every input is read once per polling period, the thread sleeps for the rest of the period
+//  - Event: the thread is woken up by the transfer completion and processes each report as soon as it lands,
+//           the polling period is only an upper bound (keep-alive, output) when the controller doesn't send anything
+enum SwitchInputMode
+{
+    SwitchInputMode_Polling = 0,
+    SwitchInputMode_Event = 1,
+};
+
+// Input thread statistics, logged periodically (Debug) to compare the input modes
+// The "blind" time is the time between two reads, a report which lands during this time waits until the next read
+// The "gap" is the time between the end of two reads, it grows when the read itself is blocked (i.e: USB lock)
+struct SwitchInputLoopStats
+{
+    u64 iterations = 0;
+    u64 reports = 0;
+    u64 blind_us_total = 0;
+    u64 blind_us_max = 0;
+    u64 process_us_total = 0;
+    u64 process_us_max = 0;
+    u64 gap_us_max = 0;
+};
+
+// Latency histograms of one input since the controller was plugged, written to the SD card by syscon::latency
+struct SwitchInputLatency
+{
+    LatencyHistogram usbToDecode;  // USB transfer completed -> report decoded (ReadInput returned)
+    LatencyHistogram decodeToHdl;  // Report decoded -> state given to HID (hiddbgSetHdlsState returned)
+    LatencyHistogram interArrival; // Between the USB completions of two reports
+    u64 usbToDecodeUnmeasured = 0; // Reports whose USB completion time is unknown, in none of the histograms
+    ams::os::Tick lastCompletionTick;
+};
 
 // This class is a base class for SwitchHDLHandler and SwitchAbstractedPaadHandler.
 class SwitchVirtualGamepadHandler
 {
     friend void SwitchVirtualGamepadHandlerThreadFunc(void *arg);
+    friend class SwitchInputReactor;
+
+private:
+    struct alignas(ams::os::ThreadStackAlignment) ThreadStack
+    {
+        u8 data[0x1000];
+    };
 
 protected:
     std::unique_ptr<IController> m_controller;
     s32 m_polling_frequency_ms;
     s32 m_read_input_timeout_us;
+    SwitchInputMode m_input_mode;
+
+    // Polling period given by SetPollingFrequency, not yet applied by the input thread (0: none)
+    std::atomic<s32> m_pendingPollingFrequencyMs{0};
+
+    SwitchInputLoopStats m_inputStats;
+    ams::os::Tick m_inputStatsTick;
 
-    alignas(ams::os::ThreadStackAlignment) u8 thread_stack[0x1000];
+    // Worst input gap since ResetInputGap(), read by another thread (See GetInputGap)
+    std::atomic<s64> m_lastReadTick{0};
+    std::atomic<u64> m_inputGapUsMax{0};
+
+    // Only allocated when the handler has its own input thread (Not in reactor mode)
+    std::unique_ptr<ThreadStack> m_threadStack;
     Thread m_Thread;
     bool m_ThreadIsRunning = false;
+    bool m_reactorRegistered = false;
+
+    ams::os::Tick m_inputLoopReadTick;
+    ams::os::Tick m_reactorRunTick;
+
+    // Written by the input thread only, read by FormatLatency from another thread
+    SwitchInputLatency m_latency[CONTROLLER_MAX_INPUTS];
+    ams::os::Tick m_latencyStartTick;
 
     void onRun();
+    void StartInputLoop();
+    // One iteration of the input loop: UpdateInput, UpdateOutput and statistics
+    ams::Result RunInputLoopOnce(s32 timeout_us);
+    void LogInputLoopStats();
+    // Input thread: apply the config and the polling period changed while running (See SetPollingFrequency, IController::SetConfig)
+    void ApplyPendingConfig();
+
+    // Reactor mode: post the IN transfers of the controller and get the events signaled when they complete
+    size_t GetInputWaiters(Waiter *waiters, SwitchUSBEndpoint **endpoints, size_t maxWaiters);
+
+    // Called once a report was decoded: record its USB completion -> decode latency and the time since the previous report
+    void RecordDecodeLatency(uint16_t input_idx, ams::os::Tick decodedTick);
 
 public:
-    SwitchVirtualGamepadHandler(std::unique_ptr<IController> &&controller, s32 polling_frequency_ms);
+    SwitchVirtualGamepadHandler(std::unique_ptr<IController> &&controller, s32 polling_frequency_ms, SwitchInputMode input_mode);
     virtual ~SwitchVirtualGamepadHandler();
 
     // Override this if you want a custom init procedure
@@ -28,18 +106,30 @@ public:
     // Override this if you want a custom exit procedure
     virtual void Exit();
 
-    // Separately init the input-reading thread
+    // Separately init the input-reading thread (Or register the handler to SwitchInputReactor when enabled)
     ams::Result InitThread();
     // Separately close the input-reading thread
     void ExitThread();
 
-    // The function to call indefinitely by the input thread
-    virtual void UpdateInput(s32 timeout_us) = 0;
+    // The function to call indefinitely by the input thread, return a failure if no report was processed
+    virtual ams::Result UpdateInput(s32 timeout_us) = 0;
     // The function to call indefinitely by the output thread
     virtual void UpdateOutput() = 0;
 
     void ConvertAxisToSwitchAxis(float x, float y, s32 *x_out, s32 *y_out);
 
+    // Change the polling period of a controller running, from any thread: applied by the input thread before its next read
+    void SetPollingFrequency(s32 polling_frequency_ms);
+
     // Get the raw controller pointer
     inline IController *GetController() { return m_controller.get(); }
+
+    inline const SwitchInputLoopStats &GetInputLoopStats() const { return m_inputStats; }
+
+    // Worst time between two reads since the last reset, including the read in progress (i.e: while another controller is initialized)
+    void ResetInputGap();
+    u64 GetInputGap() const;
+
+    // Append the latency histograms of every input (text, one line per histogram)
+    void FormatLatency(std::string *out) const;
 };
\ No newline at end of file
@@ -2,16 +2,44 @@
 #include "config_handler.h"
 #include "Controllers.h"
 #include "ControllerConfig.h"
+#include "ConfigStore.h"
 #include "logger.h"
+#include <algorithm>
 #include <cstring>
 #include <cstdlib>
 #include <stratosphere.hpp>
-#include <stratosphere/util/util_ini.hpp>
+
+// Resolved controller configs kept in memory (Oldest dropped first), until a section they depend on changes in config.ini
+#define CONFIG_CACHE_MAX_ENTRIES 32
 
 namespace syscon::config
 {
     namespace
     {
+        // config.ini parsed once (See ConfigStore.h), parsed again when its size or modification time changes
+        struct ConfigFileStamp
+        {
+            s64 size;
+            s64 modify;
+        };
+
+        struct CachedControllerConfig
+        {
+            uint16_t vendor_id;
+            uint16_t product_id;
+            ControllerConfig config;
+        };
+
+        ams::os::Mutex configMutex(false);
+        ConfigStore configStore;
+        ConfigFileStamp configStamp = {0, 0};
+        bool configLoaded = false;
+        std::vector<CachedControllerConfig> controllerConfigCache;
+        // Sections changed since the last ReloadConfig (The file can be parsed again by a controller connection in between),
+        // then the ones of the last ReloadConfig
+        std::vector<std::string> pendingChangedSections;
+        std::vector<std::string> reloadChangedSections;
+
         // Utils function
         std::string convertToLowercase(const std::string &str)
         {
@@ -21,29 +49,6 @@ namespace syscon::config
             return result;
         }
 
-        class ConfigINIData
-        {
-        public:
-            std::string ini_section;
-            ControllerConfig *controller_config;
-            GlobalConfig *global_config;
-            bool ini_section_found;
-
-            ConfigINIData(const std::string &ini_section_str, ControllerConfig *config) : ini_section(convertToLowercase(ini_section_str)),
-                                                                                          controller_config(config),
-                                                                                          global_config(NULL),
-                                                                                          ini_section_found(false)
-            {
-            }
-
-            ConfigINIData(const std::string &ini_section_str, GlobalConfig *config) : ini_section(convertToLowercase(ini_section_str)),
-                                                                                      controller_config(NULL),
-                                                                                      global_config(config),
-                                                                                      ini_section_found(false)
-            {
-            }
-        };
-
         ControllerButton keyStrToButton(const char *name)
         {
             std::string nameStr = convertToLowercase(name);
@@ -184,106 +189,163 @@ namespace syscon::config
             return analogCfg;
         }
 
-        int ParseGlobalConfigLine(void *data, const char *section, const char *name, const char *value)
+        void ApplyGlobalConfigEntry(GlobalConfig *config, const std::string &nameStr, const char *value)
         {
-            ConfigINIData *ini_data = static_cast<ConfigINIData *>(data);
-            std::string sectionStr = convertToLowercase(section);
-            std::string nameStr = convertToLowercase(name);
-
-            if (ini_data->ini_section != sectionStr)
-                return 1; // Not the section we are looking for (return success to continue parsing)
-
-            ini_data->ini_section_found = true;
-
             if (nameStr == "polling_frequency_ms")
-                ini_data->global_config->polling_frequency_ms = atoi(value);
+                config->polling_frequency_ms = atoi(value);
+            else if (nameStr == "input_mode")
+                config->input_mode = atoi(value);
+            else if (nameStr == "hdl_keepalive_ms")
+                config->hdl_keepalive_ms = atoi(value);
+            else if (nameStr == "hdl_stick_deadband")
+                config->hdl_stick_deadband = atoi(value);
+            else if (nameStr == "usb_in_transfers")
+                config->usb_in_transfers = atoi(value);
+            else if (nameStr == "input_threads")
+                config->input_threads = atoi(value);
+            else if (nameStr == "latency_dump_s")
+                config->latency_dump_s = atoi(value);
             else if (nameStr == "log_level")
-                ini_data->global_config->log_level = atoi(value);
+                config->log_level = atoi(value);
+            else if (nameStr == "log_level_usb")
+                config->log_level_usb = atoi(value);
+            else if (nameStr == "log_level_hdl")
+                config->log_level_hdl = atoi(value);
+            else if (nameStr == "log_level_driver")
+                config->log_level_driver = atoi(value);
+            else if (nameStr == "log_level_config")
+                config->log_level_config = atoi(value);
+            else if (nameStr == "log_sample")
+                config->log_sample = atoi(value);
+            else if (nameStr == "log_rate_limit")
+                config->log_rate_limit = atoi(value);
+            else if (nameStr == "log_binary")
+                config->log_binary = (atoi(value) == 0) ? false : true;
+            else if (nameStr == "log_file_size_kb")
+                config->log_file_size_kb = atoi(value);
+            else if (nameStr == "log_file_count")
+                config->log_file_count = atoi(value);
             else if (nameStr == "discovery_mode")
-                ini_data->global_config->discovery_mode = static_cast<DiscoveryMode>(atoi(value));
+                config->discovery_mode = static_cast<DiscoveryMode>(atoi(value));
             else if (nameStr == "auto_add_controller")
-                ini_data->global_config->auto_add_controller = (atoi(value) == 0) ? false : true;
+                config->auto_add_controller = (atoi(value) == 0) ? false : true;
+            else if (nameStr == "config_reload_ms")
+                config->config_reload_ms = atoi(value);
+            else if (nameStr == "usb_capture_size_kb")
+                config->usb_capture_size_kb = atoi(value);
+            else if (nameStr == "usb_capture_max_file_kb")
+                config->usb_capture_max_file_kb = atoi(value);
             else if (nameStr == "discovery_vidpid")
             {
                 char *tok = strtok(const_cast<char *>(value), ",");
 
                 while (tok != NULL)
                 {
-                    ini_data->global_config->discovery_vidpid.push_back(ControllerVidPid(tok));
+                    config->discovery_vidpid.push_back(ControllerVidPid(tok));
                     tok = strtok(NULL, ",");
                 }
             }
             else
             {
-                syscon::logger::LogError("Unknown key: %s, continue anyway ...", name);
+                syscon::logger::LogError("Unknown key: %s, continue anyway ...", nameStr.c_str());
             }
-
-            return 1; // Success
         }
 
-        int ParseControllerConfigLine(void *data, const char *section, const char *name, const char *value)
+        void ApplyControllerConfigEntry(ControllerConfig *config, const std::string &nameStr, const char *value)
         {
-            ConfigINIData *ini_data = static_cast<ConfigINIData *>(data);
-            std::string sectionStr = convertToLowercase(section);
-            std::string nameStr = convertToLowercase(name);
-
-            // syscon::logger::LogTrace("Parsing controller config line: %s, %s, %s (expect: %s)", section, name, value, ini_data->ini_section.c_str());
-            if (ini_data->ini_section != sectionStr)
-                return 1; // Not the section we are looking for (return success to continue parsing)
-
-            ini_data->ini_section_found = true;
-
             ControllerButton buttonId = keyStrToButton(nameStr.c_str());
             if (buttonId != ControllerButton::NONE)
-                ini_data->controller_config->buttons_pin[buttonId] = atoi(value);
+                config->buttons_pin[buttonId] = atoi(value);
             else if (nameStr == "driver")
-                ini_data->controller_config->driver = convertToLowercase(value);
+                config->driver = convertToLowercase(value);
             else if (nameStr == "profile")
-                ini_data->controller_config->profile = convertToLowercase(value);
+                config->profile = convertToLowercase(value);
             else if (nameStr == "controller_type")
-                ini_data->controller_config->controllerType = DecodeControllerType(value);
+                config->controllerType = DecodeControllerType(value);
             else if (nameStr == "simulate_home")
-                DecodeHotKey(value, ini_data->controller_config->simulateHome);
+                DecodeHotKey(value, config->simulateHome);
             else if (nameStr == "simulate_capture")
-                DecodeHotKey(value, ini_data->controller_config->simulateCapture);
+                DecodeHotKey(value, config->simulateCapture);
             else if (nameStr == "left_stick_x")
-                ini_data->controller_config->stickConfig[0].X = DecodeAnalogConfig(value);
+                config->stickConfig[0].X = DecodeAnalogConfig(value);
             else if (nameStr == "left_stick_y")
-                ini_data->controller_config->stickConfig[0].Y = DecodeAnalogConfig(value);
+                config->stickConfig[0].Y = DecodeAnalogConfig(value);
             else if (nameStr == "right_stick_x")
-                ini_data->controller_config->stickConfig[1].X = DecodeAnalogConfig(value);
+                config->stickConfig[1].X = DecodeAnalogConfig(value);
             else if (nameStr == "right_stick_y")
-                ini_data->controller_config->stickConfig[1].Y = DecodeAnalogConfig(value);
+                config->stickConfig[1].Y = DecodeAnalogConfig(value);
             else if (nameStr == "left_trigger")
-                ini_data->controller_config->triggerConfig[0] = DecodeAnalogConfig(value);
+                config->triggerConfig[0] = DecodeAnalogConfig(value);
             else if (nameStr == "right_trigger")
-                ini_data->controller_config->triggerConfig[1] = DecodeAnalogConfig(value);
+                config->triggerConfig[1] = DecodeAnalogConfig(value);
             else if (nameStr == "left_stick_deadzone")
-                ini_data->controller_config->stickDeadzonePercent[0] = atoi(value);
+                config->stickDeadzonePercent[0] = atoi(value);
             else if (nameStr == "right_stick_deadzone")
-                ini_data->controller_config->stickDeadzonePercent[1] = atoi(value);
+                config->stickDeadzonePercent[1] = atoi(value);
             else if (nameStr == "left_trigger_deadzone")
-                ini_data->controller_config->triggerDeadzonePercent[0] = atoi(value);
+                config->triggerDeadzonePercent[0] = atoi(value);
             else if (nameStr == "right_trigger_deadzone")
-                ini_data->controller_config->triggerDeadzonePercent[1] = atoi(value);
+                config->triggerDeadzonePercent[1] = atoi(value);
             else if (nameStr == "color_body")
-                ini_data->controller_config->bodyColor = DecodeColorValue(value);
+                config->bodyColor = DecodeColorValue(value);
             else if (nameStr == "color_buttons")
-                ini_data->controller_config->buttonsColor = DecodeColorValue(value);
+                config->buttonsColor = DecodeColorValue(value);
             else if (nameStr == "color_leftgrip")
-                ini_data->controller_config->leftGripColor = DecodeColorValue(value);
+                config->leftGripColor = DecodeColorValue(value);
             else if (nameStr == "color_rightgrip")
-                ini_data->controller_config->rightGripColor = DecodeColorValue(value);
+                config->rightGripColor = DecodeColorValue(value);
             else
             {
-                syscon::logger::LogError("Unknown key: %s, continue anyway ...", name);
+                syscon::logger::LogError("Unknown key: %s, continue anyway ...", nameStr.c_str());
             }
-            return 1; // Success
         }
 
-        ams::Result ReadFromConfig(const char *path, ams::util::ini::Handler h, void *config)
+        // The values are copied, some of them are decoded in place (strtok)
+        void ApplyGlobalConfigSection(GlobalConfig *config, const ConfigStore::Section *section)
+        {
+            for (const ConfigStore::Entry &entry : section->entries)
+            {
+                std::string value = entry.value;
+                ApplyGlobalConfigEntry(config, configStore.GetKey(entry.key), value.c_str());
+            }
+        }
+
+        void ApplyControllerConfigSection(ControllerConfig *config, const ConfigStore::Section *section)
+        {
+            for (const ConfigStore::Entry &entry : section->entries)
+            {
+                std::string value = entry.value;
+                ApplyControllerConfigEntry(config, configStore.GetKey(entry.key), value.c_str());
+            }
+        }
+
+        // Parse the file into configStore unless it's unchanged since the last time (Same size and modification time), configMutex held
+        bool IsSectionChanged(const std::vector<std::string> &changedSections, const std::string &name)
+        {
+            return std::find(changedSections.begin(), changedSections.end(), name) != changedSections.end();
+        }
+
+        // True when one of the sections of this controller is in changedSections, resolved from the store parsed last:
+        // a profile= changed is a change of [default] or [vid-pid] itself, so the sections used before are covered too
+        bool IsControllerChanged(const std::vector<std::string> &changedSections, const std::string &controllerSection)
+        {
+            std::string names[ConfigStore::MaxControllerSections];
+            int count = configStore.GetControllerSectionNames(controllerSection, names);
+
+            for (int i = 0; i < count; i++)
+            {
+                if (IsSectionChanged(changedSections, names[i]))
+                    return true;
+            }
+            return false;
+        }
+
+        // force: parse the file even when its size and modification time didn't change (i.e: after writing it)
+        ams::Result LoadConfigStore(const char *path, bool force)
         {
             ams::fs::FileHandle file;
+            ams::fs::FileTimeStampRaw timeStamp = {};
+            ConfigFileStamp stamp = {0, 0};
 
             if (R_FAILED(ams::fs::OpenFile(std::addressof(file), path, ams::fs::OpenMode_Read)))
             {
@@ -292,25 +354,119 @@ namespace syscon::config
             }
             ON_SCOPE_EXIT { ams::fs::CloseFile(file); };
 
-            /* Parse the config. */
-            Result rc = ams::util::ini::ParseFile(file, config, h);
-            if (R_FAILED(rc))
+            R_TRY(ams::fs::GetFileSize(&stamp.size, file));
+
+            // FAT keeps the modification time with a resolution of 2s, the size catches most of the edits in between
+            if (R_SUCCEEDED(ams::fs::GetFileTimeStampRawForDebug(&timeStamp, path)))
+                stamp.modify = timeStamp.modify;
+
+            if (configLoaded && !force && stamp.size == configStamp.size && stamp.modify == configStamp.modify)
+                R_SUCCEED();
+
+            std::vector<char> buffer(stamp.size);
+            if (R_FAILED(ams::fs::ReadFile(file, 0, buffer.data(), buffer.size())))
             {
-                syscon::logger::LogError("Failed to parse configuration file: '%s' !", path);
+                syscon::logger::LogError("Failed to read configuration file: '%s' !", path);
                 return 1;
             }
 
+            ConfigStore previousStore = std::move(configStore);
+            configStore.Parse(buffer.data(), buffer.size());
+            configStamp = stamp;
+
+            if (!configLoaded)
+            {
+                configLoaded = true;
+                controllerConfigCache.clear();
+                SYSCON_LOG_DEBUG(LOG_MODULE_CONFIG, "Configuration file parsed: '%s' (%d sections, %d keys)", path, (int)configStore.GetSectionCount(), (int)configStore.GetKeyCount());
+                R_SUCCEED();
+            }
+
+            // Only the configs depending on a section changed are resolved again
+            std::vector<std::string> changedSections;
+            configStore.GetChangedSections(previousStore, &changedSections);
+
+            for (auto it = controllerConfigCache.begin(); it != controllerConfigCache.end();)
+            {
+                if (IsControllerChanged(changedSections, ControllerVidPid(it->vendor_id, it->product_id)))
+                    it = controllerConfigCache.erase(it);
+                else
+                    ++it;
+            }
+
+            for (const std::string &name : changedSections)
+            {
+                if (!IsSectionChanged(pendingChangedSections, name))
+                    pendingChangedSections.push_back(name);
+            }
+
+            SYSCON_LOG_DEBUG(LOG_MODULE_CONFIG, "Configuration file parsed again: '%s' (%d sections, %d keys, %d sections changed)", path, (int)configStore.GetSectionCount(), (int)configStore.GetKeyCount(), (int)changedSections.size());
+            R_SUCCEED();
+        }
+
+        // Resolve the config of a controller from configStore and cache it
+        ams::Result ResolveControllerConfig(ControllerConfig *config, uint16_t vendor_id, uint16_t product_id)
+        {
+            std::string controllerSection = ControllerVidPid(vendor_id, product_id);
+
+            // [default] overrided by [profile] overrided by [vid-pid] (The profile can be set by [vid-pid] or [default])
+            const ConfigStore::Section *sections[ConfigStore::MaxControllerSections];
+            int sectionCount = configStore.GetControllerSections(controllerSection, sections);
+
+            *config = ControllerConfig();
+            for (int i = 0; i < sectionCount; i++)
+            {
+                SYSCON_LOG_DEBUG(LOG_MODULE_CONFIG, "Loading controller config: '%s' [%s] ...", CONFIG_FULLPATH, sections[i]->name.c_str());
+                ApplyControllerConfigSection(config, sections[i]);
+            }
+
+            for (int i = 0; i < ControllerButton::COUNT; i++)
+            {
+                if (config->buttons_pin[i] >= MAX_CONTROLLER_BUTTONS)
+                {
+                    syscon::logger::LogError("Invalid button pin: %d (Max: %d)", config->buttons_pin[i], MAX_CONTROLLER_BUTTONS);
+                    return 1;
+                }
+            }
+
+            if (config->stickConfig[0].X.bind == ControllerAnalogBinding_Unknown)
+                config->stickConfig[0].X.bind = ControllerAnalogBinding_X;
+            if (config->stickConfig[0].Y.bind == ControllerAnalogBinding_Unknown)
+                config->stickConfig[0].Y.bind = ControllerAnalogBinding_Y;
+            if (config->stickConfig[1].X.bind == ControllerAnalogBinding_Unknown)
+                config->stickConfig[1].X.bind = ControllerAnalogBinding_RZ;
+            if (config->stickConfig[1].Y.bind == ControllerAnalogBinding_Unknown)
+                config->stickConfig[1].Y.bind = ControllerAnalogBinding_Z;
+
+            if (config->triggerConfig[0].bind == ControllerAnalogBinding_Unknown)
+                config->triggerConfig[0].bind = ControllerAnalogBinding_RX;
+            if (config->triggerConfig[1].bind == ControllerAnalogBinding_Unknown)
+                config->triggerConfig[1].bind = ControllerAnalogBinding_RY;
+
+            if (config->buttons_pin[ControllerButton::B] == 0 && config->buttons_pin[ControllerButton::A] == 0 && config->buttons_pin[ControllerButton::Y] == 0 && config->buttons_pin[ControllerButton::X] == 0)
+                syscon::logger::LogError("No buttons configured for this controller [%04x-%04x] - Stick might works but buttons will not work (https://github.com/o0Zz/sys-con/blob/master/doc/Troubleshooting.md)", vendor_id, product_id);
+            else
+                syscon::logger::LogInfo("Controller successfully loaded (B=%d, A=%d, Y=%d, X=%d, ...) !", config->buttons_pin[ControllerButton::B], config->buttons_pin[ControllerButton::A], config->buttons_pin[ControllerButton::Y], config->buttons_pin[ControllerButton::X]);
+
+            if (controllerConfigCache.size() >= CONFIG_CACHE_MAX_ENTRIES)
+                controllerConfigCache.erase(controllerConfigCache.begin());
+            controllerConfigCache.push_back({vendor_id, product_id, *config});
+
             R_SUCCEED();
         }
     } // namespace
 
     ams::Result LoadGlobalConfig(GlobalConfig *config)
     {
-        ConfigINIData cfg("global", config);
+        std::scoped_lock lock(configMutex);
 
-        syscon::logger::LogDebug("Loading global config: '%s' ...", CONFIG_FULLPATH);
+        SYSCON_LOG_DEBUG(LOG_MODULE_CONFIG, "Loading global config: '%s' ...", CONFIG_FULLPATH);
 
-        R_TRY(ReadFromConfig(CONFIG_FULLPATH, ParseGlobalConfigLine, &cfg));
+        R_TRY(LoadConfigStore(CONFIG_FULLPATH, false));
+
+        const ConfigStore::Section *section = configStore.FindSection("global");
+        if (section != NULL)
+            ApplyGlobalConfigSection(config, section);
 
         R_SUCCEED();
     }
@@ -375,66 +531,71 @@ namespace syscon::config
     ams::Result LoadControllerConfig(ControllerConfig *config, uint16_t vendor_id, uint16_t product_id, bool auto_add_controller, const std::string &default_profile)
     {
         ControllerVidPid controllerVidPid(vendor_id, product_id);
-        ConfigINIData cfg_default("default", config);
-        ConfigINIData cfg_controller(controllerVidPid, config);
+        std::string controllerSection = controllerVidPid;
 
-        syscon::logger::LogDebug("Loading controller config: '%s' [default] ...", CONFIG_FULLPATH);
-        R_TRY(ReadFromConfig(CONFIG_FULLPATH, ParseControllerConfigLine, &cfg_default));
+        std::scoped_lock lock(configMutex);
 
-        // Override with vendor specific config
-        syscon::logger::LogDebug("Loading controller config: '%s' [%s] ...", CONFIG_FULLPATH, std::string(controllerVidPid).c_str());
-        R_TRY(ReadFromConfig(CONFIG_FULLPATH, ParseControllerConfigLine, &cfg_controller));
+        R_TRY(LoadConfigStore(CONFIG_FULLPATH, false));
 
-        if (!cfg_controller.ini_section_found && auto_add_controller)
+        for (const CachedControllerConfig &cached : controllerConfigCache)
         {
-            syscon::logger::LogDebug("Controller not found in config file, adding it ...");
-            R_TRY(AddControllerToConfig(CONFIG_FULLPATH, std::string(controllerVidPid), default_profile));
-
-            syscon::logger::LogDebug("Reloading controller config: '%s' [%s] ...", CONFIG_FULLPATH, std::string(controllerVidPid).c_str());
-            R_TRY(ReadFromConfig(CONFIG_FULLPATH, ParseControllerConfigLine, &cfg_controller));
+            if (cached.vendor_id == vendor_id && cached.product_id == product_id)
+            {
+                SYSCON_LOG_DEBUG(LOG_MODULE_CONFIG, "Controller config [%s] already loaded (driver: %s, profile: %s)", controllerSection.c_str(), cached.config.driver.c_str(), cached.config.profile.c_str());
+                *config = cached.config;
+                R_SUCCEED();
+            }
         }
 
-        // Check if have a "profile"
-        if (config->profile.length() > 0)
+        if (configStore.FindSection(controllerSection) == NULL && auto_add_controller)
         {
-            syscon::logger::LogDebug("Loading controller config: '%s' (Profile: [%s]) ... ", CONFIG_FULLPATH, config->profile.c_str());
-            ConfigINIData cfg_profile(config->profile, config);
-            R_TRY(ReadFromConfig(CONFIG_FULLPATH, ParseControllerConfigLine, &cfg_profile));
-
-            // Re-Override with vendor specific config
-            // We are doing this to allow the profile to be overrided by the vendor specific config
-            // In other words we would like to have [default] overrided by [profile] overrided by [vid-pid]
-            R_TRY(ReadFromConfig(CONFIG_FULLPATH, ParseControllerConfigLine, &cfg_controller));
+            SYSCON_LOG_DEBUG(LOG_MODULE_CONFIG, "Controller not found in config file, adding it ...");
+            R_TRY(AddControllerToConfig(CONFIG_FULLPATH, controllerSection, default_profile));
+
+            SYSCON_LOG_DEBUG(LOG_MODULE_CONFIG, "Reloading controller config: '%s' [%s] ...", CONFIG_FULLPATH, controllerSection.c_str());
+            R_TRY(LoadConfigStore(CONFIG_FULLPATH, true));
         }
 
-        for (int i = 0; i < ControllerButton::COUNT; i++)
+        R_RETURN(ResolveControllerConfig(config, vendor_id, product_id));
+    }
+
+    ams::Result ReloadConfig(int *changedSectionCount)
+    {
+        std::scoped_lock lock(configMutex);
+
+        reloadChangedSections.clear();
+        *changedSectionCount = 0;
+
+        R_TRY(LoadConfigStore(CONFIG_FULLPATH, false));
+
+        reloadChangedSections.swap(pendingChangedSections);
+        *changedSectionCount = (int)reloadChangedSections.size();
+        R_SUCCEED();
+    }
+
+    bool IsGlobalConfigChanged()
+    {
+        std::scoped_lock lock(configMutex);
+        return IsSectionChanged(reloadChangedSections, "global");
+    }
+
+    bool ReloadControllerConfig(ControllerConfig *config, uint16_t vendor_id, uint16_t product_id)
+    {
+        std::scoped_lock lock(configMutex);
+
+        if (!IsControllerChanged(reloadChangedSections, ControllerVidPid(vendor_id, product_id)))
+            return false;
+
+        // Several controllers with the same VID/PID: resolved by the first one, cached for the others
+        for (const CachedControllerConfig &cached : controllerConfigCache)
         {
-            if (config->buttons_pin[i] >= MAX_CONTROLLER_BUTTONS)
+            if (cached.vendor_id == vendor_id && cached.product_id == product_id)
             {
-                syscon::logger::LogError("Invalid button pin: %d (Max: %d)", config->buttons_pin[i], MAX_CONTROLLER_BUTTONS);
-                return 1;
+                *config = cached.config;
+                return true;
             }
         }
 
-        if (config->stickConfig[0].X.bind == ControllerAnalogBinding_Unknown)
-            config->stickConfig[0].X.bind = ControllerAnalogBinding_X;
-        if (config->stickConfig[0].Y.bind == ControllerAnalogBinding_Unknown)
-            config->stickConfig[0].Y.bind = ControllerAnalogBinding_Y;
-        if (config->stickConfig[1].X.bind == ControllerAnalogBinding_Unknown)
-            config->stickConfig[1].X.bind = ControllerAnalogBinding_RZ;
-        if (config->stickConfig[1].Y.bind == ControllerAnalogBinding_Unknown)
-            config->stickConfig[1].Y.bind = ControllerAnalogBinding_Z;
-
-        if (config->triggerConfig[0].bind == ControllerAnalogBinding_Unknown)
-            config->triggerConfig[0].bind = ControllerAnalogBinding_RX;
-        if (config->triggerConfig[1].bind == ControllerAnalogBinding_Unknown)
-            config->triggerConfig[1].bind = ControllerAnalogBinding_RY;
-
-        if (config->buttons_pin[ControllerButton::B] == 0 && config->buttons_pin[ControllerButton::A] == 0 && config->buttons_pin[ControllerButton::Y] == 0 && config->buttons_pin[ControllerButton::X] == 0)
-            syscon::logger::LogError("No buttons configured for this controller [%04x-%04x] - Stick might works but buttons will not work (https://github.com/o0Zz/sys-con/blob/master/doc/Troubleshooting.md)", vendor_id, product_id);
-        else
-            syscon::logger::LogInfo("Controller successfully loaded (B=%d, A=%d, Y=%d, X=%d, ...) !", config->buttons_pin[ControllerButton::B], config->buttons_pin[ControllerButton::A], config->buttons_pin[ControllerButton::Y], config->buttons_pin[ControllerButton::X]);
-
-        R_SUCCEED();
+        return R_SUCCEEDED(ResolveControllerConfig(config, vendor_id, product_id));
     }
-} // namespace syscon::config
\ No newline at end of file
+} // namespace syscon::config
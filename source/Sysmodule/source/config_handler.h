@@ -59,14 +59,44 @@ namespace syscon::config
     {
     public:
         uint16_t polling_frequency_ms{0};
+        uint8_t input_mode{0};
+        uint16_t hdl_keepalive_ms{100};
+        uint16_t hdl_stick_deadband{256};
+        uint8_t usb_in_transfers{1};
+        uint8_t input_threads{0};
+        uint16_t latency_dump_s{0};
         int log_level{LOG_LEVEL_INFO};
+        int log_level_usb{-1};
+        int log_level_hdl{-1};
+        int log_level_driver{-1};
+        int log_level_config{-1};
+        uint32_t log_sample{1};
+        uint32_t log_rate_limit{10};
+        bool log_binary{false};
+        uint32_t log_file_size_kb{128};
+        uint8_t log_file_count{2};
         DiscoveryMode discovery_mode{DiscoveryMode::HID_AND_XBOX};
         std::vector<ControllerVidPid> discovery_vidpid;
         bool auto_add_controller{true};
+        uint32_t config_reload_ms{1000};
+        uint32_t usb_capture_size_kb{0};
+        uint32_t usb_capture_max_file_kb{8192};
     };
 
+    // config.ini is parsed once, then again only when its size or modification time changes
     ams::Result LoadGlobalConfig(GlobalConfig *config);
 
+    // config is replaced by the config resolved for this VID/PID, cached until a section it depends on changes in config.ini
     ams::Result LoadControllerConfig(ControllerConfig *config, uint16_t vendor_id, uint16_t product_id, bool auto_add_controller, const std::string &default_profile);
 
+    // Parse config.ini again when its size or modification time changed, *changedSectionCount: sections changed since the previous call (0: nothing to apply).
+    // The controllers plugged are then updated with IsGlobalConfigChanged and ReloadControllerConfig (See syscon::config_reload).
+    ams::Result ReloadConfig(int *changedSectionCount);
+
+    // After ReloadConfig: true when [global] changed
+    bool IsGlobalConfigChanged();
+
+    // After ReloadConfig: true when one of the sections of this controller changed ([default], [profile], [vid-pid]), config is then replaced by its new config
+    bool ReloadControllerConfig(ControllerConfig *config, uint16_t vendor_id, uint16_t product_id);
+
 }; // namespace syscon::config
\ No newline at end of file
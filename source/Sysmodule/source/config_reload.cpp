@@ -0,0 +1,72 @@
+#include "switch.h"
+#include "config_reload.h"
+#include "config_handler.h"
+#include "controller_handler.h"
+#include "logger.h"
+#include <stratosphere.hpp>
+
+namespace syscon::config_reload
+{
+    namespace
+    {
+        u32 reloadPeriod_ms = 0;
+        ams::os::Tick checkTick;
+
+        void ApplyGlobalConfig()
+        {
+            syscon::config::GlobalConfig globalConfig;
+            if (R_FAILED(syscon::config::LoadGlobalConfig(&globalConfig)))
+                return;
+
+            syscon::logger::SetLogLevel(globalConfig.log_level);
+            syscon::logger::SetModuleLogLevel(LOG_MODULE_USB, globalConfig.log_level_usb);
+            syscon::logger::SetModuleLogLevel(LOG_MODULE_HDL, globalConfig.log_level_hdl);
+            syscon::logger::SetModuleLogLevel(LOG_MODULE_DRIVER, globalConfig.log_level_driver);
+            syscon::logger::SetModuleLogLevel(LOG_MODULE_CONFIG, globalConfig.log_level_config);
+            syscon::logger::SetLogLimit(globalConfig.log_sample, globalConfig.log_rate_limit);
+
+            syscon::controllers::SetPollingFrequency(globalConfig.polling_frequency_ms);
+        }
+    } // namespace
+
+    void Initialize(u32 period_ms)
+    {
+        reloadPeriod_ms = period_ms;
+        checkTick = ams::os::GetSystemTick();
+    }
+
+    void Exit()
+    {
+        reloadPeriod_ms = 0;
+    }
+
+    void Process()
+    {
+        if (reloadPeriod_ms == 0)
+            return;
+
+        ams::os::Tick now = ams::os::GetSystemTick();
+        if (ams::os::ConvertToTimeSpan(now - checkTick).GetMilliSeconds() < reloadPeriod_ms)
+            return;
+
+        checkTick = now;
+
+        // Unchanged: one open, one size and one time stamp query
+        int changedSectionCount = 0;
+        if (R_FAILED(syscon::config::ReloadConfig(&changedSectionCount)) || changedSectionCount == 0)
+            return;
+
+        ams::os::Tick parseTick = ams::os::GetSystemTick();
+
+        bool globalChanged = syscon::config::IsGlobalConfigChanged();
+        if (globalChanged)
+            ApplyGlobalConfig();
+
+        int controllerCount = syscon::controllers::ReloadConfig();
+
+        ams::os::Tick endTick = ams::os::GetSystemTick();
+        syscon::logger::LogInfo("Configuration reloaded in %d us (parse: %d us, apply: %d us), %d sections changed%s, %d controllers updated",
+                        (int)ams::os::ConvertToTimeSpan(endTick - now).GetMicroSeconds(), (int)ams::os::ConvertToTimeSpan(parseTick - now).GetMicroSeconds(),
+                        (int)ams::os::ConvertToTimeSpan(endTick - parseTick).GetMicroSeconds(), changedSectionCount, globalChanged ? " (global included)" : "", controllerCount);
+    }
+} // namespace syscon::config_reload
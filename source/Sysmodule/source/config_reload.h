@@ -0,0 +1,14 @@
+#pragma once
+#include "switch.h"
+
+namespace syscon::config_reload
+{
+    // config.ini is checked every period_ms (0: never) by its size and modification time, when it changed:
+    //  - the sections changed are applied to the controllers plugged which depend on them (See config::ReloadControllerConfig)
+    //  - [global]: polling_frequency_ms, the log levels and the log limit are applied, the other settings still need a reboot
+    void Initialize(u32 period_ms);
+    void Exit();
+
+    // Called periodically by the main loop
+    void Process();
+} // namespace syscon::config_reload
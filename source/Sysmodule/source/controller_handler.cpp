@@ -1,5 +1,6 @@
 #include "switch.h"
 #include "controller_handler.h"
+#include "config_handler.h"
 #include "SwitchHDLHandler.h"
 #include "SwitchUSBInterface.h"
 #include <algorithm>
@@ -13,8 +14,13 @@ namespace syscon::controllers
     {
         constexpr size_t MaxControllerHandlersSize = 10;
         std::vector<std::unique_ptr<SwitchVirtualGamepadHandler>> controllerHandlers;
+        // Config last given to each handler (Same index), the live one of the controller belongs to its input thread
+        std::vector<ControllerConfig> controllerConfigs;
         ams::os::Mutex controllerMutex(false);
         int polling_frequency_ms = 0;
+        SwitchInputMode input_mode = SwitchInputMode_Polling;
+        int hdl_keepalive_ms = 0;
+        int hdl_stick_deadband = 0;
     } // namespace
 
     bool IsAtControllerLimit()
@@ -25,15 +31,37 @@ namespace syscon::controllers
 
     ams::Result Insert(std::unique_ptr<IController> &&controllerPtr)
     {
-        std::unique_ptr<SwitchVirtualGamepadHandler> switchHandler = std::make_unique<SwitchHDLHandler>(std::move(controllerPtr), polling_frequency_ms);
+        // The input thread isn't started yet, the config can still be read from here
+        ControllerConfig config = controllerPtr->GetConfig();
+        std::unique_ptr<SwitchVirtualGamepadHandler> switchHandler = std::make_unique<SwitchHDLHandler>(std::move(controllerPtr), polling_frequency_ms, input_mode, hdl_keepalive_ms, hdl_stick_deadband);
 
+        // Measure how much the controllers already running are disturbed by the bring-up of this one
+        {
+            std::scoped_lock scoped_lock(controllerMutex);
+            for (auto &&handler : controllerHandlers)
+                handler->ResetInputGap();
+        }
+
+        ams::os::Tick bringupTick = ams::os::GetSystemTick();
         ams::Result rc = switchHandler->Initialize();
+        s64 bringup_ms = ams::os::ConvertToTimeSpan(ams::os::GetSystemTick() - bringupTick).GetMilliSeconds();
+
+        {
+            std::scoped_lock scoped_lock(controllerMutex);
+            u64 worst_gap_us = 0;
+            for (auto &&handler : controllerHandlers)
+                worst_gap_us = std::max(worst_gap_us, handler->GetInputGap());
+
+            SYSCON_LOG_DEBUG(LOG_MODULE_HDL, "Controller[%04x-%04x] bring-up took %d ms (Worst input gap of the %d other controllers: %d us)", switchHandler->GetController()->GetDevice()->GetVendor(), switchHandler->GetController()->GetDevice()->GetProduct(), (int)bringup_ms, (int)controllerHandlers.size(), (int)worst_gap_us);
+        }
+
         if (R_SUCCEEDED(rc))
         {
             syscon::logger::LogInfo("Controller[%04x-%04x] plugged !", switchHandler->GetController()->GetDevice()->GetVendor(), switchHandler->GetController()->GetDevice()->GetProduct());
 
             std::scoped_lock scoped_lock(controllerMutex);
             controllerHandlers.push_back(std::move(switchHandler));
+            controllerConfigs.push_back(std::move(config));
         }
         else
         {
@@ -46,8 +74,9 @@ namespace syscon::controllers
     void RemoveIfNotPlugged(std::vector<s32> interfaceIDsPlugged)
     {
         std::scoped_lock scoped_lock(controllerMutex);
-        for (auto it = controllerHandlers.begin(); it != controllerHandlers.end(); it++)
+        for (size_t index = 0; index < controllerHandlers.size(); index++)
         {
+            auto it = controllerHandlers.begin() + index;
             bool found = false;
 
             for (auto &&ptr : (*it)->GetController()->GetDevice()->GetInterfaces())
@@ -67,26 +96,83 @@ namespace syscon::controllers
             if (!found)
             {
                 syscon::logger::LogInfo("Controller[%04x-%04x] unplugged !", (*it)->GetController()->GetDevice()->GetVendor(), (*it)->GetController()->GetDevice()->GetProduct());
-                controllerHandlers.erase(it--);
+                controllerHandlers.erase(it);
+                controllerConfigs.erase(controllerConfigs.begin() + index--);
             }
         }
     }
 
     void SetPollingFrequency(int _polling_frequency_ms)
     {
+        std::scoped_lock scoped_lock(controllerMutex);
+        if (polling_frequency_ms == _polling_frequency_ms)
+            return;
+
         polling_frequency_ms = _polling_frequency_ms;
+        for (auto &&handler : controllerHandlers)
+            handler->SetPollingFrequency(polling_frequency_ms);
+    }
+
+    int ReloadConfig()
+    {
+        std::scoped_lock scoped_lock(controllerMutex);
+        int updated = 0;
+
+        for (size_t index = 0; index < controllerHandlers.size(); index++)
+        {
+            IController *controller = controllerHandlers[index]->GetController();
+            ControllerConfig config;
+
+            if (!syscon::config::ReloadControllerConfig(&config, controller->GetDevice()->GetVendor(), controller->GetDevice()->GetProduct()))
+                continue;
+
+            // Compared with the config last given: the one of the controller may be assigned by its input thread meanwhile (See ApplyPendingConfig)
+            ControllerConfig &previous = controllerConfigs[index];
+            if (config.driver != previous.driver || config.controllerType != previous.controllerType)
+                syscon::logger::LogInfo("Controller[%04x-%04x] driver or controller_type changed, replug the controller to apply it", controller->GetDevice()->GetVendor(), controller->GetDevice()->GetProduct());
+
+            previous = config;
+            controller->SetConfig(config);
+            updated++;
+        }
+
+        return updated;
+    }
+
+    void SetInputMode(SwitchInputMode _input_mode)
+    {
+        input_mode = _input_mode;
+    }
+
+    void SetHdlKeepAlive(int _hdl_keepalive_ms)
+    {
+        hdl_keepalive_ms = _hdl_keepalive_ms;
+    }
+
+    void SetHdlStickDeadband(int _hdl_stick_deadband)
+    {
+        hdl_stick_deadband = _hdl_stick_deadband;
+    }
+
+    void FormatLatency(std::string *out)
+    {
+        std::scoped_lock scoped_lock(controllerMutex);
+        for (auto &&handler : controllerHandlers)
+            handler->FormatLatency(out);
     }
 
     void Initialize()
     {
         controllerHandlers.reserve(MaxControllerHandlersSize);
+        controllerConfigs.reserve(MaxControllerHandlersSize);
     }
 
     void Reset()
     {
-        syscon::logger::LogDebug("Controllers Reset !");
+        SYSCON_LOG_DEBUG(LOG_MODULE_HDL, "Controllers Reset !");
         std::scoped_lock scoped_lock(controllerMutex);
         controllerHandlers.clear();
+        controllerConfigs.clear();
     }
 
     void Exit()
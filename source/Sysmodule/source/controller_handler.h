@@ -10,7 +10,18 @@ namespace syscon::controllers
     ams::Result Insert(std::unique_ptr<IController> &&controllerPtr);
     void RemoveIfNotPlugged(std::vector<s32> interfaceIDsPlugged);
 
+    // Also given to the controllers plugged, applied by their input thread
     void SetPollingFrequency(int polling_frequency_ms);
+    void SetInputMode(SwitchInputMode input_mode);
+    void SetHdlKeepAlive(int hdl_keepalive_ms);
+    void SetHdlStickDeadband(int hdl_stick_deadband);
+
+    // After config::ReloadConfig: give their new config to the controllers plugged whose sections changed, applied by their input thread.
+    // Returns the number of controllers updated.
+    int ReloadConfig();
+
+    // Append the latency histograms of every controller plugged (See SwitchVirtualGamepadHandler::FormatLatency)
+    void FormatLatency(std::string *out);
 
     void Initialize();
     void Reset();
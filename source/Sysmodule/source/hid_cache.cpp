@@ -0,0 +1,223 @@
+#include "switch.h"
+#include "hid_cache.h"
+#include "logger.h"
+#include "ControllerErrors.h"
+#include <cstring>
+#include <string>
+#include <stratosphere.hpp>
+#include <stratosphere/fs/fs_filesystem.hpp>
+#include <stratosphere/fs/fs_file.hpp>
+
+#define HID_CACHE_MAGIC       0x43444948 // "HIDC"
+#define HID_CACHE_VERSION     1
+#define HID_CACHE_MAX_ENTRIES 32
+#define HID_CACHE_MAX_DATA    4096
+
+namespace syscon::hid_cache
+{
+    namespace
+    {
+        struct FileHeader
+        {
+            u32 magic;
+            u16 version;
+            u16 count;
+        };
+
+        struct EntryHeader
+        {
+            u16 vendor;
+            u16 product;
+            u32 size;
+            u64 descriptorHash;
+        };
+
+        struct Entry
+        {
+            EntryHeader header;
+            std::vector<uint8_t> data;
+        };
+
+        ams::os::Mutex cacheMutex(false);
+        std::vector<Entry> cacheEntries; // Oldest first
+        std::string cachePath;
+        bool cacheChanged = false; // Stored since the last write of the file
+
+        // The file is small (a few hundred bytes per controller), it's fully rewritten on each change
+        std::vector<u8> SerializeCache()
+        {
+            std::vector<u8> buffer;
+            FileHeader fileHeader = {HID_CACHE_MAGIC, HID_CACHE_VERSION, (u16)cacheEntries.size()};
+            buffer.insert(buffer.end(), (const u8 *)&fileHeader, (const u8 *)&fileHeader + sizeof(fileHeader));
+
+            for (const Entry &entry : cacheEntries)
+            {
+                buffer.insert(buffer.end(), (const u8 *)&entry.header, (const u8 *)&entry.header + sizeof(entry.header));
+                buffer.insert(buffer.end(), entry.data.begin(), entry.data.end());
+            }
+
+            return buffer;
+        }
+
+        ams::Result WriteCacheFile(const char *path, const std::vector<u8> &buffer)
+        {
+            ams::fs::DeleteFile(path);
+            R_TRY(ams::fs::CreateFile(path, buffer.size()));
+
+            ams::fs::FileHandle file;
+            R_TRY(ams::fs::OpenFile(std::addressof(file), path, ams::fs::OpenMode_Write));
+            ON_SCOPE_EXIT { ams::fs::CloseFile(file); };
+
+            R_TRY(ams::fs::WriteFile(file, 0, buffer.data(), buffer.size(), ams::fs::WriteOption::Flush));
+
+            R_SUCCEED();
+        }
+
+        ams::Result ReadCacheFile()
+        {
+            ams::fs::FileHandle file;
+            s64 fileSize = 0;
+
+            R_TRY(ams::fs::OpenFile(std::addressof(file), cachePath.c_str(), ams::fs::OpenMode_Read));
+            ON_SCOPE_EXIT { ams::fs::CloseFile(file); };
+
+            R_TRY(ams::fs::GetFileSize(&fileSize, file));
+
+            std::vector<u8> buffer(fileSize);
+            R_TRY(ams::fs::ReadFile(file, 0, buffer.data(), buffer.size()));
+
+            FileHeader fileHeader;
+            if (buffer.size() < sizeof(fileHeader))
+                R_RETURN(CONTROL_ERR_UNEXPECTED_DATA);
+
+            memcpy(&fileHeader, buffer.data(), sizeof(fileHeader));
+            if (fileHeader.magic != HID_CACHE_MAGIC || fileHeader.version != HID_CACHE_VERSION || fileHeader.count > HID_CACHE_MAX_ENTRIES)
+                R_RETURN(CONTROL_ERR_UNEXPECTED_DATA);
+
+            size_t offset = sizeof(fileHeader);
+            for (u16 i = 0; i < fileHeader.count; i++)
+            {
+                Entry entry;
+                if (offset + sizeof(entry.header) > buffer.size())
+                    R_RETURN(CONTROL_ERR_UNEXPECTED_DATA);
+
+                memcpy(&entry.header, &buffer[offset], sizeof(entry.header));
+                offset += sizeof(entry.header);
+
+                if (entry.header.size > HID_CACHE_MAX_DATA || offset + entry.header.size > buffer.size())
+                    R_RETURN(CONTROL_ERR_UNEXPECTED_DATA);
+
+                entry.data.assign(&buffer[offset], &buffer[offset] + entry.header.size);
+                offset += entry.header.size;
+
+                cacheEntries.push_back(std::move(entry));
+            }
+
+            R_SUCCEED();
+        }
+    } // namespace
+
+    ams::Result Initialize(const char *path)
+    {
+        std::scoped_lock cacheLock(cacheMutex);
+
+        cachePath = std::string(path);
+        cacheEntries.clear();
+        cacheChanged = false;
+
+        ams::Result rc = ReadCacheFile();
+        if (R_FAILED(rc))
+        {
+            // Missing (first boot) or invalid, start from an empty cache
+            cacheEntries.clear();
+            SYSCON_LOG_DEBUG(LOG_MODULE_CONFIG, "HID layout cache: '%s' not loaded (Error: 0x%X)", path, rc.GetValue());
+            R_SUCCEED();
+        }
+
+        SYSCON_LOG_DEBUG(LOG_MODULE_CONFIG, "HID layout cache: %d entries loaded from '%s'", (int)cacheEntries.size(), path);
+        R_SUCCEED();
+    }
+
+    void Exit()
+    {
+        Process();
+
+        std::scoped_lock cacheLock(cacheMutex);
+        cacheEntries.clear();
+        cachePath.clear();
+        cacheChanged = false;
+    }
+
+    void Process()
+    {
+        std::vector<u8> buffer;
+        std::string path;
+
+        {
+            std::scoped_lock cacheLock(cacheMutex);
+            if (!cacheChanged)
+                return;
+
+            buffer = SerializeCache();
+            path = cachePath;
+            cacheChanged = false;
+        }
+
+        // Outside of the lock: Load is called by the controllers being initialized
+        ams::Result rc = WriteCacheFile(path.c_str(), buffer);
+        if (R_FAILED(rc))
+            syscon::logger::LogError("HID layout cache: Failed to write '%s' (Error: 0x%X)", path.c_str(), rc.GetValue());
+    }
+
+    bool Load(uint16_t vendor, uint16_t product, uint64_t descriptorHash, std::vector<uint8_t> *data)
+    {
+        std::scoped_lock cacheLock(cacheMutex);
+
+        for (const Entry &entry : cacheEntries)
+        {
+            if (entry.header.vendor == vendor && entry.header.product == product && entry.header.descriptorHash == descriptorHash)
+            {
+                *data = entry.data;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void Store(uint16_t vendor, uint16_t product, uint64_t descriptorHash, const uint8_t *data, size_t size)
+    {
+        std::scoped_lock cacheLock(cacheMutex);
+
+        if (cachePath.empty() || size > HID_CACHE_MAX_DATA)
+            return;
+
+        // Only one descriptor is kept per VID/PID, a new hash replaces the previous entry (Firmware update, ...)
+        for (auto it = cacheEntries.begin(); it != cacheEntries.end(); ++it)
+        {
+            if (it->header.vendor == vendor && it->header.product == product)
+            {
+                cacheEntries.erase(it);
+                break;
+            }
+        }
+
+        if (cacheEntries.size() >= HID_CACHE_MAX_ENTRIES)
+            cacheEntries.erase(cacheEntries.begin());
+
+        cacheEntries.push_back(Entry{EntryHeader{vendor, product, (u32)size, descriptorHash}, std::vector<uint8_t>(data, data + size)});
+
+        // Written later by Process, never from the controller initialization (SD card I/O under the USB lock)
+        cacheChanged = true;
+    }
+
+    bool LayoutCache::Load(uint16_t vendor, uint16_t product, uint64_t descriptorHash, std::vector<uint8_t> *data)
+    {
+        return syscon::hid_cache::Load(vendor, product, descriptorHash, data);
+    }
+
+    void LayoutCache::Store(uint16_t vendor, uint16_t product, uint64_t descriptorHash, const uint8_t *data, size_t size)
+    {
+        syscon::hid_cache::Store(vendor, product, descriptorHash, data, size);
+    }
+} // namespace syscon::hid_cache
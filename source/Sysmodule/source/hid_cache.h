@@ -0,0 +1,25 @@
+#pragma once
+#include "IHIDLayoutCache.h"
+#include "vapours/results/results_common.hpp"
+
+namespace syscon::hid_cache
+{
+    // Load every entry of the cache file in memory, lookups never touch the SD card
+    ams::Result Initialize(const char *cachePath);
+    // Write the entries stored since the last Process
+    void Exit();
+
+    // Called periodically by the main loop: the file is written here when an entry was stored
+    void Process();
+
+    bool Load(uint16_t vendor, uint16_t product, uint64_t descriptorHash, std::vector<uint8_t> *data);
+    // Memory only, the file is written by the next Process
+    void Store(uint16_t vendor, uint16_t product, uint64_t descriptorHash, const uint8_t *data, size_t size);
+
+    class LayoutCache : public IHIDLayoutCache
+    {
+    public:
+        bool Load(uint16_t vendor, uint16_t product, uint64_t descriptorHash, std::vector<uint8_t> *data) override;
+        void Store(uint16_t vendor, uint16_t product, uint64_t descriptorHash, const uint8_t *data, size_t size) override;
+    };
+} // namespace syscon::hid_cache
@@ -0,0 +1,92 @@
+#include "switch.h"
+#include "latency_dump.h"
+#include "controller_handler.h"
+#include "logger.h"
+#include <string>
+#include <stratosphere.hpp>
+#include <stratosphere/fs/fs_filesystem.hpp>
+#include <stratosphere/fs/fs_file.hpp>
+
+// The trigger file is looked up at most once per second (One fs IPC)
+#define LATENCY_TRIGGER_CHECK_MS 1000
+
+namespace syscon::latency
+{
+    namespace
+    {
+        std::string dumpPath;
+        std::string triggerPath;
+        u32 dumpPeriod_s = 0;
+        ams::os::Tick dumpTick;
+        ams::os::Tick triggerCheckTick;
+        ams::os::Tick startTick;
+    } // namespace
+
+    void Initialize(const char *_dumpPath, const char *_triggerPath, u32 period_s)
+    {
+        dumpPath = std::string(_dumpPath);
+        triggerPath = std::string(_triggerPath);
+        dumpPeriod_s = period_s;
+        startTick = ams::os::GetSystemTick();
+        dumpTick = startTick;
+        triggerCheckTick = startTick;
+
+        // A trigger left from a previous boot would only dump empty histograms
+        ams::fs::DeleteFile(triggerPath.c_str());
+    }
+
+    void Exit()
+    {
+        dumpPath.clear();
+        triggerPath.clear();
+    }
+
+    void Process()
+    {
+        if (dumpPath.empty())
+            return;
+
+        ams::os::Tick now = ams::os::GetSystemTick();
+
+        if (dumpPeriod_s > 0 && ams::os::ConvertToTimeSpan(now - dumpTick).GetSeconds() >= dumpPeriod_s)
+        {
+            Dump();
+            dumpTick = now;
+        }
+
+        if (ams::os::ConvertToTimeSpan(now - triggerCheckTick).GetMilliSeconds() >= LATENCY_TRIGGER_CHECK_MS)
+        {
+            ams::fs::DirectoryEntryType type;
+            triggerCheckTick = now;
+
+            if (R_SUCCEEDED(ams::fs::GetEntryType(&type, triggerPath.c_str())))
+            {
+                syscon::logger::LogInfo("Latency histograms requested (%s)", triggerPath.c_str());
+                Dump();
+                ams::fs::DeleteFile(triggerPath.c_str());
+            }
+        }
+    }
+
+    // The file is fully rewritten: the histograms are cumulative since each controller was plugged
+    ams::Result Dump()
+    {
+        std::string text;
+        char header[128];
+
+        snprintf(header, sizeof(header), "sys-con latency histograms (us), up for %d s\n", (int)ams::os::ConvertToTimeSpan(ams::os::GetSystemTick() - startTick).GetSeconds());
+        text.append(header);
+        syscon::controllers::FormatLatency(&text);
+
+        ams::fs::DeleteFile(dumpPath.c_str());
+        R_TRY(ams::fs::CreateFile(dumpPath.c_str(), text.length()));
+
+        ams::fs::FileHandle file;
+        R_TRY(ams::fs::OpenFile(std::addressof(file), dumpPath.c_str(), ams::fs::OpenMode_Write));
+        ON_SCOPE_EXIT { ams::fs::CloseFile(file); };
+
+        R_TRY(ams::fs::WriteFile(file, 0, text.c_str(), text.length(), ams::fs::WriteOption::Flush));
+
+        R_SUCCEED();
+    }
+} // namespace syscon::latency
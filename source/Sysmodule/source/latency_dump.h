@@ -0,0 +1,16 @@
+#pragma once
+#include "switch.h"
+#include "vapours/results/results_common.hpp"
+
+namespace syscon::latency
+{
+    // The latency histograms of every controller are written to dumpPath every period_s seconds (0: never),
+    // and on demand: when triggerPath is created on the SD card (It's deleted once the histograms are written).
+    void Initialize(const char *dumpPath, const char *triggerPath, u32 period_s);
+    void Exit();
+
+    // Called periodically by the main loop
+    void Process();
+
+    ams::Result Dump();
+} // namespace syscon::latency
@@ -1,72 +1,697 @@
 #include "switch.h"
 #include "logger.h"
+#include "LogRing.h"
+#include "LogBinary.h"
+#include "LogHex.h"
+#include "ControllerErrors.h"
 #include <algorithm>
+#include <atomic>
+#include <new>
 #include <sys/stat.h>
 #include <stratosphere.hpp>
 #include <stratosphere/fs/fs_filesystem.hpp>
 #include <stratosphere/fs/fs_file.hpp>
 #include <vapours/util/util_format_string.hpp>
 
-#define LOG_FILE_SIZE_MAX (128 * 1024)
+// Default rotation of the log files (See SetLogRotation): segments of LOG_FILE_SIZE_MAX bytes, log.log then log.1.log, ... log.<N-1>.log
+#define LOG_FILE_SIZE_MAX      (128 * 1024)
+#define LOG_FILE_SEGMENT_COUNT 2
+
+// Default limit of the high frequency call sites (See SetLogLimit): no sampling, LOG_LIMIT_RATE messages per second
+#define LOG_LIMIT_RATE 10
+
+// The flush thread writes the lines at least every LOG_FLUSH_PERIOD_MS, earlier when the ring is half full or on error
+#define LOG_FLUSH_PERIOD_MS 100
+#define LOG_FLUSH_PRIORITY  0x3F
+
+// Maximum length of a line (Header included), longer lines are truncated. In asynchronous mode a line takes several ring entries.
+#define LOG_LINE_SIZE 1024
+
+// Binary log: number of format strings (Power of 2), longer format strings are always formatted as text
+#define LOG_BINARY_MAX_FORMATS       256
+#define LOG_BINARY_MAX_FORMAT_LENGTH (LOG_RING_LINE_SIZE - sizeof(LogBinaryRecordHeader) - 3 - LOG_BINARY_MAX_ARGS)
 
 namespace syscon::logger
 {
-    static ams::os::Mutex printMutex(false);
-    char logBuffer[1024];
-    std::string logPath;
+    static ams::os::Mutex printMutex(false); // Synchronous mode, and the lines longer than a ring entry
+    char logBuffer[LOG_LINE_SIZE];
     int logLevel = LOG_LEVEL_INFO;
+    int moduleLevel[LOG_MODULE_COUNT] = {LOG_LEVEL_INFO, LOG_LEVEL_INFO, LOG_LEVEL_INFO, LOG_LEVEL_INFO};
     char logLevelStr[LOG_LEVEL_COUNT] = {'T', 'D', 'I', 'W', 'E'};
 
+    // Asynchronous mode: the lines are formatted by the callers into the ring and written by the flush thread,
+    // in large appends to the file kept open. Until the thread is started (and after Exit) every line is written synchronously.
+    namespace
+    {
+        struct alignas(ams::os::ThreadStackAlignment) FlushStack
+        {
+            u8 data[0x2000];
+        };
+
+        LogRing logRing;
+        std::atomic<bool> logAsync{false};
+        std::unique_ptr<FlushStack> flushStack;
+        Thread flushThread;
+        UEvent flushEvent;
+        bool flushThreadRunning = false;
+        char flushBuffer[0x1000];
+        size_t flushUsed = 0;
+        u32 droppedReported = 0;
+        char flushLine[LOG_LINE_SIZE]; // Line taking several ring entries, gathered until its last entry
+        size_t flushLineLength = 0;
+
+        // Consumer side (the ring, flushBuffer and the files in asynchronous mode): the flush thread,
+        // or a thread writing its error line itself when the ring is full. Lock order: printMutex, then flushMutex.
+        ams::os::SdkMutex flushMutex;
+
+        // Log files kept open, the append offset is kept in memory.
+        // Written by the flush thread in asynchronous mode, under printMutex in synchronous mode.
+        struct LogFile
+        {
+            std::string path;
+            ams::fs::FileHandle handle;
+            s64 offset;
+            bool open;
+            bool written;
+            bool binary; // Each segment starts with a Start record and the formats defined so far
+        };
+
+        LogFile textLog;
+        LogFile binaryLog;
+        LogFile *flushTarget = NULL;
+        std::atomic<s64> logSegmentSize{LOG_FILE_SIZE_MAX};
+        std::atomic<int> logSegmentCount{LOG_FILE_SEGMENT_COUNT};
+
+        // Kind of the ring entries: a text line, or a LogBinary record
+        enum LogEntryKind : u8
+        {
+            LogEntryKind_Text = 0,
+            LogEntryKind_Binary,
+            LogEntryKind_TextPart, // The line continues in the next entry
+            LogEntryKind_Empty,    // Given back without line (See WriteLog)
+        };
+
+        // Binary log: the format strings are identified by their address, the index in this table is their ID in the file
+        enum BinaryFormatState : u8
+        {
+            BinaryFormatState_Free = 0,
+            BinaryFormatState_Undefined,   // Its Format record was not written yet (or was dropped)
+            BinaryFormatState_Defining,    // Its Format record is being written by a thread
+            BinaryFormatState_Ready,       // Its messages are written as Message records
+            BinaryFormatState_Unsupported, // Always formatted as text (See LogBinaryParseFormat)
+        };
+
+        struct BinaryFormat
+        {
+            std::atomic<const char *> fmt{NULL};
+            std::atomic<u8> state{BinaryFormatState_Free};
+            u8 argCount;
+            u8 argTypes[LOG_BINARY_MAX_ARGS];
+        };
+
+        std::atomic<bool> logBinary{false};     // Messages recorded as binary (Producers)
+        std::atomic<bool> binaryLogOpen{false}; // Text lines written to binaryLog as Text records (Flush thread)
+        BinaryFormat binaryFormats[LOG_BINARY_MAX_FORMATS];
+
+        // Level set for each module, -1 when it follows logLevel
+        int moduleLevelConfig[LOG_MODULE_COUNT] = {-1, -1, -1, -1};
+        LogLimitConfig logLimitConfig = {1, LOG_LIMIT_RATE, LOG_LIMIT_RATE};
+    } // namespace
+
+    size_t FormatHeader(char *buffer, size_t size, int lvl)
+    {
+        ams::TimeSpan ts = ams::os::ConvertToTimeSpan(ams::os::GetSystemTick());
+
+        ams::util::SNPrintf(buffer, size, "|%c|%02li:%02li:%02li.%03li|%08X| ", logLevelStr[lvl], ts.GetHours() % 24, ts.GetMinutes() % 60, ts.GetSeconds() % 60, ts.GetMilliSeconds() % 1000, (uint32_t)((uint64_t)threadGetSelf()));
+        return strlen(buffer);
+    }
+
+    size_t FormatLine(char *buffer, size_t size, int lvl, const char *fmt, ::std::va_list vl)
+    {
+        size_t length = FormatHeader(buffer, size, lvl);
+
+        ams::util::VSNPrintf(&buffer[length], size - length, fmt, vl);
+        return strlen(buffer);
+    }
+
+    // Format record of a format string (LogBinary.h), returns its size
+    size_t EncodeFormatRecord(char *out, const BinaryFormat *format)
+    {
+        const char *fmt = format->fmt.load(std::memory_order_relaxed);
+        u16 id = format - binaryFormats;
+        size_t fmtLength = strlen(fmt);
+        size_t size = sizeof(LogBinaryRecordHeader);
+
+        memcpy(&out[size], &id, sizeof(id));
+        size += sizeof(id);
+        out[size++] = format->argCount;
+        memcpy(&out[size], format->argTypes, format->argCount);
+        size += format->argCount;
+        memcpy(&out[size], fmt, fmtLength);
+        size += fmtLength;
+
+        LogBinaryRecordHeader header = {(u16)(size - sizeof(header)), LogBinaryRecordType_Format, 0, 0, 0};
+        memcpy(out, &header, sizeof(header));
+        return size;
+    }
+
+    // Path of a segment: log.log, log.1.log, log.2.log ...
+    void GetSegmentPath(char *out, size_t size, const std::string &path, int index)
+    {
+        if (index == 0)
+        {
+            ams::util::SNPrintf(out, size, "%s", path.c_str());
+            return;
+        }
+
+        std::size_t delimExtension = path.rfind('.');
+        if (delimExtension == std::string::npos || delimExtension < path.rfind('/'))
+            delimExtension = path.length();
+
+        ams::util::SNPrintf(out, size, "%.*s.%d%s", (int)delimExtension, path.c_str(), index, path.c_str() + delimExtension);
+    }
+
+    // The oldest segment is deleted, the others are renamed to the next index: the segment 0 is free
+    void ShiftSegments(const std::string &path)
+    {
+        char from[FS_MAX_PATH];
+        char to[FS_MAX_PATH];
+        int count = std::max(logSegmentCount.load(), 1);
+
+        GetSegmentPath(to, sizeof(to), path, count - 1);
+        ams::fs::DeleteFile(to);
+
+        for (int i = count - 1; i > 0; i--)
+        {
+            GetSegmentPath(from, sizeof(from), path, i - 1);
+            GetSegmentPath(to, sizeof(to), path, i);
+            ams::fs::RenameFile(from, to);
+        }
+    }
+
+    // A binary segment must be readable on its own: the format IDs are defined again after its Start record
+    ams::Result WriteBinaryLogHeader(LogFile *file)
+    {
+        struct
+        {
+            LogBinaryRecordHeader header;
+            LogBinaryStart start;
+        } record = {{sizeof(LogBinaryStart), LogBinaryRecordType_Start, 0, 0, 0}, {LOG_BINARY_MAGIC, LOG_BINARY_VERSION, 0}};
+
+        R_TRY(ams::fs::WriteFile(file->handle, file->offset, &record, sizeof(record), ams::fs::WriteOption::None));
+        file->offset += sizeof(record);
+
+        for (const BinaryFormat &format : binaryFormats)
+        {
+            // Defining: its record may have been written to the previous segment already
+            u8 state = format.state.load(std::memory_order_acquire);
+            if (state != BinaryFormatState_Ready && state != BinaryFormatState_Defining)
+                continue;
+
+            char formatRecord[LOG_RING_LINE_SIZE];
+            size_t size = EncodeFormatRecord(formatRecord, &format);
+            R_TRY(ams::fs::WriteFile(file->handle, file->offset, formatRecord, size, ams::fs::WriteOption::None));
+            file->offset += size;
+        }
+
+        R_RETURN(ams::fs::FlushFile(file->handle));
+    }
+
+    ams::Result OpenSegment(LogFile *file)
+    {
+        // Create the log file if it doesn't exist (Or previously rotated)
+        ams::fs::CreateFile(file->path.c_str(), 0);
+
+        R_TRY(ams::fs::OpenFile(std::addressof(file->handle), file->path.c_str(), ams::fs::OpenMode_Write | ams::fs::OpenMode_AllowAppend));
+        if (R_FAILED(ams::fs::GetFileSize(&file->offset, file->handle)))
+            file->offset = 0;
+
+        R_SUCCEED();
+    }
+
+    // Open the segment 0 of the file to append to it, it's rotated first if it's already full (i.e: previous boot)
+    ams::Result OpenLogFile(LogFile *file)
+    {
+        R_TRY(OpenSegment(file));
+
+        if (file->offset >= logSegmentSize)
+        {
+            ams::fs::CloseFile(file->handle);
+            ShiftSegments(file->path);
+            R_TRY(OpenSegment(file));
+        }
+
+        file->open = true;
+        file->written = false;
+
+        if (file->binary)
+            R_TRY(WriteBinaryLogHeader(file));
+
+        R_SUCCEED();
+    }
+
+    void CloseLogFile(LogFile *file)
+    {
+        if (!file->open)
+            return;
+
+        ams::fs::FlushFile(file->handle);
+        ams::fs::CloseFile(file->handle);
+        file->open = false;
+        file->written = false;
+    }
+
+    // Before appending size bytes: when they don't fit in the segment anymore, the segments are rotated and a new one is started
+    void RotateIfFull(LogFile *file, size_t size)
+    {
+        if (!file->open || file->offset == 0 || file->offset + (s64)size <= logSegmentSize)
+            return;
+
+        CloseLogFile(file);
+        ShiftSegments(file->path);
+        OpenLogFile(file);
+    }
+
+    // Synchronous mode: written and flushed right away
+    ams::Result LogWriteToFile(const char *logBuffer)
+    {
+        size_t length = strlen(logBuffer);
+
+        RotateIfFull(&textLog, length + 1);
+        if (!textLog.open)
+            R_RETURN(CONTROL_ERR_NOTHING_TODO);
+
+        R_TRY(ams::fs::WriteFile(textLog.handle, textLog.offset, logBuffer, length, ams::fs::WriteOption::None));
+        R_TRY(ams::fs::WriteFile(textLog.handle, textLog.offset + length, "\n", 1, ams::fs::WriteOption::Flush));
+        textLog.offset += length + 1;
+
+        R_SUCCEED();
+    }
+
+    void SignalFlush(int lvl)
+    {
+        if (lvl >= LOG_LEVEL_ERROR || logRing.GetUsed() >= LOG_RING_ENTRIES / 2)
+            ueventSignal(&flushEvent);
+    }
+
+    // Synchronous mode: the dump in logBuffer (length characters) and the lines remaining are written by chunks of logBuffer, flushed once
+    ams::Result LogWriteHexDumpToFile(size_t length, const char *prefix, size_t prefixLength, const uint8_t *buffer, size_t size)
+    {
+        while (length > 0)
+        {
+            logBuffer[length++] = '\n';
+
+            RotateIfFull(&textLog, length);
+            if (!textLog.open)
+                R_RETURN(CONTROL_ERR_NOTHING_TODO);
+
+            R_TRY(ams::fs::WriteFile(textLog.handle, textLog.offset, logBuffer, length, ams::fs::WriteOption::None));
+            textLog.offset += length;
+
+            length = LogHexAppendLines(logBuffer, 0, sizeof(logBuffer) - 1, prefix, prefixLength, &buffer, &size);
+        }
+
+        R_RETURN(ams::fs::FlushFile(textLog.handle));
+    }
+
+    // Write the lines appended to flushBuffer to their file
+    void FlushWrite()
+    {
+        if (flushUsed == 0 || !flushTarget->open)
+        {
+            flushUsed = 0;
+            return;
+        }
+
+        if (R_SUCCEEDED(ams::fs::WriteFile(flushTarget->handle, flushTarget->offset, flushBuffer, flushUsed, ams::fs::WriteOption::None)))
+            flushTarget->offset += flushUsed;
+
+        flushTarget->written = true;
+        flushUsed = 0;
+    }
+
+    void FlushAppend(LogFile *target, const void *data, size_t size)
+    {
+        if (target != flushTarget || flushUsed + size > sizeof(flushBuffer))
+            FlushWrite();
+
+        flushTarget = target;
+        memcpy(&flushBuffer[flushUsed], data, size);
+        flushUsed += size;
+    }
+
+    // Before appending a record (or a line) of size bytes: it's never split across two segments
+    void FlushBegin(LogFile *target, size_t size)
+    {
+        size_t pending = target == flushTarget ? flushUsed : 0;
+        if (target->offset + (s64)(pending + size) <= logSegmentSize)
+            return;
+
+        if (pending > 0)
+            FlushWrite();
+        RotateIfFull(target, size);
+    }
+
+    // Once the binary log is enabled, the text lines go to the binary file as Text records
+    void FlushText(const char *text, size_t length)
+    {
+        if (binaryLogOpen)
+        {
+            LogBinaryRecordHeader header = {(u16)length, LogBinaryRecordType_Text, 0, 0, 0};
+            FlushBegin(&binaryLog, sizeof(header) + length);
+            FlushAppend(&binaryLog, &header, sizeof(header));
+            FlushAppend(&binaryLog, text, length);
+            return;
+        }
+
+        FlushBegin(&textLog, length + 1);
+        FlushAppend(&textLog, text, length);
+        FlushAppend(&textLog, "\n", 1);
+    }
+
+    void FlushFiles()
+    {
+        for (LogFile *file : {&textLog, &binaryLog})
+        {
+            if (file->written && file->open)
+                ams::fs::FlushFile(file->handle);
+            file->written = false;
+        }
+    }
+
+    // Write every line available in the ring, in appends of up to sizeof(flushBuffer), then flush the files once (Under flushMutex)
+    void Flush()
+    {
+        for (const LogRing::Entry *entry = logRing.Peek(); entry != NULL; entry = logRing.Peek())
+        {
+            if (entry->kind == LogEntryKind_Binary)
+            {
+                FlushBegin(&binaryLog, entry->length);
+                FlushAppend(&binaryLog, entry->data, entry->length);
+            }
+            else if (entry->kind == LogEntryKind_TextPart || (entry->kind == LogEntryKind_Text && flushLineLength > 0))
+            {
+                // The entries of a line are consecutive, the last one is a Text entry
+                size_t length = std::min<size_t>(entry->length, sizeof(flushLine) - flushLineLength);
+                memcpy(&flushLine[flushLineLength], entry->data, length);
+                flushLineLength += length;
+
+                if (entry->kind == LogEntryKind_Text)
+                {
+                    FlushText(flushLine, flushLineLength);
+                    flushLineLength = 0;
+                }
+            }
+            else if (entry->kind == LogEntryKind_Text)
+                FlushText(entry->data, entry->length);
+
+            logRing.Pop();
+        }
+
+        // The lines dropped since the last flush, the ring was full
+        u32 dropped = logRing.GetDropped();
+        if (dropped != droppedReported)
+        {
+            char line[LOG_RING_LINE_SIZE];
+            size_t length = FormatHeader(line, sizeof(line), LOG_LEVEL_WARNING);
+
+            ams::util::SNPrintf(&line[length], sizeof(line) - length, "Logger: %u lines dropped (%u since boot)", dropped - droppedReported, dropped);
+            FlushText(line, strlen(line));
+            droppedReported = dropped;
+        }
+
+        FlushWrite();
+        FlushFiles();
+    }
+
+    // The ring is full: the line is written by the caller, after the lines in the ring
+    void FlushLine(const char *line, size_t length)
+    {
+        std::scoped_lock flushLock(flushMutex);
+
+        Flush();
+        FlushText(line, length);
+        FlushWrite();
+        FlushFiles();
+    }
+
+    BinaryFormat *FindBinaryFormat(const char *fmt)
+    {
+        size_t idx = (((uintptr_t)fmt >> 2) * 0x9E3779B97F4A7C15ULL) >> 56;
+
+        static_assert(LOG_BINARY_MAX_FORMATS == 256, "The hash gives 8 bits");
+
+        for (size_t i = 0; i < LOG_BINARY_MAX_FORMATS; i++, idx = (idx + 1) % LOG_BINARY_MAX_FORMATS)
+        {
+            BinaryFormat *format = &binaryFormats[idx];
+            const char *current = format->fmt.load(std::memory_order_acquire);
+
+            // First use of the format: parse its arguments once
+            if (current == NULL && format->fmt.compare_exchange_strong(current, fmt, std::memory_order_acq_rel))
+            {
+                int count = LogBinaryParseFormat(fmt, format->argTypes, LOG_BINARY_MAX_ARGS);
+                format->argCount = std::max(count, 0);
+                format->state.store(count < 0 || strlen(fmt) > LOG_BINARY_MAX_FORMAT_LENGTH ? BinaryFormatState_Unsupported : BinaryFormatState_Undefined, std::memory_order_release);
+                return format;
+            }
+
+            if (current == fmt)
+                return format;
+        }
+
+        return NULL;
+    }
+
+    // The Format record must be in the ring before any message using it
+    void DefineBinaryFormat(BinaryFormat *format)
+    {
+        u8 expected = BinaryFormatState_Undefined;
+        if (!format->state.compare_exchange_strong(expected, BinaryFormatState_Defining, std::memory_order_acquire))
+            return;
+
+        LogRing::Entry *entry = logRing.Reserve();
+        if (entry == NULL)
+        {
+            format->state.store(BinaryFormatState_Undefined, std::memory_order_release);
+            return;
+        }
+
+        logRing.Commit(entry, EncodeFormatRecord(entry->data, format), LogEntryKind_Binary);
+        format->state.store(BinaryFormatState_Ready, std::memory_order_release);
+    }
+
+    // Record the raw arguments of the message, false if it must be formatted as text (The arguments were not read)
+    bool LogBinaryMessage(int lvl, const char *fmt, ::std::va_list vl)
+    {
+        BinaryFormat *format = FindBinaryFormat(fmt);
+        if (format == NULL)
+            return false;
+
+        if (format->state.load(std::memory_order_acquire) == BinaryFormatState_Undefined)
+            DefineBinaryFormat(format);
+
+        if (format->state.load(std::memory_order_acquire) != BinaryFormatState_Ready)
+            return false;
+
+        // The ring is full: an error is formatted as text and written right away (See WriteLog)
+        LogRing::Entry *entry = logRing.Reserve(1, lvl < LOG_LEVEL_ERROR);
+        if (entry == NULL)
+            return lvl < LOG_LEVEL_ERROR; // Dropped, reported by the flush thread
+
+        u16 id = format - binaryFormats;
+        size_t size = sizeof(LogBinaryRecordHeader);
+
+        memcpy(&entry->data[size], &id, sizeof(id));
+        size += sizeof(id);
+
+        size += LogBinaryWriteArgs((uint8_t *)&entry->data[size], sizeof(entry->data) - size, format->argTypes, format->argCount, vl);
+
+        LogBinaryRecordHeader header = {(u16)(size - sizeof(header)), LogBinaryRecordType_Message, (u8)lvl, (u32)((uint64_t)threadGetSelf()),
+                                        (u64)ams::os::ConvertToTimeSpan(ams::os::GetSystemTick()).GetMicroSeconds()};
+        memcpy(entry->data, &header, sizeof(header));
+
+        logRing.Commit(entry, size, LogEntryKind_Binary);
+        SignalFlush(lvl);
+        return true;
+    }
+
+    void FlushThreadFunc(void *arg)
+    {
+        (void)arg;
+
+        while (flushThreadRunning)
+        {
+            waitSingle(waiterForUEvent(&flushEvent), LOG_FLUSH_PERIOD_MS * 1000000ULL);
+
+            std::scoped_lock flushLock(flushMutex);
+            Flush();
+        }
+
+        std::scoped_lock flushLock(flushMutex);
+        Flush();
+    }
+
     ams::Result Initialize(const char *log)
     {
         std::scoped_lock printLock(printMutex);
-        s64 fileOffset = 0;
-        ams::fs::FileHandle file;
 
-        logPath = std::string(log);
+        textLog.path = std::string(log);
 
         // Create folder if it doesn't exist.
-        std::size_t delimBasePath = logPath.rfind('/');
+        std::size_t delimBasePath = textLog.path.rfind('/');
         if (delimBasePath != std::string::npos)
         {
-            std::string basePath = logPath.substr(0, delimBasePath);
+            std::string basePath = textLog.path.substr(0, delimBasePath);
             ams::fs::CreateDirectory(basePath.c_str());
         }
 
-        // Check if the log file is too big, if so, delete it.
-        if (R_SUCCEEDED(ams::fs::OpenFile(std::addressof(file), logPath.c_str(), ams::fs::OpenMode_Read)))
+        // The file stays open in both modes, it's rotated once full
+        R_TRY(OpenLogFile(&textLog));
+
+        // Asynchronous mode: the file is written by the flush thread, otherwise every line is written synchronously
+        flushStack.reset(new (std::nothrow) FlushStack);
+        if (flushStack == nullptr)
+            R_SUCCEED();
+
+        ueventCreate(&flushEvent, true);
+        flushThreadRunning = true;
+        R_ABORT_UNLESS(threadCreate(&flushThread, &FlushThreadFunc, NULL, flushStack->data, sizeof(flushStack->data), LOG_FLUSH_PRIORITY, -2));
+        R_ABORT_UNLESS(threadStart(&flushThread));
+
+        logAsync = true;
+
+        R_SUCCEED();
+    }
+
+    ams::Result EnableBinaryLog(const char *path)
+    {
+        std::scoped_lock printLock(printMutex);
+
+        // The binary records are written by the flush thread only
+        if (!logAsync)
+            R_RETURN(CONTROL_ERR_NOT_IMPLEMENTED);
+
+        if (binaryLogOpen)
+            R_SUCCEED();
+
+        // The format IDs of the previous boots are not valid anymore: a Start record is written first
+        binaryLog.path = std::string(path);
+        binaryLog.binary = true;
+
+        ams::Result rc = OpenLogFile(&binaryLog);
+        if (R_FAILED(rc))
         {
-            ams::fs::GetFileSize(&fileOffset, file);
-            ams::fs::CloseFile(file);
+            CloseLogFile(&binaryLog);
+            R_RETURN(rc);
         }
-        if (fileOffset >= LOG_FILE_SIZE_MAX)
-            ams::fs::DeleteFile(logPath.c_str());
 
-        // Create the log file if it doesn't exist (Or previously deleted)
-        ams::fs::CreateFile(logPath.c_str(), 0);
+        binaryLogOpen = true;
+        logBinary = true;
 
         R_SUCCEED();
     }
 
+    void SetLogRotation(size_t segmentSize, int segmentCount)
+    {
+        logSegmentSize = std::max<s64>(segmentSize, LOG_RING_LINE_SIZE + 1);
+        logSegmentCount = std::max(segmentCount, 1);
+    }
+
+    void UpdateModuleLevels()
+    {
+        for (int i = 0; i < LOG_MODULE_COUNT; i++)
+            moduleLevel[i] = moduleLevelConfig[i] < 0 ? logLevel : moduleLevelConfig[i];
+    }
+
     void SetLogLevel(int level)
     {
         logLevel = level;
+        UpdateModuleLevels();
     }
 
-    ams::Result LogWriteToFile(const char *logBuffer)
+    void SetModuleLogLevel(int module, int level)
     {
-        s64 fileOffset;
-        ams::fs::FileHandle file;
+        if (module < 0 || module >= LOG_MODULE_COUNT)
+            return;
 
-        R_TRY(ams::fs::OpenFile(std::addressof(file), logPath.c_str(), ams::fs::OpenMode_Write | ams::fs::OpenMode_AllowAppend));
-        ON_SCOPE_EXIT { ams::fs::CloseFile(file); };
+        moduleLevelConfig[module] = level;
+        UpdateModuleLevels();
+    }
 
-        R_TRY(ams::fs::GetFileSize(&fileOffset, file));
+    void SetLogLimit(int sample, int rate)
+    {
+        // A burst of one second of messages
+        logLimitConfig.sample = std::max(sample, 1);
+        logLimitConfig.rate = std::max(rate, 0);
+        logLimitConfig.burst = logLimitConfig.rate;
+    }
 
-        R_TRY(ams::fs::WriteFile(file, fileOffset, logBuffer, strlen(logBuffer), ams::fs::WriteOption::Flush));
-        R_TRY(ams::fs::WriteFile(file, fileOffset + strlen(logBuffer), "\n", 1, ams::fs::WriteOption::Flush));
+    // Write a message without checking its level
+    void WriteLog(int lvl, const char *fmt, ::std::va_list vl)
+    {
+        // Formatted directly into the ring, no lock
+        if (logAsync)
+        {
+            if (logBinary && LogBinaryMessage(lvl, fmt, vl))
+                return;
+
+            LogRing::Entry *entry = logRing.Reserve(1, lvl < LOG_LEVEL_ERROR);
+            if (entry == NULL && lvl < LOG_LEVEL_ERROR)
+                return; // Dropped, reported by the flush thread
+
+            if (entry != NULL)
+            {
+                std::va_list line_vl;
+                va_copy(line_vl, vl);
+                size_t length = FormatLine(entry->data, sizeof(entry->data), lvl, fmt, line_vl);
+                va_end(line_vl);
+
+                if (length < sizeof(entry->data) - 1)
+                {
+                    logRing.Commit(entry, length);
+                    SignalFlush(lvl);
+                    return;
+                }
+
+                // The line may not fit in one entry: this one is given back, the line is formatted again and takes consecutive entries
+                logRing.Commit(entry, 0, LogEntryKind_Empty);
+            }
+
+            std::scoped_lock printLock(printMutex);
+
+            size_t length = FormatLine(logBuffer, sizeof(logBuffer), lvl, fmt, vl);
+            u32 count = (length + LOG_RING_LINE_SIZE - 1) / LOG_RING_LINE_SIZE;
+
+            LogRing::Entry *part = entry != NULL ? logRing.Reserve(count, lvl < LOG_LEVEL_ERROR) : NULL;
+            if (part == NULL)
+            {
+                // The ring is full: the errors are written right away, the other lines are dropped (reported by the flush thread)
+                if (lvl >= LOG_LEVEL_ERROR)
+                    FlushLine(logBuffer, length);
+                return;
+            }
+
+            for (u32 i = 0; i < count; i++)
+            {
+                size_t partLength = std::min<size_t>(length - i * LOG_RING_LINE_SIZE, LOG_RING_LINE_SIZE);
+                LogRing::Entry *next = logRing.Next(part);
+
+                memcpy(part->data, &logBuffer[i * LOG_RING_LINE_SIZE], partLength);
+                logRing.Commit(part, partLength, i + 1 < count ? LogEntryKind_TextPart : LogEntryKind_Text);
+                part = next;
+            }
+
+            SignalFlush(lvl);
+            return;
+        }
 
-        R_SUCCEED();
+        std::scoped_lock printLock(printMutex);
+
+        /* Format log */
+        FormatLine(logBuffer, sizeof(logBuffer), lvl, fmt, vl);
+
+        /* Write in the file. */
+        LogWriteToFile(logBuffer);
     }
 
     void Log(int lvl, const char *fmt, ::std::va_list vl)
@@ -74,16 +699,42 @@ namespace syscon::logger
         if (lvl < logLevel)
             return; // Don't log if the level is lower than the current log level.
 
-        std::scoped_lock printLock(printMutex);
+        WriteLog(lvl, fmt, vl);
+    }
 
-        ams::TimeSpan ts = ams::os::ConvertToTimeSpan(ams::os::GetSystemTick());
+    void WriteLogBuffer(int lvl, const uint8_t *buffer, size_t size)
+    {
+        // Every line starts with the same header, the first one gives the size
+        char prefix[64];
+        size_t prefixLength = FormatHeader(prefix, sizeof(prefix), lvl);
+
+        // Asynchronous mode: the lines are dumped directly into as few ring entries as possible (The flush thread writes them at once)
+        if (logAsync)
+        {
+            LogRing::Entry *entry = logRing.Reserve();
+            if (entry == NULL)
+                return; // Dropped, reported by the flush thread
+
+            memcpy(entry->data, prefix, prefixLength);
+            ams::util::SNPrintf(&entry->data[prefixLength], sizeof(entry->data) - prefixLength, "Buffer (%ld): ", size);
+            logRing.Commit(entry, LogHexAppendLines(entry->data, strlen(entry->data), sizeof(entry->data), prefix, prefixLength, &buffer, &size));
+
+            while (size > 0 && (entry = logRing.Reserve()) != NULL)
+                logRing.Commit(entry, LogHexAppendLines(entry->data, 0, sizeof(entry->data), prefix, prefixLength, &buffer, &size));
+
+            SignalFlush(lvl);
+            return;
+        }
+
+        std::scoped_lock printLock(printMutex);
 
         /* Format log */
-        ams::util::SNPrintf(logBuffer, sizeof(logBuffer), "|%c|%02li:%02li:%02li.%03li|%08X| ", logLevelStr[lvl], ts.GetHours() % 24, ts.GetMinutes() % 60, ts.GetSeconds() % 60, ts.GetMilliSeconds() % 1000, (uint32_t)((uint64_t)threadGetSelf()));
-        ams::util::VSNPrintf(&logBuffer[strlen(logBuffer)], ams::util::size(logBuffer) - strlen(logBuffer), fmt, vl);
+        memcpy(logBuffer, prefix, prefixLength);
+        ams::util::SNPrintf(&logBuffer[prefixLength], sizeof(logBuffer) - prefixLength, "Buffer (%ld): ", size);
+        size_t length = LogHexAppendLines(logBuffer, strlen(logBuffer), sizeof(logBuffer) - 1, prefix, prefixLength, &buffer, &size);
 
         /* Write in the file. */
-        LogWriteToFile(logBuffer);
+        LogWriteHexDumpToFile(length, prefix, prefixLength, buffer, size);
     }
 
     void LogBuffer(int lvl, const uint8_t *buffer, size_t size)
@@ -91,27 +742,30 @@ namespace syscon::logger
         if (lvl < logLevel)
             return; // Don't log if the level is lower than the current log level.
 
-        std::scoped_lock printLock(printMutex);
-
-        ams::TimeSpan ts = ams::os::ConvertToTimeSpan(ams::os::GetSystemTick());
-
-        ams::util::SNPrintf(logBuffer, sizeof(logBuffer), "|%c|%02li:%02li:%02li.%03li|%08X| ", logLevelStr[lvl], ts.GetHours() % 24, ts.GetMinutes() % 60, ts.GetSeconds() % 60, ts.GetMilliSeconds() % 1000, (uint32_t)((uint64_t)threadGetSelf()));
-
-        size_t start_offset = strlen(logBuffer);
+        WriteLogBuffer(lvl, buffer, size);
+    }
 
-        ams::util::SNPrintf(&logBuffer[strlen(logBuffer)], ams::util::size(logBuffer) - strlen(logBuffer), "Buffer (%ld): ", size);
+    void LogAt(int lvl, const char *fmt, ...)
+    {
+        ::std::va_list vl;
+        va_start(vl, fmt);
+        WriteLog(lvl, fmt, vl);
+        va_end(vl);
+    }
 
-        LogWriteToFile(logBuffer);
+    void LogBufferAt(int lvl, const uint8_t *buffer, size_t size)
+    {
+        WriteLogBuffer(lvl, buffer, size);
+    }
 
-        /* Format log */
-        for (size_t i = 0; i < size; i += 16)
-        {
-            for (size_t k = 0; k < std::min((size_t)16, size - i); k++)
-                ams::util::SNPrintf(&logBuffer[start_offset + (k * 3)], ams::util::size(logBuffer) - (start_offset + (k * 3)), "%02X ", buffer[i + k]);
+    bool PassLogLimit(LogLimit *limit, uint32_t *suppressed)
+    {
+        return LogLimitPass(limit, logLimitConfig, ams::os::ConvertToTimeSpan(ams::os::GetSystemTick()).GetNanoSeconds(), suppressed);
+    }
 
-            /* Write in the file. */
-            LogWriteToFile(logBuffer);
-        }
+    void LogSuppressed(int lvl, uint32_t count, const char *file, int line)
+    {
+        LogAt(lvl, LOG_LIMIT_SUPPRESSED_FORMAT, (unsigned)count, LogLimitFileName(file), line);
     }
 
     void LogTrace(const char *fmt, ...)
@@ -156,16 +810,49 @@ namespace syscon::logger
 
     void Exit()
     {
+        // The lines logged from now on are dropped, the files are closed
+        std::scoped_lock printLock(printMutex);
+
+        if (logAsync)
+        {
+            logAsync = false;
+            flushThreadRunning = false;
+            ueventSignal(&flushEvent);
+            threadWaitForExit(&flushThread);
+            threadClose(&flushThread);
+            flushStack.reset();
+        }
+
+        CloseLogFile(&textLog);
+        if (binaryLogOpen)
+        {
+            logBinary = false;
+            binaryLogOpen = false;
+            CloseLogFile(&binaryLog);
+        }
     }
 
+    // The drivers log at the level of LOG_MODULE_DRIVER
     void Logger::Print(LogLevel lvl, const char *format, ::std::va_list vl)
     {
-        Log(lvl, format, vl);
+        if (IsEnabled(lvl))
+            WriteLog(lvl, format, vl);
     }
 
     void Logger::PrintBuffer(LogLevel lvl, const uint8_t *buffer, size_t size)
     {
-        LogBuffer(lvl, buffer, size);
+        if (IsEnabled(lvl))
+            WriteLogBuffer(lvl, buffer, size);
+    }
+
+    bool Logger::IsEnabled(LogLevel lvl) const
+    {
+        return lvl >= moduleLevel[LOG_MODULE_DRIVER];
+    }
+
+    bool Logger::PassLimit(LogLimit *limit, uint32_t *suppressed)
+    {
+        return PassLogLimit(limit, suppressed);
     }
 
 } // namespace syscon::logger
\ No newline at end of file
@@ -2,22 +2,29 @@
 #include <cstdarg>
 #include <string>
 #include "ILogger.h"
+#include "SwitchLogger.h"
 #include "vapours/results/results_common.hpp"
 
-#define LOG_LEVEL_TRACE   0
-#define LOG_LEVEL_DEBUG   1
-#define LOG_LEVEL_INFO    2
-#define LOG_LEVEL_WARNING 3
-#define LOG_LEVEL_ERROR   4
-#define LOG_LEVEL_COUNT   5
-
 namespace syscon::logger
 {
     ams::Result Initialize(const char *logPath);
     void Exit();
 
+    // Record the messages in binary (format string ID and raw arguments, See LogBinary.h) into path instead of formatting them.
+    // Only available once the flush thread runs, every line is written to path from now on.
+    ams::Result EnableBinaryLog(const char *path);
+
+    // The log files are rotated once they reach segmentSize bytes: log.log is renamed log.1.log, ... up to segmentCount files (The oldest one is deleted)
+    void SetLogRotation(size_t segmentSize, int segmentCount);
+
     void SetLogLevel(int level);
 
+    // Level of a module (LOG_MODULE_xxx), -1 to follow SetLogLevel
+    void SetModuleLogLevel(int module, int level);
+
+    // High frequency call sites (SYSCON_LOG_LIMITED): 1 message out of sample, then at most rate messages per second per call site (0: unlimited)
+    void SetLogLimit(int sample, int rate);
+
     void LogTrace(const char *format, ...);
     void LogDebug(const char *format, ...);
     void LogInfo(const char *format, ...);
@@ -27,10 +34,15 @@ namespace syscon::logger
     void Log(int lvl, const char *fmt, ::std::va_list vl);
     void LogBuffer(int lvl, const uint8_t *buffer, size_t size);
 
+    void LogAt(int lvl, const char *fmt, ...);
+    void LogBufferAt(int lvl, const uint8_t *buffer, size_t size);
+
     class Logger : public ILogger
     {
     public:
         void Print(LogLevel lvl, const char *format, ::std::va_list vl) override;
         void PrintBuffer(LogLevel lvl, const uint8_t *buffer, size_t size) override;
+        bool IsEnabled(LogLevel lvl) const override;
+        bool PassLimit(LogLimit *limit, uint32_t *suppressed) override;
     };
 } // namespace syscon::logger
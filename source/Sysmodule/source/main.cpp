@@ -6,8 +6,15 @@
 #include "controller_handler.h"
 #include "config_handler.h"
 #include "psc_module.h"
+#include "hid_cache.h"
+#include "latency_dump.h"
+#include "config_reload.h"
 #include "version.h"
 #include "SwitchHDLHandler.h"
+#include "SwitchUSBCapture.h"
+#include "SwitchUSBEndpoint.h"
+#include "SwitchInputReactor.h"
+#include "SwitchUSBOutput.h"
 
 // libstratosphere variables
 namespace ams
@@ -124,20 +131,65 @@ namespace ams
         ::syscon::config::LoadGlobalConfig(&globalConfig);
 
         ::syscon::logger::SetLogLevel(globalConfig.log_level);
+        ::syscon::logger::SetModuleLogLevel(LOG_MODULE_USB, globalConfig.log_level_usb);
+        ::syscon::logger::SetModuleLogLevel(LOG_MODULE_HDL, globalConfig.log_level_hdl);
+        ::syscon::logger::SetModuleLogLevel(LOG_MODULE_DRIVER, globalConfig.log_level_driver);
+        ::syscon::logger::SetModuleLogLevel(LOG_MODULE_CONFIG, globalConfig.log_level_config);
+        ::syscon::logger::SetLogLimit(globalConfig.log_sample, globalConfig.log_rate_limit);
+        ::syscon::logger::SetLogRotation(globalConfig.log_file_size_kb * 1024, globalConfig.log_file_count);
+
+        if (globalConfig.log_binary)
+        {
+            ::syscon::logger::LogDebug("Switching to binary log ...");
+            if (R_FAILED(::syscon::logger::EnableBinaryLog(CONFIG_PATH "log.bin")))
+                ::syscon::logger::LogError("Failed to enable the binary log !");
+        }
 
-        ::syscon::logger::LogDebug("Initializing controllers ...");
-        ::syscon::controllers::Initialize();
+        if (globalConfig.usb_capture_size_kb > 0)
+        {
+            ::syscon::logger::LogDebug("Initializing USB capture ...");
+            if (R_FAILED(SwitchUSBCapture::Initialize(CONFIG_PATH "usb_capture.scap", globalConfig.usb_capture_size_kb * 1024, globalConfig.usb_capture_max_file_kb * 1024)))
+                ::syscon::logger::LogError("Failed to initialize USB capture !");
+        }
 
-        // Reduce polling frequency when we use debug or trace to avoid spamming the logs
-        if (globalConfig.log_level == LOG_LEVEL_TRACE && globalConfig.polling_frequency_ms < 500)
-            globalConfig.polling_frequency_ms = 500;
+        ::syscon::logger::LogDebug("Initializing HID layout cache ...");
+        ::syscon::hid_cache::Initialize(CONFIG_PATH "hid_layout_cache.bin");
 
-        if (globalConfig.log_level == LOG_LEVEL_DEBUG && globalConfig.polling_frequency_ms < 100)
-            globalConfig.polling_frequency_ms = 100;
+        ::syscon::logger::LogDebug("Initializing controllers ...");
+        ::syscon::controllers::Initialize();
 
         ::syscon::logger::LogDebug("Polling frequency: %d ms", globalConfig.polling_frequency_ms);
         ::syscon::controllers::SetPollingFrequency(globalConfig.polling_frequency_ms);
 
+        ::syscon::logger::LogDebug("Input mode: %s", globalConfig.input_mode == SwitchInputMode_Event ? "event" : "polling");
+        ::syscon::controllers::SetInputMode(globalConfig.input_mode == SwitchInputMode_Event ? SwitchInputMode_Event : SwitchInputMode_Polling);
+
+        ::syscon::logger::LogDebug("HDL keep-alive: %d ms", globalConfig.hdl_keepalive_ms);
+        ::syscon::controllers::SetHdlKeepAlive(globalConfig.hdl_keepalive_ms);
+
+        ::syscon::logger::LogDebug("HDL stick deadband: %d", globalConfig.hdl_stick_deadband);
+        ::syscon::controllers::SetHdlStickDeadband(globalConfig.hdl_stick_deadband);
+
+        ::syscon::logger::LogDebug("USB IN transfers per endpoint: %d", globalConfig.usb_in_transfers);
+        SwitchUSBEndpoint::SetInTransferCount(globalConfig.usb_in_transfers);
+
+        if (globalConfig.input_threads > 0)
+        {
+            ::syscon::logger::LogDebug("Initializing input reactor ...");
+            if (R_FAILED(SwitchInputReactor::Initialize(globalConfig.input_threads)))
+                ::syscon::logger::LogError("Failed to initialize the input reactor, every controller will use its own thread !");
+        }
+
+        ::syscon::logger::LogDebug("Initializing USB output thread ...");
+        if (R_FAILED(SwitchUSBOutput::Initialize()))
+            ::syscon::logger::LogError("Failed to initialize the USB output thread, rumble and LED writes will be synchronous !");
+
+        ::syscon::logger::LogDebug("Latency histograms dump: %d s", globalConfig.latency_dump_s);
+        ::syscon::latency::Initialize(CONFIG_PATH "latency.txt", CONFIG_PATH "latency_dump", globalConfig.latency_dump_s);
+
+        ::syscon::logger::LogDebug("Configuration reload: %d ms", globalConfig.config_reload_ms);
+        ::syscon::config_reload::Initialize(globalConfig.config_reload_ms);
+
         ::syscon::logger::LogDebug("Initializing USB stack ...");
         ::syscon::usb::Initialize(globalConfig.discovery_mode, globalConfig.discovery_vidpid, globalConfig.auto_add_controller);
 
@@ -147,11 +199,20 @@ namespace ams
         while (true)
         {
             svcSleepThread(1e+8L);
+            ::syscon::latency::Process();
+            ::syscon::config_reload::Process();
+            ::syscon::hid_cache::Process();
         }
 
         ::syscon::psc::Exit();
         ::syscon::usb::Exit();
+        ::syscon::config_reload::Exit();
+        ::syscon::latency::Exit();
         ::syscon::controllers::Exit();
+        SwitchInputReactor::Exit();
+        SwitchUSBOutput::Exit();
+        SwitchUSBCapture::Exit();
+        ::syscon::hid_cache::Exit();
         ::syscon::logger::Exit();
     }
 
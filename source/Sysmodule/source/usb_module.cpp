@@ -7,6 +7,7 @@
 #include "SwitchUSBDevice.h"
 #include "SwitchUSBLock.h"
 #include "logger.h"
+#include "hid_cache.h"
 #include <string.h>
 
 #define MS_TO_NS(x) (x * 1000000ul)
@@ -60,12 +61,13 @@ namespace syscon::usb
                 Result rc = waitObjects(&idx_out, g_usbWaiters, g_usbEventCount, timeoutNs);
                 if (R_SUCCEEDED(rc) || R_VALUE(rc) == KERNELRESULT(TimedOut))
                 {
-                    syscon::logger::LogDebug("New USB device detected (Or polling timeout), checking for controllers ...");
+                    SYSCON_LOG_DEBUG(LOG_MODULE_USB, "New USB device detected (Or polling timeout), checking for controllers ...");
 
                     /*
                         For unknown reason we have to keep this lock in order to lock the usb stacks during the controller initialization
                         If we don't do that, we will have some issue with the USB stack when we have multiple controllers connected at boot time
                         (Example: Not being able to setLed to the device - On XBOX360 wired controller)
+                        Only the usb:hs service calls are blocked: the transfers of the running controllers only lock their own session (See SwitchUSBLock)
                     */
 
                     SwitchUSBLock usbLock;
@@ -140,12 +142,12 @@ namespace syscon::usb
                         {
                             /* Generic controller expose 1 interface, thus we have to take only 1 */
                             syscon::logger::LogInfo("Initializing Generic controller (Interface count: %d) ...", total_entries);
-                            controllers::Insert(std::make_unique<GenericHIDController>(std::make_unique<SwitchUSBDevice>(interfaces, 1), config, std::make_unique<syscon::logger::Logger>()));
+                            controllers::Insert(std::make_unique<GenericHIDController>(std::make_unique<SwitchUSBDevice>(interfaces, 1), config, std::make_unique<syscon::logger::Logger>(), std::make_unique<syscon::hid_cache::LayoutCache>()));
                         }
                     }
                     else
                     {
-                        syscon::logger::LogDebug("No HID or XBOX interfaces found !");
+                        SYSCON_LOG_DEBUG(LOG_MODULE_USB, "No HID or XBOX interfaces found !");
                         timeoutNs = UINT64_MAX; // As soon as no controller is found, we wait for the next event
                     }
                 }
@@ -167,7 +169,7 @@ namespace syscon::usb
 
                     s32 total_entries = QueryAcquiredInterfaces(interfaces, sizeof(interfaces));
 
-                    syscon::logger::LogDebug("USBInterface %d interfaces acquired !", total_entries);
+                    SYSCON_LOG_DEBUG(LOG_MODULE_USB, "USBInterface %d interfaces acquired !", total_entries);
 
                     std::vector<s32> interfaceIDsPlugged;
                     for (int i = 0; i < total_entries; i++)
@@ -242,7 +244,7 @@ namespace syscon::usb
                 return CONTROL_ERR_OUT_OF_MEMORY;
             }
 
-            syscon::logger::LogDebug("Adding event with filter: %s (%d/%d)...", name.c_str(), g_usbEventCount + 1, MaxUsbEvents);
+            SYSCON_LOG_DEBUG(LOG_MODULE_USB, "Adding event with filter: %s (%d/%d)...", name.c_str(), g_usbEventCount + 1, MaxUsbEvents);
             Result ret = usbHsCreateInterfaceAvailableEvent(&g_usbEvent[g_usbEventCount], true, g_usbEventCount, filter);
             g_usbWaiters[g_usbEventCount] = waiterForEvent(&g_usbEvent[g_usbEventCount]);
 